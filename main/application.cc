@@ -5,6 +5,7 @@
 #include "system_info.h"
 #include "ml307_ssl_transport.h"
 #include "audio_codec.h"
+#include "audio_dsp.h"
 #include "mqtt_protocol.h"
 #include "websocket_protocol.h"
 #include "font_awesome_symbols.h"
@@ -12,7 +13,10 @@
 #include "assets/lang_config.h"
 #include "YT_UART.h"
 #include "storage/gif_storage.h"
+#include "storage/download_cache.h"
+#include "gif_downloader.h"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 #include <esp_log.h>
@@ -22,9 +26,6 @@
 #include <esp_app_desc.h>
 #include <driver/uart.h>
 #include <esp_heap_caps.h>
-#include <esp_http_client.h>
-#include <esp_tls.h>
-#include <esp_crt_bundle.h>
 #include "YT_UART.h"
 #include "gif_test.h"
 #include "image_upload_server.h"
@@ -39,12 +40,6 @@ extern "C"{
 
 #define TAG "Application"
 
-// Helper function to collect file names
-static std::vector<std::string> storage_files;
-static void collect_file_callback(const char* filename, size_t size, time_t upload_time, void* user_data) {
-    storage_files.push_back(std::string(filename));
-}
-
 static void GifStorageProgressBridge(size_t written, size_t total, void* user_data) {
     if (!user_data) {
         return;
@@ -53,6 +48,40 @@ static void GifStorageProgressBridge(size_t written, size_t total, void* user_da
     server->NotifyStorageProgress(written, total);
 }
 
+// Free space kept beyond the upload itself (index journal, filesystem overhead)
+static constexpr size_t kUploadReserveBytes = 100000;
+
+// Free enough space on the storage partition for an upload of `size` bytes:
+// cached slideshow downloads go first, then the least recently shown unpinned
+// images. With dry_run nothing is deleted and `plan` lists the images that
+// would be evicted.
+static bool MakeRoomForUpload(size_t size, bool dry_run, gif_storage_evict_plan_t* plan) {
+    const size_t needed = size + kUploadReserveBytes;
+    auto& cache = DownloadCache::GetInstance();
+
+    if (dry_run) {
+        // The whole cache can go before any image does
+        size_t cached = cache.CachedBytes();
+        return gif_storage_plan_eviction(needed > cached ? needed - cached : 0, plan) == ESP_OK;
+    }
+
+    size_t total_bytes = 0, used_bytes = 0;
+    gif_storage_info(&total_bytes, &used_bytes);
+    size_t free_bytes = total_bytes - used_bytes;
+    ESP_LOGI(TAG, "Storage info: %zu total, %zu used, %zu free", total_bytes, used_bytes, free_bytes);
+    if (free_bytes >= needed) {
+        return true;
+    }
+
+    cache.Shrink(needed - free_bytes);
+    esp_err_t ret = gif_storage_evict(needed, plan);
+    if (plan->count > 0) {
+        ESP_LOGI(TAG, "Evicted %zu images (%zu bytes) for a %zu byte upload", plan->count, plan->bytes_freed, size);
+        OfflineImageManager::GetInstance().RefreshImageList(true);
+    }
+    return ret == ESP_OK;
+}
+
 static const char *const STATE_STRINGS[] = {
     "unknown",
     "starting",
@@ -69,7 +98,7 @@ static const char *const STATE_STRINGS[] = {
 Application::Application()
 {
     event_group_ = xEventGroupCreate();
-    background_task_ = new BackgroundTask(4096 * 8);
+    background_task_ = new BackgroundTask();
 
     esp_timer_create_args_t clock_timer_args = {
         .callback = [](void *arg)
@@ -152,10 +181,8 @@ void Application::CheckNewVersion()
                 auto codec = board.GetAudioCodec();
                 codec->EnableInput(false);
                 codec->EnableOutput(false);
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    audio_decode_queue_.clear();
-                }
+                ResetDecoder();
+                StopSlideShow();
                 background_task_->WaitForCompletion();
                 delete background_task_;
                 background_task_ = nullptr;
@@ -231,7 +258,7 @@ void Application::ShowActivationCode()
     // This sentence uses 9KB of SRAM, so we need to wait for it to finish
     Alert(Lang::Strings::ACTIVATION, message.c_str(), "happy", Lang::Sounds::P3_ACTIVATION);
     vTaskDelay(pdMS_TO_TICKS(1000));
-    background_task_->WaitForCompletion();
+    WaitForPlaybackDrained();
 
     for (const auto &digit : code)
     {
@@ -354,8 +381,7 @@ void Application::PlaySound(const std::string_view &sound)
         memcpy(opus.data(), p3->payload, payload_size);
         p += payload_size;
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        audio_decode_queue_.emplace_back(std::move(opus));
+        QueueAudioPacket(std::move(opus));
     }
 }
 
@@ -379,8 +405,7 @@ void Application::PlaySound1(const std::string_view &sound)
         memcpy(opus.data(), p3->payload, payload_size);
         p += payload_size;
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        audio_decode_queue_.emplace_back(std::move(opus));
+        QueueAudioPacket(std::move(opus));
     }
 }
 
@@ -486,7 +511,7 @@ void Application::Start()
     auto codec = board.GetAudioCodec();
     opus_decode_sample_rate_ = codec->output_sample_rate();
     opus_decoder_ = std::make_unique<OpusDecoderWrapper>(opus_decode_sample_rate_, 1);
-    opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
+    opus_encoder_ = std::make_unique<OpusFrameEncoder>(16000, 1, OPUS_FRAME_DURATION_MS);
     // For ML307 boards, we use complexity 5 to save bandwidth
     // For other boards, we use complexity 3 to save CPU
     if (board.GetBoardType() == "ml307")
@@ -505,18 +530,52 @@ void Application::Start()
         input_resampler_.Configure(codec->input_sample_rate(), 16000);
         reference_resampler_.Configure(codec->input_sample_rate(), 16000);
     }
+
+    /* Capture pipeline: every buffer is sized here once */
+    size_t input_samples = codec->input_frame_samples();
+    size_t channel_samples = input_samples / codec->input_channels();
+    size_t frame_samples = 16000 / 1000 * AUDIO_CODEC_INPUT_FRAME_MS * codec->input_channels();
+    input_pool_ = std::make_unique<AudioFramePool>(frame_samples, AUDIO_INPUT_FRAME_POOL_SIZE);
+    encode_queue_ = xQueueCreate(AUDIO_INPUT_FRAME_POOL_SIZE, sizeof(int));
+    input_pcm_.resize(input_samples);
+    if (codec->input_channels() == 2)
+    {
+        mic_pcm_.resize(channel_samples);
+        reference_pcm_.resize(channel_samples);
+    }
+    if (codec->input_sample_rate() != 16000)
+    {
+        resampled_mic_pcm_.resize(input_resampler_.GetOutputSamples(channel_samples));
+        resampled_reference_pcm_.resize(reference_resampler_.GetOutputSamples(channel_samples));
+    }
     codec->OnInputReady([this, codec]()
                         {
         BaseType_t higher_priority_task_woken = pdFALSE;
         xEventGroupSetBitsFromISR(event_group_, AUDIO_INPUT_READY_EVENT, &higher_priority_task_woken);
         return higher_priority_task_woken == pdTRUE; });
-    codec->OnOutputReady([this]()
-                         {
-        BaseType_t higher_priority_task_woken = pdFALSE;
-        xEventGroupSetBitsFromISR(event_group_, AUDIO_OUTPUT_READY_EVENT, &higher_priority_task_woken);
-        return higher_priority_task_woken == pdTRUE; });
     codec->Start();
 
+    /* Playback pipeline: packets are decoded ahead into the PCM ring, the output task feeds I2S from it */
+    decoded_pcm_.reserve(opus_decode_sample_rate_ / 1000 * OPUS_FRAME_DURATION_MS);
+    resampled_pcm_.reserve(codec->output_sample_rate() / 1000 * OPUS_FRAME_DURATION_MS);
+    pcm_ring_ = std::make_unique<PcmRingBuffer>(codec->output_sample_rate() / 1000 * CONFIG_AUDIO_OUTPUT_BUFFER_MS);
+    if (pcm_ring_->capacity() == 0)
+    {
+        ESP_LOGE(TAG, "Failed to allocate the %d ms PCM ring (%u bytes), decoding straight to the codec",
+                 CONFIG_AUDIO_OUTPUT_BUFFER_MS,
+                 (unsigned)(codec->output_sample_rate() / 1000 * CONFIG_AUDIO_OUTPUT_BUFFER_MS * sizeof(int16_t)));
+    }
+    xTaskCreate([](void *arg)
+                {
+        Application* app = (Application*)arg;
+        app->AudioDecodeLoop();
+        vTaskDelete(NULL); }, "audio_decoder", 4096 * 3, this, 5, nullptr);
+    xTaskCreate([](void *arg)
+                {
+        Application* app = (Application*)arg;
+        app->AudioOutputLoop();
+        vTaskDelete(NULL); }, "audio_output", 4096, this, 6, nullptr);
+
     /* Start the main loop */
     xTaskCreate([](void *arg)
                 {
@@ -555,9 +614,8 @@ void Application::Start()
         Alert(Lang::Strings::ERROR, message.c_str(), "sad", Lang::Sounds::P3_EXCLAMATION); });
     protocol_->OnIncomingAudio([this](std::vector<uint8_t> &&data)
                                {
-        std::lock_guard<std::mutex> lock(mutex_);
         if (device_state_ == kDeviceStateSpeaking) {
-            audio_decode_queue_.emplace_back(std::move(data));
+            QueueAudioPacket(std::move(data));
         } });
     protocol_->OnAudioChannelOpened([this, codec, &board]()
                                     {
@@ -582,7 +640,7 @@ void Application::Start()
             display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
         }); });
-    protocol_->OnIncomingJson([this, display](const cJSON *root)
+    protocol_->OnIncomingMessage([this, display](const ServerMessage &message)
                               {
         // if (yt_command_flag == Bluetooth_mode ||yt_command_flag == Wake_word_ended||yt_command_flag ==Wake_word_pattern
         // || yt_command_flag ==Bluetooth_disconnected || yt_command_flag ==Bluetooth_connected  || yt_command_flag ==Last_song || yt_command_flag ==Next_song
@@ -595,21 +653,19 @@ void Application::Start()
                 ESP_LOGI(TAG, "Ignore JSON in Bluetooth mode");
                 return;  // 蓝牙模式下不处理任何协议指令
         }
-        // Parse JSON data
-        auto type = cJSON_GetObjectItem(root, "type");
-        if (strcmp(type->valuestring, "tts") == 0) {
-            auto state = cJSON_GetObjectItem(root, "state");
-            if (strcmp(state->valuestring, "start") == 0) {
+        switch (message.type) {
+        case kServerMessageTts:
+            if (message.state == kTtsStateStart) {
                 Schedule([this]() {
                     aborted_ = false;
                     if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
                         SetDeviceState(kDeviceStateSpeaking);
                     }
                 });
-            } else if (strcmp(state->valuestring, "stop") == 0) {
+            } else if (message.state == kTtsStateStop) {
                 Schedule([this]() {
                         if (device_state_ == kDeviceStateSpeaking) {
-                            background_task_->WaitForCompletion();
+                            WaitForPlaybackDrained();
                             if (keep_listening_) {
                                 protocol_->SendStartListening(kListeningModeAutoStop);
                                 SetDeviceState(kDeviceStateListening);
@@ -618,40 +674,43 @@ void Application::Start()
                             }
                         }
                 });
-            } else if (strcmp(state->valuestring, "sentence_start") == 0) {
-                auto text = cJSON_GetObjectItem(root, "text");
-                if (text != NULL) {
-                    ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    Schedule([this, display, message = std::string(text->valuestring)]() {
-                        display->SetChatMessage("assistant", message.c_str());
-                    });
-                }
+            } else if (message.state == kTtsStateSentenceStart && message.has_text) {
+                ESP_LOGI(TAG, "<< %s", message.text.c_str());
+                Schedule([this, display, text = message.text]() {
+                    display->SetChatMessage("assistant", text.c_str());
+                });
             }
-        } else if (strcmp(type->valuestring, "stt") == 0) {
-            auto text = cJSON_GetObjectItem(root, "text");
-            if (text != NULL) {
-                ESP_LOGI(TAG, ">> %s", text->valuestring);
-                Schedule([this, display, message = std::string(text->valuestring)]() {
-                    display->SetChatMessage("user", message.c_str());
+            break;
+        case kServerMessageStt:
+            if (message.has_text) {
+                ESP_LOGI(TAG, ">> %s", message.text.c_str());
+                Schedule([this, display, text = message.text]() {
+                    display->SetChatMessage("user", text.c_str());
                 });
             }
-        } else if (strcmp(type->valuestring, "llm") == 0) {
-            auto emotion = cJSON_GetObjectItem(root, "emotion");
-            if (emotion != NULL) {
-                Schedule([this, display, emotion_str = std::string(emotion->valuestring)]() {
-                    // SendEmotionByString(emotion_str.c_str());
-                    display->SetEmotion(emotion_str.c_str());
+            break;
+        case kServerMessageLlm:
+            if (message.has_emotion) {
+                Schedule([this, display, emotion = message.emotion]() {
+                    // SendEmotionByString(emotion.c_str());
+                    display->SetEmotion(emotion.c_str());
                 });
             }
-        } else if (strcmp(type->valuestring, "iot") == 0) {
-            auto commands = cJSON_GetObjectItem(root, "commands");
-            if (commands != NULL) {
+            break;
+        case kServerMessageIot:
+            if (!message.commands.empty()) {
+                // Only the command list is built as a tree, ThingManager walks cJSON
+                auto commands = cJSON_ParseWithLength(message.commands.data(), message.commands.size());
                 auto& thing_manager = iot::ThingManager::GetInstance();
                 for (int i = 0; i < cJSON_GetArraySize(commands); ++i) {
                     auto command = cJSON_GetArrayItem(commands, i);
                     thing_manager.Invoke(command);
                 }
+                cJSON_Delete(commands);
             }
+            break;
+        default:
+            break;
         } });
     protocol_->Start();
     // Check for new firmware version or get the MQTT broker address
@@ -670,11 +729,8 @@ void Application::Start()
 
 #if CONFIG_USE_AUDIO_PROCESSOR
     audio_processor_.Initialize(codec->input_channels(), codec->input_reference());
-    audio_processor_.OnOutput([this](std::vector<int16_t> &&data)
-                              { background_task_->Schedule([this, data = std::move(data)]() mutable
-                                                           { opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t> &&opus)
-                                                                                   { Schedule([this, opus = std::move(opus)]()
-                                                                                              { protocol_->SendAudio(opus); }); }); }); });
+    audio_processor_.OnOutput([this](const int16_t *data, size_t samples)
+                              { QueueAudioFrame(data, samples); });
     audio_processor_.OnVadStateChange([this](bool speaking)
                                       {
         if (device_state_ == kDeviceStateListening) {
@@ -728,7 +784,7 @@ void Application::Start()
     InitializeOfflineImageManager();
 
     // 启动完成后检查本地是否有GIF，如果有则立即播放
-    background_task_->Schedule([this]() {
+    ScheduleAutoShow([this]() {
         vTaskDelay(pdMS_TO_TICKS(3000));  // 等待系统稳定
         if (device_state_ == kDeviceStateIdle && !IsSlideShowRunning()) {
             // 检查本地是否有GIF文件
@@ -763,6 +819,7 @@ void Application::OnClockTimer()
         int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
         int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
         ESP_LOGI(TAG, "Free internal: %u minimal internal: %u", free_sram, min_free_sram);
+        background_task_->LogStats();
 
 #if CONFIG_USE_WAKE_WORD_DETECT
         // 只在在线模式下显示时钟
@@ -790,7 +847,7 @@ void Application::OnClockTimer()
         if (clock_ticks_ % 45 == 0) // 每45秒
         {
             // 延迟2秒执行，避免与时钟更新冲突
-            background_task_->Schedule([this]() {
+            ScheduleAutoShow([this]() {
                 vTaskDelay(pdMS_TO_TICKS(2000));  // 延迟2秒
                 auto& offline_mgr = OfflineImageManager::GetInstance();
                 if (device_state_ == kDeviceStateIdle && !IsImageUploadServerRunning() && !offline_mgr.IsBrowsingImages()) { // 再次检查状态
@@ -802,12 +859,9 @@ void Application::OnClockTimer()
     }
 }
 
-void Application::Schedule(std::function<void()> callback)
+void Application::Schedule(InlineTask callback)
 {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        main_tasks_.push_back(std::move(callback));
-    }
+    main_tasks_.Push(std::move(callback));
     xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
 }
 
@@ -821,25 +875,23 @@ void Application::MainLoop()
         // if(flag_sound!=1)
         // {
         auto bits = xEventGroupWaitBits(event_group_,
-                                        SCHEDULE_EVENT | AUDIO_INPUT_READY_EVENT | AUDIO_OUTPUT_READY_EVENT,
+                                        SCHEDULE_EVENT | AUDIO_INPUT_READY_EVENT,
                                         pdTRUE, pdFALSE, portMAX_DELAY);
 
         if (bits & AUDIO_INPUT_READY_EVENT)
         {
             InputAudio();
         }
-        if (bits & AUDIO_OUTPUT_READY_EVENT)
-        {
-            OutputAudio();
-        }
         if (bits & SCHEDULE_EVENT)
         {
-            std::unique_lock<std::mutex> lock(mutex_);
-            std::list<std::function<void()>> tasks = std::move(main_tasks_);
-            lock.unlock();
-            for (auto &task : tasks)
+            // Only what was queued before this pass, like the old list swap; tasks
+            // scheduled meanwhile set SCHEDULE_EVENT again
+            size_t pending = main_tasks_.size();
+            InlineTask task;
+            while (pending-- > 0 && main_tasks_.Pop(task))
             {
                 task();
+                task = nullptr;
             }
         }
         // }
@@ -848,78 +900,248 @@ void Application::MainLoop()
 
 void Application::ResetDecoder()
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    opus_decoder_->ResetState();
-    audio_decode_queue_.clear();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        audio_decode_queue_.clear();
+    }
+    decode_generation_++;
+    {
+        std::lock_guard<std::mutex> lock(decoder_mutex_);
+        opus_decoder_->ResetState();
+    }
+    if (pcm_ring_)
+    {
+        pcm_ring_->Discard();
+    }
 }
 void Application::Clearaudio()
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    opus_decoder_->ResetState();
-    audio_decode_queue_.clear();
+    ResetDecoder();
     // opus_encoder_->ResetState(); //加
-    last_output_time_ = std::chrono::steady_clock::now();
+    last_output_time_us_ = esp_timer_get_time();
 }
-void Application::OutputAudio()
+
+void Application::QueueAudioPacket(std::vector<uint8_t> &&opus)
 {
-    auto now = std::chrono::steady_clock::now();
-    auto codec = Board::GetInstance().GetAudioCodec();
-    const int max_silence_seconds = 10;
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (audio_decode_queue_.empty())
     {
-        // lock.unlock();
-        // Disable the output if there is no audio data for a long time
-        if (device_state_ == kDeviceStateIdle)
+        std::lock_guard<std::mutex> lock(mutex_);
+        audio_decode_queue_.emplace_back(std::move(opus));
+    }
+    xEventGroupSetBits(event_group_, AUDIO_DECODE_EVENT);
+}
+
+// Decoder task: turns queued opus packets into PCM ahead of playback
+void Application::AudioDecodeLoop()
+{
+    while (true)
+    {
+        xEventGroupWaitBits(event_group_, AUDIO_DECODE_EVENT, pdTRUE, pdFALSE, portMAX_DELAY);
+        while (true)
         {
-            auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_output_time_).count();
-            if (duration > max_silence_seconds)
+            std::vector<uint8_t> opus;
             {
-                codec->EnableOutput(false);
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (audio_decode_queue_.empty())
+                {
+                    break;
+                }
+                if (device_state_ == kDeviceStateListening)
+                {
+                    audio_decode_queue_.clear();
+                    break;
+                }
+                opus = std::move(audio_decode_queue_.front());
+                audio_decode_queue_.pop_front();
+                decoding_ = true;
+            }
+            DecodeToRing(std::move(opus));
+            // The decoder only reads the packet, so its buffer can go back to the pool
+            if (protocol_)
+            {
+                protocol_->RecycleAudioBuffer(std::move(opus));
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                decoding_ = false;
             }
         }
+    }
+}
+
+void Application::DecodeToRing(std::vector<uint8_t> &&opus)
+{
+    if (aborted_)
+    {
         return;
     }
+    auto codec = Board::GetInstance().GetAudioCodec();
+    uint32_t generation = decode_generation_;
 
-    if (device_state_ == kDeviceStateListening)
+    // decoded_pcm_ / resampled_pcm_ keep their capacity, so a frame costs no allocation
+    const int16_t *pcm;
+    size_t samples;
     {
-        audio_decode_queue_.clear();
+        std::lock_guard<std::mutex> lock(decoder_mutex_);
+        if (!opus_decoder_->Decode(std::move(opus), decoded_pcm_))
+        {
+            return;
+        }
+        pcm = decoded_pcm_.data();
+        samples = decoded_pcm_.size();
+
+        // Resample if the sample rate is different
+        if (opus_decode_sample_rate_ != codec->output_sample_rate())
+        {
+            resampled_pcm_.resize(output_resampler_.GetOutputSamples(samples));
+            output_resampler_.Process(pcm, samples, resampled_pcm_.data());
+            pcm = resampled_pcm_.data();
+            samples = resampled_pcm_.size();
+        }
+    }
+
+    // No ring (allocation failed): play the frame from here, as before the ring existed
+    if (pcm_ring_->capacity() == 0)
+    {
+        output_writing_ = true;
+        codec->OutputData(pcm, samples);
+        output_writing_ = false;
+        last_output_time_us_ = esp_timer_get_time();
         return;
     }
 
-    last_output_time_ = now;
-    auto opus = std::move(audio_decode_queue_.front());
-    audio_decode_queue_.pop_front();
-    lock.unlock();
+    // Wait for the output task to make room; give up if the decoder was reset meanwhile
+    while (samples > 0 && !aborted_ && generation == decode_generation_)
+    {
+        size_t written = pcm_ring_->Write(pcm, samples);
+        pcm += written;
+        samples -= written;
+        if (written > 0)
+        {
+            xEventGroupSetBits(event_group_, AUDIO_PCM_READY_EVENT);
+        }
+        if (samples > 0)
+        {
+            xEventGroupWaitBits(event_group_, AUDIO_PCM_SPACE_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(100));
+        }
+    }
+}
+
+// Nothing queued and nothing being decoded
+bool Application::IsDecoderIdle()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return audio_decode_queue_.empty() && !decoding_;
+}
+
+// ... and everything decoded has been written to the codec
+bool Application::IsPlaybackIdle()
+{
+    return IsDecoderIdle() && pcm_ring_->Empty() && !output_writing_;
+}
 
-    background_task_->Schedule([this, codec, opus = std::move(opus)]() mutable
-                               {
-        if (aborted_) {
-            return;
+void Application::WaitForPlaybackDrained(int timeout_ms)
+{
+    for (int waited = 0; waited < timeout_ms && !IsPlaybackIdle(); waited += 10)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+// Output task: feeds the codec from the PCM ring. Whenever the ring ran dry it
+// waits until CONFIG_AUDIO_OUTPUT_PREBUFFER_MS are buffered again (jitter
+// buffer), or until that long has passed with the decoder idle, which is the
+// case for a sound shorter than the target depth.
+void Application::AudioOutputLoop()
+{
+    auto codec = Board::GetInstance().GetAudioCodec();
+    // A target deeper than the ring could never be reached
+    const size_t prebuffer_samples = std::min<size_t>(codec->output_sample_rate() / 1000 * CONFIG_AUDIO_OUTPUT_PREBUFFER_MS,
+                                                      pcm_ring_->capacity());
+    // Small writes keep the reaction to aborts and resets short
+    const size_t chunk_samples = codec->output_sample_rate() / 1000 * 20;
+    const int64_t prebuffer_us = CONFIG_AUDIO_OUTPUT_PREBUFFER_MS * 1000;
+    const int64_t max_silence_us = 10 * 1000 * 1000;
+    bool prebuffering = true;
+    int64_t prebuffer_start_us = 0;
+    uint32_t underruns = 0;
+
+    while (true)
+    {
+        size_t available = pcm_ring_->ReadAvailable();
+        if (available == 0)
+        {
+            if (!prebuffering)
+            {
+                prebuffering = true;
+                if (!IsDecoderIdle())
+                {
+                    underruns++;
+                    ESP_LOGW(TAG, "Audio output underrun (%lu)", (unsigned long)underruns);
+                }
+            }
+            // Disable the output if there is no audio data for a long time
+            if (device_state_ == kDeviceStateIdle && codec->output_enabled() &&
+                esp_timer_get_time() - last_output_time_us_ > max_silence_us)
+            {
+                codec->EnableOutput(false);
+            }
+            prebuffer_start_us = 0;
+            xEventGroupWaitBits(event_group_, AUDIO_PCM_READY_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(1000));
+            continue;
         }
 
-        std::vector<int16_t> pcm;
-        if (!opus_decoder_->Decode(std::move(opus), pcm)) {
-            return;
+        if (prebuffering && available < prebuffer_samples)
+        {
+            int64_t now = esp_timer_get_time();
+            if (prebuffer_start_us == 0)
+            {
+                prebuffer_start_us = now;
+            }
+            if (now - prebuffer_start_us < prebuffer_us || !IsDecoderIdle())
+            {
+                xEventGroupWaitBits(event_group_, AUDIO_PCM_READY_EVENT, pdTRUE, pdFALSE, pdMS_TO_TICKS(20));
+                continue;
+            }
         }
+        prebuffering = false;
 
-        // Resample if the sample rate is different
-        if (opus_decode_sample_rate_ != codec->output_sample_rate()) {
-            int target_size = output_resampler_.GetOutputSamples(pcm.size());
-            std::vector<int16_t> resampled(target_size);
-            output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
-            pcm = std::move(resampled);
+        if (!codec->output_enabled())
+        {
+            vTaskDelay(pdMS_TO_TICKS(20));
+            continue;
         }
 
-        codec->OutputData(pcm); });
+        const int16_t *data;
+        size_t samples = pcm_ring_->Peek(&data);
+        if (samples > chunk_samples)
+        {
+            samples = chunk_samples;
+        }
+        output_writing_ = true;
+        codec->OutputData(data, samples);
+        pcm_ring_->Consume(samples);
+        output_writing_ = false;
+        last_output_time_us_ = esp_timer_get_time();
+        xEventGroupSetBits(event_group_, AUDIO_PCM_SPACE_EVENT);
+    }
 }
 
 void Application::InputAudio()
 {
     auto codec = Board::GetInstance().GetAudioCodec();
-    std::vector<int16_t> data;
-    if (!codec->InputData(data))
+    if (!codec->InputData(input_pcm_.data(), input_pcm_.size()))
+    {
+        return;
+    }
+
+    // 16 kHz PCM for the AFE / encoder, in a pool frame
+    AudioFrame frame = input_pool_->Acquire();
+    if (!frame)
     {
+        if ((input_pool_->exhausted_count() & 0x3F) == 1)
+        {
+            ESP_LOGW(TAG, "Audio input frame pool exhausted, dropped %lu frames", input_pool_->exhausted_count());
+        }
         return;
     }
 
@@ -927,54 +1149,93 @@ void Application::InputAudio()
     {
         if (codec->input_channels() == 2)
         {
-            auto mic_channel = std::vector<int16_t>(data.size() / 2);
-            auto reference_channel = std::vector<int16_t>(data.size() / 2);
-            for (size_t i = 0, j = 0; i < mic_channel.size(); ++i, j += 2)
-            {
-                mic_channel[i] = data[j];
-                reference_channel[i] = data[j + 1];
-            }
-            auto resampled_mic = std::vector<int16_t>(input_resampler_.GetOutputSamples(mic_channel.size()));
-            auto resampled_reference = std::vector<int16_t>(reference_resampler_.GetOutputSamples(reference_channel.size()));
-            input_resampler_.Process(mic_channel.data(), mic_channel.size(), resampled_mic.data());
-            reference_resampler_.Process(reference_channel.data(), reference_channel.size(), resampled_reference.data());
-            data.resize(resampled_mic.size() + resampled_reference.size());
-            for (size_t i = 0, j = 0; i < resampled_mic.size(); ++i, j += 2)
-            {
-                data[j] = resampled_mic[i];
-                data[j + 1] = resampled_reference[i];
-            }
+            audio_dsp::Deinterleave(input_pcm_.data(), mic_pcm_.data(), reference_pcm_.data(), mic_pcm_.size());
+            input_resampler_.Process(mic_pcm_.data(), mic_pcm_.size(), resampled_mic_pcm_.data());
+            reference_resampler_.Process(reference_pcm_.data(), reference_pcm_.size(), resampled_reference_pcm_.data());
+            frame.resize(resampled_mic_pcm_.size() + resampled_reference_pcm_.size());
+            audio_dsp::Interleave(resampled_mic_pcm_.data(), resampled_reference_pcm_.data(), frame.data(), resampled_mic_pcm_.size());
         }
         else
         {
-            auto resampled = std::vector<int16_t>(input_resampler_.GetOutputSamples(data.size()));
-            input_resampler_.Process(data.data(), data.size(), resampled.data());
-            data = std::move(resampled);
+            frame.resize(resampled_mic_pcm_.size());
+            input_resampler_.Process(input_pcm_.data(), input_pcm_.size(), frame.data());
         }
     }
+    else
+    {
+        frame.resize(input_pcm_.size());
+        memcpy(frame.data(), input_pcm_.data(), frame.size() * sizeof(int16_t));
+    }
 
 #if CONFIG_USE_WAKE_WORD_DETECT
     if (wake_word_detect_.IsDetectionRunning())
     {
-        wake_word_detect_.Feed(data);
+        wake_word_detect_.Feed(frame.data(), frame.size());
     }
 #endif
 #if CONFIG_USE_WAKE_WORD_DETECT && CONFIG_USE_AUDIO_PROCESSOR
     if (audio_processor_.IsRunning())
     {
-        audio_processor_.Input(data);
+        audio_processor_.Input(frame.data(), frame.size());
     }
 #else
     if (device_state_ == kDeviceStateListening)
     {
-        background_task_->Schedule([this, data = std::move(data)]() mutable
-                                   { opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t> &&opus)
-                                                           { Schedule([this, opus = std::move(opus)]()
-                                                                      { protocol_->SendAudio(opus); }); }); });
+        QueueAudioFrame(std::move(frame));
     }
 #endif
 }
 
+// Hand a frame to the encoder on the background task; the frame crosses by slot index
+void Application::QueueAudioFrame(AudioFrame &&frame)
+{
+    int index = frame.Detach();
+    if (xQueueSend(encode_queue_, &index, 0) != pdTRUE)
+    {
+        input_pool_->Adopt(index);
+        ESP_LOGW(TAG, "Audio encode queue full, frame dropped");
+        return;
+    }
+    if (!encode_scheduled_.exchange(true))
+    {
+        background_task_->Schedule(kBackgroundLaneAudio, [this]()
+                                   { EncodeQueuedAudio(); });
+    }
+}
+
+// AFE output: copy into pool frames (the AFE buffer is reused after the callback)
+void Application::QueueAudioFrame(const int16_t *data, size_t samples)
+{
+    while (samples > 0)
+    {
+        AudioFrame frame = input_pool_->Acquire();
+        if (!frame)
+        {
+            ESP_LOGW(TAG, "Audio input frame pool exhausted, dropped %u samples", (unsigned)samples);
+            return;
+        }
+        frame.resize(samples);
+        memcpy(frame.data(), data, frame.size() * sizeof(int16_t));
+        data += frame.size();
+        samples -= frame.size();
+        QueueAudioFrame(std::move(frame));
+    }
+}
+
+void Application::EncodeQueuedAudio()
+{
+    // Cleared first: a frame queued from now on schedules another pass
+    encode_scheduled_ = false;
+    int index;
+    while (xQueueReceive(encode_queue_, &index, 0) == pdTRUE)
+    {
+        AudioFrame frame = input_pool_->Adopt(index);
+        opus_encoder_->Encode(frame.data(), frame.size(), [this](const uint8_t *opus, size_t size)
+                              {
+            protocol_->SendAudio(opus, size); });
+    }
+}
+
 void Application::AbortSpeaking(AbortReason reason)
 {
     ESP_LOGI(TAG, "Abort speaking");
@@ -996,8 +1257,13 @@ void Application::SetDeviceState(DeviceState state)
     auto previous_state = device_state_;
     device_state_ = state;
     ESP_LOGI(TAG, "STATE: %s", STATE_STRINGS[device_state_]);
-    // The state is changed, wait for all background tasks to finish
-    background_task_->WaitForCompletion();
+    // The state is changed, wait for the queued audio to be encoded. The slideshow
+    // on the bulk lane stops by itself outside idle; pending auto-shows are dropped.
+    if (state != kDeviceStateIdle)
+    {
+        CancelAutoShow();
+    }
+    background_task_->WaitForCompletion(kBackgroundLaneAudio);
     auto &board = Board::GetInstance();
     auto codec = board.GetAudioCodec();
     auto display = board.GetDisplay();
@@ -1112,6 +1378,7 @@ void Application::SetDecodeSampleRate(int sample_rate)
         return;
     }
 
+    std::lock_guard<std::mutex> lock(decoder_mutex_);
     opus_decode_sample_rate_ = sample_rate;
     opus_decoder_.reset();
     opus_decoder_ = std::make_unique<OpusDecoderWrapper>(opus_decode_sample_rate_, 1);
@@ -1127,10 +1394,9 @@ void Application::SetDecodeSampleRate(int sample_rate)
 void Application::UpdateIotStates()
 {
     auto &thing_manager = iot::ThingManager::GetInstance();
-    std::string states;
-    if (thing_manager.GetStatesJson(states, true))
+    if (thing_manager.GetStatesJson(iot_states_, true))
     {
-        protocol_->SendIotStates(states);
+        protocol_->SendIotStates(iot_states_);
     }
 }
 
@@ -1238,6 +1504,18 @@ void Application::PrintMemoryInfo()
     uint32_t largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
     ESP_LOGI(TAG, "Largest free block (Internal): %lu bytes", largest_block);
 
+#if CONFIG_USE_WAKE_WORD_DETECT
+    auto feed = wake_word_detect_.GetFeedStats();
+    ESP_LOGI(TAG, "Wake word AFE feed - High watermark: %u/%u samples, Overruns: %lu, Dropped: %lu",
+             (unsigned)feed.high_watermark, (unsigned)feed.capacity, feed.overruns, feed.dropped_samples);
+#endif
+#if CONFIG_USE_AUDIO_PROCESSOR
+    auto processor_feed = audio_processor_.GetFeedStats();
+    ESP_LOGI(TAG, "Processor AFE feed - High watermark: %u/%u samples, Overruns: %lu, Dropped: %lu",
+             (unsigned)processor_feed.high_watermark, (unsigned)processor_feed.capacity,
+             processor_feed.overruns, processor_feed.dropped_samples);
+#endif
+
     ESP_LOGI(TAG, "================================");
 }
 
@@ -1319,167 +1597,8 @@ bool Application::IsGifPlaying() const
     return display ? display->IsGifPlaying() : false;
 }
 
-// Load a GIF from storage into PSRAM buffer (no display). Caller must free *out_buf with heap_caps_free.
-static bool LoadGifFromStorage(const char* filename, uint8_t** out_buf, size_t* out_len) {
-    if (!filename || !out_buf || !out_len) return false;
-    *out_buf = nullptr;
-    *out_len = 0;
-
-    ESP_LOGI(TAG, "Loading GIF from storage: %s", filename);
-
-    // Use gif_storage_read which allocates in PSRAM (same as DownloadGifToPsram)
-    uint8_t* buf = nullptr;
-    size_t len = 0;
-    esp_err_t ret = gif_storage_read(filename, &buf, &len);
-
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to load GIF from storage: %s", esp_err_to_name(ret));
-        return false;
-    }
-
-    // Validate GIF header (same validation as DownloadGifToPsram)
-    if (len < 6 || (memcmp(buf, "GIF87a", 6) != 0 && memcmp(buf, "GIF89a", 6) != 0)) {
-        ESP_LOGE(TAG, "Invalid GIF file: %s", filename);
-        heap_caps_free(buf);
-        return false;
-    }
-
-    *out_buf = buf;
-    *out_len = len;
-    ESP_LOGI(TAG, "Loaded GIF from storage: %s (%zu bytes)", filename, len);
-    return true;
-}
-
-// Download a GIF into PSRAM buffer (no display). Caller must free *out_buf with heap_caps_free.
-static bool DownloadGifToPsram(const char* url, uint8_t** out_buf, size_t* out_len) {
-    if (!url || !out_buf || !out_len) return false;
-    *out_buf = nullptr;
-    *out_len = 0;
-
-    const int kMaxRetries = 2;           // restart whole download up to 2 times
-    const size_t kDefaultCap = 512 * 1024;
-    const size_t kMaxSize   = 10 * 1024 * 1024; // 10MB cap
-    const int kRxChunk = 16384;                 // read chunk goes directly into PSRAM dest buffer
-
-    for (int attempt = 0; attempt <= kMaxRetries; ++attempt) {
-        esp_http_client_config_t cfg = {};
-        cfg.url = url;
-        cfg.timeout_ms = 60000;          // increase socket timeout
-        // Keep esp_http_client internal RX buffer small to save SRAM; data goes to PSRAM via read()
-        cfg.buffer_size = 2048;          // small header/parse buffer in SRAM
-        cfg.buffer_size_tx = 2048;
-        cfg.keep_alive_enable = false;   // avoid keep-alive surprises on some servers
-        if (strncmp(url, "https://", 8) == 0) {
-            cfg.use_global_ca_store = true;
-            cfg.crt_bundle_attach = esp_crt_bundle_attach;
-        }
-
-        esp_http_client_handle_t client = esp_http_client_init(&cfg);
-        if (!client) {
-            ESP_LOGE(TAG, "Download init failed (attempt %d)", attempt + 1);
-            continue;
-        }
-
-        esp_err_t err = esp_http_client_open(client, 0);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "HTTP open failed: %s (attempt %d)", esp_err_to_name(err), attempt + 1);
-            esp_http_client_cleanup(client);
-            continue;
-        }
-
-        // Fetch headers and get content length if provided
-        esp_http_client_fetch_headers(client);
-        int content_length = esp_http_client_get_content_length(client);
-        size_t cap = kDefaultCap;
-        if (content_length > 0) {
-            cap = (size_t)content_length;
-            if (cap > kMaxSize) {
-                ESP_LOGE(TAG, "File too large: %d bytes", content_length);
-                esp_http_client_close(client);
-                esp_http_client_cleanup(client);
-                return false;
-            }
-        }
-
-        uint8_t* buf = (uint8_t*)heap_caps_malloc(cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        if (!buf) {
-            ESP_LOGE(TAG, "PSRAM alloc failed: %u bytes", (unsigned)cap);
-            esp_http_client_close(client);
-            esp_http_client_cleanup(client);
-            return false;
-        }
-
-        size_t pos = 0;
-        size_t last_progress = 0;
-        size_t last_yield_bytes = 0;
-        const size_t kYieldEvery = 64 * 1024;
-
-        bool ok = true;
-        while (true) {
-            int r = esp_http_client_read(client, (char*)buf + pos, kRxChunk);
-            if (r < 0) {
-                ESP_LOGE(TAG, "HTTP read error: %d (attempt %d)", r, attempt + 1);
-                ok = false;
-                break;
-            }
-            if (r == 0) break; // done
-            pos += (size_t)r;
-
-            // Grow if needed for unknown content length
-            if (pos > cap) {
-                size_t new_cap = cap * 2;
-                if (new_cap < pos) new_cap = pos;
-                if (new_cap > kMaxSize) {
-                    ESP_LOGE(TAG, "Download exceeds max cap (%u > %u)", (unsigned)new_cap, (unsigned)kMaxSize);
-                    ok = false;
-                    break;
-                }
-                uint8_t* nb = (uint8_t*)heap_caps_realloc(buf, new_cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-                if (!nb) {
-                    ESP_LOGE(TAG, "PSRAM realloc failed: %u bytes", (unsigned)new_cap);
-                    ok = false;
-                    break;
-                }
-                buf = nb;
-                cap = new_cap;
-            }
-
-            // Progress (if content length known)
-            if (content_length > 0) {
-                size_t prog = (pos * 100) / (size_t)content_length;
-                if (prog >= last_progress + 20) {
-                    ESP_LOGI(TAG, "Download progress: %u%% (%u/%u bytes)", (unsigned)prog, (unsigned)pos, (unsigned)content_length);
-                    last_progress = prog;
-                }
-            }
-            // Yield periodically to feed WDT
-            if (pos - last_yield_bytes >= kYieldEvery) {
-                vTaskDelay(1);
-                last_yield_bytes = pos;
-            }
-        }
-
-        int status = esp_http_client_get_status_code(client);
-        esp_http_client_close(client);
-        esp_http_client_cleanup(client);
-
-        if (ok && (status == 200 || status == 206) && pos >= 6 && (memcmp(buf, "GIF87a", 6) == 0 || memcmp(buf, "GIF89a", 6) == 0)) {
-            *out_buf = buf;
-            *out_len = pos;
-            ESP_LOGI(TAG, "Downloaded GIF: %u bytes", (unsigned)pos);
-            return true;
-        }
-
-        // failure path
-        ESP_LOGE(TAG, "Download failed: status=%d, size=%u (attempt %d)", status, (unsigned)pos, attempt + 1);
-        heap_caps_free(buf);
-        if (attempt < kMaxRetries) {
-            vTaskDelay(pdMS_TO_TICKS(500 * (attempt + 1))); // backoff before retry
-        }
-    }
-
-    return false;
-}
+// Slideshow window: below this much free PSRAM only the current item stays resident
+static constexpr size_t kSlideShowMinFreePsram = 2 * 1024 * 1024;
 
 bool Application::IsSlideShowRunning() const
 {
@@ -1550,7 +1669,7 @@ void Application::SlideShowGeneric(bool from_url)
     stop_slideshow_ = false;
     slideshow_running_ = true;
 
-    background_task_->Schedule([this, from_url]() {
+    background_task_->Schedule(kBackgroundLaneBulk, [this, from_url]() {
         struct TimerHoldGuard {
             PowerSaveTimer* timer = nullptr;
             TimerHoldGuard() {
@@ -1617,79 +1736,141 @@ void Application::SlideShowGeneric(bool from_url)
 
         const int kCount = gif_sources.size();
 
-        ESP_LOGI(TAG, "SlideShow started (preload + loop) (%d items) from %s", kCount, from_url ? "URL" : "storage");
-
-        // Ensure no decoding during preload phase
-        if (auto display = Board::GetInstance().GetDisplay()) {
-            display->HideGif();
-        }
-
-        struct PreGif { uint8_t* data; size_t size; std::string source; };
-        std::vector<PreGif> items(kCount);
-        for (int i = 0; i < kCount; ++i) {
-            items[i].data = nullptr;
-            items[i].size = 0;
-            items[i].source = gif_sources[i];
-        }
-
-        int loaded = 0;
-        // Load all GIFs first (no decoding)
-        for (int i = 0; i < kCount && !stop_slideshow_; ++i) {
-            if (device_state_ != kDeviceStateIdle) {
-                ESP_LOGW(TAG, "Device not idle, abort SlideShow preload");
-                stop_slideshow_ = true;
-                break;
+        ESP_LOGI(TAG, "SlideShow started (lazy window) (%d items) from %s", kCount, from_url ? "URL" : "storage");
+
+        // Only the current item and its neighbours (N-1, N+1) stay resident. Stored GIFs are
+        // streamed from flash by the display, so the window only holds URL downloads.
+        // Neighbours are fetched concurrently by GifDownloader workers; the state is shared
+        // with their callbacks, which may complete after the slideshow has ended.
+        struct SlideItem { uint8_t* data = nullptr; size_t size = 0; bool failed = false; bool pending = false; };
+        struct SlideState { std::mutex mutex; std::vector<SlideItem> items; bool closed = false; };
+        auto state = std::make_shared<SlideState>();
+        state->items.resize(kCount);
+        auto& downloader = GifDownloader::GetInstance();
+        auto wrap = [kCount](int i) { return ((i % kCount) + kCount) % kCount; };
+        auto psram_low = []() {
+            return heap_caps_get_free_size(MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) < kSlideShowMinFreePsram;
+        };
+        auto release_locked = [&state](int i) {
+            SlideItem& item = state->items[i];
+            if (item.data) {
+                heap_caps_free(item.data);
+                item.data = nullptr;
+                item.size = 0;
             }
-            ESP_LOGI(TAG, "Pre-load %d/%d: %s", i + 1, kCount, gif_sources[i].c_str());
-            uint8_t* buf = nullptr; size_t len = 0;
-            bool success = false;
-
-            if (from_url) {
-                success = DownloadGifToPsram(gif_sources[i].c_str(), &buf, &len);
-            } else {
-                success = LoadGifFromStorage(gif_sources[i].c_str(), &buf, &len);
+        };
+        // Make item i showable; false if it failed to load (now or earlier)
+        auto ensure_loaded = [&](int i) -> bool {
+            if (!from_url) return true;
+            while (!stop_slideshow_) {
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    SlideItem& item = state->items[i];
+                    if (item.data) return true;
+                    if (item.failed) return false;
+                    if (!item.pending) {
+                        item.pending = true;
+                        break;
+                    }
+                }
+                // A prefetch of this item is already running
+                vTaskDelay(pdMS_TO_TICKS(50));
             }
-
-            if (success) {
-                items[loaded].data = buf;
-                items[loaded].size = len;
-                items[loaded].source = gif_sources[i];
-                ++loaded;
-            } else {
-                if (buf) heap_caps_free(buf);
-                ESP_LOGE(TAG, "Pre-load failed: %s", gif_sources[i].c_str());
+            if (stop_slideshow_) return false;
+            ESP_LOGI(TAG, "SlideShow loading %d/%d: %s", i + 1, kCount, gif_sources[i].c_str());
+            uint8_t* data = nullptr;
+            size_t size = 0;
+            bool ok = downloader.Download(gif_sources[i], &data, &size);
+            std::lock_guard<std::mutex> lock(state->mutex);
+            SlideItem& item = state->items[i];
+            item.pending = false;
+            item.data = data;
+            item.size = size;
+            item.failed = !ok;
+            if (!ok) {
+                ESP_LOGE(TAG, "SlideShow load failed: %s", gif_sources[i].c_str());
             }
-            vTaskDelay(1);
-        }
-
-        if (loaded == 0 || stop_slideshow_) {
-            ESP_LOGW(TAG, "No GIFs preloaded or slideshow stopped during preload");
-            if (auto display = Board::GetInstance().GetDisplay()) display->HideGif();
-            for (int i = 0; i < loaded; ++i) if (items[i].data) heap_caps_free(items[i].data);
-            stop_slideshow_ = false;
-            slideshow_running_ = false;
-            ESP_LOGI(TAG, "SlideShow finished");
-            return;
-        }
-
-        ESP_LOGI(TAG, "Pre-load completed: %d/%d", loaded, kCount);
+            return ok;
+        };
+        auto prefetch = [&](int i) {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                SlideItem& item = state->items[i];
+                if (item.data || item.failed || item.pending) return;
+                item.pending = true;
+            }
+            ESP_LOGI(TAG, "SlideShow prefetch %d/%d: %s", i + 1, kCount, gif_sources[i].c_str());
+            downloader.DownloadAsync(gif_sources[i], [state, i](uint8_t* data, size_t size) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->closed) {
+                    heap_caps_free(data);
+                    return;
+                }
+                SlideItem& item = state->items[i];
+                item.pending = false;
+                item.data = data;
+                item.size = size;
+                item.failed = (data == nullptr);
+            });
+        };
+        // Drop buffers outside the window; under PSRAM pressure keep only the current item.
+        // The previous item's decoder is gone once ShowGif() returns, so its buffer is free to go.
+        auto trim_window = [&](int current) {
+            bool low = psram_low();
+            std::lock_guard<std::mutex> lock(state->mutex);
+            for (int i = 0; i < kCount; ++i) {
+                if (i == current || !state->items[i].data) continue;
+                bool neighbour = (i == wrap(current - 1) || i == wrap(current + 1));
+                if (!neighbour || low) {
+                    ESP_LOGI(TAG, "SlideShow release %d/%d%s", i + 1, kCount, low ? " (PSRAM low)" : "");
+                    release_locked(i);
+                }
+            }
+        };
 
-        // Display phase (no loading)
         int index = 0;
+        int direction = 1;  // last swipe direction, prefetched first
         while (!stop_slideshow_) {
             if (device_state_ != kDeviceStateIdle) {
                 ESP_LOGW(TAG, "Device state changed, abort SlideShow");
                 stop_slideshow_ = true;
                 break;
             }
-            // Normalize index
-            if (index < 0) index = (loaded - 1);
-            if (index >= loaded) index = 0;
 
-            ESP_LOGI(TAG, "SlideShow showing %d/%d: %s", index + 1, loaded, items[index].source.c_str());
+            // Load on demand, skipping broken items in the swipe direction
+            index = wrap(index);
+            int tries = 0;
+            while (tries < kCount && !stop_slideshow_ && !ensure_loaded(index)) {
+                index = wrap(index + direction);
+                ++tries;
+            }
+            if (tries == kCount) {
+                ESP_LOGE(TAG, "SlideShow: no item could be loaded");
+                break;
+            }
+            if (stop_slideshow_) break;
+
+            ESP_LOGI(TAG, "SlideShow showing %d/%d: %s", index + 1, kCount, gif_sources[index].c_str());
             if (auto display = Board::GetInstance().GetDisplay()) {
-                display->ShowGif(items[index].data, items[index].size, 0, 0);
+                uint8_t* data;
+                size_t size;
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    data = state->items[index].data;
+                    size = state->items[index].size;
+                }
+                if (data) {
+                    display->ShowGif(data, size, 0, 0);
+                } else {
+                    display->ShowGifFromFlash(gif_sources[index].c_str(), 0, 0);
+                }
             }
+            trim_window(index);
+            if (from_url && kCount > 1 && !psram_low()) {
+                prefetch(wrap(index + direction));
+                prefetch(wrap(index - direction));
+            }
+
             // wait for user swipe to change item; do not auto-advance when GIF finishes
             while (!stop_slideshow_) {
                 if (device_state_ != kDeviceStateIdle) {
@@ -1699,26 +1880,30 @@ void Application::SlideShowGeneric(bool from_url)
                 }
                 int skip = slideshow_skip_.exchange(0);
                 if (skip != 0) {
+                    direction = (skip > 0) ? 1 : -1;
                     index += skip; // -1 prev, +1 next (from gesture)
                     // Add delay to allow previous GIF cleanup to complete
                     // This prevents concurrent decoder tasks from corrupting heap
                     vTaskDelay(pdMS_TO_TICKS(300));
-                    goto next_item;
+                    break;
                 }
                 // Keep current GIF looping until user swipes to change item
                 vTaskDelay(pdMS_TO_TICKS(100));
+                // Prefetches land in the background; re-apply the window limits
+                trim_window(index);
             }
-            // no automatic index change here; wait strictly for gestures
-        next_item:
-            continue;
         }
 
-        // Clean up display and free preloaded buffers
+        // Clean up display and free the resident window; late prefetches free their own data
         if (auto display = Board::GetInstance().GetDisplay())
             display->HideGif();
-        for (int i = 0; i < loaded; ++i) {
-            if (items[i].data)
-                heap_caps_free(items[i].data);
+        downloader.CancelPending();
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->closed = true;
+            for (int i = 0; i < kCount; ++i) {
+                release_locked(i);
+            }
         }
         stop_slideshow_ = false;
         slideshow_running_ = false;
@@ -1738,8 +1923,27 @@ void Application::SlideShow()
 }
 
 
+// Delayed slideshow triggers run on the interactive lane; a new one supersedes the old
+void Application::ScheduleAutoShow(InlineTask callback)
+{
+    CancellationToken token = CancellationToken::Create();
+    {
+        std::lock_guard<std::mutex> lock(auto_show_mutex_);
+        auto_show_token_.Cancel();
+        auto_show_token_ = token;
+    }
+    background_task_->Schedule(kBackgroundLaneInteractive, std::move(callback), token);
+}
+
+void Application::CancelAutoShow()
+{
+    std::lock_guard<std::mutex> lock(auto_show_mutex_);
+    auto_show_token_.Cancel();
+}
+
 void Application::StopSlideShow()
 {
+    CancelAutoShow();
     if (!slideshow_running_) return;
     stop_slideshow_ = true;
     ESP_LOGI(TAG, "SlideShow stop requested");
@@ -1753,76 +1957,102 @@ bool Application::StartImageUploadServer(const std::string& ssid_prefix) {
         return true;
     }
 
-    // 设置图片接收回调
-    server.SetImageReceivedCallback([this](const uint8_t* data, size_t size, const std::string& filename, time_t upload_time) {
-        ESP_LOGI(TAG, "Received image: %s, size: %zu bytes", filename.c_str(), size);
-
-        auto image_buffer = std::make_shared<std::vector<uint8_t>>(data, data + size);
-        auto filename_copy = filename;
-        auto upload_time_copy = upload_time;
+    // 上传的文件边接收边写入存储，不再整体缓存在内存中
+    struct UploadState {
+        gif_storage_writer_t* writer = nullptr;
+        std::string filename;
+        size_t written = 0;
+        time_t upload_time = 0;
+    };
+    auto upload = std::make_shared<UploadState>();
+
+    ImageUploadServer::UploadSink sink;
+    sink.begin = [upload](const std::string& filename, size_t size_hint, time_t upload_time) {
+        ESP_LOGI(TAG, "Receiving image: %s, up to %zu bytes", filename.c_str(), size_hint);
+        // Hidden names belong to storage internals (download cache, metadata)
+        if (filename.empty() || filename[0] == '.') {
+            ESP_LOGE(TAG, "Invalid upload filename: %s", filename.c_str());
+            return false;
+        }
+        gif_storage_evict_plan_t plan = {};
+        MakeRoomForUpload(size_hint, false, &plan);
+        gif_storage_free_evict_plan(&plan);
 
-        background_task_->Schedule([this, image_buffer, filename_copy, upload_time_copy]() {
-            size_t total_bytes = 0, used_bytes = 0;
-            gif_storage_info(&total_bytes, &used_bytes);
-            size_t free_bytes = total_bytes - used_bytes;
-            ESP_LOGI(TAG, "Storage info: %zu total, %zu used, %zu free", total_bytes, used_bytes, free_bytes);
+        esp_err_t ret = gif_storage_open_write(filename.c_str(), size_hint, &upload->writer);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to open %s for writing (%s)", filename.c_str(), esp_err_to_name(ret));
+            return false;
+        }
+        gif_storage_writer_set_progress_callback(upload->writer, GifStorageProgressBridge,
+                                                 &ImageUploadServer::GetInstance());
+        upload->filename = filename;
+        upload->written = 0;
+        upload->upload_time = upload_time;
+        return true;
+    };
+    sink.write = [upload](const uint8_t* data, size_t size) {
+        if (!upload->writer || gif_storage_append(upload->writer, data, size) != ESP_OK) {
+            ESP_LOGE(TAG, "Write failed at offset %zu", upload->written);
+            return false;
+        }
+        upload->written += size;
+        return true;
+    };
+    sink.abort = [upload]() {
+        if (upload->writer) {
+            gif_storage_abort(upload->writer);
+            upload->writer = nullptr;
+        }
+        ImageUploadServer::GetInstance().NotifyStorageResult(false, "保存失败");
+    };
+    sink.finish = [this, upload]() {
+        auto& upload_server = ImageUploadServer::GetInstance();
+        std::string filename = upload->filename;
+        bool ok = false;
+        if (upload->writer) {
+            if (upload->written > 0) {
+                ok = gif_storage_commit(upload->writer) == ESP_OK;
+            } else {
+                gif_storage_abort(upload->writer);
+            }
+            upload->writer = nullptr;
+        }
 
-            if (free_bytes < image_buffer->size() + 100000) {
-                ESP_LOGW(TAG, "Storage space low (%zu bytes free, need %zu), clearing old files", free_bytes, image_buffer->size());
-                storage_files.clear();
-                gif_storage_list(collect_file_callback, nullptr);
+        if (!ok) {
+            ESP_LOGE(TAG, "Failed to save image to storage: %s", filename.c_str());
+            upload_server.NotifyStorageResult(false, "保存失败");
+            Schedule([this, filename]() {
+                auto display = Board::GetInstance().GetDisplay();
+                if (display) {
+                    std::string message = std::string("保存失败: ") + filename;
+                    display->ShowNotification(message.c_str(), 3000);
+                }
+            });
+            return false;
+        }
 
-                for (const auto& old_file : storage_files) {
-                    ESP_LOGI(TAG, "Deleting old file: %s", old_file.c_str());
-                    gif_storage_delete(old_file.c_str());
+        ESP_LOGI(TAG, "Image saved to storage: %s (%zu bytes)", filename.c_str(), upload->written);
+        upload_server.NotifyStorageResult(true, "上传并保存成功");
+        gif_storage_set_upload_time(filename.c_str(), upload->upload_time);
+        OfflineImageManager::GetInstance().RefreshImageList(true);
 
-                    gif_storage_info(&total_bytes, &used_bytes);
-                    free_bytes = total_bytes - used_bytes;
-                    if (free_bytes >= image_buffer->size() + 100000) {
-                        ESP_LOGI(TAG, "Sufficient space available after cleanup: %zu bytes", free_bytes);
-                        break;
-                    }
+        Schedule([this, filename]() {
+            auto display = Board::GetInstance().GetDisplay();
+            if (display) {
+                std::string message = std::string("图片已保存: ") + filename;
+                auto lcd_display = static_cast<LcdDisplay*>(display);
+                if (lcd_display) {
+                    lcd_display->ShowCenterMessage(message.c_str(), 3000);
                 }
             }
-
-            auto& upload_server = ImageUploadServer::GetInstance();
-            upload_server.NotifyStorageStart(image_buffer->size());
-            gif_storage_set_progress_callback(GifStorageProgressBridge, &upload_server);
-
-            esp_err_t ret = gif_storage_write(filename_copy.c_str(), image_buffer->data(), image_buffer->size());
-            gif_storage_set_progress_callback(nullptr, nullptr);
-
-            if (ret == ESP_OK) {
-                ESP_LOGI(TAG, "Image saved to storage: %s", filename_copy.c_str());
-                upload_server.NotifyStorageResult(true, "上传并保存成功");
-                gif_storage_set_upload_time(filename_copy.c_str(), upload_time_copy);
-                OfflineImageManager::GetInstance().RefreshImageList(true);
-
-                Schedule([this, filename_copy]() {
-                    auto display = Board::GetInstance().GetDisplay();
-                    if (display) {
-                        std::string message = std::string("图片已保存: ") + filename_copy;
-                        auto lcd_display = static_cast<LcdDisplay*>(display);
-                        if (lcd_display) {
-                            lcd_display->ShowCenterMessage(message.c_str(), 3000);
-                        }
-                    }
-                });
-            } else {
-                ESP_LOGE(TAG, "Failed to save image to storage: %s", filename_copy.c_str());
-                upload_server.NotifyStorageResult(false, "保存失败");
-
-                Schedule([this, filename_copy]() {
-                    auto display = Board::GetInstance().GetDisplay();
-                    if (display) {
-                        std::string message = std::string("保存失败: ") + filename_copy;
-                        display->ShowNotification(message.c_str(), 3000);
-                    }
-                });
-            }
-            ESP_LOGI(TAG, "GIF uploaded successfully: %s, upload service remains active", filename_copy.c_str());
         });
-    });
+        ESP_LOGI(TAG, "GIF uploaded successfully: %s, upload service remains active", filename.c_str());
+        return true;
+    };
+    sink.preview_eviction = [](size_t size, gif_storage_evict_plan_t* plan) {
+        return MakeRoomForUpload(size, true, plan);
+    };
+    server.SetUploadSink(std::move(sink));
 
     bool success = server.Start(ssid_prefix);
     if (success) {
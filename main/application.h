@@ -4,11 +4,13 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 #include <freertos/task.h>
+#include <freertos/queue.h>
 #include <esp_timer.h>
 
 #include <string>
 #include <mutex>
-#include <list>
+#include <deque>
+#include <vector>
 #include <atomic>
 #include <chrono>
 #include <memory>
@@ -20,6 +22,9 @@
 #include "protocol.h"
 #include "ota.h"
 #include "background_task.h"
+#include "pcm_ring_buffer.h"
+#include "audio_frame_pool.h"
+#include "opus_frame_encoder.h"
 #include "offline_image_manager.h"
 
 #if CONFIG_USE_WAKE_WORD_DETECT
@@ -31,7 +36,9 @@
 
 #define SCHEDULE_EVENT (1 << 0)
 #define AUDIO_INPUT_READY_EVENT (1 << 1)
-#define AUDIO_OUTPUT_READY_EVENT (1 << 2)
+#define AUDIO_DECODE_EVENT (1 << 2)      // opus packets queued for the decoder task
+#define AUDIO_PCM_READY_EVENT (1 << 3)   // decoded PCM written to the ring
+#define AUDIO_PCM_SPACE_EVENT (1 << 4)   // output task freed ring space
 
 enum DeviceState {
     kDeviceStateUnknown,
@@ -47,6 +54,7 @@ enum DeviceState {
 };
 
 #define OPUS_FRAME_DURATION_MS 60
+#define AUDIO_INPUT_FRAME_POOL_SIZE 6    // 30 ms capture frames in flight between the mic and the encoder
 
 class Application {
 public:
@@ -61,7 +69,7 @@ public:
     void Start();
     DeviceState GetDeviceState() const { return device_state_; }
     bool IsVoiceDetected() const { return voice_detected_; }
-    void Schedule(std::function<void()> callback);
+    void Schedule(InlineTask callback);
     void SetDeviceState(DeviceState state);
     void Alert(const char* status, const char* message, const char* emotion = "", const std::string_view& sound = "");
     void DismissAlert();
@@ -125,7 +133,7 @@ private:
 #endif
     Ota ota_;
     std::mutex mutex_;
-    std::list<std::function<void()>> main_tasks_;
+    MpscQueue<InlineTask, 16> main_tasks_;     // lock-free, drained by MainLoop
     std::unique_ptr<Protocol> protocol_;
     EventGroupHandle_t event_group_ = nullptr;
     esp_timer_handle_t clock_timer_handle_ = nullptr;
@@ -134,17 +142,40 @@ private:
     bool aborted_ = false;
     bool voice_detected_ = false;
     int clock_ticks_ = 0;
+    std::string iot_states_;                    // UpdateIotStates() buffer, capacity kept
 
     // Slideshow control flags
     std::atomic<bool> slideshow_running_{false};
     std::atomic<bool> stop_slideshow_{false};
+    std::mutex auto_show_mutex_;
+    CancellationToken auto_show_token_;         // pending delayed auto-show
 
     // Audio encode / decode
     BackgroundTask* background_task_ = nullptr;
-    std::chrono::steady_clock::time_point last_output_time_;
-    std::list<std::vector<uint8_t>> audio_decode_queue_;
-
-    std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
+    std::atomic<int64_t> last_output_time_us_{0};
+    std::deque<std::vector<uint8_t>> audio_decode_queue_;   // guarded by mutex_
+
+    // Decoded playback: audio_decoder task → pcm_ring_ → audio_output task → codec
+    std::mutex decoder_mutex_;                  // opus_decoder_, output_resampler_, opus_decode_sample_rate_
+    std::unique_ptr<PcmRingBuffer> pcm_ring_;
+    std::vector<int16_t> decoded_pcm_;          // decoder task only, capacity kept across frames
+    std::vector<int16_t> resampled_pcm_;        // decoder task only
+    bool decoding_ = false;                     // guarded by mutex_, a packet is between queue and ring
+    std::atomic<uint32_t> decode_generation_{0};  // bumped by ResetDecoder() to drop in-flight PCM
+    std::atomic<bool> output_writing_{false};
+
+    // Capture: codec → 16 kHz pool frame → AFE / encode queue → background task → protocol.
+    // Frames travel by pool slot index, so listening does not touch the heap.
+    std::unique_ptr<AudioFramePool> input_pool_;
+    QueueHandle_t encode_queue_ = nullptr;
+    std::atomic<bool> encode_scheduled_{false};
+    std::vector<int16_t> input_pcm_;            // main loop only, raw codec frame
+    std::vector<int16_t> mic_pcm_;              // main loop only, deinterleave / resample scratch
+    std::vector<int16_t> reference_pcm_;
+    std::vector<int16_t> resampled_mic_pcm_;
+    std::vector<int16_t> resampled_reference_pcm_;
+
+    std::unique_ptr<OpusFrameEncoder> opus_encoder_;
     std::unique_ptr<OpusDecoderWrapper> opus_decoder_;
 
     int opus_decode_sample_rate_ = -1;
@@ -154,7 +185,18 @@ private:
 
     void MainLoop();
     void InputAudio();
-    void OutputAudio();
+    void ScheduleAutoShow(InlineTask callback);
+    void CancelAutoShow();
+    void QueueAudioFrame(AudioFrame&& frame);
+    void QueueAudioFrame(const int16_t* data, size_t samples);
+    void EncodeQueuedAudio();
+    void QueueAudioPacket(std::vector<uint8_t>&& opus);
+    void AudioDecodeLoop();
+    void DecodeToRing(std::vector<uint8_t>&& opus);
+    void AudioOutputLoop();
+    bool IsDecoderIdle();
+    bool IsPlaybackIdle();
+    void WaitForPlaybackDrained(int timeout_ms = 10000);
     void ResetDecoder();
     void SetDecodeSampleRate(int sample_rate);
     void CheckNewVersion();
@@ -26,16 +26,17 @@ void AudioCodec::OutputData(std::vector<int16_t>& data) {
     Write(data.data(), data.size());
 }
 
+void AudioCodec::OutputData(const int16_t* data, size_t samples) {
+    Write(data, samples);
+}
+
 bool AudioCodec::InputData(std::vector<int16_t>& data) {
-    int duration = 30;
-    int input_frame_size = input_sample_rate_ / 1000 * duration * input_channels_;
+    data.resize(input_frame_samples());
+    return InputData(data.data(), data.size());
+}
 
-    data.resize(input_frame_size);
-    int samples = Read(data.data(), data.size());
-    if (samples > 0) {
-        return true;
-    }
-    return false;
+bool AudioCodec::InputData(int16_t* data, size_t samples) {
+    return Read(data, samples) > 0;
 }
 
 IRAM_ATTR bool AudioCodec::on_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
@@ -11,6 +11,8 @@
 
 #include "board.h"
 
+#define AUDIO_CODEC_INPUT_FRAME_MS 30
+
 class AudioCodec {
 public:
     AudioCodec();
@@ -22,7 +24,9 @@ public:
 
     void Start();
     void OutputData(std::vector<int16_t>& data);
+    void OutputData(const int16_t* data, size_t samples);
     bool InputData(std::vector<int16_t>& data);
+    bool InputData(int16_t* data, size_t samples);
     void OnOutputReady(std::function<bool()> callback);
     void OnInputReady(std::function<bool()> callback);
 
@@ -33,6 +37,9 @@ public:
     inline int input_channels() const { return input_channels_; }
     inline int output_channels() const { return output_channels_; }
     inline int output_volume() const { return output_volume_; }
+    inline bool output_enabled() const { return output_enabled_; }
+    // Interleaved samples delivered per InputData() call
+    inline size_t input_frame_samples() const { return input_sample_rate_ / 1000 * AUDIO_CODEC_INPUT_FRAME_MS * input_channels_; }
 
 private:
     std::function<bool()> on_input_ready_;
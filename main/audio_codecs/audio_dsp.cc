@@ -0,0 +1,174 @@
+#include "audio_dsp.h"
+
+#include <cstring>
+
+#if AUDIO_DSP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace audio_dsp {
+
+#if AUDIO_DSP_PACKED
+// Two samples per word; memcpy keeps the accesses alias-safe and still
+// compiles to single 32-bit loads and stores.
+static inline uint32_t Load32(const int16_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void Store32(int16_t* p, uint32_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline bool Aligned32(const void* p) {
+    return ((uintptr_t)p & 3) == 0;
+}
+#endif
+
+#if AUDIO_DSP_SSE2
+// Unaligned 128-bit accesses: no alignment requirement on the buffers
+static inline __m128i Load128(const void* p) {
+    return _mm_loadu_si128((const __m128i*)p);
+}
+
+static inline void Store128(void* p, __m128i v) {
+    _mm_storeu_si128((__m128i*)p, v);
+}
+#endif
+
+void Deinterleave(const int16_t* interleaved, int16_t* left, int16_t* right, size_t frames) {
+    size_t i = 0;
+#if AUDIO_DSP_SSE2
+    for (; i + 8 <= frames; i += 8) {
+        __m128i a = Load128(interleaved + 2 * i);       // L0 R0 .. L3 R3
+        __m128i b = Load128(interleaved + 2 * i + 8);   // L4 R4 .. L7 R7
+        // Both halves sign-extended to 32 bits, so the saturating pack is exact
+        __m128i l = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16), _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+        __m128i r = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+        Store128(left + i, l);
+        Store128(right + i, r);
+    }
+#endif
+#if AUDIO_DSP_PACKED
+    if (Aligned32(interleaved) && Aligned32(left) && Aligned32(right)) {
+        for (; i + 2 <= frames; i += 2) {
+            uint32_t a = Load32(interleaved + 2 * i);       // L0 | R0 << 16
+            uint32_t b = Load32(interleaved + 2 * i + 2);   // L1 | R1 << 16
+            Store32(left + i, (a & 0xFFFF) | (b << 16));
+            Store32(right + i, (a >> 16) | (b & 0xFFFF0000));
+        }
+    }
+#endif
+    for (; i < frames; i++) {
+        left[i] = interleaved[2 * i];
+        right[i] = interleaved[2 * i + 1];
+    }
+}
+
+void Interleave(const int16_t* left, const int16_t* right, int16_t* interleaved, size_t frames) {
+    size_t i = 0;
+#if AUDIO_DSP_SSE2
+    for (; i + 8 <= frames; i += 8) {
+        __m128i l = Load128(left + i);
+        __m128i r = Load128(right + i);
+        Store128(interleaved + 2 * i, _mm_unpacklo_epi16(l, r));
+        Store128(interleaved + 2 * i + 8, _mm_unpackhi_epi16(l, r));
+    }
+#endif
+#if AUDIO_DSP_PACKED
+    if (Aligned32(interleaved) && Aligned32(left) && Aligned32(right)) {
+        for (; i + 2 <= frames; i += 2) {
+            uint32_t l = Load32(left + i);      // L0 | L1 << 16
+            uint32_t r = Load32(right + i);     // R0 | R1 << 16
+            Store32(interleaved + 2 * i, (l & 0xFFFF) | (r << 16));
+            Store32(interleaved + 2 * i + 2, (l >> 16) | (r & 0xFFFF0000));
+        }
+    }
+#endif
+    for (; i < frames; i++) {
+        interleaved[2 * i] = left[i];
+        interleaved[2 * i + 1] = right[i];
+    }
+}
+
+int32_t VolumeToGainQ16(int volume) {
+    if (volume < 0) {
+        volume = 0;
+    }
+    // (volume / 100)^2 * 65536, in integers
+    return (int32_t)((int64_t)volume * volume * 65536 / 10000);
+}
+
+void ScaleToS32(const int16_t* src, int32_t* dst, int32_t gain_q16, size_t samples) {
+    if (gain_q16 >= 0 && gain_q16 <= 65536) {
+        // |src * gain| <= 32768 * 65536 fits in int32: no widening, no clamp
+        size_t i = 0;
+#if AUDIO_DSP_SSE2
+        if (gain_q16 == 65536) {
+            // src << 16: each sample into the high half of a zeroed word
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 8 <= samples; i += 8) {
+                __m128i v = Load128(src + i);
+                Store128(dst + i, _mm_unpacklo_epi16(zero, v));
+                Store128(dst + i + 4, _mm_unpackhi_epi16(zero, v));
+            }
+        } else if (gain_q16 < 65535) {
+            // SSE2 has no 32-bit multiply: src * gain = src * g0 + src * g1
+            // with both halves of the gain below 32768, one pmaddwd per 4 samples
+            int32_t g0 = gain_q16 >> 1;
+            int32_t g1 = gain_q16 - g0;
+            const __m128i gains = _mm_set1_epi32((int32_t)((uint32_t)g1 << 16 | (uint32_t)g0));
+            for (; i + 8 <= samples; i += 8) {
+                __m128i v = Load128(src + i);
+                Store128(dst + i, _mm_madd_epi16(_mm_unpacklo_epi16(v, v), gains));
+                Store128(dst + i + 4, _mm_madd_epi16(_mm_unpackhi_epi16(v, v), gains));
+            }
+        }
+#endif
+        for (; i + 4 <= samples; i += 4) {
+            dst[i] = src[i] * gain_q16;
+            dst[i + 1] = src[i + 1] * gain_q16;
+            dst[i + 2] = src[i + 2] * gain_q16;
+            dst[i + 3] = src[i + 3] * gain_q16;
+        }
+        for (; i < samples; i++) {
+            dst[i] = src[i] * gain_q16;
+        }
+        return;
+    }
+    for (size_t i = 0; i < samples; i++) {
+        int64_t v = (int64_t)src[i] * gain_q16;
+        dst[i] = v > INT32_MAX ? INT32_MAX : v < INT32_MIN ? INT32_MIN : (int32_t)v;
+    }
+}
+
+static inline int16_t ClampS16(int32_t v) {
+    v = v > INT16_MAX ? INT16_MAX : v;
+    v = v < -INT16_MAX ? -INT16_MAX : v;
+    return (int16_t)v;
+}
+
+void ConvertS32ToS16(const int32_t* src, int16_t* dst, int shift, size_t samples) {
+    size_t i = 0;
+#if AUDIO_DSP_SSE2
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const __m128i min = _mm_set1_epi16(-INT16_MAX);
+    for (; i + 8 <= samples; i += 8) {
+        // packs saturates to [INT16_MIN, INT16_MAX]; the max raises INT16_MIN to -INT16_MAX
+        __m128i v = _mm_packs_epi32(_mm_sra_epi32(Load128(src + i), count), _mm_sra_epi32(Load128(src + i + 4), count));
+        Store128(dst + i, _mm_max_epi16(v, min));
+    }
+#endif
+    for (; i + 4 <= samples; i += 4) {
+        dst[i] = ClampS16(src[i] >> shift);
+        dst[i + 1] = ClampS16(src[i + 1] >> shift);
+        dst[i + 2] = ClampS16(src[i + 2] >> shift);
+        dst[i + 3] = ClampS16(src[i + 3] >> shift);
+    }
+    for (; i < samples; i++) {
+        dst[i] = ClampS16(src[i] >> shift);
+    }
+}
+
+} // namespace audio_dsp
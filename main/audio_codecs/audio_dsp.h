@@ -0,0 +1,54 @@
+#ifndef _AUDIO_DSP_H_
+#define _AUDIO_DSP_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Sample-format kernels for the capture / playback paths.
+ *
+ * AUDIO_DSP_PACKED selects the packed implementation at compile time: it
+ * moves two 16-bit samples per 32-bit load/store instead of one, which
+ * halves the memory operations on the ESP32 cores (little endian only).
+ *
+ * AUDIO_DSP_SSE2 adds SSE2 loops, eight samples per iteration, in front of
+ * those. It is on wherever the compiler targets SSE2, i.e. in the x86 host
+ * builds of the tests and the benchmark; the ESP32 firmware runs the packed
+ * path. All implementations produce identical output.
+ */
+#ifndef AUDIO_DSP_PACKED
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define AUDIO_DSP_PACKED 1
+#else
+#define AUDIO_DSP_PACKED 0
+#endif
+#endif
+
+#ifndef AUDIO_DSP_SSE2
+#if defined(__SSE2__)
+#define AUDIO_DSP_SSE2 1
+#else
+#define AUDIO_DSP_SSE2 0
+#endif
+#endif
+
+namespace audio_dsp {
+
+// Stereo frames → two mono buffers
+void Deinterleave(const int16_t* interleaved, int16_t* left, int16_t* right, size_t frames);
+
+// Two mono buffers → stereo frames
+void Interleave(const int16_t* left, const int16_t* right, int16_t* interleaved, size_t frames);
+
+// Volume 0-100 → Q16 gain on a squared curve
+int32_t VolumeToGainQ16(int volume);
+
+// dst = saturate32(src * gain_q16), for 32-bit I2S slots
+void ScaleToS32(const int16_t* src, int32_t* dst, int32_t gain_q16, size_t samples);
+
+// dst = clamp(src >> shift, -INT16_MAX, INT16_MAX), from 32-bit I2S slots
+void ConvertS32ToS16(const int32_t* src, int16_t* dst, int shift, size_t samples);
+
+} // namespace audio_dsp
+
+#endif // _AUDIO_DSP_H_
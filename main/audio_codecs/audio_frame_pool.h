@@ -0,0 +1,168 @@
+#ifndef _AUDIO_FRAME_POOL_H_
+#define _AUDIO_FRAME_POOL_H_
+
+#include <esp_heap_caps.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class AudioFramePool;
+
+/**
+ * @brief Move-only handle to one PCM frame borrowed from an AudioFramePool
+ *
+ * The frame goes back to the pool when the handle is destroyed. Detach()
+ * turns it into a slot index that fits in a FreeRTOS queue; the receiver
+ * takes ownership back with AudioFramePool::Adopt().
+ */
+class AudioFrame {
+public:
+    AudioFrame() = default;
+    AudioFrame(AudioFrame&& other) { *this = static_cast<AudioFrame&&>(other); }
+    AudioFrame& operator=(AudioFrame&& other);
+    ~AudioFrame() { reset(); }
+
+    AudioFrame(const AudioFrame&) = delete;
+    AudioFrame& operator=(const AudioFrame&) = delete;
+
+    explicit operator bool() const { return pool_ != nullptr; }
+    int16_t* data() { return data_; }
+    const int16_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    size_t capacity() const;
+    void resize(size_t samples);
+
+    int Detach();
+    void reset();
+
+private:
+    friend class AudioFramePool;
+    AudioFramePool* pool_ = nullptr;
+    int index_ = -1;
+    int16_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Fixed set of equally sized PCM frames allocated once
+ *
+ * Acquire and release are lock-free (a CAS on a bitmask), so frames can be
+ * taken on the capture side and returned from the encoder without touching
+ * the heap. At most 32 frames.
+ */
+class AudioFramePool {
+public:
+    AudioFramePool(size_t frame_capacity, size_t count)
+        : frame_capacity_(frame_capacity), count_(count > 32 ? 32 : count) {
+        size_t bytes = frame_capacity_ * count_ * sizeof(int16_t);
+        storage_ = (int16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (storage_ == nullptr) {
+            storage_ = (int16_t*)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+        }
+        if (storage_ == nullptr) {
+            count_ = 0;
+        }
+        free_mask_ = count_ == 32 ? 0xFFFFFFFFu : (1u << count_) - 1;
+    }
+
+    ~AudioFramePool() {
+        heap_caps_free(storage_);
+    }
+
+    AudioFramePool(const AudioFramePool&) = delete;
+    AudioFramePool& operator=(const AudioFramePool&) = delete;
+
+    size_t frame_capacity() const { return frame_capacity_; }
+    uint32_t exhausted_count() const { return exhausted_; }
+
+    // Empty handle when every frame is in use
+    AudioFrame Acquire() {
+        AudioFrame frame;
+        uint32_t mask = free_mask_.load(std::memory_order_relaxed);
+        while (mask != 0) {
+            int index = __builtin_ctz(mask);
+            if (free_mask_.compare_exchange_weak(mask, mask & ~(1u << index), std::memory_order_acquire)) {
+                Bind(frame, index, 0);
+                return frame;
+            }
+        }
+        exhausted_++;
+        return frame;
+    }
+
+    // Take back a frame passed along as AudioFrame::Detach()
+    AudioFrame Adopt(int index) {
+        AudioFrame frame;
+        Bind(frame, index, sizes_[index]);
+        return frame;
+    }
+
+private:
+    friend class AudioFrame;
+
+    int16_t* storage_ = nullptr;
+    size_t frame_capacity_;
+    size_t count_;
+    size_t sizes_[32] = {};
+    std::atomic<uint32_t> free_mask_{0};
+    std::atomic<uint32_t> exhausted_{0};
+
+    void Bind(AudioFrame& frame, int index, size_t size) {
+        frame.pool_ = this;
+        frame.index_ = index;
+        frame.data_ = storage_ + index * frame_capacity_;
+        frame.size_ = size;
+    }
+
+    void Release(int index) {
+        free_mask_.fetch_or(1u << index, std::memory_order_release);
+    }
+};
+
+inline AudioFrame& AudioFrame::operator=(AudioFrame&& other) {
+    if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        index_ = other.index_;
+        data_ = other.data_;
+        size_ = other.size_;
+        other.pool_ = nullptr;
+        other.index_ = -1;
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+inline size_t AudioFrame::capacity() const {
+    return pool_ != nullptr ? pool_->frame_capacity() : 0;
+}
+
+inline void AudioFrame::resize(size_t samples) {
+    size_ = samples < capacity() ? samples : capacity();
+}
+
+inline int AudioFrame::Detach() {
+    int index = index_;
+    if (pool_ != nullptr) {
+        pool_->sizes_[index] = size_;
+    }
+    pool_ = nullptr;
+    index_ = -1;
+    data_ = nullptr;
+    size_ = 0;
+    return index;
+}
+
+inline void AudioFrame::reset() {
+    if (pool_ != nullptr) {
+        pool_->Release(index_);
+    }
+    pool_ = nullptr;
+    index_ = -1;
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif // _AUDIO_FRAME_POOL_H_
@@ -6,8 +6,14 @@
 #include <driver/gpio.h>
 #include <driver/i2s_pdm.h>
 
+#include <vector>
+
 class NoAudioCodec : public AudioCodec {
 private:
+    // 32-bit I2S slot buffers, grown to the frame size once and reused
+    std::vector<int32_t> write_buffer_;
+    std::vector<int32_t> read_buffer_;
+
     virtual int Write(const int16_t* data, int samples) override;
     virtual int Read(int16_t* dest, int samples) override;
 
@@ -0,0 +1,85 @@
+#include "opus_frame_encoder.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstring>
+
+#define TAG "OpusFrameEncoder"
+
+OpusFrameEncoder::OpusFrameEncoder(int sample_rate, int channels, int duration_ms)
+    : channels_(channels), frame_size_(sample_rate / 1000 * channels * duration_ms) {
+    int error;
+    encoder_ = opus_encoder_create(sample_rate, channels, OPUS_APPLICATION_VOIP, &error);
+    if (encoder_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create audio encoder, error code: %d", error);
+        return;
+    }
+    frame_ = (int16_t*)heap_caps_malloc(frame_size_ * sizeof(int16_t), MALLOC_CAP_8BIT);
+    if (frame_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate frame buffer");
+    }
+
+    SetDtx(true);
+    SetComplexity(5);
+}
+
+OpusFrameEncoder::~OpusFrameEncoder() {
+    if (encoder_ != nullptr) {
+        opus_encoder_destroy(encoder_);
+    }
+    heap_caps_free(frame_);
+}
+
+void OpusFrameEncoder::SetDtx(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ != nullptr) {
+        opus_encoder_ctl(encoder_, OPUS_SET_DTX(enable ? 1 : 0));
+    }
+}
+
+void OpusFrameEncoder::SetComplexity(int complexity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ != nullptr) {
+        opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(complexity));
+    }
+}
+
+void OpusFrameEncoder::ResetState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ != nullptr) {
+        opus_encoder_ctl(encoder_, OPUS_RESET_STATE);
+    }
+    frame_fill_ = 0;
+}
+
+void OpusFrameEncoder::Encode(const int16_t* pcm, size_t samples, const std::function<void(const uint8_t* opus, size_t size)>& handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (encoder_ == nullptr || frame_ == nullptr) {
+        ESP_LOGE(TAG, "Audio encoder is not configured");
+        return;
+    }
+
+    while (samples > 0) {
+        size_t n = frame_size_ - frame_fill_;
+        if (n > samples) {
+            n = samples;
+        }
+        memcpy(frame_ + frame_fill_, pcm, n * sizeof(int16_t));
+        frame_fill_ += n;
+        pcm += n;
+        samples -= n;
+        if (frame_fill_ < frame_size_) {
+            break;
+        }
+
+        frame_fill_ = 0;
+        auto ret = opus_encode(encoder_, frame_, frame_size_ / channels_, packet_, sizeof(packet_));
+        if (ret < 0) {
+            ESP_LOGE(TAG, "Failed to encode audio, error code: %d", ret);
+            continue;
+        }
+        if (handler) {
+            handler(packet_, ret);
+        }
+    }
+}
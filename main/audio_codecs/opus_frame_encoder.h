@@ -0,0 +1,45 @@
+#ifndef _OPUS_FRAME_ENCODER_H_
+#define _OPUS_FRAME_ENCODER_H_
+
+#include <opus.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#define OPUS_FRAME_MAX_PACKET_SIZE 1000
+
+/**
+ * @brief Opus encoder that works out of fixed buffers
+ *
+ * Same settings as OpusEncoderWrapper (VOIP, DTX on), but PCM is taken by
+ * pointer and collected in a preallocated frame, and each packet is handed
+ * to the caller from an internal buffer. Nothing is allocated per frame.
+ */
+class OpusFrameEncoder {
+public:
+    OpusFrameEncoder(int sample_rate, int channels, int duration_ms);
+    ~OpusFrameEncoder();
+
+    OpusFrameEncoder(const OpusFrameEncoder&) = delete;
+    OpusFrameEncoder& operator=(const OpusFrameEncoder&) = delete;
+
+    void SetDtx(bool enable);
+    void SetComplexity(int complexity);
+    void ResetState();
+
+    // Buffers `samples` samples; every completed frame is encoded and passed to handler
+    void Encode(const int16_t* pcm, size_t samples, const std::function<void(const uint8_t* opus, size_t size)>& handler);
+
+private:
+    std::mutex mutex_;
+    OpusEncoder* encoder_ = nullptr;
+    int16_t* frame_ = nullptr;
+    int channels_;
+    size_t frame_size_;
+    size_t frame_fill_ = 0;
+    uint8_t packet_[OPUS_FRAME_MAX_PACKET_SIZE];
+};
+
+#endif // _OPUS_FRAME_ENCODER_H_
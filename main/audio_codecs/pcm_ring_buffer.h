@@ -0,0 +1,127 @@
+#ifndef _PCM_RING_BUFFER_H_
+#define _PCM_RING_BUFFER_H_
+
+#include <esp_heap_caps.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief Lock-free single-producer / single-consumer ring of PCM samples
+ *
+ * The decoder task writes, the output task reads. Storage is allocated once
+ * (PSRAM when available), so moving audio through it never touches the heap.
+ * The reader gets contiguous spans it can hand straight to the codec.
+ *
+ * Each index is written by one side only; the other side reads it with
+ * acquire ordering, which makes the samples written before a release store
+ * visible. One slot stays empty so a full ring is distinguishable from an
+ * empty one without a shared counter.
+ */
+class PcmRingBuffer {
+public:
+    explicit PcmRingBuffer(size_t capacity)
+        : size_(capacity + 1) {
+        buffer_ = (int16_t*)heap_caps_malloc(size_ * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (buffer_ == nullptr) {
+            buffer_ = (int16_t*)heap_caps_malloc(size_ * sizeof(int16_t), MALLOC_CAP_8BIT);
+        }
+        if (buffer_ == nullptr) {
+            size_ = 1;
+        }
+    }
+
+    ~PcmRingBuffer() {
+        heap_caps_free(buffer_);
+    }
+
+    PcmRingBuffer(const PcmRingBuffer&) = delete;
+    PcmRingBuffer& operator=(const PcmRingBuffer&) = delete;
+
+    size_t capacity() const { return size_ - 1; }
+
+    /* ---------- producer ---------- */
+
+    size_t WriteAvailable() const {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return (tail + size_ - head - 1) % size_;
+    }
+
+    // Copy up to `samples` samples in, returns how many fit
+    size_t Write(const int16_t* data, size_t samples) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t free = (tail + size_ - head - 1) % size_;
+        if (samples > free) {
+            samples = free;
+        }
+        size_t first = size_ - head < samples ? size_ - head : samples;
+        memcpy(buffer_ + head, data, first * sizeof(int16_t));
+        memcpy(buffer_, data + first, (samples - first) * sizeof(int16_t));
+        head_.store((head + samples) % size_, std::memory_order_release);
+        return samples;
+    }
+
+    /* ---------- consumer ---------- */
+
+    size_t ReadAvailable() {
+        ApplyDiscard();
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        return (head + size_ - tail) % size_;
+    }
+
+    // Contiguous readable span starting at the read position; call Consume() when done with it
+    size_t Peek(const int16_t** data) {
+        ApplyDiscard();
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        *data = buffer_ + tail;
+        return head >= tail ? head - tail : size_ - tail;
+    }
+
+    void Consume(size_t samples) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        tail_.store((tail + samples) % size_, std::memory_order_release);
+    }
+
+    /* ---------- any thread ---------- */
+
+    // Drop everything written so far. Applied by the consumer on its next
+    // read, so neither side's index is ever written by a third thread.
+    void Discard() {
+        discard_to_.store(head_.load(std::memory_order_acquire), std::memory_order_relaxed);
+        discard_pending_.store(true, std::memory_order_release);
+    }
+
+    // Approximate from any thread other than the consumer
+    bool Empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    int16_t* buffer_ = nullptr;
+    size_t size_;
+    std::atomic<size_t> head_{0};   // written by the producer
+    std::atomic<size_t> tail_{0};   // written by the consumer
+    std::atomic<size_t> discard_to_{0};
+    std::atomic<bool> discard_pending_{false};
+
+    void ApplyDiscard() {
+        if (!discard_pending_.exchange(false, std::memory_order_acquire)) {
+            return;
+        }
+        size_t target = discard_to_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        // Skip if the reader already got past the discard point
+        if ((target + size_ - tail) % size_ <= (head + size_ - tail) % size_) {
+            tail_.store(target, std::memory_order_release);
+        }
+    }
+};
+
+#endif // _PCM_RING_BUFFER_H_
@@ -0,0 +1,141 @@
+#ifndef AFE_FEED_RING_H
+#define AFE_FEED_RING_H
+
+#include <esp_heap_caps.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define AFE_FEED_RING_CHUNKS 4
+
+/**
+ * @brief Fixed-capacity sample ring that hands out whole AFE feed chunks
+ *
+ * Capture frames (30 ms) and AFE feed chunks (32 ms) never line up, so the
+ * ring collects frames and returns one chunk at a time as a contiguous view:
+ * directly from the ring when the chunk does not wrap, otherwise from a
+ * one-chunk scratch buffer. Nothing is moved when a chunk is consumed.
+ *
+ * If more than the capacity is queued, the oldest whole chunks are dropped
+ * (keeping the mic/reference interleave aligned) and counted as overruns.
+ * Used from a single task; the stats may be read from anywhere.
+ */
+class AfeFeedRing {
+public:
+    struct Stats {
+        uint32_t overruns;          // writes that had to drop data
+        uint32_t dropped_samples;
+        size_t high_watermark;      // most samples ever buffered
+        size_t capacity;
+    };
+
+    AfeFeedRing() = default;
+    ~AfeFeedRing() {
+        heap_caps_free(buffer_);
+        heap_caps_free(scratch_);
+    }
+
+    AfeFeedRing(const AfeFeedRing&) = delete;
+    AfeFeedRing& operator=(const AfeFeedRing&) = delete;
+
+    // Room for `chunks` feed chunks of `chunk_samples` interleaved samples
+    bool Configure(size_t chunk_samples, size_t chunks) {
+        heap_caps_free(buffer_);
+        heap_caps_free(scratch_);
+        chunk_ = chunk_samples;
+        capacity_ = chunk_samples * chunks;
+        buffer_ = Allocate(capacity_);
+        scratch_ = Allocate(chunk_);
+        if (buffer_ == nullptr || scratch_ == nullptr) {
+            capacity_ = 0;
+        }
+        Reset();
+        return capacity_ > 0;
+    }
+
+    void Reset() {
+        read_ = 0;
+        size_ = 0;
+    }
+
+    void Write(const int16_t* data, size_t samples) {
+        if (capacity_ == 0) {
+            return;
+        }
+        if (size_ + samples > capacity_) {
+            // Drop the oldest whole chunks; if the write alone is too big, its head too
+            size_t excess = size_ + samples - capacity_;
+            size_t drop = (excess + chunk_ - 1) / chunk_ * chunk_;
+            size_t from_ring = drop < size_ ? drop : size_;
+            read_ = (read_ + from_ring) % capacity_;
+            size_ -= from_ring;
+            if (drop > from_ring) {
+                data += drop - from_ring;
+                samples -= drop - from_ring;
+            }
+            overruns_.fetch_add(1, std::memory_order_relaxed);
+            dropped_samples_.fetch_add(drop, std::memory_order_relaxed);
+        }
+
+        size_t write = (read_ + size_) % capacity_;
+        size_t first = capacity_ - write < samples ? capacity_ - write : samples;
+        memcpy(buffer_ + write, data, first * sizeof(int16_t));
+        memcpy(buffer_, data + first, (samples - first) * sizeof(int16_t));
+        size_ += samples;
+        if (size_ > high_watermark_.load(std::memory_order_relaxed)) {
+            high_watermark_.store(size_, std::memory_order_relaxed);
+        }
+    }
+
+    // Next whole chunk, or nullptr while less than a chunk is buffered.
+    // Valid until ConsumeChunk() or the next Write().
+    const int16_t* PeekChunk() {
+        if (capacity_ == 0 || size_ < chunk_) {
+            return nullptr;
+        }
+        if (read_ + chunk_ <= capacity_) {
+            return buffer_ + read_;
+        }
+        size_t first = capacity_ - read_;
+        memcpy(scratch_, buffer_ + read_, first * sizeof(int16_t));
+        memcpy(scratch_ + first, buffer_, (chunk_ - first) * sizeof(int16_t));
+        return scratch_;
+    }
+
+    void ConsumeChunk() {
+        read_ = (read_ + chunk_) % capacity_;
+        size_ -= chunk_;
+    }
+
+    Stats GetStats() const {
+        return Stats{
+            overruns_.load(std::memory_order_relaxed),
+            dropped_samples_.load(std::memory_order_relaxed),
+            high_watermark_.load(std::memory_order_relaxed),
+            capacity_,
+        };
+    }
+
+private:
+    int16_t* buffer_ = nullptr;
+    int16_t* scratch_ = nullptr;
+    size_t chunk_ = 0;
+    size_t capacity_ = 0;
+    size_t read_ = 0;
+    size_t size_ = 0;
+    std::atomic<uint32_t> overruns_{0};
+    std::atomic<uint32_t> dropped_samples_{0};
+    std::atomic<size_t> high_watermark_{0};
+
+    static int16_t* Allocate(size_t samples) {
+        auto p = (int16_t*)heap_caps_malloc(samples * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (p == nullptr) {
+            p = (int16_t*)heap_caps_malloc(samples * sizeof(int16_t), MALLOC_CAP_8BIT);
+        }
+        return p;
+    }
+};
+
+#endif // AFE_FEED_RING_H
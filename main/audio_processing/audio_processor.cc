@@ -39,6 +39,7 @@ void AudioProcessor::Initialize(int channels, bool reference) {
 
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
+    feed_ring_.Configure(afe_iface_->get_feed_chunksize(afe_data_) * channels_, AFE_FEED_RING_CHUNKS);
     
     xTaskCreate([](void* arg) {
         auto this_ = (AudioProcessor*)arg;
@@ -55,13 +56,14 @@ AudioProcessor::~AudioProcessor() {
 }
 
 void AudioProcessor::Input(const std::vector<int16_t>& data) {
-    input_buffer_.insert(input_buffer_.end(), data.begin(), data.end());
+    Input(data.data(), data.size());
+}
 
-    auto feed_size = afe_iface_->get_feed_chunksize(afe_data_) * channels_;
-    while (input_buffer_.size() >= feed_size) {
-        auto chunk = input_buffer_.data();
+void AudioProcessor::Input(const int16_t* data, size_t samples) {
+    feed_ring_.Write(data, samples);
+    while (auto chunk = feed_ring_.PeekChunk()) {
         afe_iface_->feed(afe_data_, chunk);
-        input_buffer_.erase(input_buffer_.begin(), input_buffer_.begin() + feed_size);
+        feed_ring_.ConsumeChunk();
     }
 }
 
@@ -78,7 +80,7 @@ bool AudioProcessor::IsRunning() {
     return xEventGroupGetBits(event_group_) & PROCESSOR_RUNNING;
 }
 
-void AudioProcessor::OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) {
+void AudioProcessor::OnOutput(std::function<void(const int16_t* data, size_t samples)> callback) {
     output_callback_ = callback;
 }
 
@@ -118,7 +120,7 @@ void AudioProcessor::AudioProcessorTask() {
         }
 
         if (output_callback_) {
-            output_callback_(std::vector<int16_t>(res->data, res->data + res->data_size / sizeof(int16_t)));
+            output_callback_(res->data, res->data_size / sizeof(int16_t));
         }
     }
 }
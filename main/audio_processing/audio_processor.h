@@ -10,6 +10,8 @@
 #include <vector>
 #include <functional>
 
+#include "afe_feed_ring.h"
+
 class AudioProcessor {
 public:
     AudioProcessor();
@@ -17,18 +19,21 @@ public:
 
     void Initialize(int channels, bool reference);
     void Input(const std::vector<int16_t>& data);
+    void Input(const int16_t* data, size_t samples);
     void Start();
     void Stop();
     bool IsRunning();
-    void OnOutput(std::function<void(std::vector<int16_t>&& data)> callback);
+    // The data pointer is only valid during the callback
+    void OnOutput(std::function<void(const int16_t* data, size_t samples)> callback);
     void OnVadStateChange(std::function<void(bool speaking)> callback);
+    AfeFeedRing::Stats GetFeedStats() const { return feed_ring_.GetStats(); }
 
 private:
     EventGroupHandle_t event_group_ = nullptr;
     esp_afe_sr_iface_t* afe_iface_ = nullptr;
     esp_afe_sr_data_t* afe_data_ = nullptr;
-    std::vector<int16_t> input_buffer_;
-    std::function<void(std::vector<int16_t>&& data)> output_callback_;
+    AfeFeedRing feed_ring_;
+    std::function<void(const int16_t* data, size_t samples)> output_callback_;
     std::function<void(bool speaking)> vad_state_change_callback_;
     int channels_;
     bool reference_;
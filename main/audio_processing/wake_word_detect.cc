@@ -66,6 +66,7 @@ void WakeWordDetect::Initialize(int channels, bool reference) {
     
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
+    feed_ring_.Configure(afe_iface_->get_feed_chunksize(afe_data_) * channels_, AFE_FEED_RING_CHUNKS);
 
     xTaskCreate([](void* arg) {
         auto this_ = (WakeWordDetect*)arg;
@@ -92,12 +93,14 @@ bool WakeWordDetect::IsDetectionRunning() {
 }
 
 void WakeWordDetect::Feed(const std::vector<int16_t>& data) {
-    input_buffer_.insert(input_buffer_.end(), data.begin(), data.end());
+    Feed(data.data(), data.size());
+}
 
-    auto feed_size = afe_iface_->get_feed_chunksize(afe_data_) * channels_;
-    while (input_buffer_.size() >= feed_size) {
-        afe_iface_->feed(afe_data_, input_buffer_.data());
-        input_buffer_.erase(input_buffer_.begin(), input_buffer_.begin() + feed_size);
+void WakeWordDetect::Feed(const int16_t* data, size_t samples) {
+    feed_ring_.Write(data, samples);
+    while (auto chunk = feed_ring_.PeekChunk()) {
+        afe_iface_->feed(afe_data_, chunk);
+        feed_ring_.ConsumeChunk();
     }
 }
 
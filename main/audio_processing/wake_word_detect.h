@@ -15,6 +15,8 @@
 #include <mutex>
 #include <condition_variable>
 
+#include "afe_feed_ring.h"
+
 
 class WakeWordDetect {
 public:
@@ -23,6 +25,7 @@ public:
 
     void Initialize(int channels, bool reference);
     void Feed(const std::vector<int16_t>& data);
+    void Feed(const int16_t* data, size_t samples);
     void OnWakeWordDetected(std::function<void(const std::string& wake_word)> callback);
     void StartDetection();
     void StopDetection();
@@ -30,13 +33,14 @@ public:
     void EncodeWakeWordData();
     bool GetWakeWordOpus(std::vector<uint8_t>& opus);
     const std::string& GetLastDetectedWakeWord() const { return last_detected_wake_word_; }
+    AfeFeedRing::Stats GetFeedStats() const { return feed_ring_.GetStats(); }
 
 private:
     esp_afe_sr_iface_t* afe_iface_ = nullptr;
     esp_afe_sr_data_t* afe_data_ = nullptr;
     char* wakenet_model_ = NULL;
     std::vector<std::string> wake_words_;
-    std::vector<int16_t> input_buffer_;
+    AfeFeedRing feed_ring_;
     EventGroupHandle_t event_group_;
     std::function<void(const std::string& wake_word)> wake_word_detected_callback_;
     int channels_;
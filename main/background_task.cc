@@ -1,63 +1,165 @@
 #include "background_task.h"
 
 #include <esp_log.h>
-#include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 
 #define TAG "BackgroundTask"
 
-BackgroundTask::BackgroundTask(uint32_t stack_size) {
-    xTaskCreate([](void* arg) {
-        BackgroundTask* task = (BackgroundTask*)arg;
-        task->BackgroundTaskLoop();
-    }, "background_task", stack_size, this, 2, &background_task_handle_);
+struct LaneConfig {
+    const char* name;
+    uint32_t stack_size;
+    UBaseType_t priority;
+    BaseType_t core_id;
+};
+
+#if CONFIG_BACKGROUND_TASK_PIN_CORES
+// Audio encoding beside the AFE on core 1, everything else on core 0
+#define AUDIO_LANE_CORE 1
+#define OTHER_LANE_CORE 0
+#else
+#define AUDIO_LANE_CORE tskNO_AFFINITY
+#define OTHER_LANE_CORE tskNO_AFFINITY
+#endif
+
+static const LaneConfig kLaneConfigs[kBackgroundLaneCount] = {
+    {"bg_audio", CONFIG_BACKGROUND_AUDIO_STACK_SIZE, 3, AUDIO_LANE_CORE},
+    {"bg_interactive", CONFIG_BACKGROUND_INTERACTIVE_STACK_SIZE, 2, OTHER_LANE_CORE},
+    {"bg_bulk", CONFIG_BACKGROUND_BULK_STACK_SIZE, 1, OTHER_LANE_CORE},
+};
+
+// The lane whose task runs this lane's jobs
+static int LaneIndex(BackgroundLane lane) {
+#if CONFIG_BACKGROUND_SHARED_BULK_LANE
+    // No task of its own: the delayed triggers queue on the bulk lane
+    if (lane == kBackgroundLaneInteractive) {
+        return kBackgroundLaneBulk;
+    }
+#endif
+    return lane;
+}
+
+BackgroundTask::BackgroundTask() {
+    for (int i = 0; i < kBackgroundLaneCount; i++) {
+        auto& config = kLaneConfigs[i];
+        auto& lane = lanes_[i];
+        if (LaneIndex((BackgroundLane)i) != i) {
+            continue;
+        }
+        lane.name = config.name;
+        if (xTaskCreatePinnedToCore([](void* arg) {
+            BackgroundTask::LaneLoop(*(Lane*)arg);
+        }, config.name, config.stack_size, &lane, config.priority, &lane.handle, config.core_id) != pdPASS) {
+            lane.handle = nullptr;
+            ESP_LOGE(TAG, "Failed to create %s task (%lu bytes stack), its jobs will be dropped",
+                config.name, config.stack_size);
+        }
+    }
 }
 
 BackgroundTask::~BackgroundTask() {
-    if (background_task_handle_ != nullptr) {
-        vTaskDelete(background_task_handle_);
+    for (auto& lane : lanes_) {
+        if (lane.handle != NULL) {
+            vTaskDelete(lane.handle);
+        }
+    }
+}
+
+static void UpdateMax(std::atomic<uint32_t>& value, uint32_t sample) {
+    uint32_t current = value.load(std::memory_order_relaxed);
+    while (sample > current && !value.compare_exchange_weak(current, sample, std::memory_order_relaxed)) {
     }
 }
 
-void BackgroundTask::Schedule(std::function<void()> callback) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (active_tasks_ >= 30) {
+void BackgroundTask::Schedule(BackgroundLane lane_id, InlineTask callback, CancellationToken token) {
+    auto& lane = lanes_[LaneIndex(lane_id)];
+    if (lane.handle == nullptr) {
+        // Nothing would ever run the job, and WaitForCompletion() would wait for it forever
+        lane.cancelled.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    size_t active_tasks = lane.active_tasks.fetch_add(1) + 1;
+    if (active_tasks >= 30) {
         int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
         if (free_sram < 10000) {
-            ESP_LOGW(TAG, "active_tasks_ == %u, free_sram == %u", active_tasks_.load(), free_sram);
+            ESP_LOGW(TAG, "%s: active_tasks == %u, free_sram == %u", lane.name, active_tasks, free_sram);
         }
     }
-    active_tasks_++;
-    main_tasks_.emplace_back([this, cb = std::move(callback)]() {
-        cb();
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            active_tasks_--;
-            if (main_tasks_.empty() && active_tasks_ == 0) {
-                condition_variable_.notify_all();
-            }
-        }
+    lane.jobs.Push(Job{std::move(callback), std::move(token), esp_timer_get_time()});
+    UpdateMax(lane.max_depth, lane.jobs.size());
+    xTaskNotifyGive(lane.handle);
+}
+
+void BackgroundTask::WaitForCompletion(BackgroundLane lane_id) {
+    auto& lane = lanes_[LaneIndex(lane_id)];
+    std::unique_lock<std::mutex> lock(lane.mutex);
+    lane.condition_variable.wait(lock, [&lane]() {
+        return lane.active_tasks.load() == 0;
     });
-    condition_variable_.notify_all();
 }
 
 void BackgroundTask::WaitForCompletion() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    condition_variable_.wait(lock, [this]() {
-        return main_tasks_.empty() && active_tasks_ == 0;
-    });
+    for (int i = 0; i < kBackgroundLaneCount; i++) {
+        WaitForCompletion((BackgroundLane)i);
+    }
+}
+
+BackgroundTask::LaneStats BackgroundTask::GetStats(BackgroundLane lane_id) {
+    auto& lane = lanes_[LaneIndex(lane_id)];
+    LaneStats stats;
+    stats.depth = lane.jobs.size();
+    stats.max_depth = lane.max_depth.load(std::memory_order_relaxed);
+    stats.executed = lane.executed.load(std::memory_order_relaxed);
+    stats.cancelled = lane.cancelled.load(std::memory_order_relaxed);
+    stats.avg_latency_us = lane.avg_latency_us.load(std::memory_order_relaxed);
+    stats.max_latency_us = lane.max_latency_us.load(std::memory_order_relaxed);
+    stats.max_run_us = lane.max_run_us.load(std::memory_order_relaxed);
+    stats.heap_nodes = lane.jobs.heap_nodes();
+    return stats;
 }
 
-void BackgroundTask::BackgroundTaskLoop() {
-    ESP_LOGI(TAG, "background_task started");
+void BackgroundTask::LogStats() {
+    for (int i = 0; i < kBackgroundLaneCount; i++) {
+        if (LaneIndex((BackgroundLane)i) != i) {
+            continue;
+        }
+        auto stats = GetStats((BackgroundLane)i);
+        ESP_LOGI(TAG, "%s: depth %u/%u, executed %lu, cancelled %lu, latency avg %lu max %lu us, run max %lu us, heap nodes %lu",
+            lanes_[i].name, stats.depth, stats.max_depth, stats.executed, stats.cancelled,
+            stats.avg_latency_us, stats.max_latency_us, stats.max_run_us, stats.heap_nodes);
+    }
+}
+
+void BackgroundTask::LaneLoop(Lane& lane) {
+    ESP_LOGI(TAG, "%s started", lane.name);
+
+    Job job;
     while (true) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        condition_variable_.wait(lock, [this]() { return !main_tasks_.empty(); });
-        
-        std::list<std::function<void()>> tasks = std::move(main_tasks_);
-        lock.unlock();
-
-        for (auto& task : tasks) {
-            task();
+        if (!lane.jobs.Pop(job)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        if (job.token.IsCancelled()) {
+            lane.cancelled.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            int64_t start = esp_timer_get_time();
+            uint32_t latency = (uint32_t)(start - job.queued_us);
+            uint32_t executed = lane.executed.load(std::memory_order_relaxed) + 1;
+            lane.latency_sum_us += latency;
+            lane.avg_latency_us.store((uint32_t)(lane.latency_sum_us / executed), std::memory_order_relaxed);
+            lane.executed.store(executed, std::memory_order_relaxed);
+            UpdateMax(lane.max_latency_us, latency);
+
+            job.callback();
+            UpdateMax(lane.max_run_us, (uint32_t)(esp_timer_get_time() - start));
+        }
+        // Drop the captures before reporting completion
+        job = Job();
+
+        if (lane.active_tasks.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            lane.condition_variable.notify_all();
         }
     }
 }
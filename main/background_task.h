@@ -4,26 +4,95 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <mutex>
-#include <list>
+#include <memory>
 #include <condition_variable>
 #include <atomic>
 
+#include "inline_task.h"
+#include "mpsc_queue.h"
+
+// Each lane is its own worker task, so audio work never queues behind a download.
+// With BACKGROUND_SHARED_BULK_LANE the interactive lane runs on the bulk task.
+enum BackgroundLane {
+    kBackgroundLaneAudio,           // 实时音频：Opus 编码
+    kBackgroundLaneInteractive,     // 界面响应：短小的延时触发
+    kBackgroundLaneBulk,            // 批量 I/O：下载、存储、幻灯片循环
+    kBackgroundLaneCount
+};
+
+// Shared flag: Cancel() drops the job if it has not started yet, and long
+// jobs can poll IsCancelled(). A default-constructed token never cancels.
+class CancellationToken {
+public:
+    CancellationToken() = default;
+    static CancellationToken Create() {
+        CancellationToken token;
+        token.cancelled_ = std::make_shared<std::atomic<bool>>(false);
+        return token;
+    }
+
+    void Cancel() const {
+        if (cancelled_) {
+            cancelled_->store(true);
+        }
+    }
+    bool IsCancelled() const { return cancelled_ && cancelled_->load(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
 class BackgroundTask {
 public:
-    BackgroundTask(uint32_t stack_size = 4096 * 2);
+    struct LaneStats {
+        size_t depth = 0;               // queued, not started
+        size_t max_depth = 0;
+        uint32_t executed = 0;
+        uint32_t cancelled = 0;
+        uint32_t avg_latency_us = 0;    // queued → started
+        uint32_t max_latency_us = 0;
+        uint32_t max_run_us = 0;
+        uint32_t heap_nodes = 0;        // schedules that overflowed the node pool
+    };
+
+    BackgroundTask();
     ~BackgroundTask();
 
-    void Schedule(std::function<void()> callback);
+    // Lock-free and, for callables that fit an InlineTask, allocation-free
+    void Schedule(BackgroundLane lane, InlineTask callback, CancellationToken token = CancellationToken());
+    void WaitForCompletion(BackgroundLane lane);
     void WaitForCompletion();
+    LaneStats GetStats(BackgroundLane lane);
+    void LogStats();
 
 private:
-    std::mutex mutex_;
-    std::list<std::function<void()>> main_tasks_;
-    std::condition_variable condition_variable_;
-    TaskHandle_t background_task_handle_ = nullptr;
-    std::atomic<size_t> active_tasks_{0};
+    struct Job {
+        InlineTask callback;
+        CancellationToken token;
+        int64_t queued_us = 0;
+    };
+
+    struct Lane {
+        const char* name = nullptr;
+        MpscQueue<Job, 8> jobs;
+        std::atomic<size_t> active_tasks{0};    // queued + running
+        TaskHandle_t handle = nullptr;
+        // WaitForCompletion() only; the queue itself is lock-free
+        std::mutex mutex;
+        std::condition_variable condition_variable;
+        // Written by the lane task (max_depth by producers), read by GetStats()
+        std::atomic<uint32_t> max_depth{0};
+        std::atomic<uint32_t> executed{0};
+        std::atomic<uint32_t> cancelled{0};
+        std::atomic<uint32_t> avg_latency_us{0};
+        std::atomic<uint32_t> max_latency_us{0};
+        std::atomic<uint32_t> max_run_us{0};
+        uint64_t latency_sum_us = 0;
+    };
+
+    Lane lanes_[kBackgroundLaneCount];
 
-    void BackgroundTaskLoop();
+    static void LaneLoop(Lane& lane);
 };
 
 #endif
@@ -11,18 +11,17 @@
 
 #include "board.h"
 #include <math.h>
-#include <esp_http_client.h>
-#include <esp_tls.h>
-#include <esp_crt_bundle.h>
 #include <esp_heap_caps.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <lvgl.h>
 #include "power_save_timer.h"
 
 extern "C" {
 #include "storage/gif_storage.h"
+#include "gif_downloader.h"
 }
 
 #define TAG "LcdDisplay"
@@ -318,6 +317,17 @@ static void ensure_gif_style() {
     s_gif_style_inited = true;
 }
 
+// Invalidate only the part of a GIF view changed by the last frame (area is in image coordinates)
+static void invalidate_gif_area(lv_obj_t* img, const lv_area_t& area) {
+    lv_area_t coords;
+    lv_obj_get_coords(img, &coords);
+    lv_area_t dirty = {
+        coords.x1 + area.x1, coords.y1 + area.y1,
+        coords.x1 + area.x2, coords.y1 + area.y2,
+    };
+    lv_obj_invalidate_area(img, &dirty);
+}
+
 void LcdDisplay::SetGifPos(int x, int y) {
     int cx = x, cy = y;
     if (x == 0 && y == 0 && gif_controller_) {
@@ -333,6 +343,9 @@ void LcdDisplay::SetGifPos(int x, int y) {
 }
 
 LcdDisplay::~LcdDisplay() {
+    if (gif_release_callback_set_) {
+        gif_storage_set_release_callback(nullptr, nullptr);
+    }
     // 先销毁 GIF 控制器并释放托管缓冲区，防止泄漏
     DestroyGif();
 
@@ -1261,25 +1274,9 @@ void LcdDisplay::ShowGifImpl_(const uint8_t* gif_data, size_t gif_size, int x, i
     ESP_LOGI(TAG, "SPIRAM before Show: %u",
              (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
 
-    std::unique_ptr<LvglGif> old_controller;
-    lv_obj_t* active_obj = (active_gif_view_ == 0 ? gif_img_ : gif_img_b_);
-    if (gif_controller_ && active_obj) {
-        if (last_gif_data_ == gif_data && last_gif_size_ == gif_size) {
-            lv_obj_clear_flag(active_obj, LV_OBJ_FLAG_HIDDEN);
-            if (!gif_controller_->IsPlaying()) {
-                gif_controller_->Start();
-            }
-            AcquireGifPowerHold();
-            SetGifPos(x, y);
-            lv_obj_move_foreground(active_obj);
-            ESP_LOGI(TAG, "GIF reused without restart");
-            return;
-        }
-        // Different content: stop old GIF asynchronously to avoid blocking LVGL task
-        ESP_LOGI(TAG, "Stopping previous GIF (async)");
-        old_controller = std::move(gif_controller_);
-        // Trigger async cleanup - old_controller will be destroyed when it goes out of scope
-        // but we add a small delay before starting new GIF to allow cleanup to progress
+    if (last_gif_path_.empty() && last_gif_data_ == gif_data && last_gif_size_ == gif_size &&
+        ResumeActiveGif_(x, y)) {
+        return;
     }
 
     lv_image_dsc_t src{};
@@ -1288,10 +1285,87 @@ void LcdDisplay::ShowGifImpl_(const uint8_t* gif_data, size_t gif_size, int x, i
     src.data = gif_data;
     src.data_size = gif_size;
 
-    auto new_controller = std::make_unique<LvglGif>(&src);
+    if (!SwapInGif_(std::make_unique<LvglGif>(&src), x, y)) {
+        return;
+    }
+    last_gif_data_ = gif_data;
+    last_gif_size_ = gif_size;
+    last_gif_path_.clear();
+
+    ESP_LOGI(TAG, "GIF started via LvglGif controller (official style)");
+}
+
+void LcdDisplay::ShowGifFileImpl_(const char* path, bool indexed, uint32_t crc, int x, int y) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        ESP_LOGE(TAG, "GIF file not found: %s", path);
+        return;
+    }
+
+    // The decoder keeps the file open while paused; storage tells us before it
+    // deletes or replaces it
+    if (!gif_release_callback_set_) {
+        gif_storage_set_release_callback(OnStorageFileReleased, this);
+        gif_release_callback_set_ = true;
+    }
+
+    // Same file with the same content: keep the running decoder. Files that are
+    // not in the index have no CRC and always restart.
+    if (indexed && last_gif_path_ == path && last_gif_crc_ == crc && ResumeActiveGif_(x, y)) {
+        return;
+    }
+
+    if (!SwapInGif_(std::make_unique<LvglGif>(path), x, y)) {
+        return;
+    }
+    last_gif_data_ = nullptr;
+    last_gif_size_ = (size_t)st.st_size;
+    last_gif_path_ = path;
+    last_gif_crc_ = crc;
+
+    // The previous controller is gone; a download buffer it played from is no longer needed
+    if (managed_gif_buffer_ != nullptr) {
+        heap_caps_free(managed_gif_buffer_);
+        managed_gif_buffer_ = nullptr;
+        managed_gif_buffer_size_ = 0;
+    }
+
+    ESP_LOGI(TAG, "GIF streaming from %s (%ld bytes), SPIRAM free: %u", path, (long)st.st_size,
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+}
+
+void LcdDisplay::OnStorageFileReleased(const char* path, void* user_data) {
+    LcdDisplay* self = static_cast<LcdDisplay*>(user_data);
+    DisplayLockGuard lock(self);
+    if (!lock.locked()) {
+        return;
+    }
+    if (!self->last_gif_path_.empty() && self->last_gif_path_ == path) {
+        ESP_LOGI(TAG, "Closing %s before storage deletes or replaces it", path);
+        self->DestroyGif();
+    }
+}
+
+bool LcdDisplay::ResumeActiveGif_(int x, int y) {
+    lv_obj_t* active_obj = (active_gif_view_ == 0 ? gif_img_ : gif_img_b_);
+    if (!gif_controller_ || !active_obj) {
+        return false;
+    }
+    lv_obj_clear_flag(active_obj, LV_OBJ_FLAG_HIDDEN);
+    if (!gif_controller_->IsPlaying()) {
+        gif_controller_->Start();
+    }
+    AcquireGifPowerHold();
+    SetGifPos(x, y);
+    lv_obj_move_foreground(active_obj);
+    ESP_LOGI(TAG, "GIF reused without restart");
+    return true;
+}
+
+bool LcdDisplay::SwapInGif_(std::unique_ptr<LvglGif> new_controller, int x, int y) {
     if (!new_controller || !new_controller->IsLoaded()) {
         ESP_LOGE(TAG, "Failed to initialize GIF controller");
-        return;
+        return false;
     }
     // Loop GIF indefinitely until user swipes (0 = infinite loops)
     new_controller->SetLoopCount(0);
@@ -1299,32 +1373,33 @@ void LcdDisplay::ShowGifImpl_(const uint8_t* gif_data, size_t gif_size, int x, i
     // Ensure two LVGL image views exist (for seamless switching)
     if (!gif_img_) {
         gif_img_ = lv_image_create(lv_screen_active());
-        if (!gif_img_) { return; }
+        if (!gif_img_) { return false; }
         ensure_gif_style();
         lv_obj_add_style(gif_img_, &s_gif_style, 0);
         lv_obj_add_flag(gif_img_, LV_OBJ_FLAG_HIDDEN);
     }
     if (!gif_img_b_) {
         gif_img_b_ = lv_image_create(lv_screen_active());
-        if (!gif_img_b_) { return; }
+        if (!gif_img_b_) { return false; }
         ensure_gif_style();
         lv_obj_add_style(gif_img_b_, &s_gif_style, 0);
         lv_obj_add_flag(gif_img_b_, LV_OBJ_FLAG_HIDDEN);
     }
 
-    // CRITICAL: Stop old GIF BEFORE starting new one to prevent concurrent decoder tasks
-    // Just set playing_ = false, the decoder task will exit on its own
-    // The destructor will handle full cleanup asynchronously
+    // CRITICAL: Stop old GIF BEFORE starting new one to prevent concurrent decoders
+    // The destructor handles full cleanup once old_controller goes out of scope
+    std::unique_ptr<LvglGif> old_controller = std::move(gif_controller_);
     if (old_controller) {
         ESP_LOGI(TAG, "Stopping old GIF playback");
         old_controller->Stop();  // Sets playing_ = false, non-blocking
     }
 
     // Render on the inactive view, keep current visible until swap
+    lv_obj_t* active_obj = (active_gif_view_ == 0 ? gif_img_ : gif_img_b_);
     lv_obj_t* target = (active_gif_view_ == 0 ? gif_img_b_ : gif_img_);
     lv_image_set_src(target, new_controller->image_dsc());
-    new_controller->SetFrameCallback([this, target]() {
-        if (target) { lv_obj_invalidate(target); }
+    new_controller->SetFrameCallback([target](const lv_area_t& area) {
+        if (target) { invalidate_gif_area(target, area); }
     });
 
     // Now safe to start new GIF (old one is stopped)
@@ -1333,21 +1408,13 @@ void LcdDisplay::ShowGifImpl_(const uint8_t* gif_data, size_t gif_size, int x, i
     SetGifPos(x, y);
     lv_obj_clear_flag(target, LV_OBJ_FLAG_HIDDEN);
     lv_obj_move_foreground(target);
-
-    if (active_obj) {
-        lv_obj_add_flag(active_obj, LV_OBJ_FLAG_HIDDEN);
-    }
+    lv_obj_add_flag(active_obj, LV_OBJ_FLAG_HIDDEN);
 
     // Commit controller and swap active view index
     gif_controller_ = std::move(new_controller);
-    last_gif_data_ = gif_data;
-    last_gif_size_ = gif_size;
     active_gif_view_ ^= 1u;
     AcquireGifPowerHold();
-
-    ESP_LOGI(TAG, "GIF started via LvglGif controller (official style)");
-
-    // old_controller will be destroyed here (async cleanup in destructor)
+    return true;
 }
 
 void LcdDisplay::HideGif() {
@@ -1393,6 +1460,8 @@ void LcdDisplay::DestroyGif() {
     ReleaseGifPowerHold();
     last_gif_data_ = nullptr;
     last_gif_size_ = 0;
+    last_gif_path_.clear();
+    last_gif_crc_ = 0;
     if (managed_gif_buffer_ != nullptr) {
         heap_caps_free(managed_gif_buffer_);
         managed_gif_buffer_ = nullptr;
@@ -1460,8 +1529,8 @@ void LcdDisplay::ShowGifWithManagedBuffer(uint8_t* gif_data, size_t gif_size, in
         lv_obj_add_style(gif_img_, &s_gif_style, 0);
     }
     lv_image_set_src(gif_img_, gif_controller_->image_dsc());
-    gif_controller_->SetFrameCallback([this]() {
-        if (gif_img_) { lv_obj_invalidate(gif_img_); }
+    gif_controller_->SetFrameCallback([this](const lv_area_t& area) {
+        if (gif_img_) { invalidate_gif_area(gif_img_, area); }
     });
     gif_controller_->Start();
     AcquireGifPowerHold();
@@ -1470,6 +1539,7 @@ void LcdDisplay::ShowGifWithManagedBuffer(uint8_t* gif_data, size_t gif_size, in
     lv_obj_move_foreground(gif_img_);
     last_gif_data_ = temp_buffer;
     last_gif_size_ = gif_size;
+    last_gif_path_.clear();
     // Track owned managed buffer for later free
     uint8_t* old_managed = managed_gif_buffer_;
     managed_gif_buffer_ = temp_buffer;
@@ -1485,117 +1555,6 @@ void LcdDisplay::ShowGifWithManagedBuffer(uint8_t* gif_data, size_t gif_size, in
     ESP_LOGI(TAG, "GIF with managed buffer displayed successfully");
 }
 
-// HTTP下载数据结构
-struct HttpDownloadData {
-    uint8_t* buffer;
-    size_t buffer_size;
-    size_t data_len;
-    size_t content_length;
-    size_t max_size;
-    bool success;
-    // Throttling and yielding helpers
-    TickType_t last_log_tick;
-    int last_percent_logged;
-    size_t last_yield_bytes;
-};
-
-// HTTP事件处理回调
-static esp_err_t http_event_handler(esp_http_client_event_t *evt) {
-    HttpDownloadData* download_data = (HttpDownloadData*)evt->user_data;
-
-    switch(evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGE(TAG, "HTTP_EVENT_ERROR");
-            download_data->success = false;
-            break;
-
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_CONNECTED");
-            break;
-
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGI(TAG, "HTTP_EVENT_HEADER_SENT");
-            break;
-
-        case HTTP_EVENT_ON_HEADER:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-            if (strcasecmp(evt->header_key, "Content-Length") == 0) {
-                size_t content_length = atoi(evt->header_value);
-                ESP_LOGI(TAG, "Content-Length: %zu bytes", content_length);
-
-                download_data->content_length = content_length;
-                // 检查文件大小是否合理 (最大10MB)
-                if (content_length > 10 * 1024 * 1024) {
-                    ESP_LOGE(TAG, "GIF file too large: %zu bytes (max 10MB)", content_length);
-                    download_data->success = false;
-                    return ESP_FAIL;
-                }
-
-                // 重新分配缓冲区以适应实际大小
-                if (content_length > download_data->buffer_size) {
-                    uint8_t* new_buffer = (uint8_t*)heap_caps_realloc(download_data->buffer,
-                                                                     content_length,
-                                                                     MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-                    if (new_buffer == nullptr) {
-                        ESP_LOGE(TAG, "Failed to reallocate buffer for %zu bytes", content_length);
-                        download_data->success = false;
-                        return ESP_FAIL;
-                    }
-                    download_data->buffer = new_buffer;
-                    download_data->buffer_size = content_length;
-                    download_data->max_size = content_length;
-                }
-            }
-            break;
-
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            if (!esp_http_client_is_chunked_response(evt->client)) {
-                // 检查缓冲区空间
-                if (download_data->data_len + evt->data_len > download_data->max_size) {
-                    ESP_LOGE(TAG, "Download data exceeds buffer size");
-                    download_data->success = false;
-                    return ESP_FAIL;
-                }
-
-                // 复制数据到缓冲区
-                memcpy(download_data->buffer + download_data->data_len, evt->data, evt->data_len);
-                download_data->data_len += evt->data_len;
-
-                // 仅每提升>=20%打印一次进度，减少日志影响
-                if (download_data->content_length > 0) {
-                    int progress = (download_data->data_len * 100) / download_data->content_length;
-                    if (download_data->last_percent_logged < 0 ||
-                        progress >= download_data->last_percent_logged + 20) {
-                        ESP_LOGI(TAG, "Download progress: %d%% (%zu/%zu bytes)",
-                                 progress, download_data->data_len, download_data->content_length);
-                        download_data->last_percent_logged = progress;
-                    }
-                }
-
-                // 周期性让出CPU，避免喂狗失败
-                if (download_data->data_len - download_data->last_yield_bytes >= (64 * 1024)) {
-                    vTaskDelay(1);
-                    download_data->last_yield_bytes = download_data->data_len;
-                }
-            }
-            break;
-
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGI(TAG, "HTTP_EVENT_ON_FINISH, total downloaded: %zu bytes", download_data->data_len);
-            download_data->success = true;
-            break;
-
-        case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
-            break;
-
-        default:
-            break;
-    }
-    return ESP_OK;
-}
-
 void LcdDisplay::ShowGifFromUrl(const char* url, int x, int y) {
     if (url == nullptr || strlen(url) == 0) {
         ESP_LOGE(TAG, "Invalid URL provided");
@@ -1613,97 +1572,17 @@ void LcdDisplay::ShowGifFromUrl(const char* url, int x, int y) {
         return;
     }
 
-    // 初始化下载数据结构
-    HttpDownloadData download_data = {0};
-    download_data.buffer_size = 512 * 1024; // 初始512KB缓冲区
-    download_data.max_size = 10 * 1024 * 1024; // 最大10MB
-    download_data.data_len = 0;
-    download_data.content_length = 0;
-    download_data.success = false;
-
-    // 分配初始缓冲区 (优先使用PSRAM)
-    download_data.buffer = (uint8_t*)heap_caps_malloc(download_data.buffer_size,
-                                                     MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    if (download_data.buffer == nullptr) {
-        ESP_LOGE(TAG, "Failed to allocate download buffer");
+    // 共享下载管理器：复用长连接、断点续传、条件请求缓存，并校验 GIF 文件头
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    if (!GifDownloader::GetInstance().Download(url, &data, &size)) {
+        ESP_LOGE(TAG, "GIF download failed: %s", url);
         return;
     }
 
-    // 配置HTTP客户端
-    esp_http_client_config_t config = {};
-    config.url = url;
-    // 初始化下载进度节流状态
-    download_data.last_log_tick = xTaskGetTickCount();
-    download_data.last_percent_logged = -1;
-    download_data.last_yield_bytes = 0;
-
-    config.event_handler = http_event_handler;
-    config.user_data = &download_data;
-    config.timeout_ms = 30000; // 30秒超时
-    config.buffer_size = 4096;
-    config.buffer_size_tx = 1024;
-
-    // 如果是HTTPS，启用证书验证
-    if (strncmp(url, "https://", 8) == 0) {
-        config.use_global_ca_store = true;
-        config.crt_bundle_attach = esp_crt_bundle_attach;
-    }
-
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-    if (client == nullptr) {
-        ESP_LOGE(TAG, "Failed to initialize HTTP client");
-        heap_caps_free(download_data.buffer);
-        return;
-    }
-
-    // 执行HTTP GET请求
-    ESP_LOGI(TAG, "Starting HTTP GET request...");
-    esp_err_t err = esp_http_client_perform(client);
-
-    if (err == ESP_OK) {
-        int status_code = esp_http_client_get_status_code(client);
-        int content_length = esp_http_client_get_content_length(client);
-
-        ESP_LOGI(TAG, "HTTP GET Status = %d, content_length = %d", status_code, content_length);
-
-        if (status_code == 200 && download_data.success && download_data.data_len > 0) {
-            ESP_LOGI(TAG, "GIF download successful: %zu bytes", download_data.data_len);
-
-            // 验证GIF文件头
-            if (download_data.data_len >= 6 &&
-                (memcmp(download_data.buffer, "GIF87a", 6) == 0 ||
-                 memcmp(download_data.buffer, "GIF89a", 6) == 0)) {
-
-                ESP_LOGI(TAG, "Valid GIF file detected, displaying...");
-
-                // 使用管理缓冲区的方法显示GIF
-                // 这会转移缓冲区的所有权给显示系统
-                ShowGifWithManagedBuffer(download_data.buffer, download_data.data_len, x, y);
-
-                // 重要：缓冲区所有权已转移，不要在这里释放
-                download_data.buffer = nullptr;
-
-            } else {
-                ESP_LOGE(TAG, "Downloaded file is not a valid GIF");
-            }
-        } else {
-            ESP_LOGE(TAG, "HTTP request failed: status=%d, success=%d, data_len=%zu",
-                    status_code, download_data.success, download_data.data_len);
-        }
-    } else {
-        ESP_LOGE(TAG, "HTTP GET request failed: %s", esp_err_to_name(err));
-    }
-
-    // 清理资源
-    esp_http_client_cleanup(client);
-
-    // 释放下载缓冲区（如果所有权没有被转移）
-    if (download_data.buffer != nullptr) {
-        heap_caps_free(download_data.buffer);
-        ESP_LOGI(TAG, "Download buffer freed (not used for GIF)");
-    }
-
-    ESP_LOGI(TAG, "GIF download and display process completed");
+    ESP_LOGI(TAG, "GIF download successful: %zu bytes, displaying...", size);
+    // 使用管理缓冲区的方法显示GIF，缓冲区所有权转移给显示系统
+    ShowGifWithManagedBuffer(data, size, x, y);
 }
 
 void LcdDisplay::ShowGifFromFlash(const char* filename, int x, int y) {
@@ -1712,25 +1591,43 @@ void LcdDisplay::ShowGifFromFlash(const char* filename, int x, int y) {
         return;
     }
 
-    ESP_LOGI(TAG, "Loading GIF from Flash: %s", filename);
-
-    uint8_t* gif_data = nullptr;
-    size_t gif_size = 0;
-
-    // Read GIF from Flash storage
-    esp_err_t ret = gif_storage_read(filename, &gif_data, &gif_size);
+    // Stream from the file instead of loading it into PSRAM; gifdec only keeps a
+    // read-ahead window and the frame offset index
+    struct Ctx { LcdDisplay* self; char path[128]; bool indexed; uint32_t crc; int x; int y; SemaphoreHandle_t done; };
+    Ctx* ctx = (Ctx*)heap_caps_malloc(sizeof(Ctx), MALLOC_CAP_INTERNAL);
+    if (!ctx) {
+        ESP_LOGE(TAG, "ShowGifFromFlash: failed to alloc ctx");
+        return;
+    }
+    esp_err_t ret = gif_storage_get_path(filename, ctx->path, sizeof(ctx->path));
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to read GIF from Flash: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "GIF not available in Flash: %s (%s)", filename, esp_err_to_name(ret));
+        heap_caps_free(ctx);
+        return;
+    }
+    gif_storage_entry_t entry;
+    ctx->indexed = gif_storage_get_entry(filename, &entry) == ESP_OK;
+    ctx->crc = ctx->indexed ? entry.crc32 : 0;
+    // Recently shown images are the last to be evicted
+    gif_storage_mark_shown(filename);
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    if (!done) {
+        ESP_LOGE(TAG, "ShowGifFromFlash: failed to create semaphore");
+        heap_caps_free(ctx);
         return;
     }
 
-    ESP_LOGI(TAG, "Successfully loaded GIF from Flash: %s (%zu bytes)", filename, gif_size);
-
-    // Display the GIF using managed buffer (transfers ownership)
-    ShowGifWithManagedBuffer(gif_data, gif_size, x, y);
-
-    // Note: gif_data ownership is transferred to ShowGifWithManagedBuffer
-    // Do not free it here
+    ESP_LOGI(TAG, "Streaming GIF from Flash: %s", ctx->path);
+    ctx->self = this; ctx->x = x; ctx->y = y; ctx->done = done;
+    auto async_cb = [](void* p){
+        Ctx* c = (Ctx*)p;
+        c->self->ShowGifFileImpl_(c->path, c->indexed, c->crc, c->x, c->y);
+        xSemaphoreGive(c->done);
+        heap_caps_free(c);
+    };
+    lv_async_call(async_cb, ctx);
+    (void)xSemaphoreTake(done, pdMS_TO_TICKS(5000));
+    vSemaphoreDelete(done);
 }
 
 void LcdDisplay::ShowCenterMessage(const std::string &message, int duration_ms) {
@@ -38,6 +38,12 @@ protected:
     // Remember last GIF data to avoid redundant restart
     const void* last_gif_data_ = nullptr;
     size_t last_gif_size_ = 0;
+    // VFS path of the streamed GIF (ShowGifFromFlash), empty for memory sources
+    std::string last_gif_path_;
+    // Index CRC of that file; a re-upload under the same name restarts the decoder
+    uint32_t last_gif_crc_ = 0;
+    // Registered with gif_storage_set_release_callback() on the first streamed GIF
+    bool gif_release_callback_set_ = false;
     // Managed download buffer (owned) for ShowGifFromUrl path
     uint8_t* managed_gif_buffer_ = nullptr;
     size_t managed_gif_buffer_size_ = 0;
@@ -97,6 +103,12 @@ private:
 
     // Run on LVGL task context implementations
     void ShowGifImpl_(const uint8_t* gif_data, size_t gif_size, int x, int y);
+    void ShowGifFileImpl_(const char* path, bool indexed, uint32_t crc, int x, int y);
+    // gif_storage is about to delete or replace `path` (any task)
+    static void OnStorageFileReleased(const char* path, void* user_data);
+    // Helpers shared by the memory and file paths (LVGL task context)
+    bool ResumeActiveGif_(int x, int y);
+    bool SwapInGif_(std::unique_ptr<LvglGif> new_controller, int x, int y);
     void HideGifImpl_();
 
     void AcquireGifPowerHold();
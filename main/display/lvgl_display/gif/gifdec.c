@@ -4,11 +4,48 @@
 #include <string.h>
 #include <stdbool.h>
 
+/* GIFDEC_YIELD / GIFDEC_TIME_US may be predefined; outside ESP-IDF (host builds, tests/host)
+ * they default to a no-op and the monotonic clock */
+#ifndef GIFDEC_YIELD
+#ifdef ESP_PLATFORM
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-
-#ifndef GIFDEC_YIELD
 #define GIFDEC_YIELD() do { taskYIELD(); } while (0)
+#else
+#define GIFDEC_YIELD() do { } while (0)
+#endif
+#endif
+
+#if GIFDEC_PROFILE
+#ifndef GIFDEC_TIME_US
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#define GIFDEC_TIME_US() ((uint64_t)esp_timer_get_time())
+#else
+#include <time.h>
+static inline uint64_t gifdec_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+#define GIFDEC_TIME_US() gifdec_time_us()
+#endif
+#endif
+#define GIFDEC_PROF_BEGIN(t) uint64_t t = GIFDEC_TIME_US()
+#define GIFDEC_PROF_END(gif, t, field) do { \
+        uint32_t _elapsed = (uint32_t)(GIFDEC_TIME_US() - (t)); \
+        (gif)->stats.last_##field = _elapsed; \
+        (gif)->stats.field += _elapsed; \
+    } while (0)
+#define GIFDEC_PROF_ALLOC(gif, n) do { \
+        (gif)->stats.frame_alloc_bytes += (uint32_t)(n); \
+        (gif)->stats.total_alloc_bytes += (uint32_t)(n); \
+    } while (0)
+#else
+#define GIFDEC_PROF_BEGIN(t) do { } while (0)
+#define GIFDEC_PROF_END(gif, t, field) do { } while (0)
+#define GIFDEC_PROF_ALLOC(gif, n) do { } while (0)
 #endif
 
 #if LV_GIF_PREFETCH_SUBBLOCKS
@@ -16,27 +53,37 @@ typedef struct {
     const uint8_t* data;
     size_t size;
     size_t byte_pos;
-    uint8_t bit_in_byte; /* 0..7 */
+    uint32_t bits;  /* pending bits, LSB first */
+    int count;      /* number of valid bits in `bits` */
 } gif_bitreader_t;
 
 static inline uint16_t gif_br_get_key(gif_bitreader_t* br, int key_size) {
-    uint16_t key = 0;
-    int bits_read = 0;
-    while (bits_read < key_size) {
-        if (br->byte_pos >= br->size) {
-            return 0x1000; /* signal out-of-data similar to original get_key */
-        }
-        uint8_t byte = br->data[br->byte_pos];
-        int avail = 8 - br->bit_in_byte;
-        int take = (key_size - bits_read < avail) ? (key_size - bits_read) : avail;
-        key |= (uint16_t)(((byte >> br->bit_in_byte) & ((1u << take) - 1u)) << bits_read);
-        br->bit_in_byte += (uint8_t)take;
-        if (br->bit_in_byte == 8) {
-            br->bit_in_byte = 0;
-            br->byte_pos++;
+    uint16_t key;
+    if (br->count < key_size) {
+        if (br->byte_pos + 4 <= br->size) {
+            /* Top up with one little-endian word: the bits of it that fit go in, whole
+             * bytes of those are consumed. The part of a byte shifted in above `count`
+             * is the same stream bits the next refill ORs in again. */
+            const uint8_t *p = br->data + br->byte_pos;
+            uint32_t word = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+            int bytes = (32 - br->count) >> 3;
+            br->bits |= word << br->count;
+            br->byte_pos += bytes;
+            br->count += bytes * 8;
+        } else {
+            /* Last bytes: refill whole bytes while they fit into the 32-bit buffer */
+            while (br->count <= 24 && br->byte_pos < br->size) {
+                br->bits |= (uint32_t)br->data[br->byte_pos++] << br->count;
+                br->count += 8;
+            }
+            if (br->count < key_size) {
+                return 0x1000; /* signal out-of-data similar to original get_key */
+            }
         }
-        bits_read += take;
     }
+    key = (uint16_t)(br->bits & ((1u << key_size) - 1u));
+    br->bits >>= key_size;
+    br->count -= key_size;
     return key;
 }
 #endif
@@ -59,7 +106,12 @@ typedef struct Table {
 #if LV_GIF_CACHE_DECODE_DATA
 #define LZW_MAXBITS                 12
 #define LZW_TABLE_SIZE              (1 << LZW_MAXBITS)
-#define LZW_CACHE_SIZE              (LZW_TABLE_SIZE * 4)
+/* suffix[] + row-crossing scratch (bytes), prefix[] + length[] (uint16_t);
+ * linear frames use the first 16KB as a uint32_t string offset table instead */
+#define LZW_CACHE_SIZE              (LZW_TABLE_SIZE * 6)
+/* The cache follows the byte-sized frame buffer; padding keeps its uint16_t/uint32_t
+ * tables aligned whatever width * height is (Xtensa faults on unaligned access) */
+#define LZW_CACHE_ALIGN             4
 #endif
 
 static gd_GIF  * gif_open(gd_GIF * gif);
@@ -112,6 +164,7 @@ static gd_GIF * gif_open(gd_GIF * gif_base)
     uint8_t fdsz, bgidx, aspect;
     uint8_t * bgcolor;
     int gct_sz;
+    size_t gif_size;
     gd_GIF * gif = NULL;
 
     /* Header */
@@ -152,17 +205,19 @@ static gd_GIF * gif_open(gd_GIF * gif_base)
     }
 #if LV_GIF_CACHE_DECODE_DATA
     #if GIFDEC_USE_RGB565
-    if(0 == (INT_MAX - sizeof(gd_GIF) - LZW_CACHE_SIZE) / width / height / 3){
+    if(0 == (INT_MAX - sizeof(gd_GIF) - (LZW_CACHE_ALIGN - 1) - LZW_CACHE_SIZE) / width / height / 3){
         LV_LOG_WARN("Image dimensions are too large");
         goto fail;
     }
-    gif = lv_malloc(sizeof(gd_GIF) + 3 * width * height + LZW_CACHE_SIZE);
+    gif_size = sizeof(gd_GIF) + 3 * width * height + (LZW_CACHE_ALIGN - 1) + LZW_CACHE_SIZE;
+    gif = lv_malloc(gif_size);
     #else
-    if(0 == (INT_MAX - sizeof(gd_GIF) - LZW_CACHE_SIZE) / width / height / 5){
+    if(0 == (INT_MAX - sizeof(gd_GIF) - (LZW_CACHE_ALIGN - 1) - LZW_CACHE_SIZE) / width / height / 5){
         LV_LOG_WARN("Image dimensions are too large");
         goto fail;
     }
-    gif = lv_malloc(sizeof(gd_GIF) + 5 * width * height + LZW_CACHE_SIZE);
+    gif_size = sizeof(gd_GIF) + 5 * width * height + (LZW_CACHE_ALIGN - 1) + LZW_CACHE_SIZE;
+    gif = lv_malloc(gif_size);
     #endif
 #else
     #if GIFDEC_USE_RGB565
@@ -170,17 +225,22 @@ static gd_GIF * gif_open(gd_GIF * gif_base)
         LV_LOG_WARN("Image dimensions are too large");
         goto fail;
     }
-    gif = lv_malloc(sizeof(gd_GIF) + 3 * width * height);
+    gif_size = sizeof(gd_GIF) + 3 * width * height;
+    gif = lv_malloc(gif_size);
     #else
     if(0 == (INT_MAX - sizeof(gd_GIF)) / width / height / 5){
         LV_LOG_WARN("Image dimensions are too large");
         goto fail;
     }
-    gif = lv_malloc(sizeof(gd_GIF) + 5 * width * height);
+    gif_size = sizeof(gd_GIF) + 5 * width * height;
+    gif = lv_malloc(gif_size);
     #endif
 #endif
     if(!gif) goto fail;
     memcpy(gif, gif_base, sizeof(gd_GIF));
+#if GIFDEC_PROFILE
+    gif->stats.open_bytes = (uint32_t)gif_size;
+#endif
     gif->width  = width;
     gif->height = height;
     gif->depth  = depth;
@@ -203,7 +263,8 @@ static gd_GIF * gif_open(gd_GIF * gif_base)
     }
     bgcolor = &gif->palette->colors[gif->bgindex * 3];
     #if LV_GIF_CACHE_DECODE_DATA
-    gif->lzw_cache = gif->frame + width * height;
+    gif->lzw_cache = (uint8_t *)(((uintptr_t)(gif->frame + width * height) + (LZW_CACHE_ALIGN - 1)) &
+                                 ~(uintptr_t)(LZW_CACHE_ALIGN - 1));
     #endif
 
 #if defined(GIFDEC_FILL_BG) && !(GIFDEC_USE_RGB565)
@@ -397,6 +458,89 @@ get_key(gd_GIF *gif, int key_size, uint8_t *sub_len, uint8_t *shift, uint8_t *by
 }
 
 #if LV_GIF_CACHE_DECODE_DATA
+/* Index entry of the current frame if it was recorded on an earlier pass */
+static const gd_FrameSpan *
+lookup_frame_span(const gd_GIF *gif, uint32_t start)
+{
+    if (gif->frame_no < gif->index_len && gif->index[gif->frame_no].start == start)
+        return &gif->index[gif->frame_no];
+    return NULL;
+}
+
+/* Append the current frame to the index (first pass only; silently stops on OOM) */
+static void
+record_frame_span(gd_GIF *gif, uint32_t start, uint32_t end, uint32_t size)
+{
+    if (gif->frame_no != gif->index_len || gif->index_len == UINT16_MAX)
+        return;
+    if (gif->index_len == gif->index_cap) {
+        uint16_t cap = gif->index_cap ? (uint16_t)MIN(gif->index_cap * 2u, UINT16_MAX) : 16;
+        gd_FrameSpan *index = lv_realloc(gif->index, sizeof(gd_FrameSpan) * cap);
+        if (!index)
+            return;
+        gif->index = index;
+        gif->index_cap = cap;
+    }
+    gif->index[gif->index_len].start = start;
+    gif->index[gif->index_len].end = end;
+    gif->index[gif->index_len].size = size;
+    gif->index_len++;
+}
+
+/* Output cursor over the frame rectangle, walking rows in GIF (optionally interlaced) order */
+typedef struct {
+    uint8_t *base;  /* top-left pixel of the frame rectangle */
+    uint8_t *row;   /* start of the current row */
+    int linesize;
+    int fh;
+    int y;
+    int pass;
+    int interlace;
+} gif_rows_t;
+
+static inline void
+gif_next_row(gif_rows_t *r)
+{
+    if (!r->interlace) {
+        r->row += r->linesize;
+        return;
+    }
+    switch(r->pass) {
+    case 0:
+    case 1:
+        r->y += 8;
+        break;
+    case 2:
+        r->y += 4;
+        break;
+    case 3:
+        r->y += 2;
+        break;
+    default:
+        break;
+    }
+    while (r->y >= r->fh) {
+        r->y = 4 >> r->pass;
+        r->pass++;
+    }
+    r->row = r->base + r->linesize * r->y;
+}
+
+/* Write the dictionary string of `code` (length `len`) backwards so it ends at dst[len - 1].
+ * Return the first (root) value of the string. */
+static inline uint8_t
+lzw_write_string(uint8_t *dst, int len, int code, int new_codes,
+                 const uint8_t *p_suffix, const uint16_t *p_prefix)
+{
+    uint8_t *out = dst + len;
+    while (code >= new_codes) {
+        *--out = p_suffix[code];
+        code = p_prefix[code];
+    }
+    *--out = (uint8_t)code;
+    return (uint8_t)code;
+}
+
 /* Decompress image pixels.
  * Return 0 on success or -1 on out-of-memory (w.r.t. LZW code table) or parse error. */
 static int
@@ -405,20 +549,26 @@ read_image_data(gd_GIF *gif, int interlace)
     uint8_t sub_len, shift, byte;
     int ret = 0;
     int key_size;
-    int y, pass, linesize;
-    uint8_t *ptr = NULL;
-    uint8_t *ptr_row_start = NULL;
-    uint8_t *ptr_base = NULL;
     size_t start, end;
-    uint16_t key, clear_code, stop_code, curr_code;
-    int frm_off, frm_size,curr_size,top_slot,new_codes,slot;
-    /* The first value of the value sequence corresponding to key */
+    uint16_t key, clear_code, stop_code;
+    int code, len, frm_off, frm_size, curr_size, top_slot, new_codes, slot;
+    /* The first value of the value sequence corresponding to last_key */
     int first_value;
     int last_key;
-    uint8_t *sp = NULL;
-    uint8_t *p_stack = NULL;
-    uint8_t *p_suffix = NULL;
-    uint16_t *p_prefix = NULL;
+    /* Pixels left before the cursor has to move to the next row */
+    int row_left;
+    /* Full-width progressive frame: output is one linear run */
+    int linear;
+    /* Frame offset where last_key's string was written (linear frames) */
+    int prev_off = 0;
+    uint8_t *ptr;
+    uint8_t *p_stack;
+    uint8_t *p_suffix;
+    uint16_t *p_prefix;
+    uint16_t *p_length;
+    uint32_t *p_offset;
+    const gd_FrameSpan *span;
+    gif_rows_t rows;
 #if LV_GIF_PREFETCH_SUBBLOCKS
     uint8_t *comp_buf = NULL;
     size_t comp_size = 0;
@@ -433,26 +583,36 @@ read_image_data(gd_GIF *gif, int interlace)
     key = 0;
 
     start = f_gif_seek(gif, 0, LV_FS_SEEK_CUR);
-    discard_sub_blocks(gif);
-    end = f_gif_seek(gif, 0, LV_FS_SEEK_CUR);
-    f_gif_seek(gif, start, LV_FS_SEEK_SET);
+    span = lookup_frame_span(gif, start);
+    if (span) {
+        end = span->end;
+    } else {
+        discard_sub_blocks(gif);
+        end = f_gif_seek(gif, 0, LV_FS_SEEK_CUR);
+        f_gif_seek(gif, start, LV_FS_SEEK_SET);
+    }
 
 #if LV_GIF_PREFETCH_SUBBLOCKS
     /* Prefetch sub-blocks into contiguous buffer and prepare bitreader */
     {
         uint8_t blen;
-        size_t pos_saved = f_gif_seek(gif, 0, LV_FS_SEEK_CUR);
-        /* pass 1: compute total payload size */
-        comp_size = 0;
-        for (;;) {
-            f_gif_read(gif, &blen, 1);
-            if (blen == 0) break;
-            comp_size += blen;
-            f_gif_seek(gif, blen, LV_FS_SEEK_CUR);
+        if (span) {
+            comp_size = span->size;
+        } else {
+            /* pass 1: compute total payload size */
+            comp_size = 0;
+            for (;;) {
+                f_gif_read(gif, &blen, 1);
+                if (blen == 0) break;
+                comp_size += blen;
+                f_gif_seek(gif, blen, LV_FS_SEEK_CUR);
+            }
+            record_frame_span(gif, start, end, comp_size);
         }
         if (comp_size > 0) {
             comp_buf = lv_malloc(comp_size);
             if (comp_buf) {
+                GIFDEC_PROF_ALLOC(gif, comp_size);
                 /* pass 2: copy payload */
                 f_gif_seek(gif, start, LV_FS_SEEK_SET);
                 size_t copied = 0;
@@ -464,80 +624,49 @@ read_image_data(gd_GIF *gif, int interlace)
                 }
                 br.data = comp_buf;
                 br.size = comp_size;
-                br.byte_pos = 0;
-                br.bit_in_byte = 0;
             }
         }
-        /* Move file pointer to end of sub-blocks regardless */
-        f_gif_seek(gif, end, LV_FS_SEEK_SET);
-        (void)pos_saved;
+        /* Without a prefetch buffer get_key() reads sub-blocks from the start */
+        f_gif_seek(gif, comp_buf ? end : start, LV_FS_SEEK_SET);
+    }
+#else
+    if (!span) {
+        record_frame_span(gif, start, end, 0);
     }
 #endif
 
-    linesize = gif->width;
-    ptr_base = &gif->frame[gif->fy * linesize + gif->fx];
-    ptr_row_start = ptr_base;
-    ptr = ptr_row_start;
-    sub_len = shift = 0;
-    /* decoder */
-    pass = 0;
-    y = 0;
-    p_stack = gif->lzw_cache;
-    p_suffix = gif->lzw_cache + LZW_TABLE_SIZE;
-    p_prefix = (uint16_t*)(gif->lzw_cache + LZW_TABLE_SIZE * 2);
+    rows.linesize = gif->width;
+    rows.base = &gif->frame[gif->fy * rows.linesize + gif->fx];
+    rows.row = rows.base;
+    rows.fh = gif->fh;
+    rows.y = 0;
+    rows.pass = 0;
+    rows.interlace = interlace;
+    ptr = rows.row;
     frm_off = 0;
     frm_size = gif->fw * gif->fh;
+    /* Full-width progressive frames are one contiguous run: no row breaks at all, and
+     * every dictionary string can be copied from where it was first written */
+    linear = (!interlace && gif->fw == gif->width);
+    row_left = linear ? frm_size : gif->fw;
+    sub_len = shift = 0;
+
+    p_suffix = gif->lzw_cache;
+    p_stack = gif->lzw_cache + LZW_TABLE_SIZE;
+    p_prefix = (uint16_t*)(gif->lzw_cache + LZW_TABLE_SIZE * 2);
+    p_length = (uint16_t*)(gif->lzw_cache + LZW_TABLE_SIZE * 4);
+    p_offset = (uint32_t*)gif->lzw_cache;
+    for (code = 0; code < clear_code; code++) {
+        p_length[code] = 1;
+    }
     curr_size = key_size + 1;
     top_slot = 1 << curr_size;
     new_codes = clear_code + 2;
     slot = new_codes;
     first_value = -1;
     last_key = -1;
-    sp = p_stack;
 
     while (frm_off < frm_size) {
-        /* copy data to frame buffer */
-        while (sp > p_stack) {
-            if(frm_off >= frm_size){
-                LV_LOG_WARN("LZW table token overflows the frame buffer");
-                ret = -1;
-                goto cleanup;
-            }
-            *ptr++ = *(--sp);
-            frm_off += 1;
-            if ((frm_off & 0x3FFF) == 0) { GIFDEC_YIELD(); }
-            /* read one line */
-            if ((ptr - ptr_row_start) == gif->fw) {
-                if (interlace) {
-                    switch(pass) {
-                    case 0:
-                    case 1:
-                        y += 8;
-                        ptr_row_start += linesize * 8;
-                        break;
-                    case 2:
-                        y += 4;
-                        ptr_row_start += linesize * 4;
-                        break;
-                    case 3:
-                        y += 2;
-                        ptr_row_start += linesize * 2;
-                        break;
-                    default:
-                        break;
-                    }
-                    while (y >= gif->fh) {
-                        y  = 4 >> pass;
-                        ptr_row_start = ptr_base + linesize * y;
-                        pass++;
-                    }
-                } else {
-                    ptr_row_start += linesize;
-                }
-                ptr = ptr_row_start;
-            }
-        }
-
 #if LV_GIF_PREFETCH_SUBBLOCKS
         key = (comp_buf ? gif_br_get_key(&br, curr_size) : get_key(gif, curr_size, &sub_len, &shift, &byte));
 #else
@@ -552,34 +681,94 @@ read_image_data(gd_GIF *gif, int interlace)
             slot = new_codes;
             top_slot = 1 << curr_size;
             first_value = last_key = -1;
-            sp = p_stack;
             continue;
         }
 
-        curr_code = key;
         /*
          * If the current code is a code that will be added to the decoding
          * dictionary, it is composed of the data list corresponding to the
          * previous key and its first data.
          * */
-        if (curr_code == slot && first_value >= 0) {
-            *sp++ = first_value;
-            curr_code = last_key;
-        }else if(curr_code >= slot)
+        if (key == slot && last_key >= 0) {
+            len = p_length[last_key] + 1;
+        } else if (key >= slot) {
             break;
+        } else {
+            len = p_length[key];
+        }
+
+        if (frm_off + len > frm_size) {
+            LV_LOG_WARN("LZW table token overflows the frame buffer");
+            ret = -1;
+            goto cleanup;
+        }
 
-        while (curr_code >= new_codes) {
-            *sp++ = p_suffix[curr_code];
-            curr_code = p_prefix[curr_code];
+        if (linear) {
+            /* The string (or, for key == slot, last_key's string plus its first value)
+             * already sits earlier in the frame: copy it forward, LZ77 style. */
+            if (key < clear_code) {
+                *ptr = (uint8_t)key;
+            } else {
+                const uint8_t *src = rows.base + (key == slot ? (uint32_t)prev_off : p_offset[key]);
+                if (src + len <= ptr) {
+                    memcpy(ptr, src, len);
+                } else {
+                    for (code = 0; code < len; code++) ptr[code] = src[code];
+                }
+            }
+            ptr += len;
+        } else {
+            /* Copy the whole string into the frame: in place when it fits the current row,
+             * otherwise through p_stack and split across rows. */
+            uint8_t *dst = (len <= row_left) ? ptr : p_stack;
+            if (key == slot) {
+                dst[len - 1] = (uint8_t)first_value;
+                first_value = lzw_write_string(dst, len - 1, last_key, new_codes, p_suffix, p_prefix);
+            } else {
+                first_value = lzw_write_string(dst, len, key, new_codes, p_suffix, p_prefix);
+            }
+
+            if (dst == ptr) {
+                ptr += len;
+                row_left -= len;
+                if (row_left == 0 && frm_off + len < frm_size) {
+                    gif_next_row(&rows);
+                    ptr = rows.row;
+                    row_left = gif->fw;
+                }
+            } else {
+                const uint8_t *src = p_stack;
+                int left = len;
+                while (left > 0) {
+                    int n = MIN(left, row_left);
+                    memcpy(ptr, src, n);
+                    src += n;
+                    left -= n;
+                    ptr += n;
+                    row_left -= n;
+                    if (row_left == 0 && frm_off + (len - left) < frm_size) {
+                        gif_next_row(&rows);
+                        ptr = rows.row;
+                        row_left = gif->fw;
+                    }
+                }
+            }
         }
-        *sp++ = curr_code;
+        if (((frm_off + len) ^ frm_off) & ~0x3FFF) { GIFDEC_YIELD(); }
 
         /* Add code to decoding dictionary */
         if (slot < top_slot && last_key >= 0) {
-            p_suffix[slot] = curr_code;
-            p_prefix[slot++] = last_key;
+            if (linear) {
+                p_offset[slot] = (uint32_t)prev_off;
+            } else {
+                p_suffix[slot] = (uint8_t)first_value;
+                p_prefix[slot] = (uint16_t)last_key;
+            }
+            p_length[slot] = p_length[last_key] + 1;
+            slot++;
         }
-        first_value = curr_code;
+        prev_off = frm_off;
+        frm_off += len;
         last_key = key;
         if (slot >= top_slot) {
             if (curr_size < LZW_MAXBITS) {
@@ -592,13 +781,11 @@ read_image_data(gd_GIF *gif, int interlace)
 cleanup:
 #if LV_GIF_PREFETCH_SUBBLOCKS
     if (comp_buf) lv_free(comp_buf);
-    f_gif_seek(gif, end, LV_FS_SEEK_SET);
-    return ret;
 #else
     if (key == stop_code) f_gif_read(gif, &sub_len, 1); /* Must be zero! */
+#endif
     f_gif_seek(gif, end, LV_FS_SEEK_SET);
     return ret;
-#endif
 }
 #else
 static Table *
@@ -907,12 +1094,28 @@ int
 gd_get_frame(gd_GIF * gif)
 {
     char sep;
+    int ret;
 
+#if GIFDEC_PROFILE
+    gif->stats.frame_alloc_bytes = 0;
+#endif
+    if(gif->gce.disposal == 2) {
+        gif->dx = gif->fx;
+        gif->dy = gif->fy;
+        gif->dw = gif->fw;
+        gif->dh = gif->fh;
+    }
+    else {
+        gif->dw = gif->dh = 0;
+    }
+    GIFDEC_PROF_BEGIN(t_dispose);
     dispose(gif);
+    GIFDEC_PROF_END(gif, t_dispose, dispose_us);
     f_gif_read(gif, &sep, 1);
     while(sep != ',') {
         if(sep == ';') {
             f_gif_seek(gif, gif->anim_start, LV_FS_SEEK_SET);
+            gif->frame_no = 0;
             if(gif->loop_count == 1 || gif->loop_count < 0) {
                 return 0;
             }
@@ -925,15 +1128,26 @@ gd_get_frame(gd_GIF * gif)
         else return -1;
         f_gif_read(gif, &sep, 1);
     }
-    if(read_image(gif) == -1)
+    GIFDEC_PROF_BEGIN(t_decode);
+    ret = read_image(gif);
+    GIFDEC_PROF_END(gif, t_decode, decode_us);
+    if(ret == -1)
         return -1;
+    gif->frame_no++;
+#if GIFDEC_PROFILE
+    gif->stats.frames++;
+    if(gif->stats.frame_alloc_bytes > gif->stats.peak_alloc_bytes)
+        gif->stats.peak_alloc_bytes = gif->stats.frame_alloc_bytes;
+#endif
     return 1;
 }
 
 void
 gd_render_frame(gd_GIF * gif, uint8_t * buffer)
 {
+    GIFDEC_PROF_BEGIN(t_render);
     render_frame_rect(gif, buffer);
+    GIFDEC_PROF_END(gif, t_render, render_us);
 }
 
 void
@@ -941,6 +1155,33 @@ gd_rewind(gd_GIF * gif)
 {
     gif->loop_count = -1;
     f_gif_seek(gif, gif->anim_start, LV_FS_SEEK_SET);
+    gif->frame_no = 0;
+}
+
+void
+gd_get_update_rect(const gd_GIF * gif, uint16_t * x, uint16_t * y, uint16_t * w, uint16_t * h)
+{
+    uint16_t x0 = gif->fx, y0 = gif->fy;
+    uint16_t x1 = gif->fx + gif->fw, y1 = gif->fy + gif->fh;
+
+    if(gif->dw && gif->dh) {
+        if(gif->fw && gif->fh) {
+            x0 = MIN(x0, gif->dx);
+            y0 = MIN(y0, gif->dy);
+            x1 = MAX(x1, gif->dx + gif->dw);
+            y1 = MAX(y1, gif->dy + gif->dh);
+        }
+        else {
+            x0 = gif->dx;
+            y0 = gif->dy;
+            x1 = gif->dx + gif->dw;
+            y1 = gif->dy + gif->dh;
+        }
+    }
+    *x = x0;
+    *y = y0;
+    *w = x1 - x0;
+    *h = y1 - y0;
 }
 
 void
@@ -950,16 +1191,33 @@ gd_close_gif(gd_GIF * gif)
     lv_free(gif);
 }
 
+#if GIFDEC_PROFILE
+void
+gd_reset_stats(gd_GIF * gif)
+{
+    uint32_t open_bytes = gif->stats.open_bytes;
+    memset(&gif->stats, 0, sizeof(gif->stats));
+    gif->stats.open_bytes = open_bytes;
+}
+#endif
+
 static bool f_gif_open(gd_GIF * gif, const void * path, bool is_file)
 {
     gif->f_rw_p = 0;
     gif->data = NULL;
     gif->is_file = is_file;
+    gif->ra_buf = NULL;
+    gif->ra_pos = 0;
+    gif->ra_len = 0;
 
     if(is_file) {
         lv_fs_res_t res = lv_fs_open(&gif->fd, path, LV_FS_MODE_RD);
         if(res != LV_FS_RES_OK) return false;
-        else return true;
+#if GIFDEC_READ_AHEAD_SIZE
+        /* Without the buffer every 1-byte header read would hit the filesystem */
+        gif->ra_buf = lv_malloc(GIFDEC_READ_AHEAD_SIZE);
+#endif
+        return true;
     }
     else {
         gif->data = path;
@@ -967,10 +1225,44 @@ static bool f_gif_open(gd_GIF * gif, const void * path, bool is_file)
     }
 }
 
+/* Read len bytes at the logical file position straight from lv_fs; zero-fill past EOF */
+static void f_gif_read_direct(gd_GIF * gif, uint8_t * buf, size_t len)
+{
+    uint32_t br = 0;
+    lv_fs_seek(&gif->fd, gif->f_rw_p, LV_FS_SEEK_SET);
+    lv_fs_read(&gif->fd, buf, len, &br);
+    if(br < len) memset(buf + br, 0, len - br);
+    gif->f_rw_p += len;
+}
+
 static void f_gif_read(gd_GIF * gif, void * buf, size_t len)
 {
     if(gif->is_file) {
-        lv_fs_read(&gif->fd, buf, len, NULL);
+        uint8_t * dst = buf;
+        while(len > 0) {
+            if(gif->f_rw_p >= gif->ra_pos && gif->f_rw_p - gif->ra_pos < gif->ra_len) {
+                uint32_t off = gif->f_rw_p - gif->ra_pos;
+                size_t n = MIN(len, gif->ra_len - off);
+                memcpy(dst, gif->ra_buf + off, n);
+                dst += n;
+                len -= n;
+                gif->f_rw_p += n;
+                continue;
+            }
+#if GIFDEC_READ_AHEAD_SIZE
+            if(gif->ra_buf && len < GIFDEC_READ_AHEAD_SIZE) {
+                uint32_t br = 0;
+                lv_fs_seek(&gif->fd, gif->f_rw_p, LV_FS_SEEK_SET);
+                lv_fs_read(&gif->fd, gif->ra_buf, GIFDEC_READ_AHEAD_SIZE, &br);
+                gif->ra_pos = gif->f_rw_p;
+                gif->ra_len = br;
+                if(br > 0) continue;
+            }
+#endif
+            /* Large reads (sub-block payloads) bypass the read-ahead window */
+            f_gif_read_direct(gif, dst, len);
+            return;
+        }
     }
     else {
         memcpy(buf, &gif->data[gif->f_rw_p], len);
@@ -980,23 +1272,30 @@ static void f_gif_read(gd_GIF * gif, void * buf, size_t len)
 
 static int f_gif_seek(gd_GIF * gif, size_t pos, int k)
 {
-    if(gif->is_file) {
+    if(gif->is_file && k == LV_FS_SEEK_END) {
+        uint32_t x = 0;
         lv_fs_seek(&gif->fd, pos, k);
-        uint32_t x;
         lv_fs_tell(&gif->fd, &x);
+        gif->f_rw_p = x;
         return x;
     }
-    else {
-        if(k == LV_FS_SEEK_CUR) gif->f_rw_p += pos;
-        else if(k == LV_FS_SEEK_SET) gif->f_rw_p = pos;
-        return gif->f_rw_p;
-    }
+    /* File sources only move the logical position; lv_fs is repositioned on the next refill */
+    if(k == LV_FS_SEEK_CUR) gif->f_rw_p += pos;
+    else if(k == LV_FS_SEEK_SET) gif->f_rw_p = pos;
+    return gif->f_rw_p;
 }
 
 static void f_gif_close(gd_GIF * gif)
 {
     if(gif->is_file) {
         lv_fs_close(&gif->fd);
+        if(gif->ra_buf) {
+            lv_free(gif->ra_buf);
+            gif->ra_buf = NULL;
+        }
+    }
+    if(gif->index) {
+        lv_free(gif->index);
+        gif->index = NULL;
     }
 }
-
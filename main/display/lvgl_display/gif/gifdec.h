@@ -14,7 +14,7 @@ extern "C" {
 #define GIFDEC_USE_RGB565 1
 #endif
 
-// Enable LZW decode working cache to improve performance (adds ~16KB per decoder instance)
+// Enable LZW decode working cache to improve performance (adds ~24KB per decoder instance)
 #ifndef LV_GIF_CACHE_DECODE_DATA
 #define LV_GIF_CACHE_DECODE_DATA 1
 #endif
@@ -24,6 +24,16 @@ extern "C" {
 #define LV_GIF_PREFETCH_SUBBLOCKS 1
 #endif
 
+/* Read-ahead buffer for file sources (gd_open_gif_file); 0 reads straight through lv_fs */
+#ifndef GIFDEC_READ_AHEAD_SIZE
+#define GIFDEC_READ_AHEAD_SIZE 4096
+#endif
+
+/* Collect per-frame decode/dispose/render timings and transient allocation counters (gd_GIF::stats) */
+#ifndef GIFDEC_PROFILE
+#define GIFDEC_PROFILE 0
+#endif
+
 typedef struct _gd_Palette {
     int size;
     uint8_t colors[0x100 * 3];
@@ -37,6 +47,29 @@ typedef struct _gd_GCE {
     int transparency;
 } gd_GCE;
 
+/* LZW data span of one frame, recorded during the first pass so later passes
+ * can skip scanning the sub-block chain */
+typedef struct _gd_FrameSpan {
+    uint32_t start; /* first sub-block, after the LZW minimum code size byte */
+    uint32_t end;   /* just past the block terminator */
+    uint32_t size;  /* payload bytes without sub-block length prefixes */
+} gd_FrameSpan;
+
+#if GIFDEC_PROFILE
+typedef struct _gd_Stats {
+    uint32_t frames;            /* frames decoded since open / last reset */
+    uint64_t decode_us;         /* accumulated LZW decode time */
+    uint64_t dispose_us;        /* accumulated disposal time */
+    uint64_t render_us;         /* accumulated palette -> canvas render time */
+    uint32_t last_decode_us;
+    uint32_t last_dispose_us;
+    uint32_t last_render_us;
+    uint32_t open_bytes;        /* persistent allocation made by gd_open_gif_* */
+    uint32_t frame_alloc_bytes; /* transient bytes allocated while decoding the last frame */
+    uint32_t total_alloc_bytes; /* transient bytes allocated since open / last reset */
+    uint32_t peak_alloc_bytes;  /* largest transient allocation seen for a single frame */
+} gd_Stats;
+#endif
 
 
 typedef struct _gd_GIF {
@@ -44,6 +77,14 @@ typedef struct _gd_GIF {
     const char * data;
     uint8_t is_file;
     uint32_t f_rw_p;
+    /* File sources: read-ahead window [ra_pos, ra_pos + ra_len) */
+    uint8_t * ra_buf;
+    uint32_t ra_pos;
+    uint32_t ra_len;
+    /* Frame offset index and the frame number within the current pass */
+    gd_FrameSpan * index;
+    uint16_t index_len, index_cap;
+    uint16_t frame_no;
     int32_t anim_start;
     uint16_t width, height;
     uint16_t depth;
@@ -59,6 +100,8 @@ typedef struct _gd_GIF {
     void (*comment)(struct _gd_GIF * gif);
     void (*application)(struct _gd_GIF * gif, char id[8], char auth[3]);
     uint16_t fx, fy, fw, fh;
+    /* Area restored to background by the last dispose() (0x0 if none) */
+    uint16_t dx, dy, dw, dh;
     uint8_t bgindex;
     uint8_t * canvas, * frame;
 #if LV_GIF_CACHE_DECODE_DATA
@@ -68,6 +111,9 @@ typedef struct _gd_GIF {
     uint16_t pal16_cache[256];
     uint8_t  pal_dirty; /* 1 if palette changed and cache needs rebuild */
 #endif
+#if GIFDEC_PROFILE
+    gd_Stats stats;
+#endif
 } gd_GIF;
 
 gd_GIF * gd_open_gif_file(const char * fname);
@@ -78,8 +124,16 @@ void gd_render_frame(gd_GIF * gif, uint8_t * buffer);
 
 int gd_get_frame(gd_GIF * gif);
 void gd_rewind(gd_GIF * gif);
+/* Canvas area changed by the last gd_get_frame()/gd_render_frame() pair:
+ * the current frame rectangle united with the area cleared by disposal. */
+void gd_get_update_rect(const gd_GIF * gif, uint16_t * x, uint16_t * y, uint16_t * w, uint16_t * h);
 void gd_close_gif(gd_GIF * gif);
 
+#if GIFDEC_PROFILE
+/* Clear accumulated counters (open_bytes is kept) */
+void gd_reset_stats(gd_GIF * gif);
+#endif
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
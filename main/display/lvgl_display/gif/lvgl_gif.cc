@@ -2,6 +2,7 @@
 #include <esp_log.h>
 #include <esp_heap_caps.h>
 #include <cstring>
+#include <cstdio>
 #include "sdkconfig.h"
 
 // Forward declarations to avoid including esp_lvgl_port.h here
@@ -10,6 +11,85 @@ extern "C" void lvgl_port_unlock(void);
 
 #define TAG "LvglGif"
 
+#if GIFDEC_USE_RGB565
+static constexpr size_t kCanvasBytesPerPixel = 2;
+#else
+static constexpr size_t kCanvasBytesPerPixel = 4;
+#endif
+
+// lv_fs drive letter backed by stdio, so gifdec can stream files from any VFS mount
+#ifndef LV_GIF_FS_LETTER
+#define LV_GIF_FS_LETTER 'G'
+#endif
+
+static void* StdioFsOpen(lv_fs_drv_t* drv, const char* path, lv_fs_mode_t mode) {
+    (void)drv;
+    if (mode != LV_FS_MODE_RD) {
+        return nullptr;
+    }
+    // LVGL strips "G:"; keep the path absolute for the VFS
+    char full[LV_FS_MAX_PATH_LENGTH];
+    if (path[0] != '/') {
+        snprintf(full, sizeof(full), "/%s", path);
+        path = full;
+    }
+    return fopen(path, "rb");
+}
+
+static lv_fs_res_t StdioFsClose(lv_fs_drv_t* drv, void* file) {
+    (void)drv;
+    fclose(static_cast<FILE*>(file));
+    return LV_FS_RES_OK;
+}
+
+static lv_fs_res_t StdioFsRead(lv_fs_drv_t* drv, void* file, void* buf, uint32_t btr, uint32_t* br) {
+    (void)drv;
+    size_t n = fread(buf, 1, btr, static_cast<FILE*>(file));
+    if (br) {
+        *br = (uint32_t)n;
+    }
+    return (n == btr || feof(static_cast<FILE*>(file))) ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+}
+
+static lv_fs_res_t StdioFsSeek(lv_fs_drv_t* drv, void* file, uint32_t pos, lv_fs_whence_t whence) {
+    (void)drv;
+    int w = (whence == LV_FS_SEEK_CUR) ? SEEK_CUR : (whence == LV_FS_SEEK_END) ? SEEK_END : SEEK_SET;
+    return fseek(static_cast<FILE*>(file), (long)pos, w) == 0 ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+}
+
+static lv_fs_res_t StdioFsTell(lv_fs_drv_t* drv, void* file, uint32_t* pos) {
+    (void)drv;
+    long p = ftell(static_cast<FILE*>(file));
+    if (p < 0) {
+        return LV_FS_RES_FS_ERR;
+    }
+    *pos = (uint32_t)p;
+    return LV_FS_RES_OK;
+}
+
+// Register the driver once; LVGL keeps a pointer to the static descriptor (LVGL thread)
+static bool RegisterStdioFsDriver() {
+    static lv_fs_drv_t drv;
+    static bool registered = false;
+    if (registered) {
+        return true;
+    }
+    if (lv_fs_get_drv(LV_GIF_FS_LETTER) != nullptr) {
+        ESP_LOGE(TAG, "lv_fs letter '%c' already taken", LV_GIF_FS_LETTER);
+        return false;
+    }
+    lv_fs_drv_init(&drv);
+    drv.letter = LV_GIF_FS_LETTER;
+    drv.open_cb = StdioFsOpen;
+    drv.close_cb = StdioFsClose;
+    drv.read_cb = StdioFsRead;
+    drv.seek_cb = StdioFsSeek;
+    drv.tell_cb = StdioFsTell;
+    lv_fs_drv_register(&drv);
+    registered = true;
+    return true;
+}
+
 LvglGif::LvglGif(const lv_img_dsc_t* img_dsc)
     : gif_(nullptr), timer_(nullptr), last_call_(0), playing_(false), loaded_(false) {
     if (!img_dsc || !img_dsc->data) {
@@ -20,8 +100,33 @@ LvglGif::LvglGif(const lv_img_dsc_t* img_dsc)
     gif_ = gd_open_gif_data(img_dsc->data);
     if (!gif_) {
         ESP_LOGE(TAG, "Failed to open GIF from image descriptor");
+        return;
+    }
+    InitFromDecoder("image descriptor");
+}
+
+LvglGif::LvglGif(const char* file_path)
+    : gif_(nullptr), timer_(nullptr), last_call_(0), playing_(false), loaded_(false) {
+    if (!file_path || file_path[0] == '\0') {
+        ESP_LOGE(TAG, "Invalid file path");
+        return;
+    }
+
+    char lv_path[LV_FS_MAX_PATH_LENGTH];
+    if (!RegisterStdioFsDriver() ||
+        snprintf(lv_path, sizeof(lv_path), "%c:%s", LV_GIF_FS_LETTER, file_path) >= (int)sizeof(lv_path)) {
+        ESP_LOGE(TAG, "Cannot stream %s", file_path);
+        return;
+    }
+    gif_ = gd_open_gif_file(lv_path);
+    if (!gif_) {
+        ESP_LOGE(TAG, "Failed to open GIF file %s", file_path);
+        return;
     }
+    InitFromDecoder(file_path);
+}
 
+void LvglGif::InitFromDecoder(const char* source) {
     // Setup LVGL image descriptor
     memset(&img_dsc_, 0, sizeof(img_dsc_));
     img_dsc_.header.magic = LV_IMAGE_HEADER_MAGIC;
@@ -43,21 +148,19 @@ LvglGif::LvglGif(const lv_img_dsc_t* img_dsc)
 #endif
 
     // Decode and render the very first frame synchronously so something is visible immediately
-    if (gif_) {
-        int ret = gd_get_frame(gif_);
-        if (ret < 0) {
-            ESP_LOGW(TAG, "Failed to decode first frame");
-        }
-        if (gif_->canvas) {
-            gd_render_frame(gif_, gif_->canvas);
-        }
+    int ret = gd_get_frame(gif_);
+    if (ret < 0) {
+        ESP_LOGW(TAG, "Failed to decode first frame");
+    }
+    if (gif_->canvas) {
+        gd_render_frame(gif_, gif_->canvas);
     }
     // First frame is considered index 0
     frame_index_ = 0;
 
     loaded_ = true;
     last_call_ = lv_tick_get();
-    ESP_LOGI(TAG, "GIF loaded from image descriptor: %dx%d", gif_->width, gif_->height);
+    ESP_LOGI(TAG, "GIF loaded from %s: %dx%d", source, gif_->width, gif_->height);
 }
 
 // Destructor
@@ -86,6 +189,15 @@ void LvglGif::Start() {
         gif_->loop_count = 1;
     }
 
+    // Only manual infinite loops replay frames; record the first frame before it is overdrawn
+    if (frame_cache_state_ == FrameCacheState::kRecording && frame_cache_.empty()) {
+        if (!force_infinite_ || frame_index_ != 0) {
+            DisableFrameCache("not looping");
+        } else if (!CacheCurrentFrame()) {
+            DisableFrameCache("first frame does not fit");
+        }
+    }
+
     playing_ = true;
     last_call_ = lv_tick_get();
 
@@ -124,7 +236,15 @@ void LvglGif::Stop() {
     if (timer_) lv_timer_pause(timer_);
     if (gif_) {
         gd_rewind(gif_);
-        frame_index_ = 0; // reset frame index on rewind
+        if (frame_cache_state_ == FrameCacheState::kReady) {
+            // Next tick wraps around and replays the full first frame
+            frame_index_ = frame_cache_.size() - 1;
+        } else {
+            if (frame_cache_state_ == FrameCacheState::kRecording && !frame_cache_.empty()) {
+                DisableFrameCache("stopped during first pass");
+            }
+            frame_index_ = 0; // reset frame index on rewind
+        }
         ESP_LOGI(TAG, "GIF animation stopped and rewound");
     }
 }
@@ -172,15 +292,24 @@ uint16_t LvglGif::height() const {
     return gif_->height;
 }
 
-void LvglGif::SetFrameCallback(std::function<void()> callback) {
+void LvglGif::SetFrameCallback(std::function<void(const lv_area_t& area)> callback) {
     frame_callback_ = callback;
 }
 
+void LvglGif::SetFrameCacheBudget(size_t bytes) {
+    frame_cache_budget_ = bytes;
+    if (bytes == 0) {
+        DisableFrameCache("budget is 0");
+    } else if (frame_cache_bytes_ > bytes) {
+        DisableFrameCache("budget shrunk");
+    }
+}
+
 // Static
 void LvglGif::AsyncFrameCb(void* user_data) {
     LvglGif* self = static_cast<LvglGif*>(user_data);
-    if (self && self->frame_callback_) {
-        self->frame_callback_();
+    if (self && self->gif_) {
+        self->NotifyFrameUpdated(0, 0, self->gif_->width, self->gif_->height);
     }
 }
 
@@ -197,8 +326,9 @@ void LvglGif::TickOnce() {
         return;
     }
 
+    const bool cached = (frame_cache_state_ == FrameCacheState::kReady);
     uint32_t elapsed = lv_tick_elaps(last_call_);
-    uint32_t orig_ms = (uint32_t)gif_->gce.delay * 10u;
+    uint32_t orig_ms = (uint32_t)(cached ? frame_cache_[frame_index_].delay : gif_->gce.delay) * 10u;
     // Heuristic: large frames need some throttle to avoid starving LVGL
     const uint32_t pixels = (uint32_t)gif_->width * (uint32_t)gif_->height;
     const bool heavy_frame = (pixels >= 160000u); // ~400x400 and above
@@ -209,11 +339,19 @@ void LvglGif::TickOnce() {
     }
     last_call_ = lv_tick_get();
 
+    if (cached) {
+        ReplayNextCachedFrame();
+        return;
+    }
+
     // Decode next frame (we are on LVGL thread so lv_malloc is safe)
     int has_next = gd_get_frame(gif_);
     if (has_next <= 0) {
         if (has_next == 0) {
             ESP_LOGI(TAG, "GIF reached trailer (loop_count=%d)", (int)gif_->loop_count);
+#if GIFDEC_PROFILE
+            LogProfile();
+#endif
         } else {
             static int s_end_err_logs = 0;
             if (((++s_end_err_logs) & 0x1F) == 1) {
@@ -221,8 +359,22 @@ void LvglGif::TickOnce() {
             }
         }
         if (force_infinite_) {
+            if (frame_cache_state_ == FrameCacheState::kRecording) {
+                if (has_next == 0 && frame_cache_.size() == frame_index_ + 1) {
+                    frame_cache_state_ = FrameCacheState::kReady;
+                    ESP_LOGI(TAG, "Frame cache ready: %u frames, %u KB PSRAM",
+                             (unsigned)frame_cache_.size(), (unsigned)(frame_cache_bytes_ / 1024));
+                } else {
+                    DisableFrameCache("incomplete first pass");
+                }
+            }
             gd_rewind(gif_);
             gif_->loop_count = 1; // keep single-pass scheme for manual infinite loop
+            if (frame_cache_state_ == FrameCacheState::kReady) {
+                // Last frame's delay has already elapsed: show the first frame now
+                ReplayNextCachedFrame();
+                return;
+            }
             frame_index_ = 0;
             static int s_rewind_logs = 0;
             if (((++s_rewind_logs) & 0x1F) == 1) {
@@ -242,12 +394,129 @@ void LvglGif::TickOnce() {
     if (gif_->canvas) {
         // Render to canvas and notify UI
         gd_render_frame(gif_, gif_->canvas);
-        if (frame_callback_) {
-            frame_callback_(); // already in LVGL thread
+        if (frame_cache_state_ == FrameCacheState::kRecording && !CacheCurrentFrame()) {
+            DisableFrameCache("over budget");
         }
+        uint16_t x, y, w, h;
+        gd_get_update_rect(gif_, &x, &y, &w, &h);
+        NotifyFrameUpdated(x, y, w, h); // already in LVGL thread
     }
 }
 
+void LvglGif::NotifyFrameUpdated(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    if (!frame_callback_ || w == 0 || h == 0) {
+        return;
+    }
+    lv_area_t area;
+    area.x1 = x;
+    area.y1 = y;
+    area.x2 = x + w - 1;
+    area.y2 = y + h - 1;
+    frame_callback_(area);
+}
+
+bool LvglGif::CacheCurrentFrame() {
+    if (!gif_ || !gif_->canvas || frame_cache_.size() != frame_index_) {
+        return false;
+    }
+
+    uint16_t x = 0, y = 0, w = gif_->width, h = gif_->height;
+    if (!frame_cache_.empty()) {
+        gd_get_update_rect(gif_, &x, &y, &w, &h);
+    }
+
+    const size_t bytes = (size_t)w * h * kCanvasBytesPerPixel;
+    if (frame_cache_bytes_ + bytes > frame_cache_budget_) {
+        ESP_LOGI(TAG, "Frame cache budget %u KB exceeded at frame %u",
+                 (unsigned)(frame_cache_budget_ / 1024), (unsigned)frame_index_);
+        return false;
+    }
+
+    uint8_t* pixels = nullptr;
+    if (bytes > 0) {
+        if (heap_caps_get_free_size(MALLOC_CAP_SPIRAM) < bytes + kFrameCacheMinFreePsram) {
+            ESP_LOGI(TAG, "Frame cache: PSRAM low at frame %u", (unsigned)frame_index_);
+            return false;
+        }
+        pixels = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!pixels) {
+            return false;
+        }
+        const size_t stride = (size_t)gif_->width * kCanvasBytesPerPixel;
+        const size_t row_bytes = (size_t)w * kCanvasBytesPerPixel;
+        const uint8_t* src = gif_->canvas + (size_t)y * stride + (size_t)x * kCanvasBytesPerPixel;
+        for (uint16_t row = 0; row < h; ++row) {
+            memcpy(pixels + row * row_bytes, src, row_bytes);
+            src += stride;
+        }
+    }
+
+    frame_cache_.push_back({x, y, w, h, gif_->gce.delay, pixels});
+    frame_cache_bytes_ += bytes;
+    return true;
+}
+
+void LvglGif::ApplyCachedFrame(const CachedFrame& frame) {
+    if (!frame.pixels) {
+        return;
+    }
+    const size_t stride = (size_t)gif_->width * kCanvasBytesPerPixel;
+    const size_t row_bytes = (size_t)frame.w * kCanvasBytesPerPixel;
+    uint8_t* dst = gif_->canvas + (size_t)frame.y * stride + (size_t)frame.x * kCanvasBytesPerPixel;
+    const uint8_t* src = frame.pixels;
+    for (uint16_t row = 0; row < frame.h; ++row) {
+        memcpy(dst, src, row_bytes);
+        dst += stride;
+        src += row_bytes;
+    }
+}
+
+void LvglGif::ReplayNextCachedFrame() {
+    frame_index_ = (frame_index_ + 1) % frame_cache_.size();
+    const CachedFrame& frame = frame_cache_[frame_index_];
+    ApplyCachedFrame(frame);
+    NotifyFrameUpdated(frame.x, frame.y, frame.w, frame.h);
+}
+
+void LvglGif::DisableFrameCache(const char* reason) {
+    if (frame_cache_state_ == FrameCacheState::kDisabled) {
+        return;
+    }
+    if (!frame_cache_.empty()) {
+        ESP_LOGI(TAG, "Frame cache disabled (%s), decoding live", reason);
+    }
+    ReleaseFrameCache();
+    frame_cache_state_ = FrameCacheState::kDisabled;
+}
+
+void LvglGif::ReleaseFrameCache() {
+    for (auto& frame : frame_cache_) {
+        if (frame.pixels) {
+            heap_caps_free(frame.pixels);
+        }
+    }
+    std::vector<CachedFrame>().swap(frame_cache_);
+    frame_cache_bytes_ = 0;
+}
+
+#if GIFDEC_PROFILE
+void LvglGif::LogProfile() {
+    const gd_Stats& st = gif_->stats;
+    if (st.frames == 0) {
+        return;
+    }
+    const uint64_t busy_us = st.decode_us + st.dispose_us + st.render_us;
+    const uint32_t fps_x10 = busy_us ? (uint32_t)((uint64_t)st.frames * 10000000ull / busy_us) : 0;
+    ESP_LOGI(TAG, "profile %ux%u: %u frames, %u.%u fps decode-bound, avg us decode=%u dispose=%u render=%u",
+             gif_->width, gif_->height, (unsigned)st.frames, (unsigned)(fps_x10 / 10), (unsigned)(fps_x10 % 10),
+             (unsigned)(st.decode_us / st.frames), (unsigned)(st.dispose_us / st.frames),
+             (unsigned)(st.render_us / st.frames));
+    ESP_LOGI(TAG, "profile alloc: open=%u B, transient avg=%u B/frame, peak=%u B",
+             (unsigned)st.open_bytes, (unsigned)(st.total_alloc_bytes / st.frames), (unsigned)st.peak_alloc_bytes);
+    gd_reset_stats(gif_);
+}
+#endif
+
 void LvglGif::NextFrame() {
     // Kept for compatibility but unused when decoder task is enabled
     if (!loaded_ || !gif_) return;
@@ -290,6 +559,8 @@ void LvglGif::Cleanup() {
         timer_ = nullptr;
     }
 
+    ReleaseFrameCache();
+
     // Close GIF decoder (after decoder task is gone)
     if (gif_) {
         gd_close_gif(gif_);
@@ -6,6 +6,7 @@
 #include <memory>
 #include <functional>
 #include <atomic>
+#include <vector>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -16,6 +17,11 @@
 class LvglGif {
 public:
     explicit LvglGif(const lv_img_dsc_t* img_dsc);
+    /**
+     * Stream a GIF from a VFS path (e.g. "/storage/a.gif") instead of a memory
+     * buffer; only a small read-ahead window of the file is kept in RAM.
+     */
+    explicit LvglGif(const char* file_path);
     virtual ~LvglGif();
 
     // LvglImage interface implementation
@@ -68,9 +74,18 @@ public:
     uint16_t height() const;
 
     /**
-     * Set frame update callback
+     * Set frame update callback. `area` is the part of the canvas changed by the
+     * new frame (disposal area included), in image coordinates, inclusive.
+     */
+    void SetFrameCallback(std::function<void(const lv_area_t& area)> callback);
+
+    /**
+     * Set the PSRAM budget (bytes) of the decoded frame cache, 0 disables it.
+     * Infinitely looping GIFs record every frame (as a dirty-rect delta) during
+     * the first pass and replay from PSRAM afterwards; animations that exceed
+     * the budget keep decoding live.
      */
-    void SetFrameCallback(std::function<void()> callback);
+    void SetFrameCacheBudget(size_t bytes);
 
 private:
     // GIF decoder instance
@@ -94,8 +109,27 @@ private:
     // If true, implement infinite looping by forcing single-pass + manual rewind
     bool force_infinite_ = false;
 
+    // Finish construction once gif_ is opened (image descriptor + first frame)
+    void InitFromDecoder(const char* source);
+
     // Frame update callback
-    std::function<void()> frame_callback_;
+    std::function<void(const lv_area_t& area)> frame_callback_;
+
+    // Decoded frame cache (PSRAM). Entry 0 is the full first frame, later entries
+    // hold only the canvas area changed by that frame.
+    struct CachedFrame {
+        uint16_t x, y, w, h;
+        uint16_t delay;   // gce.delay, 10ms units
+        uint8_t* pixels;  // w * h canvas pixels
+    };
+    enum class FrameCacheState { kRecording, kReady, kDisabled };
+    static constexpr size_t kDefaultFrameCacheBudget = 4 * 1024 * 1024;
+    // PSRAM that must stay free for downloads and other decoders
+    static constexpr size_t kFrameCacheMinFreePsram = 1024 * 1024;
+    std::vector<CachedFrame> frame_cache_;
+    FrameCacheState frame_cache_state_ = FrameCacheState::kRecording;
+    size_t frame_cache_bytes_ = 0;
+    size_t frame_cache_budget_ = kDefaultFrameCacheBudget;
 
     // (Legacy) Background decoder members kept for compatibility but unused now
     TaskHandle_t decode_task_ = nullptr;
@@ -109,6 +143,21 @@ private:
     static void TimerCb(lv_timer_t* t);
     void TickOnce();
 
+    // Frame cache helpers (LVGL thread)
+    bool CacheCurrentFrame();
+    void ApplyCachedFrame(const CachedFrame& frame);
+    void ReplayNextCachedFrame();
+    void DisableFrameCache(const char* reason);
+    void ReleaseFrameCache();
+
+    // Invoke frame_callback_ for the given canvas rectangle (skipped if empty)
+    void NotifyFrameUpdated(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+#if GIFDEC_PROFILE
+    // Log and reset gifdec per-loop statistics
+    void LogProfile();
+#endif
+
     /**
      * Update to next frame (kept for compatibility if needed)
      */
@@ -0,0 +1,451 @@
+#include "gif_downloader.h"
+#include "storage/download_cache.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_crt_bundle.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "sdkconfig.h"
+
+#define TAG "GifDownloader"
+
+#ifndef CONFIG_GIF_DOWNLOAD_WORKERS
+#define CONFIG_GIF_DOWNLOAD_WORKERS 2
+#endif
+#ifndef CONFIG_GIF_DOWNLOAD_SRAM_BUDGET_KB
+#define CONFIG_GIF_DOWNLOAD_SRAM_BUDGET_KB 128
+#endif
+
+static constexpr int kMaxWorkers = CONFIG_GIF_DOWNLOAD_WORKERS;
+static constexpr size_t kSramBudget = (size_t)CONFIG_GIF_DOWNLOAD_SRAM_BUDGET_KB * 1024;
+static constexpr size_t kInternalReserve = 32 * 1024;   // never squeeze internal RAM below this
+static constexpr int kMaxRetries = 2;
+static constexpr size_t kDefaultCap = 512 * 1024;       // unknown length (chunked)
+static constexpr size_t kMaxSize = 10 * 1024 * 1024;    // 10MB cap
+static constexpr size_t kRxChunk = 16384;               // read chunk goes directly into PSRAM dest buffer
+static constexpr int kRxBufferSize = 4096;
+static constexpr int kTxBufferSize = 1024;
+static constexpr uint32_t kWorkerStackSize = 8192;
+static constexpr uint32_t kWorkerIdleMs = 10000;        // idle workers exit and give their stack back
+static constexpr uint32_t kIdleConnectionMs = 15000;    // keep-alive connections closed after this
+static constexpr size_t kMaxIdleClients = kMaxWorkers;
+
+// Response headers of one request
+struct ResponseHeaders {
+    std::string etag;
+    std::string last_modified;
+};
+
+static esp_err_t HeaderHandler(esp_http_client_event_t* evt) {
+    if (evt->event_id == HTTP_EVENT_ON_HEADER && evt->user_data && evt->header_key && evt->header_value) {
+        auto* headers = static_cast<ResponseHeaders*>(evt->user_data);
+        if (strcasecmp(evt->header_key, "ETag") == 0) {
+            headers->etag = evt->header_value;
+        } else if (strcasecmp(evt->header_key, "Last-Modified") == 0) {
+            headers->last_modified = evt->header_value;
+        }
+    }
+    return ESP_OK;
+}
+
+static bool IsHttps(const std::string& url) {
+    return strncmp(url.c_str(), "https://", 8) == 0;
+}
+
+// "scheme://host[:port]" part of a URL; connections are pooled per origin
+static std::string OriginOf(const std::string& url) {
+    size_t scheme = url.find("://");
+    size_t start = (scheme == std::string::npos) ? 0 : scheme + 3;
+    size_t end = url.find_first_of("/?#", start);
+    return url.substr(0, end);
+}
+
+// Internal RAM one transfer pins: client buffers plus an mbedTLS session for HTTPS
+static size_t SramCost(const std::string& url) {
+    size_t cost = kRxBufferSize + kTxBufferSize + 2048;
+    if (IsHttps(url)) {
+        cost += 40 * 1024;
+    }
+    return cost;
+}
+
+GifDownloader& GifDownloader::GetInstance() {
+    static GifDownloader instance;
+    return instance;
+}
+
+bool GifDownloader::Download(const std::string& url, uint8_t** out_data, size_t* out_size) {
+    if (url.empty() || !out_data || !out_size) {
+        return false;
+    }
+    return Fetch(url, out_data, out_size);
+}
+
+void GifDownloader::DownloadAsync(const std::string& url, Callback callback) {
+    bool spawn = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back({url, std::move(callback)});
+        if (workers_ < kMaxWorkers && workers_ - busy_workers_ < (int)queue_.size()) {
+            workers_++;
+            spawn = true;
+        }
+    }
+    cv_.notify_all();
+    if (!spawn) {
+        return;
+    }
+
+    BaseType_t ret = xTaskCreate([](void* arg) {
+        static_cast<GifDownloader*>(arg)->WorkerLoop();
+        vTaskDelete(NULL);
+    }, "gif_download", kWorkerStackSize, this, 2, nullptr);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create download worker");
+        bool no_worker;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            workers_--;
+            no_worker = (workers_ == 0);
+        }
+        if (no_worker) {
+            CancelPending();
+        }
+    }
+}
+
+void GifDownloader::CancelPending() {
+    std::deque<Job> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropped.swap(queue_);
+    }
+    for (auto& job : dropped) {
+        if (job.callback) {
+            job.callback(nullptr, 0);
+        }
+    }
+}
+
+void GifDownloader::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (cv_.wait_for(lock, std::chrono::milliseconds(kWorkerIdleMs), [this]() { return !queue_.empty(); })) {
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        busy_workers_++;
+        lock.unlock();
+
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        if (!Fetch(job.url, &data, &size)) {
+            data = nullptr;
+            size = 0;
+        }
+        if (job.callback) {
+            job.callback(data, size);
+        } else if (data) {
+            heap_caps_free(data);
+        }
+
+        lock.lock();
+        busy_workers_--;
+    }
+    // The last worker going idle ends a burst of downloads: write back cache hits
+    bool last = --workers_ == 0;
+    lock.unlock();
+    if (last) {
+        DownloadCache::GetInstance().Flush();
+    }
+}
+
+void GifDownloader::CloseIdleLocked(size_t index) {
+    IdleClient idle = idle_clients_[index];
+    idle_clients_.erase(idle_clients_.begin() + index);
+    idle_sram_ -= idle.sram_cost;
+    esp_http_client_close(idle.client);
+    esp_http_client_cleanup(idle.client);
+}
+
+void GifDownloader::SweepIdleLocked() {
+    TickType_t now = xTaskGetTickCount();
+    for (size_t i = idle_clients_.size(); i-- > 0;) {
+        if (now - idle_clients_[i].idle_since > pdMS_TO_TICKS(kIdleConnectionMs)) {
+            CloseIdleLocked(i);
+        }
+    }
+}
+
+void GifDownloader::ReserveSram(size_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // Idle keep-alive connections are the first thing to give up
+        while (!idle_clients_.empty() && active_sram_ + idle_sram_ + bytes > kSramBudget) {
+            CloseIdleLocked(0);
+        }
+        bool fits = active_sram_ + bytes <= kSramBudget &&
+                    heap_caps_get_free_size(MALLOC_CAP_INTERNAL) >= bytes + kInternalReserve;
+        // A lone transfer always runs, otherwise nothing would ever make progress
+        if (fits || active_sram_ == 0) {
+            break;
+        }
+        cv_.wait_for(lock, std::chrono::milliseconds(200));
+    }
+    active_sram_ += bytes;
+}
+
+void GifDownloader::UnreserveSram(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_sram_ -= bytes;
+    }
+    cv_.notify_all();
+}
+
+esp_http_client_handle_t GifDownloader::AcquireClient(const std::string& url, const std::string& origin, bool* reused) {
+    esp_http_client_handle_t client = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SweepIdleLocked();
+        for (size_t i = 0; i < idle_clients_.size(); ++i) {
+            if (idle_clients_[i].origin == origin) {
+                client = idle_clients_[i].client;
+                idle_sram_ -= idle_clients_[i].sram_cost;
+                idle_clients_.erase(idle_clients_.begin() + i);
+                break;
+            }
+        }
+    }
+    *reused = (client != nullptr);
+    if (client) {
+        esp_http_client_set_url(client, url.c_str());
+        return client;
+    }
+
+    esp_http_client_config_t cfg = {};
+    cfg.url = url.c_str();
+    cfg.timeout_ms = 30000;
+    // Keep esp_http_client internal RX buffer small to save SRAM; data goes to PSRAM via read()
+    cfg.buffer_size = kRxBufferSize;
+    cfg.buffer_size_tx = kTxBufferSize;
+    cfg.keep_alive_enable = true;
+    cfg.event_handler = HeaderHandler;
+    if (IsHttps(url)) {
+        cfg.use_global_ca_store = true;
+        cfg.crt_bundle_attach = esp_crt_bundle_attach;
+    }
+    return esp_http_client_init(&cfg);
+}
+
+void GifDownloader::ReleaseClient(const std::string& origin, esp_http_client_handle_t client, bool keep_alive) {
+    esp_http_client_set_user_data(client, nullptr);
+    if (keep_alive) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SweepIdleLocked();
+        size_t cost = SramCost(origin);
+        if (idle_clients_.size() < kMaxIdleClients && active_sram_ + idle_sram_ + cost <= kSramBudget) {
+            idle_clients_.push_back({origin, client, cost, xTaskGetTickCount()});
+            idle_sram_ += cost;
+            return;
+        }
+    }
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+}
+
+bool GifDownloader::Fetch(const std::string& url, uint8_t** out_data, size_t* out_size) {
+    *out_data = nullptr;
+    *out_size = 0;
+
+    auto& cache = DownloadCache::GetInstance();
+    std::string cached_etag, cached_last_modified;
+    bool conditional = cache.GetValidators(url, cached_etag, cached_last_modified);
+
+    const std::string origin = OriginOf(url);
+    const size_t sram_cost = SramCost(url);
+    ResponseHeaders body_headers;  // validators of the body being assembled
+    uint8_t* buf = nullptr;
+    size_t cap = 0, pos = 0, total = 0;
+    int status = 0;
+    bool ok = false;
+    bool fatal = false;
+
+    ReserveSram(sram_cost);
+    for (int attempt = 0; attempt <= kMaxRetries && !ok && !fatal; ++attempt) {
+        if (attempt > 0) {
+            vTaskDelay(pdMS_TO_TICKS(500 * attempt)); // backoff before retry
+        }
+        bool reused = false;
+        esp_http_client_handle_t client = AcquireClient(url, origin, &reused);
+        if (!client) {
+            ESP_LOGE(TAG, "Download init failed (attempt %d)", attempt + 1);
+            continue;
+        }
+
+        // Continue a cut-off body only if the server can prove it is still the same entity
+        const std::string& validator = !body_headers.etag.empty() ? body_headers.etag : body_headers.last_modified;
+        bool resuming = pos > 0 && !validator.empty();
+        ResponseHeaders headers;
+        esp_http_client_set_user_data(client, &headers);
+        esp_http_client_delete_header(client, "Range");
+        esp_http_client_delete_header(client, "If-Range");
+        esp_http_client_delete_header(client, "If-None-Match");
+        esp_http_client_delete_header(client, "If-Modified-Since");
+        if (resuming) {
+            char range[32];
+            snprintf(range, sizeof(range), "bytes=%u-", (unsigned)pos);
+            esp_http_client_set_header(client, "Range", range);
+            esp_http_client_set_header(client, "If-Range", validator.c_str());
+        } else if (conditional) {
+            if (!cached_etag.empty()) {
+                esp_http_client_set_header(client, "If-None-Match", cached_etag.c_str());
+            }
+            if (!cached_last_modified.empty()) {
+                esp_http_client_set_header(client, "If-Modified-Since", cached_last_modified.c_str());
+            }
+        }
+
+        esp_err_t err = esp_http_client_open(client, 0);
+        int64_t content_length = (err == ESP_OK) ? esp_http_client_fetch_headers(client) : -1;
+        if (err != ESP_OK || content_length < 0) {
+            ESP_LOGW(TAG, "HTTP open failed: %s (attempt %d%s)", esp_err_to_name(err), attempt + 1,
+                     reused ? ", stale keep-alive" : "");
+            ReleaseClient(origin, client, false);
+            if (reused) {
+                --attempt;  // the server closed the pooled connection; not a real failure
+            }
+            continue;
+        }
+
+        status = esp_http_client_get_status_code(client);
+        if (status == 304 && conditional && !resuming) {
+            esp_http_client_flush_response(client, nullptr);
+            ReleaseClient(origin, client, true);
+            if (cache.Load(url, out_data, out_size)) {
+                ESP_LOGI(TAG, "Not modified, served from cache: %u bytes", (unsigned)*out_size);
+                UnreserveSram(sram_cost);
+                heap_caps_free(buf);
+                return true;
+            }
+            // Cached copy is gone: fetch the full body, without using up a retry
+            conditional = false;
+            --attempt;
+            continue;
+        }
+        if (status == 206 && resuming) {
+            total = (content_length > 0) ? pos + (size_t)content_length : 0;
+            ESP_LOGI(TAG, "Resuming at %u bytes", (unsigned)pos);
+        } else if (status == 200) {
+            if (pos > 0) {
+                ESP_LOGW(TAG, "Restarting from byte 0 (%u bytes discarded)", (unsigned)pos);
+            }
+            pos = 0;
+            total = (content_length > 0) ? (size_t)content_length : 0;
+            body_headers = headers;
+        } else {
+            ESP_LOGE(TAG, "HTTP status %d (attempt %d)", status, attempt + 1);
+            esp_http_client_flush_response(client, nullptr);
+            ReleaseClient(origin, client, true);
+            if (status == 416) {
+                pos = 0;  // our partial body no longer matches, start over
+            } else if (status < 500 && status != 408 && status != 429) {
+                fatal = true;
+            }
+            continue;
+        }
+
+        size_t need = (total > 0) ? total : std::max(cap, kDefaultCap);
+        if (need > kMaxSize) {
+            ESP_LOGE(TAG, "File too large: %u bytes", (unsigned)need);
+            ReleaseClient(origin, client, false);
+            fatal = true;
+            continue;
+        }
+        if (need > cap) {
+            uint8_t* nb = (uint8_t*)heap_caps_realloc(buf, need, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (!nb) {
+                ESP_LOGE(TAG, "PSRAM alloc failed: %u bytes", (unsigned)need);
+                ReleaseClient(origin, client, false);
+                fatal = true;
+                continue;
+            }
+            buf = nb;
+            cap = need;
+        }
+
+        size_t last_progress = (total > 0) ? (pos * 100) / total : 0;
+        size_t last_yield_bytes = pos;
+        const size_t kYieldEvery = 64 * 1024;
+        bool read_ok = true;
+        while (total == 0 || pos < total) {
+            // Grow if needed for unknown content length
+            if (pos == cap) {
+                size_t new_cap = std::min(cap * 2, kMaxSize);
+                uint8_t* nb = (new_cap > cap) ?
+                    (uint8_t*)heap_caps_realloc(buf, new_cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : nullptr;
+                if (!nb) {
+                    ESP_LOGE(TAG, "Download exceeds buffer (%u bytes)", (unsigned)cap);
+                    read_ok = false;
+                    fatal = true;
+                    break;
+                }
+                buf = nb;
+                cap = new_cap;
+            }
+            int r = esp_http_client_read(client, (char*)buf + pos, std::min(kRxChunk, cap - pos));
+            if (r < 0) {
+                ESP_LOGE(TAG, "HTTP read error: %d (attempt %d)", r, attempt + 1);
+                read_ok = false;
+                break;
+            }
+            if (r == 0) break; // done or connection closed
+            pos += (size_t)r;
+
+            if (total > 0) {
+                size_t prog = (pos * 100) / total;
+                if (prog >= last_progress + 20) {
+                    ESP_LOGI(TAG, "Download progress: %u%% (%u/%u bytes)", (unsigned)prog, (unsigned)pos, (unsigned)total);
+                    last_progress = prog;
+                }
+            }
+            // Yield periodically to feed WDT
+            if (pos - last_yield_bytes >= kYieldEvery) {
+                vTaskDelay(1);
+                last_yield_bytes = pos;
+            }
+        }
+
+        bool complete = read_ok && (total > 0 ? pos == total : esp_http_client_is_complete_data_received(client));
+        ReleaseClient(origin, client, complete);
+        if (!complete) {
+            ESP_LOGW(TAG, "Transfer interrupted at %u/%u bytes (attempt %d)", (unsigned)pos, (unsigned)total, attempt + 1);
+            continue;
+        }
+        ok = true;
+    }
+    UnreserveSram(sram_cost);
+
+    if (ok && pos >= 6 && (memcmp(buf, "GIF87a", 6) == 0 || memcmp(buf, "GIF89a", 6) == 0)) {
+        // Give back the slack of a grown buffer
+        if (cap > pos) {
+            uint8_t* nb = (uint8_t*)heap_caps_realloc(buf, pos, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            if (nb) buf = nb;
+        }
+        ESP_LOGI(TAG, "Downloaded GIF: %u bytes", (unsigned)pos);
+        cache.Store(url, buf, pos, body_headers.etag, body_headers.last_modified);
+        *out_data = buf;
+        *out_size = pos;
+        return true;
+    }
+
+    ESP_LOGE(TAG, "Download failed: status=%d, size=%u", status, (unsigned)pos);
+    heap_caps_free(buf);
+    // Server unreachable: a possibly stale cached copy beats showing nothing
+    if (cache.Load(url, out_data, out_size)) {
+        ESP_LOGW(TAG, "Using cached copy: %u bytes", (unsigned)*out_size);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,85 @@
+#ifndef _GIF_DOWNLOADER_H_
+#define _GIF_DOWNLOADER_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <esp_http_client.h>
+#include <freertos/FreeRTOS.h>
+
+/**
+ * @brief GIF download manager
+ *
+ * - Keeps one idle keep-alive connection per origin (scheme://host:port) and
+ *   reuses it for the next request to the same server
+ * - Runs up to CONFIG_GIF_DOWNLOAD_WORKERS transfers concurrently; every transfer
+ *   reserves its esp_http_client/TLS buffers against CONFIG_GIF_DOWNLOAD_SRAM_BUDGET_KB
+ * - Resumes interrupted transfers with a Range request (If-Range guarded)
+ *   instead of restarting from byte 0
+ * - Goes through DownloadCache: conditional requests, 304 served from flash
+ *
+ * Bodies are returned in PSRAM; the receiver frees them with heap_caps_free().
+ */
+class GifDownloader {
+public:
+    // data == nullptr on failure; otherwise the callback owns data
+    using Callback = std::function<void(uint8_t* data, size_t size)>;
+
+    static GifDownloader& GetInstance();
+
+    /**
+     * @brief Download on the calling task (blocking)
+     */
+    bool Download(const std::string& url, uint8_t** out_data, size_t* out_size);
+
+    /**
+     * @brief Queue a download for the worker pool; callback runs on a worker task
+     */
+    void DownloadAsync(const std::string& url, Callback callback);
+
+    /**
+     * @brief Drop queued downloads that have not started (callbacks get nullptr)
+     */
+    void CancelPending();
+
+    GifDownloader(const GifDownloader&) = delete;
+    GifDownloader& operator=(const GifDownloader&) = delete;
+
+private:
+    GifDownloader() = default;
+
+    struct Job {
+        std::string url;
+        Callback callback;
+    };
+    struct IdleClient {
+        std::string origin;
+        esp_http_client_handle_t client;
+        size_t sram_cost;
+        TickType_t idle_since;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Job> queue_;
+    std::vector<IdleClient> idle_clients_;
+    int workers_ = 0;
+    int busy_workers_ = 0;
+    size_t active_sram_ = 0;  // reserved by running transfers
+    size_t idle_sram_ = 0;    // held by idle keep-alive connections
+
+    bool Fetch(const std::string& url, uint8_t** out_data, size_t* out_size);
+    void WorkerLoop();
+
+    esp_http_client_handle_t AcquireClient(const std::string& url, const std::string& origin, bool* reused);
+    void ReleaseClient(const std::string& origin, esp_http_client_handle_t client, bool keep_alive);
+    void ReserveSram(size_t bytes);
+    void UnreserveSram(size_t bytes);
+    void CloseIdleLocked(size_t index);
+    void SweepIdleLocked();
+};
+
+#endif // _GIF_DOWNLOADER_H_
@@ -16,6 +16,7 @@
 
 #include "storage/gif_storage.h"
 #include "offline_image_manager.h"
+#include "multipart_parser.h"
 
 #define TAG "ImageUploadServer"
 
@@ -65,11 +66,32 @@ struct StoredFileInfo {
     std::string name;
     size_t size = 0;
     time_t upload_time = 0;
+    time_t last_shown = 0;
+    bool pinned = false;
 };
 
 void CollectStoredFiles(const char* filename, size_t size, time_t upload_time, void* user_data) {
     auto* files = static_cast<std::vector<StoredFileInfo>*>(user_data);
-    files->push_back(StoredFileInfo{std::string(filename), size, upload_time});
+    StoredFileInfo info{std::string(filename), size, upload_time};
+    gif_storage_entry_t entry;
+    if (gif_storage_get_entry(filename, &entry) == ESP_OK) {
+        info.last_shown = entry.last_shown;
+        info.pinned = (entry.flags & GIF_STORAGE_FLAG_PINNED) != 0;
+    }
+    files->push_back(std::move(info));
+}
+
+// Read one query parameter; false if the query or the key is missing
+bool GetQueryParam(httpd_req_t* req, const char* key, char* value, size_t value_size) {
+    size_t query_len = httpd_req_get_url_query_len(req) + 1;
+    if (query_len <= 1) {
+        return false;
+    }
+    std::string query(query_len, '\0');
+    if (httpd_req_get_url_query_str(req, query.data(), query_len) != ESP_OK) {
+        return false;
+    }
+    return httpd_query_key_value(query.c_str(), key, value, value_size) == ESP_OK;
 }
 
 std::string FormatRelativeDuration(time_t seconds_since_boot) {
@@ -126,8 +148,8 @@ ImageUploadServer::~ImageUploadServer() {
     Stop();
 }
 
-void ImageUploadServer::SetImageReceivedCallback(ImageReceivedCallback callback) {
-    image_callback_ = callback;
+void ImageUploadServer::SetUploadSink(UploadSink sink) {
+    upload_sink_ = std::move(sink);
 }
 
 void ImageUploadServer::ResetProgress() {
@@ -337,6 +359,22 @@ void ImageUploadServer::StartWebServer() {
         .user_ctx = this
     };
     ESP_ERROR_CHECK(httpd_register_uri_handler(server_, &delete_uri));
+
+    httpd_uri_t evict_preview_uri = {
+        .uri = "/files/evict_preview",
+        .method = HTTP_GET,
+        .handler = EvictPreviewHandler,
+        .user_ctx = this
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_, &evict_preview_uri));
+
+    httpd_uri_t pin_uri = {
+        .uri = "/files/pin",
+        .method = HTTP_POST,
+        .handler = PinFileHandler,
+        .user_ctx = this
+    };
+    ESP_ERROR_CHECK(httpd_register_uri_handler(server_, &pin_uri));
     
     ESP_LOGI(TAG, "Web server started");
 }
@@ -420,49 +458,100 @@ esp_err_t ImageUploadServer::UploadHandler(httpd_req_t *req) {
     }
 
     // 获取boundary
-    char* boundary = strstr(content_type, "boundary=");
-    if (!boundary) {
+    std::string boundary;
+    if (!MultipartParser::ParseBoundary(content_type, boundary)) {
         ESP_LOGE(TAG, "No boundary found in Content-Type");
         self->SetProgressError("缺少boundary");
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No boundary found");
         return ESP_FAIL;
     }
-    boundary += 9; // 跳过"boundary="
 
     ESP_LOGI(TAG, "Receiving file upload, Content-Length: %d", req->content_len);
 
-    // 限制文件大小 (5MB)
-    const size_t max_file_size = 5 * 1024 * 1024;
-    if (req->content_len > max_file_size) {
-        ESP_LOGE(TAG, "File too large: %d bytes", req->content_len);
-        self->SetProgressError("文件太大，超过5MB限制");
+    // 文件边接收边写入存储，大小只受分区容量限制
+    size_t storage_total = 0, storage_used = 0;
+    if (gif_storage_info(&storage_total, &storage_used) == ESP_OK && req->content_len > storage_total) {
+        ESP_LOGE(TAG, "File too large: %zu bytes (partition %zu bytes)", req->content_len, storage_total);
+        self->SetProgressError("文件太大，超过存储容量");
         httpd_resp_set_status(req, "413 Payload Too Large");
         httpd_resp_send(req, "File too large", HTTPD_RESP_USE_STRLEN);
         return ESP_FAIL;
     }
 
-    // 分配缓冲区接收数据
-    const size_t buffer_size = 4096;
-    auto buffer = std::make_unique<char[]>(buffer_size);
-    if (!buffer) {
-        ESP_LOGE(TAG, "Failed to allocate buffer");
-        self->SetProgressError("内存不足，无法接收文件");
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
+    const UploadSink& sink = self->upload_sink_;
+    if (!sink.begin || !sink.write || !sink.finish) {
+        ESP_LOGE(TAG, "No upload sink");
+        self->SetProgressError("设备未就绪");
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Upload not available");
         return ESP_FAIL;
     }
 
-    // 接收并处理multipart数据
-    size_t total_received = 0;
+    // 只保存第一个文件字段，其余字段忽略
+    bool writing = false;
+    bool file_saved = false;
+    bool sink_failed = false;
+    size_t file_size = 0;
     std::string filename;
-    std::vector<uint8_t> image_data;
-    bool in_file_data = false;
-    std::string boundary_str = "--" + std::string(boundary);
-    std::string end_boundary = boundary_str + "--";
+
+    MultipartParser::Callbacks callbacks;
+    callbacks.on_part_begin = [&](const MultipartParser::Part& part) {
+        if (part.filename.empty() || file_saved) {
+            return true;
+        }
+        filename = part.filename;
+        ESP_LOGI(TAG, "Found filename: %s", filename.c_str());
+        self->SetCurrentFilename(filename);
+        if (!sink.begin(filename, req->content_len, upload_time)) {
+            sink_failed = true;
+            return false;
+        }
+        writing = true;
+        return true;
+    };
+    callbacks.on_part_data = [&](const uint8_t* data, size_t size) {
+        if (!writing) {
+            return true;
+        }
+        file_size += size;
+        if (!sink.write(data, size)) {
+            sink_failed = true;
+            return false;
+        }
+        return true;
+    };
+    callbacks.on_part_end = [&]() {
+        if (!writing) {
+            return true;
+        }
+        writing = false;
+        if (!sink.finish()) {
+            sink_failed = true;
+            return false;
+        }
+        file_saved = true;
+        return true;
+    };
+    MultipartParser parser(boundary, std::move(callbacks));
+
+    auto abort_upload = [&]() {
+        if (writing) {
+            writing = false;
+            if (sink.abort) {
+                sink.abort();
+            }
+        }
+    };
+
+    // 接收缓冲区只有一个，峰值内存与文件大小无关
+    const size_t buffer_size = 4096;
+    auto buffer = std::make_unique<uint8_t[]>(buffer_size);
+    size_t total_received = 0;
 
     while (total_received < req->content_len) {
-        int received = httpd_req_recv(req, buffer.get(),
+        int received = httpd_req_recv(req, reinterpret_cast<char*>(buffer.get()),
                                     std::min(buffer_size, req->content_len - total_received));
         if (received <= 0) {
+            abort_upload();
             if (received == HTTPD_SOCK_ERR_TIMEOUT) {
                 ESP_LOGE(TAG, "Socket timeout");
                 self->SetProgressError("上传超时");
@@ -478,60 +567,30 @@ esp_err_t ImageUploadServer::UploadHandler(httpd_req_t *req) {
         total_received += received;
         self->UpdateUploadProgress(total_received);
 
-        // 简化的multipart解析 - 查找文件数据
-        std::string chunk(buffer.get(), received);
-
-        if (!in_file_data) {
-            // 查找文件名
-            size_t filename_pos = chunk.find("filename=\"");
-            if (filename_pos != std::string::npos) {
-                filename_pos += 10; // 跳过 filename="
-                size_t filename_end = chunk.find("\"", filename_pos);
-                if (filename_end != std::string::npos) {
-                    filename = chunk.substr(filename_pos, filename_end - filename_pos);
-                    ESP_LOGI(TAG, "Found filename: %s", filename.c_str());
-                    self->SetCurrentFilename(filename);
-                }
-            }
-
-            // 查找文件数据开始位置（双换行后）
-            size_t data_start = chunk.find("\r\n\r\n");
-            if (data_start != std::string::npos) {
-                in_file_data = true;
-                data_start += 4; // 跳过 \r\n\r\n
-                // 添加文件数据
-                for (size_t i = data_start; i < chunk.size(); i++) {
-                    image_data.push_back(static_cast<uint8_t>(chunk[i]));
-                }
-            }
-        } else {
-            // 已经在文件数据中，继续添加
-            for (int i = 0; i < received; i++) {
-                image_data.push_back(static_cast<uint8_t>(buffer[i]));
+        if (!parser.Feed(buffer.get(), received)) {
+            abort_upload();
+            if (sink_failed) {
+                ESP_LOGE(TAG, "Failed to store %s", filename.c_str());
+                self->SetProgressError("保存失败");
+                httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to store file");
+            } else {
+                ESP_LOGE(TAG, "Malformed multipart body: %s", parser.error());
+                self->SetProgressError("上传数据格式错误");
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Malformed multipart body");
             }
+            return ESP_FAIL;
         }
     }
 
-    if (image_data.empty()) {
+    if (!file_saved) {
+        abort_upload();
         ESP_LOGE(TAG, "No file data received");
         self->SetProgressError("未收到有效的文件数据");
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No file data received");
         return ESP_FAIL;
     }
 
-    // 移除结尾的boundary数据
-    if (image_data.size() > boundary_str.length() + 10) {
-        // 简单处理：移除最后的一些字节（包含boundary等尾数据）
-        image_data.resize(image_data.size() - boundary_str.length() - 10);
-    }
-    self->SetStorageTotal(image_data.size());
-
-    ESP_LOGI(TAG, "Received image: %s, size: %d bytes", filename.c_str(), image_data.size());
-
-    // 调用回调函数处理图片数据
-    if (self->image_callback_ && !image_data.empty()) {
-        self->image_callback_(image_data.data(), image_data.size(), filename, upload_time);
-    }
+    ESP_LOGI(TAG, "Received image: %s, size: %zu bytes", filename.c_str(), file_size);
 
     // 发送成功响应
     httpd_resp_set_type(req, "application/json");
@@ -568,7 +627,9 @@ esp_err_t ImageUploadServer::FilesHandler(httpd_req_t *req) {
         }
         oss << "{\"name\":\"" << JsonEscape(files[i].name) << "\",";
         oss << "\"size\":" << files[i].size << ",";
-        oss << "\"uploadTime\":\"" << JsonEscape(FormatTimestamp(files[i].upload_time)) << "\"}";
+        oss << "\"uploadTime\":\"" << JsonEscape(FormatTimestamp(files[i].upload_time)) << "\",";
+        oss << "\"lastShown\":\"" << (files[i].last_shown ? JsonEscape(FormatTimestamp(files[i].last_shown)) : "") << "\",";
+        oss << "\"pinned\":" << (files[i].pinned ? "true" : "false") << "}";
     }
     oss << "]}";
 
@@ -620,6 +681,71 @@ esp_err_t ImageUploadServer::DeleteFileHandler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+// GET /files/evict_preview?size=N: files an upload of N bytes would evict
+esp_err_t ImageUploadServer::EvictPreviewHandler(httpd_req_t *req) {
+    auto* self = static_cast<ImageUploadServer*>(req->user_ctx);
+    char value[16];
+    if (!GetQueryParam(req, "size", value, sizeof(value))) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing size");
+        return ESP_FAIL;
+    }
+    size_t size = strtoul(value, nullptr, 10);
+
+    gif_storage_evict_plan_t plan = {};
+    bool ok = self->upload_sink_.preview_eviction && self->upload_sink_.preview_eviction(size, &plan);
+    if (!ok) {
+        gif_storage_free_evict_plan(&plan);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Preview unavailable");
+        return ESP_FAIL;
+    }
+
+    std::ostringstream oss;
+    oss << "{\"size\":" << size << ",";
+    oss << "\"fits\":" << (plan.bytes_short == 0 ? "true" : "false") << ",";
+    oss << "\"bytesFreed\":" << plan.bytes_freed << ",";
+    oss << "\"files\":[";
+    for (size_t i = 0; i < plan.count; ++i) {
+        if (i > 0) {
+            oss << ",";
+        }
+        oss << "{\"name\":\"" << JsonEscape(plan.victims[i].name) << "\",";
+        oss << "\"size\":" << plan.victims[i].size << "}";
+    }
+    oss << "]}";
+    gif_storage_free_evict_plan(&plan);
+
+    auto payload = oss.str();
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, payload.c_str(), payload.length());
+    return ESP_OK;
+}
+
+// POST /files/pin?name=x&pinned=1|0: pinned files are never evicted
+esp_err_t ImageUploadServer::PinFileHandler(httpd_req_t *req) {
+    char name[128];
+    char pinned[4] = "1";
+    if (!GetQueryParam(req, "name", name, sizeof(name))) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing name");
+        return ESP_FAIL;
+    }
+    GetQueryParam(req, "pinned", pinned, sizeof(pinned));
+    bool pin = strcmp(pinned, "0") != 0;
+
+    esp_err_t ret = gif_storage_set_pinned(name, pin);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "File not found");
+        return ESP_FAIL;
+    }
+    if (ret != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Pin failed");
+        return ret;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, pin ? "{\"pinned\":true}" : "{\"pinned\":false}", HTTPD_RESP_USE_STRLEN);
+    return ESP_OK;
+}
+
 void ImageUploadServer::WifiEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data) {
     if (event_id == WIFI_EVENT_AP_STACONNECTED) {
         wifi_event_ap_staconnected_t* event = (wifi_event_ap_staconnected_t*) event_data;
@@ -662,6 +788,9 @@ std::string ImageUploadServer::GenerateUploadPage() {
         .filename-cell { display: flex; justify-content: space-between; align-items: center; gap: 8px; }
         .delete-btn { background: #dc3545; color: #fff; border: none; border-radius: 4px; padding: 4px 8px; font-size: 12px; cursor: pointer; }
         .delete-btn:hover { background: #c82333; }
+        .pin-btn { background: #e9ecef; color: #333; border: none; border-radius: 4px; padding: 4px 8px; font-size: 12px; cursor: pointer; }
+        .pin-btn.pinned { background: #ffc107; }
+        .file-actions { display: flex; gap: 6px; }
         .file-empty { text-align: center; color: #777; padding: 15px 0; font-size: 14px; }
         .table-wrapper { width: 100%; overflow-x: auto; }
         .upload-btn.secondary { background: #6c757d; }
@@ -694,6 +823,7 @@ std::string ImageUploadServer::GenerateUploadPage() {
                             <th>文件名</th>
                             <th>大小</th>
                             <th>上传时间</th>
+                            <th>最近显示</th>
                         </tr>
                     </thead>
                     <tbody id="fileTableBody"></tbody>
@@ -740,14 +870,37 @@ std::string ImageUploadServer::GenerateUploadPage() {
             handleFiles(e.target.files);
         });
 
-        function handleFiles(files) {
+        async function handleFiles(files) {
             for (let file of files) {
-                if (isGifFile(file)) {
+                if (isGifFile(file) && await confirmEviction(file)) {
                     uploadFile(file);
                 }
             }
         }
 
+        // 空间不足时先列出将被自动删除的文件
+        async function confirmEviction(file) {
+            try {
+                const response = await fetch(`/files/evict_preview?size=${file.size || 0}`, { cache: 'no-store' });
+                if (!response.ok) {
+                    return true;
+                }
+                const plan = await response.json();
+                if (!plan.fits) {
+                    status.innerHTML = '<div class="status error">存储空间不足（其余文件已固定），请先删除或取消固定一些文件</div>';
+                    return false;
+                }
+                if (!plan.files || !plan.files.length) {
+                    return true;
+                }
+                const names = plan.files.map((f) => `${f.name} (${formatBytes(f.size)})`).join('\n');
+                return confirm(`上传 ${file.name} 需要删除以下最久未显示的文件：\n${names}\n\n继续上传？`);
+            } catch (error) {
+                console.error('Failed to preview eviction', error);
+                return true;
+            }
+        }
+
         function isGifFile(file) {
             const name = (file.name || '').toLowerCase();
             const mime = (file.type || '').toLowerCase();
@@ -932,11 +1085,15 @@ std::string ImageUploadServer::GenerateUploadPage() {
                     <td>
                         <div class="filename-cell">
                             <span>${file.name}</span>
-                            <button class="delete-btn" data-name="${encodeURIComponent(file.name)}">删除</button>
+                            <div class="file-actions">
+                                <button class="pin-btn${file.pinned ? ' pinned' : ''}" data-name="${encodeURIComponent(file.name)}" data-pinned="${file.pinned ? 1 : 0}">${file.pinned ? '已固定' : '固定'}</button>
+                                <button class="delete-btn" data-name="${encodeURIComponent(file.name)}">删除</button>
+                            </div>
                         </div>
                     </td>
                     <td>${formatBytes(file.size)}</td>
                     <td>${file.uploadTime || '未知'}</td>
+                    <td>${file.lastShown || '-'}</td>
                 `;
                 fileTableBody.appendChild(row);
             });
@@ -950,6 +1107,26 @@ std::string ImageUploadServer::GenerateUploadPage() {
                     deleteFile(encodedName, originalName);
                 });
             });
+            fileTableBody.querySelectorAll('.pin-btn').forEach((btn) => {
+                btn.addEventListener('click', () => {
+                    setPinned(btn.dataset.name, btn.dataset.pinned !== '1');
+                });
+            });
+        }
+
+        async function setPinned(encodedName, pinned) {
+            try {
+                const response = await fetch(`/files/pin?name=${encodedName}&pinned=${pinned ? 1 : 0}`, {
+                    method: 'POST'
+                });
+                if (!response.ok) {
+                    throw new Error(await response.text());
+                }
+                loadFileList();
+            } catch (error) {
+                console.error('Failed to pin file', error);
+                status.innerHTML = `<div class="status error">操作失败：${error.message}</div>`;
+            }
         }
 
         function formatBytes(bytes) {
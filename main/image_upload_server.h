@@ -10,15 +10,26 @@
 #include <esp_timer.h>
 #include <esp_netif.h>
 
+#include "storage/gif_storage.h"
+
 class ImageUploadServer {
 public:
     static ImageUploadServer& GetInstance();
     
-    // 回调函数类型定义
-    using ImageReceivedCallback = std::function<void(const uint8_t* data, size_t size, const std::string& filename, time_t upload_time)>;
+    // 上传文件的流式接收端：文件数据边接收边写入，不在内存中缓存整个文件
+    // begin → write... → finish；中途失败时调用 abort（begin 成功之后）
+    struct UploadSink {
+        // size_hint 为请求的 Content-Length，是文件大小的上限
+        std::function<bool(const std::string& filename, size_t size_hint, time_t upload_time)> begin;
+        std::function<bool(const uint8_t* data, size_t size)> write;
+        std::function<bool()> finish;
+        std::function<void()> abort;
+        // 预览为容纳 size 字节的上传需要淘汰哪些文件（只计算，不删除）
+        std::function<bool(size_t size, gif_storage_evict_plan_t* plan)> preview_eviction;
+    };
     
-    // 设置图片接收回调
-    void SetImageReceivedCallback(ImageReceivedCallback callback);
+    // 设置上传文件接收端
+    void SetUploadSink(UploadSink sink);
     
     // 启动图片上传服务器
     bool Start(const std::string& ssid_prefix = "ImageUpload");
@@ -51,8 +62,8 @@ private:
     std::string ssid_;
     std::string ssid_prefix_;
     
-    // 回调函数
-    ImageReceivedCallback image_callback_;
+    // 上传文件接收端
+    UploadSink upload_sink_;
     
     // 事件处理
     esp_event_handler_instance_t wifi_event_instance_ = nullptr;
@@ -69,13 +80,14 @@ private:
     static esp_err_t StatusHandler(httpd_req_t *req);
     static esp_err_t FilesHandler(httpd_req_t *req);
     static esp_err_t DeleteFileHandler(httpd_req_t *req);
+    static esp_err_t EvictPreviewHandler(httpd_req_t *req);
+    static esp_err_t PinFileHandler(httpd_req_t *req);
     
     // WiFi事件处理
     static void WifiEventHandler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
     
     // 工具函数
     std::string GenerateUploadPage();
-    bool SaveImageToFlash(const uint8_t* data, size_t size, const std::string& filename);
 
 public:
     enum class UploadStage {
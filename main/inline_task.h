@@ -0,0 +1,117 @@
+#ifndef _INLINE_TASK_H_
+#define _INLINE_TASK_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Room for the captures we schedule: [this, display, message = std::string(...)]
+#define INLINE_TASK_CAPACITY (2 * sizeof(void*) + sizeof(std::string))
+
+/**
+ * @brief Move-only void() callable with inline storage
+ *
+ * Replaces std::function for scheduled work. Callables up to
+ * INLINE_TASK_CAPACITY bytes are stored in place, so scheduling them does
+ * not touch the heap; bigger ones are boxed and counted in heap_fallbacks().
+ */
+class InlineTask {
+public:
+    InlineTask() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineTask>>>
+    InlineTask(F&& callable) {
+        using T = std::decay_t<F>;
+        if constexpr (FitsInline<T>()) {
+            new (storage_) T(std::forward<F>(callable));
+            ops_ = &kInlineOps<T>;
+        } else {
+            *reinterpret_cast<T**>(storage_) = new T(std::forward<F>(callable));
+            ops_ = &kHeapOps<T>;
+            heap_fallbacks_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    InlineTask(InlineTask&& other) noexcept { MoveFrom(other); }
+
+    InlineTask& operator=(InlineTask&& other) noexcept {
+        if (this != &other) {
+            reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InlineTask& operator=(std::nullptr_t) {
+        reset();
+        return *this;
+    }
+
+    ~InlineTask() { reset(); }
+
+    InlineTask(const InlineTask&) = delete;
+    InlineTask& operator=(const InlineTask&) = delete;
+
+    explicit operator bool() const { return ops_ != nullptr; }
+    void operator()() { ops_->invoke(storage_); }
+
+    void reset() {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    // Callables that did not fit inline since boot
+    static uint32_t heap_fallbacks() { return heap_fallbacks_.load(std::memory_order_relaxed); }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src);     // move-construct dst, destroy src
+        void (*destroy)(void* storage);
+    };
+
+    template <typename T>
+    static constexpr bool FitsInline() {
+        return sizeof(T) <= INLINE_TASK_CAPACITY && alignof(T) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<T>;
+    }
+
+    template <typename T>
+    static constexpr Ops kInlineOps = {
+        [](void* storage) { (*std::launder(reinterpret_cast<T*>(storage)))(); },
+        [](void* dst, void* src) {
+            T* from = std::launder(reinterpret_cast<T*>(src));
+            new (dst) T(std::move(*from));
+            from->~T();
+        },
+        [](void* storage) { std::launder(reinterpret_cast<T*>(storage))->~T(); },
+    };
+
+    template <typename T>
+    static constexpr Ops kHeapOps = {
+        [](void* storage) { (**reinterpret_cast<T**>(storage))(); },
+        [](void* dst, void* src) { *reinterpret_cast<T**>(dst) = *reinterpret_cast<T**>(src); },
+        [](void* storage) { delete *reinterpret_cast<T**>(storage); },
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[INLINE_TASK_CAPACITY];
+    const Ops* ops_ = nullptr;
+
+    inline static std::atomic<uint32_t> heap_fallbacks_{0};
+
+    void MoveFrom(InlineTask& other) {
+        if (other.ops_ != nullptr) {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+};
+
+#endif // _INLINE_TASK_H_
@@ -99,27 +99,16 @@ std::string ImageStorageControl::ShowStoredImage(const std::string& params) {
         return "{\"success\": false, \"message\": \"图片文件不存在: " + filename + "\"}";
     }
     
-    // 读取并显示图片
-    uint8_t* data = nullptr;
-    size_t size = 0;
-    esp_err_t ret = gif_storage_read(filename.c_str(), &data, &size);
-    
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to read image: %s", esp_err_to_name(ret));
-        return "{\"success\": false, \"message\": \"读取图片失败: " + filename + "\"}";
-    }
-    
-    // 显示图片
+    // 显示图片（直接从Flash流式解码，不整文件读入内存）
     auto& app = Application::GetInstance();
-    app.Schedule([&app, data, size, filename]() {
+    app.Schedule([filename]() {
         if (auto display = Board::GetInstance().GetDisplay()) {
-            display->ShowGif(data, size);
+            display->ShowGifFromFlash(filename.c_str());
             display->ShowNotification(("正在显示: " + filename).c_str(), 2000);
         }
-        free(data); // 释放内存
     });
     
-    ESP_LOGI(TAG, "Showing image: %s (%d bytes)", filename.c_str(), size);
+    ESP_LOGI(TAG, "Showing image: %s", filename.c_str());
     return "{\"success\": true, \"message\": \"正在显示图片: " + filename + "\"}";
 }
 
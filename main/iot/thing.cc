@@ -26,6 +26,45 @@ Thing* CreateThing(const std::string& type) {
     return creator->second();
 }
 
+void AppendJsonString(std::string& json, const std::string& value) {
+    static const char kHex[] = "0123456789abcdef";
+    json += '"';
+    const char* run = value.data();
+    const char* end = run + value.size();
+    for (const char* p = run; p < end; p++) {
+        unsigned char c = *p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;       // UTF-8 passes through untouched
+        }
+        json.append(run, p - run);
+        run = p + 1;
+        switch (c) {
+        case '"':
+            json += "\\\"";
+            break;
+        case '\\':
+            json += "\\\\";
+            break;
+        case '\n':
+            json += "\\n";
+            break;
+        case '\r':
+            json += "\\r";
+            break;
+        case '\t':
+            json += "\\t";
+            break;
+        default:
+            json += "\\u00";
+            json += kHex[c >> 4];
+            json += kHex[c & 0xF];
+            break;
+        }
+    }
+    json.append(run, end - run);
+    json += '"';
+}
+
 std::string Thing::GetDescriptorJson() {
     std::string json_str = "{";
     json_str += "\"name\":\"" + name_ + "\",";
@@ -37,13 +76,26 @@ std::string Thing::GetDescriptorJson() {
 }
 
 std::string Thing::GetStateJson() {
-    std::string json_str = "{";
-    json_str += "\"name\":\"" + name_ + "\",";
-    json_str += "\"state\":" + properties_.GetStateJson();
+    std::string json_str = "{\"name\":";
+    AppendJsonString(json_str, name_);
+    json_str += ",\"state\":" + properties_.GetStateJson();
     json_str += "}";
     return json_str;
 }
 
+bool Thing::AppendStateJson(std::string& json, bool delta) {
+    size_t start = json.size();
+    json += "{\"name\":";
+    AppendJsonString(json, name_);
+    json += ",\"state\":";
+    if (!properties_.AppendStateJson(json, delta)) {
+        json.resize(start);
+        return false;
+    }
+    json += '}';
+    return true;
+}
+
 void Thing::Invoke(const cJSON* command) {
     auto method_name = cJSON_GetObjectItem(command, "method");
     auto input_params = cJSON_GetObjectItem(command, "parameters");
@@ -1,6 +1,8 @@
 #ifndef THING_H
 #define THING_H
 
+#include <cstdint>
+#include <cstdio>
 #include <string>
 #include <map>
 #include <functional>
@@ -16,6 +18,9 @@ enum ValueType {
     kValueTypeString
 };
 
+// Append value as a JSON string literal, quotes and escapes included
+void AppendJsonString(std::string& json, const std::string& value);
+
 class Property {
 private:
     std::string name_;
@@ -25,6 +30,13 @@ private:
     std::function<int()> number_getter_;
     std::function<std::string()> string_getter_;
 
+    // Value seen by the last Poll()
+    bool cached_boolean_ = false;
+    int cached_number_ = 0;
+    std::string cached_string_;
+    uint32_t version_ = 0;              // bumped whenever Poll() sees a new value
+    uint32_t reported_version_ = 0;     // version last written to a state report
+
 public:
     Property(const std::string& name, const std::string& description, std::function<bool()> getter) :
         name_(name), description_(description), type_(kValueTypeBoolean), boolean_getter_(getter) {}
@@ -41,6 +53,51 @@ public:
     int number() const { return number_getter_(); }
     std::string string() const { return string_getter_(); }
 
+    uint32_t version() const { return version_; }
+    // Changed since the last state report
+    bool dirty() const { return version_ != reported_version_; }
+    void MarkReported() { reported_version_ = version_; }
+
+    // Read the getter and bump version() if the value changed; the first
+    // poll always counts as a change
+    bool Poll() {
+        bool changed = version_ == 0;
+        if (type_ == kValueTypeBoolean) {
+            bool value = boolean_getter_();
+            changed |= value != cached_boolean_;
+            cached_boolean_ = value;
+        } else if (type_ == kValueTypeNumber) {
+            int value = number_getter_();
+            changed |= value != cached_number_;
+            cached_number_ = value;
+        } else if (type_ == kValueTypeString) {
+            std::string value = string_getter_();
+            if (value != cached_string_) {
+                cached_string_ = std::move(value);
+                changed = true;
+            }
+        }
+        if (changed) {
+            version_++;
+        }
+        return changed;
+    }
+
+    // The value from the last Poll() as JSON
+    void AppendStateJson(std::string& json) const {
+        if (type_ == kValueTypeBoolean) {
+            json += cached_boolean_ ? "true" : "false";
+        } else if (type_ == kValueTypeNumber) {
+            char number[12];
+            snprintf(number, sizeof(number), "%d", cached_number_);
+            json += number;
+        } else if (type_ == kValueTypeString) {
+            AppendJsonString(json, cached_string_);
+        } else {
+            json += "null";
+        }
+    }
+
     std::string GetDescriptorJson() {
         std::string json_str = "{";
         json_str += "\"description\":\"" + description_ + "\",";
@@ -56,14 +113,10 @@ public:
     }
 
     std::string GetStateJson() {
-        if (type_ == kValueTypeBoolean) {
-            return boolean_getter_() ? "true" : "false";
-        } else if (type_ == kValueTypeNumber) {
-            return std::to_string(number_getter_());
-        } else if (type_ == kValueTypeString) {
-            return "\"" + string_getter_() + "\"";
-        }
-        return "null";
+        Poll();
+        std::string json_str;
+        AppendStateJson(json_str);
+        return json_str;
     }
 };
 
@@ -94,6 +147,10 @@ public:
         throw std::runtime_error("Property not found: " + name);
     }
 
+    // iterator
+    auto begin() { return properties_.begin(); }
+    auto end() { return properties_.end(); }
+
     std::string GetDescriptorJson() {
         std::string json_str = "{";
         for (auto& property : properties_) {
@@ -109,14 +166,46 @@ public:
     std::string GetStateJson() {
         std::string json_str = "{";
         for (auto& property : properties_) {
-            json_str += "\"" + property.name() + "\":" + property.GetStateJson() + ",";
-        }
-        if (json_str.back() == ',') {
-            json_str.pop_back();
+            property.Poll();
+            if (json_str.size() > 1) {
+                json_str += ',';
+            }
+            AppendJsonString(json_str, property.name());
+            json_str += ':';
+            property.AppendStateJson(json_str);
         }
         json_str += "}";
         return json_str;
     }
+
+    // Poll every property and append a state object. With delta a list
+    // whose properties are all unchanged since the last report appends
+    // nothing and returns false; otherwise every property goes in, because
+    // the server replaces a thing's state rather than merging it.
+    bool AppendStateJson(std::string& json, bool delta) {
+        bool changed = false;
+        for (auto& property : properties_) {
+            property.Poll();
+            changed |= property.dirty();
+        }
+        if (delta && !changed) {
+            return false;
+        }
+        json += '{';
+        bool first = true;
+        for (auto& property : properties_) {
+            if (!first) {
+                json += ',';
+            }
+            AppendJsonString(json, property.name());
+            json += ':';
+            property.AppendStateJson(json);
+            property.MarkReported();
+            first = false;
+        }
+        json += '}';
+        return true;
+    }
 };
 
 class Parameter {
@@ -269,6 +358,9 @@ public:
     virtual std::string GetDescriptorJson();
     virtual std::string GetStateJson();
     virtual void Invoke(const cJSON* command);
+    // {"name":...,"state":{...}} appended to json, always with the full
+    // state; with delta nothing at all (false) unless a property changed
+    bool AppendStateJson(std::string& json, bool delta);
 
     const std::string& name() const { return name_; }
     const std::string& description() const { return description_; }
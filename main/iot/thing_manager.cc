@@ -23,31 +23,28 @@ std::string ThingManager::GetDescriptorsJson() {
 }
 
 bool ThingManager::GetStatesJson(std::string& json, bool delta) {
-    if (!delta) {
-        last_states_.clear();
-    }
-    bool changed = false;
-    json = "[";
-    // 枚举thing，获取每个thing的state，如果发生变化，则更新，保存到last_states_
-    // 如果delta为true，则只返回变化的部分
-    for (auto& thing : things_) {
-        std::string state = thing->GetStateJson();
-        if (delta) {
-            // 如果delta为true，则只返回变化的部分
-            auto it = last_states_.find(thing->name());
-            if (it != last_states_.end() && it->second == state) {
-                continue;
-            }
-            changed = true;
-            last_states_[thing->name()] = state;
+    std::lock_guard<std::mutex> lock(states_mutex_);
+    json.clear();
+    return AppendStatesJson(things_, json, delta);
+}
+
+bool ThingManager::AppendStatesJson(const std::vector<Thing*>& things, std::string& json, bool delta) {
+    // 每个属性带版本号，delta 时只输出有属性变化过的设备（仍带完整状态），且直接写入调用方的缓冲区
+    bool appended = false;
+    json += '[';
+    for (auto& thing : things) {
+        size_t start = json.size();
+        if (appended) {
+            json += ',';
+        }
+        if (thing->AppendStateJson(json, delta)) {
+            appended = true;
+        } else {
+            json.resize(start);
         }
-        json += state + ",";
-    }
-    if (json.back() == ',') {
-        json.pop_back();
     }
-    json += "]";
-    return changed;
+    json += ']';
+    return appended;
 }
 
 void ThingManager::Invoke(const cJSON* command) {
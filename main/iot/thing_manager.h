@@ -9,7 +9,8 @@
 #include <vector>
 #include <memory>
 #include <functional>
-#include <map>
+#include <mutex>
+#include <string>
 
 namespace iot {
 
@@ -25,15 +26,21 @@ public:
     void AddThing(Thing* thing);
 
     std::string GetDescriptorsJson();
+    // Fills json with a state array; with delta only the things with a
+    // property changed since the last report, each with its full state.
+    // Returns false if there is nothing to send.
     bool GetStatesJson(std::string& json, bool delta = false);
     void Invoke(const cJSON* command);
 
+    // The serializer behind GetStatesJson(), for any list of things
+    static bool AppendStatesJson(const std::vector<Thing*>& things, std::string& json, bool delta);
+
 private:
     ThingManager() = default;
     ~ThingManager() = default;
 
     std::vector<Thing*> things_;
-    std::map<std::string, std::string> last_states_;
+    std::mutex states_mutex_;       // reports come from the main loop and the protocol task
 };
 
 
@@ -0,0 +1,180 @@
+#include "thing_state_bench.h"
+#include "sdkconfig.h"
+
+#if CONFIG_IOT_STATE_BENCHMARK
+
+#include "thing_manager.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define TAG "ThingStateBench"
+
+#define BENCH_THINGS 32
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS 500
+#endif
+
+namespace iot {
+namespace {
+
+struct Values {
+    bool power = false;
+    int level = 50;
+    int brightness = 80;
+    std::string label;
+};
+
+class BenchThing : public Thing {
+public:
+    BenchThing(const std::string& name, Values* values) : Thing(name, "benchmark") {
+        properties_.AddBooleanProperty("power", "on/off", [values]() -> bool {
+            return values->power;
+        });
+        properties_.AddNumberProperty("level", "0-100", [values]() -> int {
+            return values->level;
+        });
+        properties_.AddNumberProperty("brightness", "0-100", [values]() -> int {
+            return values->brightness;
+        });
+        properties_.AddStringProperty("label", "display name", [values]() -> std::string {
+            return values->label;
+        });
+    }
+
+    PropertyList& properties() { return properties_; }
+};
+
+// The previous ThingManager::GetStatesJson(delta = true)
+class LegacyStates {
+public:
+    bool GetStatesJson(const std::vector<BenchThing*>& things, std::string& json) {
+        bool changed = false;
+        json = "[";
+        for (auto& thing : things) {
+            std::string state = GetStateJson(thing);
+            auto it = last_states_.find(thing->name());
+            if (it != last_states_.end() && it->second == state) {
+                continue;
+            }
+            changed = true;
+            last_states_[thing->name()] = state;
+            json += state + ",";
+        }
+        if (json.back() == ',') {
+            json.pop_back();
+        }
+        json += "]";
+        return changed;
+    }
+
+private:
+    std::map<std::string, std::string> last_states_;
+
+    static std::string GetStateJson(BenchThing* thing) {
+        std::string properties = "{";
+        for (auto& property : thing->properties()) {
+            std::string value;
+            if (property.type() == kValueTypeBoolean) {
+                value = property.boolean() ? "true" : "false";
+            } else if (property.type() == kValueTypeNumber) {
+                value = std::to_string(property.number());
+            } else {
+                value = "\"" + property.string() + "\"";
+            }
+            properties += "\"" + property.name() + "\":" + value + ",";
+        }
+        properties.pop_back();
+        properties += "}";
+
+        std::string json_str = "{";
+        json_str += "\"name\":\"" + thing->name() + "\",";
+        json_str += "\"state\":" + properties;
+        json_str += "}";
+        return json_str;
+    }
+};
+
+// A couple of properties change between reports, like volume or brightness
+// during a conversation
+void Mutate(std::vector<Values>& values, int round) {
+    values[(round * 7) % BENCH_THINGS].level = round % 101;
+    if (round % 3 == 0) {
+        auto& v = values[(round * 13) % BENCH_THINGS];
+        v.power = !v.power;
+    }
+    if (round % 10 == 0) {
+        values[(round * 5) % BENCH_THINGS].label = "客厅 \"主灯\" #" + std::to_string(round);
+    }
+}
+
+template <typename Report>
+void Run(const char* name, std::vector<Values>& values, Report report) {
+    // Start from a full report, as after OpenAudioChannel
+    std::string json;
+    report(json, false);
+
+    size_t bytes = 0;
+    int64_t start = esp_timer_get_time();
+    for (int round = 1; round <= BENCH_ROUNDS; round++) {
+        Mutate(values, round);
+        if (report(json, true)) {
+            bytes += json.size();
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "%-7s %d things: %lu us per update, %u bytes per update", name, BENCH_THINGS,
+             (unsigned long)(elapsed_us / BENCH_ROUNDS), (unsigned)(bytes / BENCH_ROUNDS));
+    ESP_LOGI(TAG, "%-7s last update: %s", name, json.c_str());
+}
+
+std::vector<Values> MakeValues() {
+    std::vector<Values> values(BENCH_THINGS);
+    for (int i = 0; i < BENCH_THINGS; i++) {
+        values[i].label = "device " + std::to_string(i);
+    }
+    return values;
+}
+
+} // namespace
+} // namespace iot
+
+void thing_state_run_benchmark() {
+    using namespace iot;
+
+    std::vector<Values> legacy_values = MakeValues();
+    std::vector<Values> delta_values = MakeValues();
+    std::vector<std::unique_ptr<BenchThing>> owners;
+    std::vector<BenchThing*> legacy_things;
+    std::vector<Thing*> delta_things;
+    for (int i = 0; i < BENCH_THINGS; i++) {
+        std::string name = "Thing" + std::to_string(i);
+        owners.emplace_back(new BenchThing(name, &legacy_values[i]));
+        legacy_things.push_back(owners.back().get());
+        owners.emplace_back(new BenchThing(name, &delta_values[i]));
+        delta_things.push_back(owners.back().get());
+    }
+
+    // The old full report never filled last_states_, so warm up with a delta
+    LegacyStates legacy;
+    Run("legacy", legacy_values, [&](std::string& json, bool /* delta */) {
+        return legacy.GetStatesJson(legacy_things, json);
+    });
+    Run("delta", delta_values, [&](std::string& json, bool delta) {
+        json.clear();
+        return ThingManager::AppendStatesJson(delta_things, json, delta);
+    });
+}
+
+#else
+
+void thing_state_run_benchmark() {
+}
+
+#endif // CONFIG_IOT_STATE_BENCHMARK
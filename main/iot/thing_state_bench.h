@@ -0,0 +1,16 @@
+#ifndef THING_STATE_BENCH_H
+#define THING_STATE_BENCH_H
+
+/**
+ * @brief Compare IoT state reporting on a few dozen things
+ *
+ * Replays a stream of small property changes over a set of synthetic
+ * things and reports each delta the old way (full state strings compared
+ * against a map) and through ThingManager::AppendStatesJson, logging time
+ * and payload bytes per update for each.
+ *
+ * @note Enabled with CONFIG_IOT_STATE_BENCHMARK
+ */
+void thing_state_run_benchmark();
+
+#endif // THING_STATE_BENCH_H
@@ -18,6 +18,10 @@
 #include "YT_UART.h"
 #include "PFS123.h"
 #include "storage/gif_storage.h"
+#include "storage/gif_storage_bench.h"
+#include "schedule_bench.h"
+#include "protocols/server_message_bench.h"
+#include "iot/thing_state_bench.h"
 
 #define TAG "main"
 void set_gpio() {
@@ -59,6 +63,20 @@ extern "C" void app_main(void)
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "GIF storage initialization failed: %s (partition may not exist)", esp_err_to_name(ret));
     }
+#if CONFIG_GIF_STORAGE_BENCHMARK
+    else {
+        gif_storage_run_benchmark();
+    }
+#endif
+#if CONFIG_SCHEDULE_BENCHMARK
+    schedule_run_benchmark();
+#endif
+#if CONFIG_SERVER_MESSAGE_BENCHMARK
+    server_message_run_benchmark();
+#endif
+#if CONFIG_IOT_STATE_BENCHMARK
+    thing_state_run_benchmark();
+#endif
 
     // Launch the application
     Application::GetInstance().Start();
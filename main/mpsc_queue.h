@@ -0,0 +1,124 @@
+#ifndef _MPSC_QUEUE_H_
+#define _MPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+/**
+ * @brief Unbounded multi-producer / single-consumer FIFO with preallocated nodes
+ *
+ * Intrusive Vyukov queue: Push() is one atomic exchange plus a store, Pop()
+ * is wait-free. Nodes come from a fixed pool claimed by CAS on a bitmask,
+ * so nothing is allocated until more than kPoolSize items are queued at
+ * once; those overflow nodes are counted in heap_nodes() and freed on pop.
+ *
+ * Pop() may return false while a Push() is halfway through; the producer
+ * is expected to wake the consumer after Push() returns, so that is only
+ * a short spurious miss. Pop() must only be called from one task.
+ */
+template <typename T, size_t kPoolSize = 16>
+class MpscQueue {
+    static_assert(kPoolSize > 0 && kPoolSize <= 32, "pool is a 32-bit mask");
+
+public:
+    MpscQueue() : head_(&stub_), tail_(&stub_) {
+        for (size_t i = 0; i < kPoolSize; i++) {
+            pool_[i].pooled = true;
+        }
+    }
+
+    ~MpscQueue() {
+        T value;
+        while (Pop(value)) {
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void Push(T&& value) {
+        Node* node = AcquireNode();
+        node->value = std::move(value);
+        node->next.store(nullptr, std::memory_order_relaxed);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        Link(node);
+    }
+
+    bool Pop(T& value) {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr) {
+                return false;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next == nullptr) {
+            if (tail != head_.load(std::memory_order_acquire)) {
+                return false;   // a producer has swapped head_ but not linked yet
+            }
+            // tail is the last node: park the stub behind it so it can be taken
+            stub_.next.store(nullptr, std::memory_order_relaxed);
+            Link(&stub_);
+            next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                return false;
+            }
+        }
+        tail_ = next;
+        value = std::move(tail->value);
+        tail->value = T();
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        ReleaseNode(tail);
+        return true;
+    }
+
+    size_t size() const { return size_.load(std::memory_order_relaxed); }
+    uint32_t heap_nodes() const { return heap_nodes_.load(std::memory_order_relaxed); }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value{};
+        bool pooled = false;
+    };
+
+    Node pool_[kPoolSize];
+    Node stub_;
+    std::atomic<Node*> head_;       // last pushed, producers
+    Node* tail_;                    // next to pop, consumer only
+    std::atomic<uint32_t> free_mask_{kPoolSize == 32 ? 0xFFFFFFFFu : (1u << kPoolSize) - 1};
+    std::atomic<size_t> size_{0};
+    std::atomic<uint32_t> heap_nodes_{0};
+
+    void Link(Node* node) {
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    Node* AcquireNode() {
+        uint32_t mask = free_mask_.load(std::memory_order_relaxed);
+        while (mask != 0) {
+            int index = __builtin_ctz(mask);
+            if (free_mask_.compare_exchange_weak(mask, mask & ~(1u << index), std::memory_order_acquire)) {
+                return &pool_[index];
+            }
+        }
+        heap_nodes_.fetch_add(1, std::memory_order_relaxed);
+        return new Node();
+    }
+
+    void ReleaseNode(Node* node) {
+        if (!node->pooled) {
+            delete node;
+            return;
+        }
+        free_mask_.fetch_or(1u << (node - pool_), std::memory_order_release);
+    }
+};
+
+#endif // _MPSC_QUEUE_H_
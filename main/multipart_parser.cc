@@ -0,0 +1,305 @@
+#include "multipart_parser.h"
+
+#include <cstring>
+#include <cctype>
+
+namespace {
+
+bool EqualsIgnoreCase(const std::string& a, const char* b) {
+    size_t n = strlen(b);
+    if (a.size() != n) {
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t");
+    return s.substr(begin, end - begin + 1);
+}
+
+// Look up a parameter in a header value such as
+// `form-data; name="file"; filename="a.gif"` or `multipart/form-data; boundary=xyz`
+bool FindParam(const std::string& value, const char* key, std::string& out) {
+    size_t pos = value.find(';');
+    while (pos != std::string::npos && pos < value.size()) {
+        ++pos;  // skip ';'
+        size_t eq = value.find_first_of("=;", pos);
+        if (eq == std::string::npos || value[eq] == ';') {
+            pos = eq;
+            continue;
+        }
+        std::string name = Trim(value.substr(pos, eq - pos));
+        pos = eq + 1;
+        while (pos < value.size() && (value[pos] == ' ' || value[pos] == '\t')) {
+            ++pos;
+        }
+
+        std::string param;
+        if (pos < value.size() && value[pos] == '"') {
+            // quoted-string, '\' escapes the next character
+            ++pos;
+            while (pos < value.size() && value[pos] != '"') {
+                if (value[pos] == '\\' && pos + 1 < value.size()) {
+                    ++pos;
+                }
+                param += value[pos++];
+            }
+            pos = value.find(';', pos);
+        } else {
+            size_t end = value.find(';', pos);
+            param = Trim(value.substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+            pos = end;
+        }
+
+        if (EqualsIgnoreCase(name, key)) {
+            out = param;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+bool MultipartParser::ParseBoundary(const char* content_type, std::string& boundary) {
+    if (!content_type) {
+        return false;
+    }
+    std::string value;
+    if (!FindParam(content_type, "boundary", value)) {
+        return false;
+    }
+    if (value.empty() || value.size() > kMaxBoundaryLength) {
+        return false;
+    }
+    boundary = value;
+    return true;
+}
+
+MultipartParser::MultipartParser(const std::string& boundary, Callbacks callbacks)
+    : callbacks_(std::move(callbacks)) {
+    delimiter_ = "\r\n--" + boundary;
+
+    // KMP failure function: failure_[j] is the longest proper prefix of
+    // delimiter_[0, j) that is also its suffix
+    const size_t len = delimiter_.size();
+    failure_.assign(len + 1, 0);
+    size_t k = 0;
+    for (size_t j = 1; j < len; ++j) {
+        while (k > 0 && delimiter_[j] != delimiter_[k]) {
+            k = failure_[k];
+        }
+        if (delimiter_[j] == delimiter_[k]) {
+            ++k;
+        }
+        failure_[j + 1] = k;
+    }
+
+    // The first boundary may start the body without a leading CRLF; pretend
+    // the CRLF was already seen so both forms match
+    match_ = 2;
+}
+
+void MultipartParser::Fail(const char* message) {
+    if (state_ != State::kError) {
+        state_ = State::kError;
+        error_ = message;
+    }
+}
+
+bool MultipartParser::Emit(const uint8_t* data, size_t size) {
+    if (size == 0 || !callbacks_.on_part_data) {
+        return true;
+    }
+    if (!callbacks_.on_part_data(data, size)) {
+        Fail("aborted by data callback");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Scan for the delimiter. Bytes that turn out not to belong to it are passed
+ * to Emit() when `emit` is set (part body) or dropped (preamble).
+ *
+ * Bytes matching a delimiter prefix are held back until the match either
+ * completes or fails. Since they equal delimiter_[0, match_), nothing has to
+ * be copied: on a mismatch they are emitted from delimiter_ itself, which is
+ * what lets a delimiter straddle chunk boundaries.
+ *
+ * @return number of bytes consumed; *found is set when the delimiter ended
+ */
+size_t MultipartParser::ScanDelimiter(const uint8_t* data, size_t size, bool emit, bool* found) {
+    const uint8_t* delim = reinterpret_cast<const uint8_t*>(delimiter_.data());
+    const size_t delim_len = delimiter_.size();
+    size_t run_start = 0;  // data[run_start, i) is plain body not emitted yet
+    size_t i = 0;
+    *found = false;
+
+    while (i < size) {
+        if (match_ == 0) {
+            // Fast path: only '\r' can start a delimiter
+            const void* cr = memchr(data + i, '\r', size - i);
+            if (!cr) {
+                i = size;
+                break;
+            }
+            i = static_cast<const uint8_t*>(cr) - data;
+        }
+
+        uint8_t c = data[i];
+        while (match_ > 0 && c != delim[match_]) {
+            size_t k = failure_[match_];
+            if (emit && !Emit(delim, match_ - k)) {
+                return i;
+            }
+            match_ = k;
+            run_start = i;
+        }
+
+        if (c == delim[match_]) {
+            if (match_ == 0 && emit && !Emit(data + run_start, i - run_start)) {
+                return i;
+            }
+            ++match_;
+            ++i;
+            if (match_ == delim_len) {
+                match_ = 0;
+                *found = true;
+                return i;
+            }
+        } else {
+            ++i;  // plain byte, extends the run
+        }
+    }
+
+    if (match_ == 0 && emit) {
+        Emit(data + run_start, i - run_start);
+    }
+    return i;
+}
+
+void MultipartParser::ParseHeaderLine() {
+    size_t colon = header_line_.find(':');
+    if (colon == std::string::npos) {
+        // Tolerate junk lines; only the headers below matter
+        return;
+    }
+    std::string name = Trim(header_line_.substr(0, colon));
+    std::string value = Trim(header_line_.substr(colon + 1));
+
+    if (EqualsIgnoreCase(name, "Content-Disposition")) {
+        FindParam(value, "name", part_.name);
+        std::string filename;
+        if (FindParam(value, "filename", filename)) {
+            // Some browsers send the full client path
+            size_t slash = filename.find_last_of("/\\");
+            part_.filename = (slash == std::string::npos) ? filename : filename.substr(slash + 1);
+        }
+    } else if (EqualsIgnoreCase(name, "Content-Type")) {
+        part_.content_type = value;
+    }
+}
+
+bool MultipartParser::Feed(const uint8_t* data, size_t size) {
+    size_t pos = 0;
+    while (pos < size && state_ != State::kError) {
+        switch (state_) {
+        case State::kPreamble:
+        case State::kBody: {
+            bool in_body = (state_ == State::kBody);
+            bool found = false;
+            pos += ScanDelimiter(data + pos, size - pos, in_body, &found);
+            if (state_ == State::kError || !found) {
+                break;
+            }
+            if (in_body && callbacks_.on_part_end && !callbacks_.on_part_end()) {
+                Fail("aborted by part end callback");
+                break;
+            }
+            state_ = State::kAfterBoundary;
+            break;
+        }
+
+        case State::kAfterBoundary: {
+            uint8_t c = data[pos++];
+            if (c == '\r') {
+                state_ = State::kAfterBoundaryLf;
+            } else if (c == '-') {
+                state_ = State::kFinalDash;
+            } else if (c != ' ' && c != '\t') {
+                Fail("malformed boundary line");
+            }
+            break;
+        }
+
+        case State::kAfterBoundaryLf:
+            if (data[pos++] != '\n') {
+                Fail("malformed boundary line");
+                break;
+            }
+            part_ = Part{};
+            header_line_.clear();
+            state_ = State::kHeaders;
+            break;
+
+        case State::kFinalDash:
+            if (data[pos++] != '-') {
+                Fail("malformed closing boundary");
+                break;
+            }
+            state_ = State::kEpilogue;
+            break;
+
+        case State::kHeaders: {
+            const void* lf = memchr(data + pos, '\n', size - pos);
+            size_t end = lf ? static_cast<const uint8_t*>(lf) - data : size;
+            if (header_line_.size() + (end - pos) > kMaxHeaderLineLength) {
+                Fail("part header too long");
+                break;
+            }
+            header_line_.append(reinterpret_cast<const char*>(data + pos), end - pos);
+            pos = lf ? end + 1 : size;
+            if (!lf) {
+                break;
+            }
+
+            if (!header_line_.empty() && header_line_.back() == '\r') {
+                header_line_.pop_back();
+            }
+            if (header_line_.empty()) {
+                // Blank line: headers done, the body follows
+                if (callbacks_.on_part_begin && !callbacks_.on_part_begin(part_)) {
+                    Fail("aborted by part begin callback");
+                    break;
+                }
+                match_ = 0;
+                state_ = State::kBody;
+            } else {
+                ParseHeaderLine();
+                header_line_.clear();
+            }
+            break;
+        }
+
+        case State::kEpilogue:
+            // Anything after the closing delimiter is ignored
+            pos = size;
+            break;
+
+        case State::kError:
+            break;
+        }
+    }
+    return state_ != State::kError;
+}
@@ -0,0 +1,92 @@
+#ifndef _MULTIPART_PARSER_H_
+#define _MULTIPART_PARSER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+/**
+ * @brief Streaming multipart/form-data parser
+ *
+ * Feed() accepts the body in arbitrarily sized chunks (as returned by
+ * httpd_req_recv) and hands part bodies to the callbacks without buffering
+ * them: data is passed as pointers into the caller's chunk, so memory use is
+ * bounded by the header line limit and does not depend on the upload size.
+ * The delimiter ("\r\n--boundary") is matched incrementally, so it may be
+ * split across any number of chunks.
+ *
+ * Every callback may return false to abort parsing (e.g. storage full); the
+ * parser then stays in the error state.
+ *
+ * No ESP-IDF dependencies, so it can be built and exercised on the host.
+ */
+class MultipartParser {
+public:
+    struct Part {
+        std::string name;          // Content-Disposition name="..."
+        std::string filename;      // Content-Disposition filename="...", empty for plain fields
+        std::string content_type;
+    };
+
+    struct Callbacks {
+        std::function<bool(const Part& part)> on_part_begin;
+        std::function<bool(const uint8_t* data, size_t size)> on_part_data;
+        std::function<bool()> on_part_end;
+    };
+
+    // RFC 2046: boundary is 1..70 characters
+    static constexpr size_t kMaxBoundaryLength = 70;
+    static constexpr size_t kMaxHeaderLineLength = 1024;
+
+    /**
+     * @brief Extract the boundary parameter from a Content-Type header value
+     * @return false if the header has no (valid) boundary
+     */
+    static bool ParseBoundary(const char* content_type, std::string& boundary);
+
+    MultipartParser(const std::string& boundary, Callbacks callbacks);
+
+    /**
+     * @brief Parse the next chunk of the body
+     * @return false on malformed input or if a callback aborted
+     */
+    bool Feed(const uint8_t* data, size_t size);
+
+    // The closing delimiter ("--boundary--") has been seen
+    bool IsComplete() const { return state_ == State::kEpilogue; }
+    bool HasError() const { return state_ == State::kError; }
+    const char* error() const { return error_; }
+
+    MultipartParser(const MultipartParser&) = delete;
+    MultipartParser& operator=(const MultipartParser&) = delete;
+
+private:
+    enum class State {
+        kPreamble,
+        kAfterBoundary,    // transport padding, then CRLF or "--"
+        kAfterBoundaryLf,
+        kFinalDash,
+        kHeaders,
+        kBody,
+        kEpilogue,
+        kError,
+    };
+
+    State state_ = State::kPreamble;
+    std::string delimiter_;         // "\r\n--" + boundary
+    std::vector<uint8_t> failure_;  // KMP failure function of delimiter_
+    size_t match_ = 0;              // delimiter_ bytes matched so far
+    std::string header_line_;
+    Part part_;
+    Callbacks callbacks_;
+    const char* error_ = nullptr;
+
+    size_t ScanDelimiter(const uint8_t* data, size_t size, bool emit, bool* found);
+    bool Emit(const uint8_t* data, size_t size);
+    void ParseHeaderLine();
+    void Fail(const char* message);
+};
+
+#endif // _MULTIPART_PARSER_H_
@@ -111,19 +111,12 @@ static bool ShowStoredImageHelper(const std::string& filename) {
         return false;
     }
 
-    uint8_t* data = nullptr;
-    size_t size = 0;
-    esp_err_t ret = gif_storage_read(filename.c_str(), &data, &size);
-    if (ret != ESP_OK) {
-        return false;
-    }
-
+    // Streamed from flash by the display, no PSRAM copy of the file
     auto& app = Application::GetInstance();
-    app.Schedule([data, size]() {
+    app.Schedule([filename]() {
         if (auto display = Board::GetInstance().GetDisplay()) {
-            display->ShowGif(data, size);
+            display->ShowGifFromFlash(filename.c_str());
         }
-        heap_caps_free(data);
     });
     return true;
 }
@@ -0,0 +1,121 @@
+#include "audio_crypto.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <arpa/inet.h>
+#include <cstring>
+
+#define TAG "AudioCrypto"
+
+#define AUDIO_CRYPTO_BLOCK_SIZE 16
+
+AudioCrypto::AudioCrypto() {
+    mbedtls_aes_init(&aes_);
+}
+
+AudioCrypto::~AudioCrypto() {
+    mbedtls_aes_free(&aes_);
+}
+
+bool AudioCrypto::Configure(const std::string& key, const std::string& nonce) {
+    configured_ = false;
+    if (key.size() != 16 || nonce.size() < AUDIO_CRYPTO_BLOCK_SIZE) {
+        ESP_LOGE(TAG, "Invalid key (%u bytes) or nonce (%u bytes)", key.size(), nonce.size());
+        return false;
+    }
+    mbedtls_aes_free(&aes_);
+    mbedtls_aes_init(&aes_);
+    if (mbedtls_aes_setkey_enc(&aes_, (const unsigned char*)key.data(), 128) != 0) {
+        ESP_LOGE(TAG, "Failed to set AES key");
+        return false;
+    }
+    nonce_ = nonce;
+    sealed_ = 0;
+    opened_ = 0;
+    failed_ = 0;
+    bytes_ = 0;
+    busy_us_ = 0;
+    configured_ = true;
+    ESP_LOGI(TAG, "AES-128-CTR on %s", backend_name());
+    return true;
+}
+
+bool AudioCrypto::Crypt(const uint8_t* counter_block, const uint8_t* input, uint8_t* output, size_t size) {
+    // mbedtls advances the counter in place; never hand it the packet header
+    uint8_t counter[AUDIO_CRYPTO_BLOCK_SIZE];
+    memcpy(counter, counter_block, sizeof(counter));
+    uint8_t stream_block[AUDIO_CRYPTO_BLOCK_SIZE] = {0};
+    size_t nc_off = 0;
+
+#if CONFIG_AUDIO_CRYPTO_PROFILE
+    int64_t start = esp_timer_get_time();
+#endif
+    int ret = mbedtls_aes_crypt_ctr(&aes_, size, &nc_off, counter, stream_block, input, output);
+#if CONFIG_AUDIO_CRYPTO_PROFILE
+    // Two timer reads per packet, so only when asked for
+    busy_us_.fetch_add((uint32_t)(esp_timer_get_time() - start), std::memory_order_relaxed);
+#endif
+    bytes_.fetch_add(size, std::memory_order_relaxed);
+    if (ret != 0) {
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        ESP_LOGE(TAG, "AES-CTR failed: %d", ret);
+        return false;
+    }
+    return true;
+}
+
+bool AudioCrypto::Seal(uint32_t sequence, const uint8_t* payload, size_t size, std::string& packet) {
+    if (!configured_) {
+        return false;
+    }
+    size_t header_size = nonce_.size();
+    packet.resize(header_size + size);
+    auto header = (uint8_t*)packet.data();
+    memcpy(header, nonce_.data(), header_size);
+    uint16_t payload_size = htons(size);
+    memcpy(header + 2, &payload_size, sizeof(payload_size));
+    sequence = htonl(sequence);
+    memcpy(header + 12, &sequence, sizeof(sequence));
+
+    if (!Crypt(header, payload, header + header_size, size)) {
+        return false;
+    }
+    sealed_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool AudioCrypto::Open(const std::string& data, std::vector<uint8_t>& payload) {
+    if (!configured_ || data.size() < nonce_.size()) {
+        return false;
+    }
+    size_t size = data.size() - nonce_.size();
+    payload.resize(size);
+    auto packet = (const uint8_t*)data.data();
+    if (!Crypt(packet, packet + nonce_.size(), payload.data(), size)) {
+        return false;
+    }
+    opened_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+AudioCrypto::Stats AudioCrypto::GetStats() const {
+    return Stats{
+        sealed_.load(std::memory_order_relaxed),
+        opened_.load(std::memory_order_relaxed),
+        failed_.load(std::memory_order_relaxed),
+        bytes_.load(std::memory_order_relaxed),
+        busy_us_.load(std::memory_order_relaxed),
+    };
+}
+
+AudioCrypto::Backend AudioCrypto::backend() {
+#if CONFIG_MBEDTLS_HARDWARE_AES
+    return kBackendHardware;
+#else
+    return kBackendSoftware;
+#endif
+}
+
+const char* AudioCrypto::backend_name() {
+    return backend() == kBackendHardware ? "AES peripheral" : "software AES";
+}
@@ -0,0 +1,74 @@
+#ifndef AUDIO_CRYPTO_H
+#define AUDIO_CRYPTO_H
+
+#include <mbedtls/aes.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief AES-CTR sealing of MQTT+UDP audio datagrams
+ *
+ * Wire format: the session nonce with the payload size patched in at
+ * [2..4) and the sequence number at [12..16), both big endian, followed by
+ * the encrypted Opus payload. The header is also the initial counter block.
+ *
+ * With CONFIG_MBEDTLS_HARDWARE_AES the mbedtls AES calls are served by the
+ * ESP AES peripheral (DMA on S3/C3), otherwise by the software tables.
+ * The counter block carries the payload size, so the keystream of a packet
+ * cannot be computed before the packet is encoded.
+ *
+ * One sealing and one opening task may run concurrently.
+ */
+class AudioCrypto {
+public:
+    enum Backend {
+        kBackendSoftware,
+        kBackendHardware,
+    };
+
+    struct Stats {
+        uint32_t sealed;
+        uint32_t opened;
+        uint32_t failed;
+        uint32_t bytes;
+        uint32_t busy_us;       // time spent in AES since Configure(), CONFIG_AUDIO_CRYPTO_PROFILE only
+    };
+
+    AudioCrypto();
+    ~AudioCrypto();
+
+    AudioCrypto(const AudioCrypto&) = delete;
+    AudioCrypto& operator=(const AudioCrypto&) = delete;
+
+    // 16-byte key and nonce as sent in the server hello (already decoded)
+    bool Configure(const std::string& key, const std::string& nonce);
+    bool IsConfigured() const { return configured_; }
+    size_t header_size() const { return nonce_.size(); }
+
+    // Seal `payload` into `packet`; the string keeps its capacity between calls
+    bool Seal(uint32_t sequence, const uint8_t* payload, size_t size, std::string& packet);
+    // Decrypt the payload of a received datagram into `payload`, reusing its capacity
+    bool Open(const std::string& data, std::vector<uint8_t>& payload);
+
+    Stats GetStats() const;
+    static Backend backend();
+    static const char* backend_name();
+
+private:
+    mbedtls_aes_context aes_;
+    std::string nonce_;
+    bool configured_ = false;
+
+    std::atomic<uint32_t> sealed_{0};
+    std::atomic<uint32_t> opened_{0};
+    std::atomic<uint32_t> failed_{0};
+    std::atomic<uint32_t> bytes_{0};
+    std::atomic<uint32_t> busy_us_{0};
+
+    bool Crypt(const uint8_t* counter_block, const uint8_t* input, uint8_t* output, size_t size);
+};
+
+#endif // AUDIO_CRYPTO_H
@@ -0,0 +1,58 @@
+#include "audio_frame_batcher.h"
+
+#define AUDIO_FRAME_HEADER_SIZE 2
+
+void AudioFrameBatcher::Configure(int frames_per_packet, int max_delay_ms) {
+    frames_per_packet_ = frames_per_packet < 1 ? 1 : frames_per_packet;
+    max_delay_us_ = (int64_t)max_delay_ms * 1000;
+    Clear();
+}
+
+bool AudioFrameBatcher::Add(const uint8_t* opus, size_t size, int64_t now_us) {
+    if (frames_ == 0) {
+        first_frame_us_ = now_us;
+    }
+    payload_.push_back((uint8_t)(size >> 8));
+    payload_.push_back((uint8_t)size);
+    payload_.insert(payload_.end(), opus, opus + size);
+    frames_++;
+    return frames_ >= frames_per_packet_ || Due(now_us);
+}
+
+bool AudioFrameBatcher::Due(int64_t now_us) const {
+    return frames_ > 0 && now_us >= deadline_us();
+}
+
+void AudioFrameBatcher::Clear() {
+    payload_.clear();
+    frames_ = 0;
+}
+
+bool AudioFrameBatcher::Split(const uint8_t* data, size_t size, int frames_per_packet,
+                              const std::function<void(const uint8_t* opus, size_t size)>& frame) {
+    if (frames_per_packet <= 1) {
+        frame(data, size);
+        return true;
+    }
+    // Validate first so a truncated message delivers nothing
+    size_t offset = 0;
+    int count = 0;
+    while (offset < size) {
+        if (size - offset < AUDIO_FRAME_HEADER_SIZE) {
+            return false;
+        }
+        size_t length = ((size_t)data[offset] << 8) | data[offset + 1];
+        offset += AUDIO_FRAME_HEADER_SIZE;
+        if (length > size - offset || ++count > frames_per_packet) {
+            return false;
+        }
+        offset += length;
+    }
+    for (offset = 0; offset < size;) {
+        size_t length = ((size_t)data[offset] << 8) | data[offset + 1];
+        offset += AUDIO_FRAME_HEADER_SIZE;
+        frame(data + offset, length);
+        offset += length;
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef AUDIO_FRAME_BATCHER_H
+#define AUDIO_FRAME_BATCHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Coalesces Opus frames into multi-frame audio messages
+ *
+ * With frames_per_packet > 1 (negotiated in the hello audio_params) every
+ * binary audio message carries one or more Opus frames, each prefixed by
+ * its size as a big-endian uint16. With 1 a message is a bare Opus frame,
+ * exactly as before.
+ *
+ * A batch is sent once it holds frames_per_packet frames, or once its
+ * first frame has waited max_delay_ms. Not thread-safe.
+ */
+class AudioFrameBatcher {
+public:
+    void Configure(int frames_per_packet, int max_delay_ms);
+    int frames_per_packet() const { return frames_per_packet_; }
+
+    // Append one frame; true when the batch should be sent now
+    bool Add(const uint8_t* opus, size_t size, int64_t now_us);
+    bool Due(int64_t now_us) const;
+
+    bool empty() const { return frames_ == 0; }
+    int frames() const { return frames_; }
+    int64_t deadline_us() const { return first_frame_us_ + max_delay_us_; }
+    const uint8_t* data() const { return payload_.data(); }
+    size_t size() const { return payload_.size(); }
+    void Clear();
+
+    // Calls `frame` for every Opus frame of a received message; false if it is malformed
+    static bool Split(const uint8_t* data, size_t size, int frames_per_packet,
+                      const std::function<void(const uint8_t* opus, size_t size)>& frame);
+
+private:
+    int frames_per_packet_ = 1;
+    int64_t max_delay_us_ = 0;
+    int frames_ = 0;
+    int64_t first_frame_us_ = 0;
+    std::vector<uint8_t> payload_;  // keeps its capacity across batches
+};
+
+#endif // AUDIO_FRAME_BATCHER_H
@@ -0,0 +1,157 @@
+#include "jitter_buffer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// A jump larger than this is a restarted stream, not loss or reordering
+static constexpr int32_t kResyncDistance = 4 * OpusJitterBuffer::kWindow;
+
+OpusJitterBuffer::OpusJitterBuffer(int frame_duration_ms, int max_delay_ms)
+    : frame_us_(frame_duration_ms * 1000LL), max_delay_us_(max_delay_ms * 1000LL) {
+    if (max_delay_us_ < frame_us_) {
+        max_delay_us_ = frame_us_;
+    }
+}
+
+void OpusJitterBuffer::SetFrameDuration(int frame_duration_ms) {
+    frame_us_ = frame_duration_ms * 1000LL;
+    if (max_delay_us_ < frame_us_) {
+        max_delay_us_ = frame_us_;
+    }
+    have_transit_ = false;
+    jitter_us_ = 0;
+}
+
+void OpusJitterBuffer::Reset() {
+    DropHeld();
+    started_ = false;
+    consecutive_lost_ = 0;
+    have_transit_ = false;
+    jitter_us_ = 0;
+    stats_ = Stats();
+}
+
+void OpusJitterBuffer::DropHeld() {
+    for (auto& slot : slots_) {
+        slot.used = false;
+        slot.opus.clear();
+    }
+    held_ = 0;
+}
+
+void OpusJitterBuffer::UpdateJitter(uint32_t sequence, int64_t now_us) {
+    // Relative transit time: arrival minus the nominal send time of this frame
+    int64_t transit = now_us - (int64_t)sequence * frame_us_;
+    if (have_transit_) {
+        int64_t d = std::llabs(transit - last_transit_us_);
+        jitter_us_ += (d - jitter_us_) / 16;
+    }
+    last_transit_us_ = transit;
+    have_transit_ = true;
+}
+
+int64_t OpusJitterBuffer::TargetDelayUs() const {
+    return std::clamp<int64_t>(2 * jitter_us_, frame_us_, max_delay_us_);
+}
+
+int64_t OpusJitterBuffer::OldestHeldArrival() const {
+    int64_t oldest = INT64_MAX;
+    for (const auto& slot : slots_) {
+        if (slot.used && slot.arrival_us < oldest) {
+            oldest = slot.arrival_us;
+        }
+    }
+    return oldest;
+}
+
+void OpusJitterBuffer::Push(uint32_t sequence, std::vector<uint8_t>&& opus, int64_t now_us, const Output& output) {
+    stats_.received++;
+
+    if (!started_) {
+        started_ = true;
+        next_sequence_ = sequence;
+    }
+
+    int32_t distance = (int32_t)(sequence - next_sequence_);
+    if (distance < -kResyncDistance || distance >= kResyncDistance) {
+        // Server restarted its counter or we missed a long stretch: play what
+        // is held, then continue from this packet
+        Release(now_us, true, output);
+        stats_.resyncs++;
+        next_sequence_ = sequence;
+        consecutive_lost_ = 0;
+        have_transit_ = false;
+        distance = 0;
+    }
+    UpdateJitter(sequence, now_us);
+
+    if (distance < 0) {
+        stats_.late++;
+        return;
+    } else if (distance >= (int32_t)kWindow) {
+        // Past the window: give up on the oldest missing frames to make room
+        while ((int32_t)(sequence - next_sequence_) >= (int32_t)kWindow) {
+            Release(now_us, true, output);
+            if ((int32_t)(sequence - next_sequence_) < (int32_t)kWindow) {
+                break;
+            }
+            stats_.lost++;
+            next_sequence_++;
+        }
+    }
+
+    Slot& slot = slots_[sequence % kWindow];
+    if (slot.used) {
+        stats_.duplicate++;
+        return;
+    }
+    slot.used = true;
+    slot.sequence = sequence;
+    slot.arrival_us = now_us;
+    slot.opus = std::move(opus);
+    held_++;
+
+    Release(now_us, false, output);
+}
+
+void OpusJitterBuffer::Poll(int64_t now_us, const Output& output) {
+    if (held_ > 0) {
+        Release(now_us, false, output);
+    }
+}
+
+// Play out in sequence order. A gap is concealed once the packets behind it
+// have waited the target delay (or unconditionally when flushing).
+void OpusJitterBuffer::Release(int64_t now_us, bool flush, const Output& output) {
+    while (held_ > 0) {
+        Slot& slot = slots_[next_sequence_ % kWindow];
+        if (slot.used && slot.sequence == next_sequence_) {
+            std::vector<uint8_t> opus = std::move(slot.opus);
+            slot.used = false;
+            held_--;
+            next_sequence_++;
+            consecutive_lost_ = 0;
+            output(std::move(opus));
+            continue;
+        }
+
+        if (!flush && now_us - OldestHeldArrival() < TargetDelayUs()) {
+            break;
+        }
+        stats_.lost++;
+        if (consecutive_lost_ < kMaxConcealFrames) {
+            stats_.concealed++;
+            output(std::vector<uint8_t>());
+        }
+        consecutive_lost_++;
+        next_sequence_++;
+    }
+}
+
+OpusJitterBuffer::Stats OpusJitterBuffer::GetStats() const {
+    Stats stats = stats_;
+    stats.depth = held_;
+    stats.target_delay_ms = (int)(TargetDelayUs() / 1000);
+    stats.jitter_ms = (int)(jitter_us_ / 1000);
+    return stats;
+}
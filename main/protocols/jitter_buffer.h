@@ -0,0 +1,84 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Reorders incoming Opus packets by sequence number and conceals gaps
+ *
+ * In-order packets are released immediately, so a clean stream pays no
+ * extra latency. When a packet is missing, the packets behind it are held
+ * for up to the target delay in case it arrives late; after that the missing
+ * frame is released as an empty packet, which the decoder turns into packet
+ * loss concealment. The target delay follows the measured inter-arrival
+ * jitter (RFC 3550 estimator), bounded by one frame and max_delay_ms.
+ *
+ * Not thread safe; the owner serialises Push(), Poll() and Reset().
+ */
+class OpusJitterBuffer {
+public:
+    // Empty packet = frame lost, decode with PLC
+    using Output = std::function<void(std::vector<uint8_t>&& opus)>;
+
+    struct Stats {
+        uint32_t received = 0;
+        uint32_t late = 0;          // arrived after its slot was played or concealed
+        uint32_t duplicate = 0;
+        uint32_t lost = 0;          // never arrived in time
+        uint32_t concealed = 0;     // lost frames handed to the decoder for PLC
+        uint32_t resyncs = 0;       // sequence jumped too far, restarted
+        size_t depth = 0;           // packets currently held behind a gap
+        int target_delay_ms = 0;
+        int jitter_ms = 0;
+    };
+
+    static constexpr size_t kWindow = 16;            // packets held at most
+    static constexpr uint32_t kMaxConcealFrames = 3; // longer gaps are skipped, not concealed
+
+    OpusJitterBuffer(int frame_duration_ms, int max_delay_ms);
+
+    void SetFrameDuration(int frame_duration_ms);
+    void Reset();
+
+    // Insert a packet and release everything that became playable
+    void Push(uint32_t sequence, std::vector<uint8_t>&& opus, int64_t now_us, const Output& output);
+    // Give up on gaps that have waited longer than the target delay
+    void Poll(int64_t now_us, const Output& output);
+
+    bool HasPending() const { return held_ > 0; }
+    Stats GetStats() const;
+
+private:
+    struct Slot {
+        bool used = false;
+        uint32_t sequence = 0;
+        int64_t arrival_us = 0;
+        std::vector<uint8_t> opus;
+    };
+
+    std::array<Slot, kWindow> slots_;
+    size_t held_ = 0;
+    bool started_ = false;
+    uint32_t next_sequence_ = 0;
+    uint32_t consecutive_lost_ = 0;
+
+    int64_t frame_us_;
+    int64_t max_delay_us_;
+    bool have_transit_ = false;
+    int64_t last_transit_us_ = 0;
+    int64_t jitter_us_ = 0;
+
+    Stats stats_;
+
+    void UpdateJitter(uint32_t sequence, int64_t now_us);
+    int64_t TargetDelayUs() const;
+    int64_t OldestHeldArrival() const;
+    void Release(int64_t now_us, bool flush, const Output& output);
+    void DropHeld();
+};
+
+#endif // JITTER_BUFFER_H
@@ -0,0 +1,402 @@
+#include "json_reader.h"
+
+#include <cstdlib>
+#include <cstring>
+
+void JsonReader::SkipSpace() {
+    // cJSON counts every byte up to 0x20 as space
+    while (pos_ < end_ && (unsigned char)*pos_ <= ' ') {
+        pos_++;
+    }
+}
+
+bool JsonReader::Fail() {
+    ok_ = false;
+    pos_ = end_;
+    return false;
+}
+
+bool JsonReader::Expect(char c) {
+    SkipSpace();
+    if (!ok_ || pos_ == end_ || *pos_ != c) {
+        return Fail();
+    }
+    pos_++;
+    return true;
+}
+
+bool JsonReader::Literal(const char* word, size_t length) {
+    if ((size_t)(end_ - pos_) < length || memcmp(pos_, word, length) != 0) {
+        return Fail();
+    }
+    pos_ += length;
+    return true;
+}
+
+bool JsonReader::BeginObject() {
+    // cJSON_Parse steps over a UTF-8 byte order mark
+    if (end_ - pos_ >= 3 && memcmp(pos_, "\xEF\xBB\xBF", 3) == 0) {
+        pos_ += 3;
+    }
+    if (!Expect('{')) {
+        return false;
+    }
+    depth_ = 1;
+    first_member_ = true;
+    return true;
+}
+
+bool JsonReader::NextMember(std::string_view& key) {
+    SkipSpace();
+    if (!ok_ || pos_ == end_) {
+        return Fail();
+    }
+    if (*pos_ == '}') {
+        pos_++;
+        depth_--;
+        return false;
+    }
+    // Members after the first are led by a comma
+    if (!first_member_) {
+        if (*pos_ != ',') {
+            return Fail();
+        }
+        pos_++;
+        SkipSpace();
+    }
+    first_member_ = false;
+    const char* quote = pos_;
+    if (pos_ == end_ || *pos_ != '"' || !ScanString(nullptr)) {
+        return Fail();
+    }
+    key = std::string_view(quote + 1, pos_ - 2 - quote);
+    if (memchr(key.data(), '\\', key.size()) != nullptr) {
+        // Escaped keys are rare: decode this one again, into key_
+        const char* next = pos_;
+        pos_ = quote;
+        key_.clear();
+        ScanString(&key_);
+        pos_ = next;
+        key = key_;
+    }
+    return Expect(':');
+}
+
+JsonReader::Type JsonReader::Peek() {
+    SkipSpace();
+    if (!ok_ || pos_ == end_) {
+        return kTypeInvalid;
+    }
+    switch (*pos_) {
+    case '{':
+        return kTypeObject;
+    case '[':
+        return kTypeArray;
+    case '"':
+        return kTypeString;
+    case 't':
+    case 'f':
+        return kTypeBool;
+    case 'n':
+        return kTypeNull;
+    default:
+        return (*pos_ == '-' || (*pos_ >= '0' && *pos_ <= '9')) ? kTypeNumber : kTypeInvalid;
+    }
+}
+
+static int HexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+static void AppendUtf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out += (char)code;
+    } else if (code < 0x800) {
+        out += (char)(0xC0 | (code >> 6));
+        out += (char)(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += (char)(0xE0 | (code >> 12));
+        out += (char)(0x80 | ((code >> 6) & 0x3F));
+        out += (char)(0x80 | (code & 0x3F));
+    } else {
+        out += (char)(0xF0 | (code >> 18));
+        out += (char)(0x80 | ((code >> 12) & 0x3F));
+        out += (char)(0x80 | ((code >> 6) & 0x3F));
+        out += (char)(0x80 | (code & 0x3F));
+    }
+}
+
+// Four hex digits; like cJSON, any bad digit makes the whole unit 0
+static uint32_t Hex4(const char* in) {
+    uint32_t unit = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = HexValue(in[i]);
+        if (digit < 0) {
+            return 0;
+        }
+        unit = (unit << 4) | digit;
+    }
+    return unit;
+}
+
+// The \uXXXX escape at in, or a surrogate pair of them, all before close.
+// Returns the bytes it took, 0 if malformed.
+static size_t DecodeUtf16(const char* in, const char* close, std::string* value) {
+    if (close - in < 6) {
+        return 0;
+    }
+    uint32_t code = Hex4(in + 2);
+    size_t length = 6;
+    if (code >= 0xDC00 && code <= 0xDFFF) {
+        return 0;
+    }
+    if (code >= 0xD800 && code <= 0xDBFF) {
+        const char* low = in + 6;
+        if (close - low < 6 || low[0] != '\\' || low[1] != 'u') {
+            return 0;
+        }
+        uint32_t unit = Hex4(low + 2);
+        if (unit < 0xDC00 || unit > 0xDFFF) {
+            return 0;
+        }
+        code = 0x10000 + (((code & 0x3FF) << 10) | (unit & 0x3FF));
+        length = 12;
+    }
+    if (value != nullptr) {
+        AppendUtf8(*value, code);
+    }
+    return length;
+}
+
+// pos_ at the opening quote; leaves it just past the closing one. As in
+// cJSON, the closing quote is found first, a backslash taking the next
+// byte with it, and the escapes are then decoded up to that quote.
+bool JsonReader::ScanString(std::string* value) {
+    const char* in = pos_ + 1;
+    const char* close = in;
+    for (;;) {
+        close = (const char*)memchr(close, '"', end_ - close);
+        if (close == nullptr) {
+            return Fail();
+        }
+        // Backslashes pair off, so an odd run before the quote escapes it
+        const char* backslash = close;
+        while (backslash > in && backslash[-1] == '\\') {
+            backslash--;
+        }
+        if ((close - backslash) % 2 == 0) {
+            break;
+        }
+        close++;
+    }
+
+    while (in < close) {
+        // Copy the unescaped run in one go
+        const char* run = in;
+        in = (const char*)memchr(in, '\\', close - in);
+        if (in == nullptr) {
+            in = close;
+        }
+        if (value != nullptr) {
+            value->append(run, in - run);
+        }
+        if (in >= close) {
+            break;
+        }
+
+        size_t length = 2;
+        char escape = in[1];
+        char decoded;
+        switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+            decoded = escape;
+            break;
+        case 'b':
+            decoded = '\b';
+            break;
+        case 'f':
+            decoded = '\f';
+            break;
+        case 'n':
+            decoded = '\n';
+            break;
+        case 'r':
+            decoded = '\r';
+            break;
+        case 't':
+            decoded = '\t';
+            break;
+        case 'u':
+            length = DecodeUtf16(in, close, value);
+            if (length == 0) {
+                return Fail();
+            }
+            in += length;
+            continue;
+        default:
+            return Fail();
+        }
+        if (value != nullptr) {
+            *value += decoded;
+        }
+        in += length;
+    }
+    pos_ = close + 1;
+    return true;
+}
+
+bool JsonReader::ReadString(std::string& value) {
+    value.clear();
+    if (Peek() != kTypeString) {
+        return Fail();
+    }
+    return ScanString(&value);
+}
+
+static bool IsNumberChar(char c) {
+    return (c >= '0' && c <= '9') || c == '+' || c == '-' || c == 'e' || c == 'E' || c == '.';
+}
+
+// cJSON's reading: the run of number characters, at most 63 of them, taken
+// as far as strtod gets. The buffer need not be NUL-terminated, so strtod
+// works on a copy.
+bool JsonReader::ScanNumber(double* value) {
+    char text[64];
+    size_t length = 0;
+    while (length < sizeof(text) - 1 && pos_ + length < end_ && IsNumberChar(pos_[length])) {
+        text[length] = pos_[length];
+        length++;
+    }
+    text[length] = '\0';
+    char* parsed_end;
+    double number = strtod(text, &parsed_end);
+    if (parsed_end == text) {
+        return Fail();
+    }
+    pos_ += parsed_end - text;
+    if (value != nullptr) {
+        *value = number;
+    }
+    return true;
+}
+
+bool JsonReader::ReadNumber(double& value) {
+    if (Peek() != kTypeNumber) {
+        return Fail();
+    }
+    return ScanNumber(&value);
+}
+
+bool JsonReader::ReadBool(bool& value) {
+    if (Peek() != kTypeBool) {
+        return Fail();
+    }
+    value = *pos_ == 't';
+    return value ? Literal("true", 4) : Literal("false", 5);
+}
+
+bool JsonReader::SkipScalar() {
+    switch (Peek()) {
+    case kTypeString:
+        return ScanString(nullptr);
+    case kTypeNumber:
+        return ScanNumber(nullptr);
+    case kTypeBool:
+        return *pos_ == 't' ? Literal("true", 4) : Literal("false", 5);
+    case kTypeNull:
+        return Literal("null", 4);
+    default:
+        return Fail();
+    }
+}
+
+// A key inside a skipped object, with its ':'
+bool JsonReader::SkipKey() {
+    SkipSpace();
+    if (pos_ == end_ || *pos_ != '"') {
+        return Fail();
+    }
+    return ScanString(nullptr) && Expect(':');
+}
+
+// Containers are walked with an explicit stack, so nesting costs bits
+// rather than recursion
+bool JsonReader::SkipValue() {
+    // One bit per open container: set for an object, clear for an array
+    uint32_t objects[(JSON_READER_MAX_DEPTH + 31) / 32];
+    int depth = 0;
+    for (;;) {
+        Type type = Peek();
+        if (type == kTypeObject || type == kTypeArray) {
+            if (depth_ + depth >= JSON_READER_MAX_DEPTH) {
+                return Fail();
+            }
+            bool object = type == kTypeObject;
+            uint32_t bit = 1u << (depth % 32);
+            objects[depth / 32] = object ? (objects[depth / 32] | bit) : (objects[depth / 32] & ~bit);
+            depth++;
+            pos_++;
+            SkipSpace();
+            if (pos_ < end_ && *pos_ == (object ? '}' : ']')) {
+                pos_++;
+                depth--;
+            } else {
+                if (object && !SkipKey()) {
+                    return false;
+                }
+                continue;
+            }
+        } else if (!SkipScalar()) {
+            return false;
+        }
+
+        // A value has ended: close containers until one has a next value
+        while (depth > 0) {
+            SkipSpace();
+            if (pos_ == end_) {
+                return Fail();
+            }
+            bool object = (objects[(depth - 1) / 32] >> ((depth - 1) % 32)) & 1;
+            if (*pos_ == ',') {
+                pos_++;
+                if (object && !SkipKey()) {
+                    return false;
+                }
+                break;
+            }
+            if (*pos_ != (object ? '}' : ']')) {
+                return Fail();
+            }
+            pos_++;
+            depth--;
+        }
+        if (depth == 0) {
+            return true;
+        }
+    }
+}
+
+bool JsonReader::Skip() {
+    return SkipValue();
+}
+
+bool JsonReader::Capture(std::string_view& raw) {
+    if (Peek() == kTypeInvalid) {
+        return Fail();
+    }
+    const char* start = pos_;
+    if (!SkipValue()) {
+        return false;
+    }
+    raw = std::string_view(start, pos_ - start);
+    return true;
+}
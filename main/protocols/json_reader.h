@@ -0,0 +1,81 @@
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Nesting allowed, the outer object included; CJSON_NESTING_LIMIT
+#define JSON_READER_MAX_DEPTH 1000
+
+/**
+ * @brief Pull reader over one JSON text, without building a tree
+ *
+ * Walks the buffer in place: keys come back as views into it, strings are
+ * unescaped into a caller-owned std::string so a reused one stops
+ * allocating once it has grown. Values the caller does not want are
+ * skipped, or captured as raw text to hand to cJSON later.
+ *
+ * It takes exactly the texts cJSON_Parse takes, so a frame means the same
+ * to both: any byte up to 0x20 is space, a leading UTF-8 BOM is skipped,
+ * strings may hold raw control bytes, a \u escape with bad hex digits reads
+ * as NUL, numbers are the strtod prefix of the number characters, and
+ * nothing after the outer object is looked at. Skipped and captured values
+ * are checked as thoroughly as the ones that are read.
+ *
+ * The first malformed token stops the reader; every call then fails and
+ * ok() returns false.
+ */
+class JsonReader {
+public:
+    enum Type {
+        kTypeInvalid,
+        kTypeObject,
+        kTypeArray,
+        kTypeString,
+        kTypeNumber,
+        kTypeBool,
+        kTypeNull,
+    };
+
+    JsonReader(const char* data, size_t size) : pos_(data), end_(data + size) {}
+
+    // Consume the '{' of an object
+    bool BeginObject();
+    // Next key of the current object, ':' consumed; false at the closing '}'.
+    // The key is unescaped, and stays valid until the next call.
+    bool NextMember(std::string_view& key);
+
+    Type Peek();
+    bool ReadString(std::string& value);
+    bool ReadNumber(double& value);
+    bool ReadBool(bool& value);
+    // Skip any value, containers included
+    bool Skip();
+    // Skip a value and return its raw text
+    bool Capture(std::string_view& raw);
+
+    bool ok() const { return ok_; }
+
+private:
+    const char* pos_;
+    const char* end_;
+    bool ok_ = true;
+    // Containers open around the reader's position: the object, once begun
+    int depth_ = 0;
+    bool first_member_ = false;
+    std::string key_;
+
+    void SkipSpace();
+    bool Fail();
+    bool Expect(char c);
+    bool Literal(const char* word, size_t length);
+    bool ScanString(std::string* value);
+    bool ScanNumber(double* value);
+    bool SkipScalar();
+    bool SkipKey();
+    bool SkipValue();
+};
+
+#endif // JSON_READER_H
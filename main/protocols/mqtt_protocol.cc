@@ -12,12 +12,29 @@
 
 #define TAG "MQTT"
 
-MqttProtocol::MqttProtocol() {
+MqttProtocol::MqttProtocol()
+    : jitter_buffer_(OPUS_FRAME_DURATION_MS, CONFIG_AUDIO_JITTER_MAX_DELAY_MS) {
     event_group_handle_ = xEventGroupCreate();
+
+    // Releases packets held behind a gap once the gap has waited long enough
+    esp_timer_create_args_t jitter_timer_args = {
+        .callback = [](void* arg) {
+            static_cast<MqttProtocol*>(arg)->PollJitterBuffer();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "jitter_timer",
+        .skip_unhandled_events = true,
+    };
+    esp_timer_create(&jitter_timer_args, &jitter_timer_);
 }
 
 MqttProtocol::~MqttProtocol() {
     ESP_LOGI(TAG, "MqttProtocol deinit");
+    if (jitter_timer_ != nullptr) {
+        esp_timer_stop(jitter_timer_);
+        esp_timer_delete(jitter_timer_);
+    }
     if (udp_ != nullptr) {
         delete udp_;
     }
@@ -60,32 +77,7 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
     });
 
     mqtt_->OnMessage([this](const std::string& topic, const std::string& payload) {
-        cJSON* root = cJSON_Parse(payload.c_str());
-        if (root == nullptr) {
-            ESP_LOGE(TAG, "Failed to parse json message %s", payload.c_str());
-            return;
-        }
-        cJSON* type = cJSON_GetObjectItem(root, "type");
-        if (type == nullptr) {
-            ESP_LOGE(TAG, "Message type is not specified");
-            cJSON_Delete(root);
-            return;
-        }
-
-        if (strcmp(type->valuestring, "hello") == 0) {
-            ParseServerHello(root);
-        } else if (strcmp(type->valuestring, "goodbye") == 0) {
-            auto session_id = cJSON_GetObjectItem(root, "session_id");
-            ESP_LOGI(TAG, "Received goodbye message, session_id: %s", session_id ? session_id->valuestring : "null");
-            if (session_id == nullptr || session_id_ == session_id->valuestring) {
-                Application::GetInstance().Schedule([this]() {
-                    CloseAudioChannel();
-                });
-            }
-        } else if (on_incoming_json_ != nullptr) {
-            on_incoming_json_(root);
-        }
-        cJSON_Delete(root);
+        DispatchIncomingText(payload.data(), payload.size());
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
@@ -110,31 +102,22 @@ void MqttProtocol::SendText(const std::string& text) {
     }
 }
 
-void MqttProtocol::SendAudio(const std::vector<uint8_t>& data) {
+void MqttProtocol::SendAudioPacket(const uint8_t* data, size_t size) {
     std::lock_guard<std::mutex> lock(channel_mutex_);
     if (udp_ == nullptr) {
         return;
     }
 
-    std::string nonce(aes_nonce_);
-    *(uint16_t*)&nonce[2] = htons(data.size());
-    *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
-
-    std::string encrypted;
-    encrypted.resize(aes_nonce_.size() + data.size());
-    memcpy(encrypted.data(), nonce.data(), nonce.size());
-
-    size_t nc_off = 0;
-    uint8_t stream_block[16] = {0};
-    if (mbedtls_aes_crypt_ctr(&aes_ctx_, data.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
-        (uint8_t*)data.data(), (uint8_t*)&encrypted[nonce.size()]) != 0) {
+    // Encrypted straight into the datagram buffer, which the socket sends as is
+    if (!audio_crypto_.Seal(++local_sequence_, data, size, udp_packet_)) {
         ESP_LOGE(TAG, "Failed to encrypt audio data");
         return;
     }
-    udp_->Send(encrypted);
+    udp_->Send(udp_packet_);
 }
 
 void MqttProtocol::CloseAudioChannel() {
+    FlushAudio();
     {
         std::lock_guard<std::mutex> lock(channel_mutex_);
         if (udp_ != nullptr) {
@@ -142,6 +125,20 @@ void MqttProtocol::CloseAudioChannel() {
             udp_ = nullptr;
         }
     }
+    esp_timer_stop(jitter_timer_);
+
+    auto stats = GetJitterStats();
+    ESP_LOGI(TAG, "Audio jitter: received %lu, late %lu, duplicate %lu, lost %lu, concealed %lu, resyncs %lu, jitter %dms, target %dms",
+        stats.received, stats.late, stats.duplicate, stats.lost, stats.concealed, stats.resyncs,
+        stats.jitter_ms, stats.target_delay_ms);
+    auto crypto = audio_crypto_.GetStats();
+#if CONFIG_AUDIO_CRYPTO_PROFILE
+    ESP_LOGI(TAG, "Audio crypto (%s): sealed %lu, opened %lu, failed %lu, %lu bytes in %lu us",
+        AudioCrypto::backend_name(), crypto.sealed, crypto.opened, crypto.failed, crypto.bytes, crypto.busy_us);
+#else
+    ESP_LOGI(TAG, "Audio crypto (%s): sealed %lu, opened %lu, failed %lu, %lu bytes",
+        AudioCrypto::backend_name(), crypto.sealed, crypto.opened, crypto.failed, crypto.bytes);
+#endif
 
     std::string message = "{";
     message += "\"session_id\":\"" + session_id_ + "\",";
@@ -164,6 +161,7 @@ bool MqttProtocol::OpenAudioChannel() {
 
     error_occurred_ = false;
     session_id_ = "";
+    ConfigureAudioFraming(1);
     xEventGroupClearBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 
     // 发送 hello 消息申请 UDP 通道
@@ -173,6 +171,9 @@ bool MqttProtocol::OpenAudioChannel() {
     message += "\"transport\":\"udp\",";
     message += "\"audio_params\":{";
     message += "\"format\":\"opus\", \"sample_rate\":16000, \"channels\":1, \"frame_duration\":" + std::to_string(OPUS_FRAME_DURATION_MS);
+#if CONFIG_AUDIO_FRAMES_PER_PACKET > 1
+    message += ", \"frames_per_packet\":" + std::to_string(CONFIG_AUDIO_FRAMES_PER_PACKET);
+#endif
     message += "}}";
     SendText(message);
 
@@ -189,8 +190,9 @@ bool MqttProtocol::OpenAudioChannel() {
         delete udp_;
     }
     udp_ = Board::GetInstance().CreateUdp();
+    udp_packet_.reserve(audio_crypto_.header_size() + MQTT_AUDIO_MAX_PAYLOAD_SIZE);
     udp_->OnMessage([this](const std::string& data) {
-        if (data.size() < sizeof(aes_nonce_)) {
+        if (data.size() < audio_crypto_.header_size()) {
             ESP_LOGE(TAG, "Invalid audio packet size: %zu", data.size());
             return;
         }
@@ -199,34 +201,23 @@ bool MqttProtocol::OpenAudioChannel() {
             return;
         }
         uint32_t sequence = ntohl(*(uint32_t*)&data[12]);
-        if (sequence < remote_sequence_) {
-            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_);
-            return;
-        }
-        if (sequence != remote_sequence_ + 1) {
-            ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
-        }
 
-        std::vector<uint8_t> decrypted;
-        size_t decrypted_size = data.size() - aes_nonce_.size();
-        size_t nc_off = 0;
-        uint8_t stream_block[16] = {0};
-        decrypted.resize(decrypted_size);
-        auto nonce = (uint8_t*)data.data();
-        auto encrypted = (uint8_t*)data.data() + aes_nonce_.size();
-        int ret = mbedtls_aes_crypt_ctr(&aes_ctx_, decrypted_size, &nc_off, nonce, stream_block, encrypted, (uint8_t*)decrypted.data());
-        if (ret != 0) {
-            ESP_LOGE(TAG, "Failed to decrypt audio data, ret: %d", ret);
+        auto decrypted = AcquireAudioBuffer();
+        if (!audio_crypto_.Open(data, decrypted)) {
+            ESP_LOGE(TAG, "Failed to decrypt audio data");
             return;
         }
-        if (on_incoming_audio_ != nullptr) {
-            on_incoming_audio_(std::move(decrypted));
+        {
+            std::lock_guard<std::mutex> lock(jitter_mutex_);
+            jitter_buffer_.Push(sequence, std::move(decrypted), esp_timer_get_time(),
+                [this](std::vector<uint8_t>&& opus) { DeliverAudio(std::move(opus)); });
         }
-        remote_sequence_ = sequence;
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
     udp_->Connect(udp_server_, udp_port_);
+    esp_timer_stop(jitter_timer_);
+    esp_timer_start_periodic(jitter_timer_, MQTT_JITTER_POLL_INTERVAL_MS * 1000);
 
     if (on_audio_channel_opened_ != nullptr) {
         on_audio_channel_opened_();
@@ -234,6 +225,15 @@ bool MqttProtocol::OpenAudioChannel() {
     return true;
 }
 
+void MqttProtocol::OnServerGoodbye(const ServerMessage& message) {
+    ESP_LOGI(TAG, "Received goodbye message, session_id: %s", message.has_session_id ? message.session_id.c_str() : "null");
+    if (message.IsForSession(session_id_)) {
+        Application::GetInstance().Schedule([this]() {
+            CloseAudioChannel();
+        });
+    }
+}
+
 void MqttProtocol::ParseServerHello(const cJSON* root) {
     auto transport = cJSON_GetObjectItem(root, "transport");
     if (transport == nullptr || strcmp(transport->valuestring, "udp") != 0) {
@@ -248,12 +248,26 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
     }
 
     // Get sample rate from hello message
+    int frame_duration_ms = OPUS_FRAME_DURATION_MS;
     auto audio_params = cJSON_GetObjectItem(root, "audio_params");
     if (audio_params != NULL) {
         auto sample_rate = cJSON_GetObjectItem(audio_params, "sample_rate");
         if (sample_rate != NULL) {
             server_sample_rate_ = sample_rate->valueint;
         }
+        auto frame_duration = cJSON_GetObjectItem(audio_params, "frame_duration");
+        if (cJSON_IsNumber(frame_duration) && frame_duration->valueint > 0) {
+            frame_duration_ms = frame_duration->valueint;
+        }
+        auto frames_per_packet = cJSON_GetObjectItem(audio_params, "frames_per_packet");
+        if (cJSON_IsNumber(frames_per_packet)) {
+            ConfigureAudioFraming(frames_per_packet->valueint);
+        }
+    }
+    {
+        // The jitter buffer orders whole datagrams
+        std::lock_guard<std::mutex> lock(jitter_mutex_);
+        jitter_buffer_.SetFrameDuration(frame_duration_ms * audio_frames_per_packet());
     }
 
     auto udp = cJSON_GetObjectItem(root, "udp");
@@ -268,14 +282,33 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
 
     // auto encryption = cJSON_GetObjectItem(udp, "encryption")->valuestring;
     // ESP_LOGI(TAG, "UDP server: %s, port: %d, encryption: %s", udp_server_.c_str(), udp_port_, encryption);
-    aes_nonce_ = DecodeHexString(nonce);
-    mbedtls_aes_init(&aes_ctx_);
-    mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
+    if (!audio_crypto_.Configure(DecodeHexString(key), DecodeHexString(nonce))) {
+        return;
+    }
     local_sequence_ = 0;
-    remote_sequence_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(jitter_mutex_);
+        jitter_buffer_.Reset();
+    }
     xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 }
 
+void MqttProtocol::DeliverAudio(std::vector<uint8_t>&& opus) {
+    DeliverIncomingAudio(std::move(opus));
+}
+
+void MqttProtocol::PollJitterBuffer() {
+    std::lock_guard<std::mutex> lock(jitter_mutex_);
+    jitter_buffer_.Poll(esp_timer_get_time(), [this](std::vector<uint8_t>&& opus) {
+        DeliverAudio(std::move(opus));
+    });
+}
+
+OpusJitterBuffer::Stats MqttProtocol::GetJitterStats() {
+    std::lock_guard<std::mutex> lock(jitter_mutex_);
+    return jitter_buffer_.GetStats();
+}
+
 static const char hex_chars[] = "0123456789ABCDEF";
 // 辅助函数，将单个十六进制字符转换为对应的数值
 static inline uint8_t CharToHex(char c) {
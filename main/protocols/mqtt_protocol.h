@@ -3,12 +3,14 @@
 
 
 #include "protocol.h"
+#include "jitter_buffer.h"
+#include "audio_crypto.h"
 #include <mqtt.h>
 #include <udp.h>
 #include <cJSON.h>
-#include <mbedtls/aes.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
+#include <esp_timer.h>
 
 #include <functional>
 #include <string>
@@ -20,17 +22,22 @@
 
 #define MQTT_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
+#define MQTT_JITTER_POLL_INTERVAL_MS 20
+// Room reserved in the send buffer; larger payloads still work, growing it once
+#define MQTT_AUDIO_MAX_PAYLOAD_SIZE 1000
+
 class MqttProtocol : public Protocol {
 public:
     MqttProtocol();
     ~MqttProtocol();
 
     void Start() override;
-    void SendAudio(const std::vector<uint8_t>& data) override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
 
+    OpusJitterBuffer::Stats GetJitterStats();
+
 private:
     EventGroupHandle_t event_group_handle_;
 
@@ -43,18 +50,26 @@ private:
     std::mutex channel_mutex_;
     Mqtt* mqtt_ = nullptr;
     Udp* udp_ = nullptr;
-    mbedtls_aes_context aes_ctx_;
-    std::string aes_nonce_;
+    AudioCrypto audio_crypto_;
     std::string udp_server_;
     int udp_port_;
     uint32_t local_sequence_;
-    uint32_t remote_sequence_;
+    std::string udp_packet_;            // reused datagram, guarded by channel_mutex_
+
+    // 下行音频按序号重排，缺失的帧交给解码器做丢包补偿
+    std::mutex jitter_mutex_;
+    OpusJitterBuffer jitter_buffer_;
+    esp_timer_handle_t jitter_timer_ = nullptr;
 
     bool StartMqttClient(bool report_error=false);
-    void ParseServerHello(const cJSON* root);
+    void ParseServerHello(const cJSON* root) override;
+    void OnServerGoodbye(const ServerMessage& message) override;
     std::string DecodeHexString(const std::string& hex_string);
+    void DeliverAudio(std::vector<uint8_t>&& opus);
+    void PollJitterBuffer();
 
     void SendText(const std::string& text) override;
+    void SendAudioPacket(const uint8_t* data, size_t size) override;
 };
 
 
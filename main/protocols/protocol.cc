@@ -1,9 +1,21 @@
 #include "protocol.h"
 
 #include <esp_log.h>
+#include <cstring>
 
 #define TAG "Protocol"
 
+Protocol::~Protocol() {
+    if (audio_batch_timer_ != nullptr) {
+        esp_timer_stop(audio_batch_timer_);
+        esp_timer_delete(audio_batch_timer_);
+    }
+}
+
+void Protocol::OnIncomingMessage(std::function<void(const ServerMessage& message)> callback) {
+    on_incoming_message_ = callback;
+}
+
 void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
     on_incoming_json_ = callback;
 }
@@ -24,6 +36,48 @@ void Protocol::OnNetworkError(std::function<void(const std::string& message)> ca
     on_network_error_ = callback;
 }
 
+void Protocol::DispatchIncomingText(const char* data, size_t size) {
+    // The transports used to hand cJSON_Parse a C string: a NUL ends the frame
+    size = strnlen(data, size);
+    auto& message = incoming_message_;
+    if (!message.Parse(data, size)) {
+        ESP_LOGE(TAG, "Failed to parse json message %.*s", (int)size, data);
+        return;
+    }
+
+    switch (message.type) {
+    case kServerMessageNone:
+        ESP_LOGE(TAG, "Missing message type, data: %.*s", (int)size, data);
+        break;
+    case kServerMessageTts:
+    case kServerMessageStt:
+    case kServerMessageLlm:
+    case kServerMessageIot:
+        if (on_incoming_message_ != nullptr) {
+            on_incoming_message_(message);
+        }
+        break;
+    case kServerMessageGoodbye:
+        OnServerGoodbye(message);
+        break;
+    default: {
+        // Hello arrives once per session and unknown types are rare: a tree is fine
+        cJSON* root = cJSON_ParseWithLength(data, size);
+        if (root == nullptr) {
+            ESP_LOGE(TAG, "Failed to parse json message %.*s", (int)size, data);
+            break;
+        }
+        if (message.type == kServerMessageHello) {
+            ParseServerHello(root);
+        } else if (on_incoming_json_ != nullptr) {
+            on_incoming_json_(root);
+        }
+        cJSON_Delete(root);
+        break;
+    }
+    }
+}
+
 void Protocol::SetError(const std::string& message) {
     error_occurred_ = true;
     if (on_network_error_ != nullptr) {
@@ -61,6 +115,7 @@ void Protocol::SendStartListening(ListeningMode mode) {
 }
 
 void Protocol::SendStopListening() {
+    FlushAudio();
     std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"listen\",\"state\":\"stop\"}";
     SendText(message);
 }
@@ -111,7 +166,13 @@ void Protocol::SendIotDescriptors(const std::string& descriptors) {
 }
 
 void Protocol::SendIotStates(const std::string& states) {
-    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"iot\",\"update\":true,\"states\":" + states + "}";
+    std::string message;
+    message.reserve(64 + session_id_.size() + states.size());
+    message += "{\"session_id\":\"";
+    message += session_id_;
+    message += "\",\"type\":\"iot\",\"update\":true,\"states\":";
+    message += states;
+    message += "}";
     SendText(message);
 }
 
@@ -126,3 +187,108 @@ bool Protocol::IsTimeout() const {
     return timeout;
 }
 
+std::vector<uint8_t> Protocol::AcquireAudioBuffer() {
+    std::lock_guard<std::mutex> lock(audio_buffer_mutex_);
+    if (audio_buffer_count_ == 0) {
+        return std::vector<uint8_t>();
+    }
+    return std::move(audio_buffers_[--audio_buffer_count_]);
+}
+
+void Protocol::RecycleAudioBuffer(std::vector<uint8_t>&& buffer) {
+    if (buffer.capacity() == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(audio_buffer_mutex_);
+    if (audio_buffer_count_ < PROTOCOL_AUDIO_BUFFER_POOL_SIZE) {
+        buffer.clear();
+        audio_buffers_[audio_buffer_count_++] = std::move(buffer);
+    }
+}
+
+void Protocol::ConfigureAudioFraming(int frames_per_packet) {
+    if (frames_per_packet < 1 || frames_per_packet > CONFIG_AUDIO_FRAMES_PER_PACKET) {
+        frames_per_packet = 1;
+    }
+    std::lock_guard<std::mutex> lock(audio_batch_mutex_);
+    audio_frames_per_packet_ = frames_per_packet;
+    audio_batcher_.Configure(frames_per_packet, CONFIG_AUDIO_BATCH_MAX_DELAY_MS);
+    if (frames_per_packet > 1 && audio_batch_timer_ == nullptr) {
+        // Sends a partial batch once its first frame has used up the latency budget
+        esp_timer_create_args_t timer_args = {
+            .callback = [](void* arg) {
+                auto protocol = static_cast<Protocol*>(arg);
+                std::lock_guard<std::mutex> lock(protocol->audio_batch_mutex_);
+                if (protocol->audio_batcher_.Due(esp_timer_get_time())) {
+                    protocol->SendAudioBatch();
+                }
+            },
+            .arg = this,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "audio_batch",
+            .skip_unhandled_events = true,
+        };
+        esp_timer_create(&timer_args, &audio_batch_timer_);
+    }
+    ESP_LOGI(TAG, "Audio framing: %d frame(s) per packet", frames_per_packet);
+}
+
+void Protocol::SendAudio(const uint8_t* data, size_t size) {
+    std::lock_guard<std::mutex> lock(audio_batch_mutex_);
+    if (audio_frames_per_packet_ <= 1) {
+        SendAudioPacket(data, size);
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    bool first = audio_batcher_.empty();
+    if (audio_batcher_.Add(data, size, now)) {
+        SendAudioBatch();
+    } else if (first) {
+        esp_timer_stop(audio_batch_timer_);
+        esp_timer_start_once(audio_batch_timer_, audio_batcher_.deadline_us() - now);
+    }
+}
+
+void Protocol::FlushAudio() {
+    std::lock_guard<std::mutex> lock(audio_batch_mutex_);
+    if (!audio_batcher_.empty()) {
+        SendAudioBatch();
+    }
+}
+
+// audio_batch_mutex_ held
+void Protocol::SendAudioBatch() {
+    if (audio_batch_timer_ != nullptr) {
+        esp_timer_stop(audio_batch_timer_);
+    }
+    SendAudioPacket(audio_batcher_.data(), audio_batcher_.size());
+    audio_batcher_.Clear();
+}
+
+void Protocol::DeliverIncomingAudio(std::vector<uint8_t>&& message) {
+    if (on_incoming_audio_ == nullptr) {
+        return;
+    }
+    int frames_per_packet = audio_frames_per_packet_;
+    if (frames_per_packet <= 1) {
+        on_incoming_audio_(std::move(message));
+        return;
+    }
+    if (message.empty()) {
+        for (int i = 0; i < frames_per_packet; i++) {
+            on_incoming_audio_(std::vector<uint8_t>());
+        }
+        return;
+    }
+    bool ok = AudioFrameBatcher::Split(message.data(), message.size(), frames_per_packet,
+        [this](const uint8_t* opus, size_t size) {
+            auto frame = AcquireAudioBuffer();
+            frame.assign(opus, opus + size);
+            on_incoming_audio_(std::move(frame));
+        });
+    if (!ok) {
+        ESP_LOGW(TAG, "Malformed audio message: %u bytes", message.size());
+    }
+    RecycleAudioBuffer(std::move(message));
+}
+
@@ -1,11 +1,20 @@
 #ifndef PROTOCOL_H
 #define PROTOCOL_H
 
+#include "audio_frame_batcher.h"
+#include "server_message.h"
+
 #include <cJSON.h>
+#include <esp_timer.h>
 #include <string>
+#include <vector>
+#include <mutex>
 #include <functional>
 #include <chrono>
 
+// Received packet buffers kept for reuse once the decoder is done with them
+#define PROTOCOL_AUDIO_BUFFER_POOL_SIZE 8
+
 struct BinaryProtocol3 {
     uint8_t type;
     uint8_t reserved;
@@ -26,7 +35,7 @@ enum ListeningMode {
 
 class Protocol {
 public:
-    virtual ~Protocol() = default;
+    virtual ~Protocol();
 
     inline int server_sample_rate() const {
         return server_sample_rate_;
@@ -35,7 +44,11 @@ public:
         return session_id_;
     }
 
+    // An empty packet marks a lost frame the decoder should conceal
     void OnIncomingAudio(std::function<void(std::vector<uint8_t>&& data)> callback);
+    // tts/stt/llm/iot control messages, parsed without a cJSON tree
+    void OnIncomingMessage(std::function<void(const ServerMessage& message)> callback);
+    // Any other message type, as a cJSON tree
     void OnIncomingJson(std::function<void(const cJSON* root)> callback);
     void OnAudioChannelOpened(std::function<void()> callback);
     void OnAudioChannelClosed(std::function<void()> callback);
@@ -45,7 +58,11 @@ public:
     virtual bool OpenAudioChannel() = 0;
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
-    virtual void SendAudio(const std::vector<uint8_t>& data) = 0;
+    // One encoded frame; coalesced into multi-frame messages when negotiated
+    void SendAudio(const uint8_t* data, size_t size);
+    void SendAudio(const std::vector<uint8_t>& data) {
+        SendAudio(data.data(), data.size());
+    }
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
@@ -53,7 +70,12 @@ public:
     virtual void SendIotDescriptors(const std::string& descriptors);
     virtual void SendIotStates(const std::string& states);
 
+    // Incoming audio is delivered in buffers from a small pool; hand them back
+    // after decoding so the receive path does not allocate per packet
+    void RecycleAudioBuffer(std::vector<uint8_t>&& buffer);
+
 protected:
+    std::function<void(const ServerMessage& message)> on_incoming_message_;
     std::function<void(const cJSON* root)> on_incoming_json_;
     std::function<void(std::vector<uint8_t>&& data)> on_incoming_audio_;
     std::function<void()> on_audio_channel_opened_;
@@ -66,8 +88,40 @@ protected:
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
 
     virtual void SendText(const std::string& text) = 0;
+    // One transport message: a bare frame, or a batch when frames_per_packet > 1
+    virtual void SendAudioPacket(const uint8_t* data, size_t size) = 0;
     virtual void SetError(const std::string& message);
     virtual bool IsTimeout() const;
+    virtual void ParseServerHello(const cJSON* root) = 0;
+    virtual void OnServerGoodbye(const ServerMessage& /* message */) {}
+
+    // Route one text frame from the server; called from the transport's receive task
+    void DispatchIncomingText(const char* data, size_t size);
+
+    std::vector<uint8_t> AcquireAudioBuffer();
+
+    // frames_per_packet accepted by the server hello (1 when it did not answer)
+    void ConfigureAudioFraming(int frames_per_packet);
+    int audio_frames_per_packet() const { return audio_frames_per_packet_; }
+    // Send what is batched now, e.g. before the audio stream stops
+    void FlushAudio();
+    // Split a received message into frames for on_incoming_audio_; an empty
+    // message (lost packet) is concealed as frames_per_packet lost frames
+    void DeliverIncomingAudio(std::vector<uint8_t>&& message);
+
+private:
+    ServerMessage incoming_message_;    // reused by DispatchIncomingText()
+
+    std::mutex audio_buffer_mutex_;
+    std::vector<uint8_t> audio_buffers_[PROTOCOL_AUDIO_BUFFER_POOL_SIZE];
+    size_t audio_buffer_count_ = 0;
+
+    std::mutex audio_batch_mutex_;
+    AudioFrameBatcher audio_batcher_;
+    esp_timer_handle_t audio_batch_timer_ = nullptr;
+    int audio_frames_per_packet_ = 1;
+
+    void SendAudioBatch();
 };
 
 #endif // PROTOCOL_H
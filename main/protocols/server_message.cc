@@ -0,0 +1,165 @@
+#include "server_message.h"
+#include "json_reader.h"
+
+#include <cstring>
+#include <strings.h>
+
+namespace {
+
+template <typename T>
+struct Keyword {
+    const char* name;
+    T value;
+};
+
+// Collision-free for both keyword sets below; a slot still has to match
+// the whole name, so unknown words fall through to the default
+constexpr size_t KeywordSlot(const char* name, size_t length) {
+    return ((unsigned char)name[0] * 2 + (unsigned char)name[length - 1] + length) & 7;
+}
+
+constexpr size_t ConstLength(const char* name) {
+    size_t length = 0;
+    while (name[length] != '\0') {
+        length++;
+    }
+    return length;
+}
+
+constexpr size_t Slot(const char* name) {
+    return KeywordSlot(name, ConstLength(name));
+}
+
+const Keyword<ServerMessageType> kTypeTable[8] = {
+    {"llm", kServerMessageLlm},             // 0
+    {"iot", kServerMessageIot},             // 1
+    {"goodbye", kServerMessageGoodbye},     // 2
+    {nullptr, kServerMessageUnknown},       // 3
+    {"hello", kServerMessageHello},         // 4
+    {"stt", kServerMessageStt},             // 5
+    {"tts", kServerMessageTts},             // 6
+    {nullptr, kServerMessageUnknown},       // 7
+};
+static_assert(Slot("llm") == 0 && Slot("iot") == 1 && Slot("goodbye") == 2 && Slot("hello") == 4 &&
+              Slot("stt") == 5 && Slot("tts") == 6, "kTypeTable is out of order");
+
+const Keyword<TtsState> kTtsStateTable[8] = {
+    {"sentence_start", kTtsStateSentenceStart},     // 0
+    {nullptr, kTtsStateNone},                       // 1
+    {"stop", kTtsStateStop},                        // 2
+    {nullptr, kTtsStateNone},                       // 3
+    {nullptr, kTtsStateNone},                       // 4
+    {nullptr, kTtsStateNone},                       // 5
+    {"sentence_end", kTtsStateSentenceEnd},         // 6
+    {"start", kTtsStateStart},                      // 7
+};
+static_assert(Slot("sentence_start") == 0 && Slot("stop") == 2 && Slot("sentence_end") == 6 &&
+              Slot("start") == 7, "kTtsStateTable is out of order");
+
+template <typename T>
+T Lookup(const Keyword<T> (&table)[8], std::string_view name, T fallback) {
+    if (name.empty()) {
+        return fallback;
+    }
+    auto& entry = table[KeywordSlot(name.data(), name.size())];
+    if (entry.name != nullptr && strlen(entry.name) == name.size() &&
+        memcmp(entry.name, name.data(), name.size()) == 0) {
+        return entry.value;
+    }
+    return fallback;
+}
+
+enum Member {
+    kMemberType,
+    kMemberState,
+    kMemberText,
+    kMemberEmotion,
+    kMemberSessionId,
+    kMemberCommands,
+    kMemberOther,
+};
+
+const char* const kMemberNames[kMemberOther] = {
+    "type", "state", "text", "emotion", "session_id", "commands",
+};
+
+// cJSON_GetObjectItem's comparison: case-insensitive, and the key ends at
+// an escaped NUL
+Member FindMember(std::string_view key) {
+    size_t length = strnlen(key.data(), key.size());
+    for (int member = 0; member < kMemberOther; member++) {
+        const char* name = kMemberNames[member];
+        if (strlen(name) == length && strncasecmp(key.data(), name, length) == 0) {
+            return (Member)member;
+        }
+    }
+    return kMemberOther;
+}
+
+} // namespace
+
+ServerMessageType ServerMessage::LookupType(std::string_view name) {
+    return Lookup(kTypeTable, name, kServerMessageUnknown);
+}
+
+TtsState ServerMessage::LookupTtsState(std::string_view name) {
+    return Lookup(kTtsStateTable, name, kTtsStateNone);
+}
+
+bool ServerMessage::Parse(const char* data, size_t size) {
+    type = kServerMessageNone;
+    state = kTtsStateNone;
+    text.clear();
+    emotion.clear();
+    session_id.clear();
+    has_text = false;
+    has_emotion = false;
+    has_session_id = false;
+    commands = std::string_view();
+
+    // Members come in any order, so collect them all before anyone acts on "type"
+    JsonReader reader(data, size);
+    if (!reader.BeginObject()) {
+        return false;
+    }
+    unsigned seen = 0;
+    std::string_view key;
+    while (reader.NextMember(key)) {
+        Member member = FindMember(key);
+        if (member == kMemberOther || (seen & (1u << member)) != 0) {
+            reader.Skip();
+            continue;
+        }
+        seen |= 1u << member;
+        if (member == kMemberCommands) {
+            reader.Capture(commands);
+            continue;
+        }
+        if (reader.Peek() != JsonReader::kTypeString) {
+            reader.Skip();
+            continue;
+        }
+        switch (member) {
+        case kMemberType:
+            reader.ReadString(scratch_);
+            type = LookupType(scratch_.c_str());
+            break;
+        case kMemberState:
+            reader.ReadString(scratch_);
+            state = LookupTtsState(scratch_.c_str());
+            break;
+        case kMemberText:
+            has_text = reader.ReadString(text);
+            break;
+        case kMemberEmotion:
+            has_emotion = reader.ReadString(emotion);
+            break;
+        case kMemberSessionId:
+            has_session_id = reader.ReadString(session_id);
+            break;
+        default:
+            break;
+        }
+    }
+    return reader.ok();
+}
@@ -0,0 +1,67 @@
+#ifndef SERVER_MESSAGE_H
+#define SERVER_MESSAGE_H
+
+#include <string>
+#include <string_view>
+
+enum ServerMessageType {
+    kServerMessageNone,         // no "type" member
+    kServerMessageUnknown,      // a type this table does not know
+    kServerMessageHello,
+    kServerMessageGoodbye,
+    kServerMessageTts,
+    kServerMessageStt,
+    kServerMessageLlm,
+    kServerMessageIot,
+};
+
+enum TtsState {
+    kTtsStateNone,
+    kTtsStateStart,
+    kTtsStateStop,
+    kTtsStateSentenceStart,
+    kTtsStateSentenceEnd,
+};
+
+/**
+ * @brief One control message from the server, read without a cJSON tree
+ *
+ * Parse() makes a single JsonReader pass over the frame and keeps only the
+ * members the client acts on. "type" and "state" are resolved through
+ * perfect-hash tables, and the strings are unescaped into members that keep
+ * their capacity, so the hot tts/stt/llm messages do not allocate once the
+ * buffers have grown. Anything else (hello, unknown types, iot command
+ * bodies) is left for cJSON.
+ *
+ * Members are found the way cJSON_GetObjectItem finds them, so a frame
+ * reads as it did with a tree: names match case-insensitively, the first
+ * match wins, and strings are C strings to the lookups.
+ */
+struct ServerMessage {
+    ServerMessageType type = kServerMessageNone;
+    TtsState state = kTtsStateNone;
+    std::string text;
+    std::string emotion;
+    std::string session_id;
+    // The member was there as a string, possibly an empty one
+    bool has_text = false;
+    bool has_emotion = false;
+    bool has_session_id = false;
+    // Raw "commands" array of an iot message; points into the parsed frame
+    std::string_view commands;
+
+    // false if the frame is not a JSON object
+    bool Parse(const char* data, size_t size);
+    // A goodbye without a session_id is for whichever session is open
+    bool IsForSession(const std::string& id) const {
+        return !has_session_id || id == session_id.c_str();
+    }
+
+    static ServerMessageType LookupType(std::string_view name);
+    static TtsState LookupTtsState(std::string_view name);
+
+private:
+    std::string scratch_;
+};
+
+#endif // SERVER_MESSAGE_H
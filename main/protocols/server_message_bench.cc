@@ -0,0 +1,141 @@
+#include "server_message_bench.h"
+#include "sdkconfig.h"
+
+#if CONFIG_SERVER_MESSAGE_BENCHMARK
+
+#include "server_message.h"
+
+#include <cJSON.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+
+#include <cstring>
+
+#define TAG "ServerMessageBench"
+
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS 200
+#endif
+
+namespace {
+
+// One turn as the server sends it: non-ASCII text arrives \u-escaped
+const char* const kCapture[] = {
+    R"({"type":"stt","text":"\u4eca\u5929\u5929\u6c14\u600e\u4e48\u6837","session_id":"7c1e4a52-93d1-4b7e-a1f0-5d2c8e6b3f19"})",
+    R"({"type":"llm","text":"\ud83d\ude0a","emotion":"happy","session_id":"7c1e4a52-93d1-4b7e-a1f0-5d2c8e6b3f19"})",
+    R"({"type":"tts","state":"start","sample_rate":24000,"session_id":"7c1e4a52-93d1-4b7e-a1f0-5d2c8e6b3f19"})",
+    R"({"type":"tts","state":"sentence_start","text":"\u4eca\u5929\u5317\u4eac\u6674\uff0c\u6c14\u6e29\u5341\u516b\u5230\u4e8c\u5341\u516d\u5ea6\u3002","session_id":"7c1e4a52-93d1-4b7e-a1f0-5d2c8e6b3f19"})",
+    R"({"type":"tts","state":"sentence_end","text":"\u4eca\u5929\u5317\u4eac\u6674\uff0c\u6c14\u6e29\u5341\u516b\u5230\u4e8c\u5341\u516d\u5ea6\u3002","session_id":"7c1e4a52-93d1-4b7e-a1f0-5d2c8e6b3f19"})",
+    R"({"type":"tts","state":"sentence_start","text":"\u51fa\u95e8\u8bb0\u5f97\u6d82\u9632\u6652\u54e6\uff01","session_id":"7c1e4a52-93d1-4b7e-a1f0-5d2c8e6b3f19"})",
+    R"({"type":"tts","state":"sentence_end","text":"\u51fa\u95e8\u8bb0\u5f97\u6d82\u9632\u6652\u54e6\uff01","session_id":"7c1e4a52-93d1-4b7e-a1f0-5d2c8e6b3f19"})",
+    R"({"type":"iot","commands":[{"name":"Speaker","method":"SetVolume","parameters":{"volume":60}}],"session_id":"7c1e4a52-93d1-4b7e-a1f0-5d2c8e6b3f19"})",
+    R"({"type":"tts","state":"stop","session_id":"7c1e4a52-93d1-4b7e-a1f0-5d2c8e6b3f19"})",
+};
+const size_t kCaptureCount = sizeof(kCapture) / sizeof(kCapture[0]);
+
+size_t AllocatedBlocks() {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+    return info.allocated_blocks;
+}
+
+volatile size_t sink;
+
+// The old path: a tree per frame, then strcmp on "type" and "state".
+// Returns the blocks the tree held at dispatch time.
+size_t DispatchTree(const char* frame, size_t /* length */, bool count) {
+    size_t before = count ? AllocatedBlocks() : 0;
+    cJSON* root = cJSON_Parse(frame);
+    size_t held = count ? AllocatedBlocks() - before : 0;
+    auto type = cJSON_GetObjectItem(root, "type");
+    if (strcmp(type->valuestring, "tts") == 0) {
+        auto state = cJSON_GetObjectItem(root, "state");
+        if (strcmp(state->valuestring, "sentence_start") == 0) {
+            sink = strlen(cJSON_GetObjectItem(root, "text")->valuestring);
+        }
+    } else if (strcmp(type->valuestring, "stt") == 0) {
+        sink = strlen(cJSON_GetObjectItem(root, "text")->valuestring);
+    } else if (strcmp(type->valuestring, "llm") == 0) {
+        sink = strlen(cJSON_GetObjectItem(root, "emotion")->valuestring);
+    } else if (strcmp(type->valuestring, "iot") == 0) {
+        sink = cJSON_GetArraySize(cJSON_GetObjectItem(root, "commands"));
+    }
+    cJSON_Delete(root);
+    return held;
+}
+
+// The new path, including the command-list tree Application builds for iot
+size_t DispatchReader(ServerMessage& message, const char* frame, size_t length, bool count) {
+    size_t before = count ? AllocatedBlocks() : 0;
+    message.Parse(frame, length);
+    switch (message.type) {
+    case kServerMessageTts:
+        if (message.state == kTtsStateSentenceStart) {
+            sink = message.text.size();
+        }
+        break;
+    case kServerMessageStt:
+        sink = message.text.size();
+        break;
+    case kServerMessageLlm:
+        sink = message.emotion.size();
+        break;
+    case kServerMessageIot: {
+        cJSON* commands = cJSON_ParseWithLength(message.commands.data(), message.commands.size());
+        size_t held = count ? AllocatedBlocks() - before : 0;
+        sink = cJSON_GetArraySize(commands);
+        cJSON_Delete(commands);
+        return held;
+    }
+    default:
+        break;
+    }
+    return count ? AllocatedBlocks() - before : 0;
+}
+
+template <typename Dispatch>
+void Run(const char* name, Dispatch dispatch) {
+    size_t lengths[kCaptureCount];
+    for (size_t i = 0; i < kCaptureCount; i++) {
+        lengths[i] = strlen(kCapture[i]);
+    }
+
+    // Warm up once so reused buffers have grown, then count what each message holds
+    for (size_t i = 0; i < kCaptureCount; i++) {
+        dispatch(kCapture[i], lengths[i], false);
+    }
+    size_t blocks = 0;
+    for (size_t i = 0; i < kCaptureCount; i++) {
+        blocks += dispatch(kCapture[i], lengths[i], true);
+    }
+
+    int64_t start = esp_timer_get_time();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (size_t i = 0; i < kCaptureCount; i++) {
+            dispatch(kCapture[i], lengths[i], false);
+        }
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start;
+
+    ESP_LOGI(TAG, "%-7s %.2f heap blocks/message, %lu ns per message", name,
+             (double)blocks / kCaptureCount,
+             (unsigned long)(elapsed_us * 1000 / (BENCH_ROUNDS * kCaptureCount)));
+}
+
+} // namespace
+
+void server_message_run_benchmark() {
+    Run("cJSON", DispatchTree);
+    ServerMessage message;
+    Run("reader", [&message](const char* frame, size_t length, bool count) {
+        return DispatchReader(message, frame, length, count);
+    });
+}
+
+#else
+
+void server_message_run_benchmark() {
+}
+
+#endif // CONFIG_SERVER_MESSAGE_BENCHMARK
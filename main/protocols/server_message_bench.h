@@ -0,0 +1,15 @@
+#ifndef SERVER_MESSAGE_BENCH_H
+#define SERVER_MESSAGE_BENCH_H
+
+/**
+ * @brief Compare cJSON trees with ServerMessage on captured server traffic
+ *
+ * Replays a recorded conversation turn (hello excluded) through the old
+ * cJSON_Parse + strcmp dispatch and through ServerMessage::Parse, and logs
+ * heap blocks held per message and time per message for each.
+ *
+ * @note Enabled with CONFIG_SERVER_MESSAGE_BENCHMARK
+ */
+void server_message_run_benchmark();
+
+#endif // SERVER_MESSAGE_BENCH_H
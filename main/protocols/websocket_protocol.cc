@@ -25,12 +25,13 @@ WebsocketProtocol::~WebsocketProtocol() {
 void WebsocketProtocol::Start() {
 }
 
-void WebsocketProtocol::SendAudio(const std::vector<uint8_t>& data) {
+void WebsocketProtocol::SendAudioPacket(const uint8_t* data, size_t size) {
+    std::lock_guard<std::mutex> lock(channel_mutex_);
     if (websocket_ == nullptr) {
         return;
     }
 
-    websocket_->Send(data.data(), data.size(), true);
+    websocket_->Send(data, size, true);
 }
 
 void WebsocketProtocol::SendText(const std::string& text) {
@@ -49,6 +50,8 @@ bool WebsocketProtocol::IsAudioChannelOpened() const {
 }
 
 void WebsocketProtocol::CloseAudioChannel() {
+    FlushAudio();
+    std::lock_guard<std::mutex> lock(channel_mutex_);
     if (websocket_ != nullptr) {
         delete websocket_;
         websocket_ = nullptr;
@@ -56,14 +59,18 @@ void WebsocketProtocol::CloseAudioChannel() {
 }
 
 bool WebsocketProtocol::OpenAudioChannel() {
-    if (websocket_ != nullptr) {
-        delete websocket_;
+    {
+        std::lock_guard<std::mutex> lock(channel_mutex_);
+        if (websocket_ != nullptr) {
+            delete websocket_;
+        }
+        websocket_ = Board::GetInstance().CreateWebSocket();
     }
 
     error_occurred_ = false;
+    ConfigureAudioFraming(1);
     std::string url = CONFIG_WEBSOCKET_URL;
     std::string token = "Bearer " + std::string(CONFIG_WEBSOCKET_ACCESS_TOKEN);
-    websocket_ = Board::GetInstance().CreateWebSocket();
     websocket_->SetHeader("Authorization", token.c_str());
     websocket_->SetHeader("Protocol-Version", "1");
     websocket_->SetHeader("Device-Id", SystemInfo::GetMacAddress().c_str());
@@ -71,25 +78,11 @@ bool WebsocketProtocol::OpenAudioChannel() {
 
     websocket_->OnData([this](const char* data, size_t len, bool binary) {
         if (binary) {
-            if (on_incoming_audio_ != nullptr) {
-                on_incoming_audio_(std::vector<uint8_t>((uint8_t*)data, (uint8_t*)data + len));
-            }
+            auto buffer = AcquireAudioBuffer();
+            buffer.assign((uint8_t*)data, (uint8_t*)data + len);
+            DeliverIncomingAudio(std::move(buffer));
         } else {
-            // Parse JSON data
-            auto root = cJSON_Parse(data);
-            auto type = cJSON_GetObjectItem(root, "type");
-            if (type != NULL) {
-                if (strcmp(type->valuestring, "hello") == 0) {
-                    ParseServerHello(root);
-                } else {
-                    if (on_incoming_json_ != nullptr) {
-                        on_incoming_json_(root);
-                    }
-                }
-            } else {
-                ESP_LOGE(TAG, "Missing message type, data: %s", data);
-            }
-            cJSON_Delete(root);
+            DispatchIncomingText(data, len);
         }
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
@@ -115,6 +108,9 @@ bool WebsocketProtocol::OpenAudioChannel() {
     message += "\"transport\":\"websocket\",";
     message += "\"audio_params\":{";
     message += "\"format\":\"opus\", \"sample_rate\":16000, \"channels\":1, \"frame_duration\":" + std::to_string(OPUS_FRAME_DURATION_MS);
+#if CONFIG_AUDIO_FRAMES_PER_PACKET > 1
+    message += ", \"frames_per_packet\":" + std::to_string(CONFIG_AUDIO_FRAMES_PER_PACKET);
+#endif
     message += "}}";
     websocket_->Send(message);
 
@@ -146,6 +142,10 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         if (sample_rate != NULL) {
             server_sample_rate_ = sample_rate->valueint;
         }
+        auto frames_per_packet = cJSON_GetObjectItem(audio_params, "frames_per_packet");
+        if (cJSON_IsNumber(frames_per_packet)) {
+            ConfigureAudioFraming(frames_per_packet->valueint);
+        }
     }
 
     xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
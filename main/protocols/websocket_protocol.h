@@ -8,6 +8,8 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 
+#include <mutex>
+
 #define WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
 class WebsocketProtocol : public Protocol {
@@ -16,17 +18,18 @@ public:
     ~WebsocketProtocol();
 
     void Start() override;
-    void SendAudio(const std::vector<uint8_t>& data) override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
 
 private:
     EventGroupHandle_t event_group_handle_;
+    std::mutex channel_mutex_;      // SendAudioPacket() runs on the encoder side, not the main loop
     WebSocket* websocket_ = nullptr;
 
-    void ParseServerHello(const cJSON* root);
+    void ParseServerHello(const cJSON* root) override;
     void SendText(const std::string& text) override;
+    void SendAudioPacket(const uint8_t* data, size_t size) override;
 };
 
 #endif
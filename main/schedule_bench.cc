@@ -0,0 +1,150 @@
+#include "schedule_bench.h"
+#include "sdkconfig.h"
+
+#if CONFIG_SCHEDULE_BENCHMARK
+
+#include "inline_task.h"
+#include "mpsc_queue.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+
+#define TAG "ScheduleBench"
+
+// Batches as deep as the queues get in practice
+#define BENCH_BATCH 8
+#define BENCH_ROUNDS 10000
+
+namespace {
+
+struct Target {
+    volatile uint32_t counter = 0;
+};
+
+// The old path: Application::Schedule / BackgroundTask::Schedule
+class ListQueue {
+public:
+    void Push(std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // BackgroundTask wrapped every callback once more
+        tasks_.emplace_back([this, cb = std::move(callback)]() {
+            cb();
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_--;
+        });
+        active_++;
+    }
+
+    void Drain() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::list<std::function<void()>> tasks = std::move(tasks_);
+        lock.unlock();
+        for (auto& task : tasks) {
+            task();
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::list<std::function<void()>> tasks_;
+    size_t active_ = 0;
+};
+
+class InlineQueue {
+public:
+    void Push(InlineTask callback) {
+        tasks_.Push(std::move(callback));
+    }
+
+    void Drain() {
+        InlineTask task;
+        while (tasks_.Pop(task)) {
+            task();
+            task = nullptr;
+        }
+    }
+
+    uint32_t heap_nodes() const { return tasks_.heap_nodes(); }
+
+private:
+    MpscQueue<InlineTask, 16> tasks_;
+};
+
+size_t AllocatedBlocks() {
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+    return info.allocated_blocks;
+}
+
+// Callbacks shaped like the real ones: [this], and [this, display, message]
+template <typename Queue>
+void PushBatch(Queue& queue, Target* target, const std::string& message) {
+    for (int i = 0; i < BENCH_BATCH; i++) {
+        if (i & 1) {
+            queue.Push([target, display = (void*)target, text = message]() {
+                target->counter += text.size() + (display != nullptr);
+            });
+        } else {
+            queue.Push([target]() { target->counter++; });
+        }
+    }
+}
+
+template <typename Queue>
+void Run(const char* name, Queue& queue, Target* target) {
+    // Short enough for the small-string buffer: only the queue should allocate
+    const std::string message = "hi";
+
+    // Allocations: count blocks alive while a batch is queued
+    size_t allocations = 0;
+    for (int round = 0; round < BENCH_ROUNDS / 10; round++) {
+        size_t before = AllocatedBlocks();
+        PushBatch(queue, target, message);
+        size_t after = AllocatedBlocks();
+        allocations += after > before ? after - before : 0;
+        queue.Drain();
+    }
+
+    // Time, without the heap walks
+    int64_t start = esp_timer_get_time();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        PushBatch(queue, target, message);
+        queue.Drain();
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start;
+
+    size_t ops = (size_t)BENCH_ROUNDS * BENCH_BATCH;
+    ESP_LOGI(TAG, "%-8s %.2f allocs/schedule, %lu ns per schedule+run", name,
+             (double)allocations / (BENCH_ROUNDS / 10 * BENCH_BATCH),
+             (unsigned long)(elapsed_us * 1000 / ops));
+}
+
+} // namespace
+
+void schedule_run_benchmark() {
+    Target target;
+    {
+        ListQueue queue;
+        Run("list", queue, &target);
+    }
+    {
+        InlineQueue queue;
+        Run("inline", queue, &target);
+        ESP_LOGI(TAG, "inline capacity %u bytes, pool overflows %lu, boxed callables %lu",
+                 (unsigned)INLINE_TASK_CAPACITY, (unsigned long)queue.heap_nodes(),
+                 (unsigned long)InlineTask::heap_fallbacks());
+    }
+}
+
+#else
+
+void schedule_run_benchmark() {
+}
+
+#endif // CONFIG_SCHEDULE_BENCHMARK
@@ -0,0 +1,16 @@
+#ifndef SCHEDULE_BENCH_H
+#define SCHEDULE_BENCH_H
+
+/**
+ * @brief Compare the cost of queueing scheduled work
+ *
+ * Pushes and pops batches of typical callbacks through the old
+ * std::list<std::function> path (with the BackgroundTask wrapper lambda)
+ * and through MpscQueue<InlineTask>, and logs heap allocations and time per
+ * operation for each.
+ *
+ * @note Enabled with CONFIG_SCHEDULE_BENCHMARK
+ */
+void schedule_run_benchmark();
+
+#endif // SCHEDULE_BENCH_H
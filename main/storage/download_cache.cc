@@ -0,0 +1,394 @@
+#include "download_cache.h"
+#include "gif_storage.h"
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "sdkconfig.h"
+
+static const char* TAG = "DownloadCache";
+
+#define STORAGE_BASE_PATH "/storage"
+#define INDEX_PATH STORAGE_BASE_PATH "/.dlcache"
+#define INDEX_TMP_PATH STORAGE_BASE_PATH "/.dlcache.tmp"
+#define BLOB_PREFIX ".dl_"
+#define INDEX_MAGIC "DLC1"
+
+#ifndef CONFIG_DOWNLOAD_CACHE_SIZE_KB
+#define CONFIG_DOWNLOAD_CACHE_SIZE_KB 1024
+#endif
+
+static constexpr size_t kBudgetBytes = (size_t)CONFIG_DOWNLOAD_CACHE_SIZE_KB * 1024;
+// Free space left on the partition for user uploads after storing a blob
+static constexpr size_t kMinFreeBytes = 128 * 1024;
+static constexpr size_t kMaxLineLength = 1024;
+// Hits are written back after this many, or once this long has passed since the last save
+static constexpr uint32_t kFlushUses = 16;
+static constexpr int64_t kFlushIntervalUs = 5 * 60 * 1000000LL;
+
+DownloadCache& DownloadCache::GetInstance() {
+    static DownloadCache instance;
+    return instance;
+}
+
+bool DownloadCache::IsEnabled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Ready();
+}
+
+// Storage mounted and the index in RAM; only the first successful call touches flash
+bool DownloadCache::Ready() {
+    if (loaded_) {
+        return true;
+    }
+    size_t total = 0, used = 0;
+    if (kBudgetBytes == 0 || gif_storage_info(&total, &used) != ESP_OK) {
+        return false;
+    }
+    LoadIndex();
+    return true;
+}
+
+std::string DownloadCache::BlobName(const std::string& url) {
+    // FNV-1a keeps names within the SPIFFS object name limit
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : url) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    char name[24];
+    snprintf(name, sizeof(name), BLOB_PREFIX "%08lx", (unsigned long)hash);
+    return name;
+}
+
+std::string DownloadCache::BlobPath(const std::string& url) {
+    return STORAGE_BASE_PATH "/" + BlobName(url);
+}
+
+DownloadCache::Entry* DownloadCache::Find(const std::string& url) {
+    for (auto& entry : entries_) {
+        if (entry.url == url) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void DownloadCache::EraseAt(size_t i) {
+    unlink(BlobPath(entries_[i].url).c_str());
+    entries_.erase(entries_.begin() + i);
+}
+
+size_t DownloadCache::LruIndex() const {
+    size_t lru = 0;
+    for (size_t i = 1; i < entries_.size(); ++i) {
+        if (entries_[i].last_used < entries_[lru].last_used) {
+            lru = i;
+        }
+    }
+    return lru;
+}
+
+size_t DownloadCache::TotalBytes() const {
+    size_t total = 0;
+    for (const auto& entry : entries_) {
+        total += entry.size;
+    }
+    return total;
+}
+
+// Split one index line "size\tlast_used\tetag\tlast_modified\turl"
+static bool ParseIndexLine(char* line, std::string fields[5]) {
+    size_t len = strlen(line);
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+        line[--len] = '\0';
+    }
+    char* p = line;
+    for (int i = 0; i < 5; ++i) {
+        char* tab = (i < 4) ? strchr(p, '\t') : nullptr;
+        if (i < 4 && !tab) {
+            return false;
+        }
+        fields[i].assign(p, tab ? (size_t)(tab - p) : strlen(p));
+        p = tab ? tab + 1 : p;
+    }
+    return !fields[4].empty();
+}
+
+void DownloadCache::LoadIndex() {
+    loaded_ = true;
+    entries_.clear();
+    use_seq_ = 0;
+
+    FILE* f = fopen(INDEX_PATH, "r");
+    if (f) {
+        char* line = (char*)malloc(kMaxLineLength);
+        if (line && fgets(line, kMaxLineLength, f) && strncmp(line, INDEX_MAGIC "\t", 5) == 0) {
+            use_seq_ = strtoul(line + 5, nullptr, 10);
+            std::string fields[5];
+            while (fgets(line, kMaxLineLength, f)) {
+                if (!ParseIndexLine(line, fields)) {
+                    continue;
+                }
+                Entry entry;
+                entry.size = strtoul(fields[0].c_str(), nullptr, 10);
+                entry.last_used = strtoul(fields[1].c_str(), nullptr, 10);
+                entry.etag = fields[2];
+                entry.last_modified = fields[3];
+                entry.url = fields[4];
+                // Drop entries whose blob is gone or was cut short
+                struct stat st;
+                if (stat(BlobPath(entry.url).c_str(), &st) != 0 || (size_t)st.st_size != entry.size) {
+                    ESP_LOGW(TAG, "Dropping stale entry: %s", entry.url.c_str());
+                    unlink(BlobPath(entry.url).c_str());
+                    continue;
+                }
+                entries_.push_back(std::move(entry));
+            }
+        }
+        free(line);
+        fclose(f);
+    }
+
+    // Remove blobs no entry refers to (index lost or written before a crash)
+    DIR* dir = opendir(STORAGE_BASE_PATH);
+    if (dir) {
+        std::vector<std::string> orphans;
+        struct dirent* de;
+        while ((de = readdir(dir)) != nullptr) {
+            if (strncmp(de->d_name, BLOB_PREFIX, strlen(BLOB_PREFIX)) != 0) {
+                continue;
+            }
+            std::string path = std::string(STORAGE_BASE_PATH "/") + de->d_name;
+            bool referenced = false;
+            for (const auto& entry : entries_) {
+                if (BlobPath(entry.url) == path) {
+                    referenced = true;
+                    break;
+                }
+            }
+            if (!referenced) {
+                orphans.push_back(path);
+            }
+        }
+        closedir(dir);
+        for (const auto& path : orphans) {
+            ESP_LOGW(TAG, "Removing orphan blob: %s", path.c_str());
+            unlink(path.c_str());
+        }
+    }
+
+    ESP_LOGI(TAG, "Loaded %zu entries (%zu bytes, budget %zu)", entries_.size(), TotalBytes(), kBudgetBytes);
+}
+
+bool DownloadCache::SaveIndex() {
+    FILE* f = fopen(INDEX_TMP_PATH, "w");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to write index");
+        return false;
+    }
+    bool ok = fprintf(f, INDEX_MAGIC "\t%lu\n", (unsigned long)use_seq_) > 0;
+    for (const auto& entry : entries_) {
+        ok = ok && fprintf(f, "%u\t%lu\t%s\t%s\t%s\n", (unsigned)entry.size, (unsigned long)entry.last_used,
+                           entry.etag.c_str(), entry.last_modified.c_str(), entry.url.c_str()) > 0;
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (ok) {
+        ok = gif_storage_replace_file(INDEX_TMP_PATH, INDEX_PATH) == ESP_OK;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to commit index");
+        unlink(INDEX_TMP_PATH);
+    }
+    // A failed save is retried by the next one; hits are not worth retrying sooner
+    unsaved_uses_ = 0;
+    last_save_us_ = esp_timer_get_time();
+    return ok;
+}
+
+void DownloadCache::Flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loaded_ && unsaved_uses_ > 0) {
+        SaveIndex();
+    }
+}
+
+bool DownloadCache::GetValidators(const std::string& url, std::string& etag, std::string& last_modified) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Ready()) {
+        return false;
+    }
+    Entry* entry = Find(url);
+    if (!entry) {
+        return false;
+    }
+    etag = entry->etag;
+    last_modified = entry->last_modified;
+    return true;
+}
+
+bool DownloadCache::Load(const std::string& url, uint8_t** out_data, size_t* out_size) {
+    if (!out_data || !out_size) {
+        return false;
+    }
+    *out_data = nullptr;
+    *out_size = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Ready()) {
+        return false;
+    }
+    Entry* entry = Find(url);
+    if (!entry || entry->size == 0) {
+        return false;
+    }
+
+    std::string path = BlobPath(url);
+    uint8_t* buf = (uint8_t*)heap_caps_malloc(entry->size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!buf) {
+        ESP_LOGE(TAG, "PSRAM alloc failed: %u bytes", (unsigned)entry->size);
+        return false;
+    }
+    FILE* f = fopen(path.c_str(), "rb");
+    size_t n = 0;
+    if (f) {
+        n = fread(buf, 1, entry->size, f);
+        fclose(f);
+    }
+    if (n != entry->size) {
+        ESP_LOGW(TAG, "Blob unreadable, dropping: %s", url.c_str());
+        heap_caps_free(buf);
+        EraseAt(entry - entries_.data());
+        SaveIndex();
+        return false;
+    }
+
+    entry->last_used = ++use_seq_;
+    if (++unsaved_uses_ >= kFlushUses || esp_timer_get_time() - last_save_us_ >= kFlushIntervalUs) {
+        SaveIndex();
+    }
+    *out_data = buf;
+    *out_size = n;
+    ESP_LOGI(TAG, "Hit: %s (%u bytes)", url.c_str(), (unsigned)n);
+    return true;
+}
+
+bool DownloadCache::Store(const std::string& url, const uint8_t* data, size_t size,
+                          const std::string& etag, const std::string& last_modified) {
+    if (!data || size == 0 || size > kBudgetBytes) {
+        return false;
+    }
+    if (etag.empty() && last_modified.empty()) {
+        return false;
+    }
+    // Fields are tab separated, one entry per line
+    for (const std::string* s : {&url, &etag, &last_modified}) {
+        if (s->find_first_of("\t\r\n") != std::string::npos || s->size() > kMaxLineLength / 4) {
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Ready()) {
+        return false;
+    }
+
+    // Replace the old copy, and any other URL that hashes to the same blob
+    std::string path = BlobPath(url);
+    for (size_t i = entries_.size(); i-- > 0;) {
+        if (entries_[i].url == url || BlobPath(entries_[i].url) == path) {
+            EraseAt(i);
+        }
+    }
+
+    auto evict_lru = [this]() {
+        size_t lru = LruIndex();
+        ESP_LOGI(TAG, "Evict: %s (%u bytes)", entries_[lru].url.c_str(), (unsigned)entries_[lru].size);
+        EraseAt(lru);
+    };
+    while (!entries_.empty() && TotalBytes() + size > kBudgetBytes) {
+        evict_lru();
+    }
+    // Never take space user uploads need
+    size_t total = 0, used = 0;
+    while (gif_storage_info(&total, &used) == ESP_OK && used + size + kMinFreeBytes > total) {
+        if (entries_.empty()) {
+            ESP_LOGW(TAG, "Not enough space to cache %u bytes", (unsigned)size);
+            SaveIndex();
+            return false;
+        }
+        evict_lru();
+    }
+
+    // Temp file + rename: Load() never sees a partially written blob
+    gif_storage_writer_t* writer = nullptr;
+    esp_err_t ret = gif_storage_open_write(BlobName(url).c_str(), size, &writer);
+    if (ret == ESP_OK) {
+        gif_storage_writer_set_progress_callback(writer, nullptr, nullptr);
+        ret = gif_storage_append(writer, data, size);
+        if (ret == ESP_OK) {
+            ret = gif_storage_commit(writer);
+        } else {
+            gif_storage_abort(writer);
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write blob for %s", url.c_str());
+        SaveIndex();
+        return false;
+    }
+
+    Entry entry;
+    entry.url = url;
+    entry.etag = etag;
+    entry.last_modified = last_modified;
+    entry.size = size;
+    entry.last_used = ++use_seq_;
+    entries_.push_back(std::move(entry));
+    bool ok = SaveIndex();
+    ESP_LOGI(TAG, "Stored: %s (%u bytes, %zu cached)", url.c_str(), (unsigned)size, TotalBytes());
+    return ok;
+}
+
+void DownloadCache::Remove(const std::string& url) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Ready()) {
+        return;
+    }
+    Entry* entry = Find(url);
+    if (entry) {
+        EraseAt(entry - entries_.data());
+        SaveIndex();
+    }
+}
+
+size_t DownloadCache::Shrink(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Ready()) {
+        return 0;
+    }
+    size_t freed = 0;
+    while (freed < bytes && !entries_.empty()) {
+        size_t lru = LruIndex();
+        freed += entries_[lru].size;
+        ESP_LOGI(TAG, "Shrink: evict %s (%u bytes)", entries_[lru].url.c_str(), (unsigned)entries_[lru].size);
+        EraseAt(lru);
+    }
+    if (freed > 0) {
+        SaveIndex();
+    }
+    return freed;
+}
+
+size_t DownloadCache::CachedBytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Ready()) {
+        return 0;
+    }
+    return TotalBytes();
+}
@@ -0,0 +1,111 @@
+#ifndef DOWNLOAD_CACHE_H
+#define DOWNLOAD_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief HTTP download cache on the storage partition
+ *
+ * Keeps downloaded bodies (e.g. slideshow GIFs) keyed by URL together with
+ * their ETag / Last-Modified validators, so repeat downloads can be issued as
+ * conditional requests and a 304 is served from flash.
+ *
+ * Blobs are hidden files ("/storage/.dl_<hash>") and the index lives in
+ * "/storage/.dlcache", so they never show up in gif_storage_list(). The cache
+ * is bounded by CONFIG_DOWNLOAD_CACHE_SIZE_KB and evicts least recently used
+ * entries first.
+ *
+ * The index is read once and then kept in RAM. Inserts and evictions write it
+ * straight away; cache hits only bump the in-RAM use counters, which are
+ * written back after several hits, after a while, or by Flush(). Losing them
+ * on a power cut only makes the LRU order a little stale.
+ */
+class DownloadCache {
+public:
+    static DownloadCache& GetInstance();
+
+    /**
+     * @brief Whether caching is enabled (budget > 0 and storage mounted)
+     */
+    bool IsEnabled();
+
+    /**
+     * @brief Get the validators of a cached URL
+     * @return false if the URL is not cached
+     */
+    bool GetValidators(const std::string& url, std::string& etag, std::string& last_modified);
+
+    /**
+     * @brief Load a cached body into PSRAM and mark the entry as recently used
+     *
+     * @note The caller frees *out_data with heap_caps_free()
+     */
+    bool Load(const std::string& url, uint8_t** out_data, size_t* out_size);
+
+    /**
+     * @brief Store a downloaded body; entries are evicted (LRU) to fit the budget
+     *
+     * Bodies without any validator are not cached, they could never be revalidated.
+     */
+    bool Store(const std::string& url, const uint8_t* data, size_t size,
+               const std::string& etag, const std::string& last_modified);
+
+    /**
+     * @brief Drop a cached URL (e.g. the blob failed to load)
+     */
+    void Remove(const std::string& url);
+
+    /**
+     * @brief Evict entries until at least `bytes` were freed (or the cache is empty)
+     *
+     * Used when user uploads need the space.
+     * @return bytes freed
+     */
+    size_t Shrink(size_t bytes);
+
+    /**
+     * @brief Bytes taken by cached bodies, all of which Shrink() can free
+     */
+    size_t CachedBytes();
+
+    /**
+     * @brief Write back use counters that hits have changed since the last save
+     */
+    void Flush();
+
+private:
+    DownloadCache() = default;
+    DownloadCache(const DownloadCache&) = delete;
+    DownloadCache& operator=(const DownloadCache&) = delete;
+
+    struct Entry {
+        std::string url;
+        std::string etag;
+        std::string last_modified;
+        size_t size = 0;
+        uint32_t last_used = 0;  // use sequence number, larger = more recent
+    };
+
+    std::mutex mutex_;
+    std::vector<Entry> entries_;
+    uint32_t use_seq_ = 0;
+    bool loaded_ = false;
+    uint32_t unsaved_uses_ = 0;  // hits not yet in the index file
+    int64_t last_save_us_ = 0;
+
+    bool Ready();
+    void LoadIndex();
+    bool SaveIndex();
+    Entry* Find(const std::string& url);
+    void EraseAt(size_t i);
+    size_t LruIndex() const;
+    size_t TotalBytes() const;
+    static std::string BlobName(const std::string& url);
+    static std::string BlobPath(const std::string& url);
+};
+
+#endif // DOWNLOAD_CACHE_H
@@ -0,0 +1,684 @@
+#include "gif_index.h"
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static const char* TAG = "GifIndex";
+
+#define INDEX_NAME ".index"
+#define INDEX_TMP_NAME ".index.tmp"
+#define META_PREFIX ".meta_"
+#define INDEX_MAGIC "GIX2"
+#define INDEX_MAGIC_V1 "GIX1"
+
+#define RECORD_MARK 0xA5
+#define RECORD_PUT 1
+#define RECORD_DELETE 2
+// mark, type, name_len, flags, size, upload_time(8), width, height, frames, crc32, last_shown(8)
+#define RECORD_HEADER_SIZE 36
+// GIX1 records end before last_shown and have no flags
+#define RECORD_HEADER_SIZE_V1 28
+#define RECORD_MAX_NAME 255
+
+#define SCAN_BUFFER_SIZE 4096
+
+static char s_base_path[32];
+static gif_index_item_t* s_items = NULL;
+static size_t s_count = 0;
+static size_t s_capacity = 0;
+static size_t s_journal_records = 0;
+
+static void build_path(char* buffer, size_t size, const char* name) {
+    snprintf(buffer, size, "%s/%s", s_base_path, name);
+}
+
+static void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (v >> (8 * i)) & 0xff;
+    }
+}
+
+static void put_time(uint8_t* p, time_t t) {
+    put_u32(p, (uint32_t)(int64_t)t);
+    put_u32(p + 4, (uint32_t)((uint64_t)(int64_t)t >> 32));
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static time_t get_time(const uint8_t* p) {
+    return (time_t)(int64_t)((uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32));
+}
+
+/* ---------- in-memory table ---------- */
+
+static gif_index_item_t* find_item(const char* name) {
+    for (size_t i = 0; i < s_count; i++) {
+        if (strcmp(s_items[i].name, name) == 0) {
+            return &s_items[i];
+        }
+    }
+    return NULL;
+}
+
+static bool table_put(const char* name, const gif_storage_entry_t* info) {
+    gif_index_item_t* item = find_item(name);
+    if (item) {
+        item->info = *info;
+        return true;
+    }
+    if (s_count == s_capacity) {
+        size_t capacity = s_capacity ? s_capacity * 2 : 16;
+        gif_index_item_t* items = realloc(s_items, capacity * sizeof(gif_index_item_t));
+        if (!items) {
+            return false;
+        }
+        s_items = items;
+        s_capacity = capacity;
+    }
+    char* copy = strdup(name);
+    if (!copy) {
+        return false;
+    }
+    s_items[s_count].name = copy;
+    s_items[s_count].info = *info;
+    s_count++;
+    return true;
+}
+
+static void table_remove_at(size_t i) {
+    free(s_items[i].name);
+    s_items[i] = s_items[--s_count];
+}
+
+static bool table_remove(const char* name) {
+    gif_index_item_t* item = find_item(name);
+    if (!item) {
+        return false;
+    }
+    table_remove_at(item - s_items);
+    return true;
+}
+
+/* ---------- journal ---------- */
+
+static size_t encode_record(uint8_t* buffer, uint8_t type, const char* name, const gif_storage_entry_t* info) {
+    size_t name_len = strlen(name);
+    memset(buffer, 0, RECORD_HEADER_SIZE);
+    buffer[0] = RECORD_MARK;
+    buffer[1] = type;
+    buffer[2] = (uint8_t)name_len;
+    if (info) {
+        buffer[3] = (uint8_t)info->flags;
+        put_u32(buffer + 4, (uint32_t)info->size);
+        put_time(buffer + 8, info->upload_time);
+        put_u16(buffer + 16, info->width);
+        put_u16(buffer + 18, info->height);
+        put_u32(buffer + 20, info->frame_count);
+        put_u32(buffer + 24, info->crc32);
+        put_time(buffer + 28, info->last_shown);
+    }
+    memcpy(buffer + RECORD_HEADER_SIZE, name, name_len);
+    uint32_t crc = esp_rom_crc32_le(0, buffer, RECORD_HEADER_SIZE + name_len);
+    put_u32(buffer + RECORD_HEADER_SIZE + name_len, crc);
+    return RECORD_HEADER_SIZE + name_len + 4;
+}
+
+static bool write_record(FILE* f, uint8_t type, const char* name, const gif_storage_entry_t* info) {
+    uint8_t buffer[RECORD_HEADER_SIZE + RECORD_MAX_NAME + 4];
+    size_t len = encode_record(buffer, type, name, info);
+    return fwrite(buffer, 1, len, f) == len;
+}
+
+// Rewrite the journal with one record per entry
+static esp_err_t compact(void) {
+    char path[64], tmp_path[64];
+    build_path(path, sizeof(path), INDEX_NAME);
+    build_path(tmp_path, sizeof(tmp_path), INDEX_TMP_NAME);
+
+    FILE* f = fopen(tmp_path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to create %s", tmp_path);
+        return ESP_FAIL;
+    }
+    bool ok = fwrite(INDEX_MAGIC, 1, 4, f) == 4;
+    for (size_t i = 0; ok && i < s_count; i++) {
+        ok = write_record(f, RECORD_PUT, s_items[i].name, &s_items[i].info);
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (ok) {
+        ok = gif_storage_replace_file(tmp_path, path) == ESP_OK;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to compact index");
+        unlink(tmp_path);
+        return ESP_FAIL;
+    }
+    s_journal_records = s_count;
+    ESP_LOGI(TAG, "Index compacted: %zu entries", s_count);
+    return ESP_OK;
+}
+
+static esp_err_t append_record(uint8_t type, const char* name, const gif_storage_entry_t* info) {
+    // Superseded records are dropped once they outnumber live ones
+    if (s_journal_records >= 2 * s_count + 32) {
+        return compact();
+    }
+
+    char path[64];
+    build_path(path, sizeof(path), INDEX_NAME);
+    FILE* f = fopen(path, "ab");
+    if (!f) {
+        return compact();
+    }
+    bool ok = write_record(f, type, name, info);
+    ok = (fclose(f) == 0) && ok;
+    if (!ok) {
+        // A torn tail is ignored on replay, but rewrite it now rather than later
+        return compact();
+    }
+    s_journal_records++;
+    return ESP_OK;
+}
+
+// Replay the journal; returns false if it ended in a torn or corrupt record.
+// *legacy is set for a GIX1 journal, which should be rewritten in the current format.
+static bool replay_journal(FILE* f, bool* legacy) {
+    uint8_t buffer[RECORD_HEADER_SIZE + RECORD_MAX_NAME + 4];
+    char name[RECORD_MAX_NAME + 1];
+
+    char magic[4];
+    if (fread(magic, 1, 4, f) != 4) {
+        return false;
+    }
+    *legacy = memcmp(magic, INDEX_MAGIC_V1, 4) == 0;
+    if (!*legacy && memcmp(magic, INDEX_MAGIC, 4) != 0) {
+        return false;
+    }
+    const size_t header_size = *legacy ? RECORD_HEADER_SIZE_V1 : RECORD_HEADER_SIZE;
+
+    for (;;) {
+        size_t n = fread(buffer, 1, header_size, f);
+        if (n == 0) {
+            return true;
+        }
+        if (n != header_size || buffer[0] != RECORD_MARK) {
+            return false;
+        }
+        size_t name_len = buffer[2];
+        if (name_len == 0 || fread(buffer + header_size, 1, name_len + 4, f) != name_len + 4) {
+            return false;
+        }
+        uint32_t crc = esp_rom_crc32_le(0, buffer, header_size + name_len);
+        if (crc != get_u32(buffer + header_size + name_len)) {
+            return false;
+        }
+
+        memcpy(name, buffer + header_size, name_len);
+        name[name_len] = '\0';
+        s_journal_records++;
+
+        if (buffer[1] == RECORD_DELETE) {
+            table_remove(name);
+        } else if (buffer[1] == RECORD_PUT) {
+            gif_storage_entry_t info = {0};
+            info.size = get_u32(buffer + 4);
+            info.upload_time = get_time(buffer + 8);
+            info.width = get_u16(buffer + 16);
+            info.height = get_u16(buffer + 18);
+            info.frame_count = get_u32(buffer + 20);
+            info.crc32 = get_u32(buffer + 24);
+            if (!*legacy) {
+                info.flags = buffer[3];
+                info.last_shown = get_time(buffer + 28);
+            }
+            table_put(name, &info);
+        } else {
+            return false;
+        }
+    }
+}
+
+/* ---------- file scan ---------- */
+
+enum {
+    SCAN_HEADER,        // collecting the 13-byte header and logical screen descriptor
+    SCAN_SEPARATOR,     // expecting ',' '!' or the trailer
+    SCAN_DESCRIPTOR,    // collecting the 9 bytes after ','
+    SCAN_CODE_SIZE,     // LZW minimum code size
+    SCAN_LABEL,         // extension label
+    SCAN_BLOCK_SIZE,    // sub-block length, 0 ends the block
+    SCAN_SKIP,          // skipping `skip` bytes, then `next`
+    SCAN_DONE,          // trailer, garbage or not a GIF: only size and CRC from here
+};
+
+static void scanner_skip(gif_index_scanner_t* s, size_t n, uint8_t next) {
+    s->skip = n;
+    s->next = next;
+    s->state = n > 0 ? SCAN_SKIP : next;
+}
+
+void gif_index_scanner_init(gif_index_scanner_t* s) {
+    memset(s, 0, sizeof(*s));
+    s->state = SCAN_HEADER;
+}
+
+// Walk the GIF block structure, counting image descriptors; the checksum
+// covers everything fed, including anything after the trailer
+void gif_index_scanner_feed(gif_index_scanner_t* s, const void* data, size_t size) {
+    const uint8_t* p = data;
+    const uint8_t* end = p + size;
+    s->crc = esp_rom_crc32_le(s->crc, p, size);
+    s->total += size;
+
+    while (p < end && s->state != SCAN_DONE) {
+        switch (s->state) {
+        case SCAN_SKIP: {
+            size_t step = (size_t)(end - p) < s->skip ? (size_t)(end - p) : s->skip;
+            p += step;
+            s->skip -= step;
+            if (s->skip == 0) {
+                s->state = s->next;
+            }
+            break;
+        }
+        case SCAN_HEADER:
+        case SCAN_DESCRIPTOR: {
+            size_t want = s->state == SCAN_HEADER ? 13 : 9;
+            size_t step = (size_t)(end - p) < want - s->have ? (size_t)(end - p) : want - s->have;
+            memcpy(s->buf + s->have, p, step);
+            p += step;
+            s->have += step;
+            if (s->have < want) {
+                break;
+            }
+            s->have = 0;
+            if (s->state == SCAN_HEADER) {
+                if (memcmp(s->buf, "GIF", 3) != 0) {
+                    s->state = SCAN_DONE;
+                    break;
+                }
+                s->width = get_u16(s->buf + 6);
+                s->height = get_u16(s->buf + 8);
+                scanner_skip(s, (s->buf[10] & 0x80) ? 3 << ((s->buf[10] & 0x07) + 1) : 0, SCAN_SEPARATOR);
+            } else {
+                scanner_skip(s, (s->buf[8] & 0x80) ? 3 << ((s->buf[8] & 0x07) + 1) : 0, SCAN_CODE_SIZE);
+            }
+            break;
+        }
+        case SCAN_SEPARATOR: {
+            uint8_t sep = *p++;
+            if (sep == ',') {
+                s->state = SCAN_DESCRIPTOR;
+            } else if (sep == '!') {
+                s->state = SCAN_LABEL;
+            } else {
+                s->state = SCAN_DONE;
+            }
+            break;
+        }
+        case SCAN_CODE_SIZE:
+        case SCAN_LABEL:
+            s->image = (s->state == SCAN_CODE_SIZE);
+            p++;
+            s->state = SCAN_BLOCK_SIZE;
+            break;
+        case SCAN_BLOCK_SIZE: {
+            uint8_t n = *p++;
+            if (n == 0) {
+                if (s->image) {
+                    s->frame_count++;
+                }
+                s->state = SCAN_SEPARATOR;
+            } else {
+                scanner_skip(s, n, SCAN_BLOCK_SIZE);
+            }
+            break;
+        }
+        }
+    }
+}
+
+void gif_index_scanner_finish(const gif_index_scanner_t* s, gif_storage_entry_t* info) {
+    // Scanning describes the content; keep what the caller knows about the file
+    gif_storage_entry_t kept = *info;
+    memset(info, 0, sizeof(*info));
+    info->upload_time = kept.upload_time;
+    info->last_shown = kept.last_shown;
+    info->flags = kept.flags;
+    info->size = s->total;
+    info->crc32 = s->crc;
+    info->width = s->width;
+    info->height = s->height;
+    info->frame_count = s->frame_count;
+}
+
+esp_err_t gif_index_scan_file(const char* path, gif_storage_entry_t* info) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint8_t* buf = malloc(SCAN_BUFFER_SIZE);
+    if (!buf) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    gif_index_scanner_t scanner;
+    gif_index_scanner_init(&scanner);
+    size_t len;
+    while ((len = fread(buf, 1, SCAN_BUFFER_SIZE, f)) > 0) {
+        gif_index_scanner_feed(&scanner, buf, len);
+    }
+    gif_index_scanner_finish(&scanner, info);
+
+    free(buf);
+    fclose(f);
+    return ESP_OK;
+}
+
+/* ---------- load / reconcile ---------- */
+
+static bool read_legacy_meta(const char* name, time_t* upload_time) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/" META_PREFIX "%s", s_base_path, name);
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    time_t value = 0;
+    bool ok = fread(&value, sizeof(value), 1, f) == 1 && value > 0;
+    fclose(f);
+    if (ok) {
+        *upload_time = value;
+    }
+    return ok;
+}
+
+esp_err_t gif_index_load(const char* base_path) {
+    gif_index_unload();
+    snprintf(s_base_path, sizeof(s_base_path), "%s", base_path);
+
+    char path[300];
+    build_path(path, sizeof(path), INDEX_NAME);
+    bool dirty = false;
+    FILE* f = fopen(path, "rb");
+    if (f) {
+        bool legacy = false;
+        if (!replay_journal(f, &legacy)) {
+            ESP_LOGW(TAG, "Index journal ends in a torn record, compacting");
+            dirty = true;
+        } else if (legacy) {
+            ESP_LOGI(TAG, "Upgrading index journal format");
+            dirty = true;
+        }
+        fclose(f);
+    } else {
+        dirty = true;
+    }
+
+    DIR* dir = opendir(s_base_path);
+    if (!dir) {
+        ESP_LOGE(TAG, "Failed to open %s", s_base_path);
+        return ESP_FAIL;
+    }
+
+    // Entries not seen in the directory belong to files deleted behind our back
+    bool* seen = s_count ? calloc(s_count, sizeof(bool)) : NULL;
+    size_t indexed = s_count;
+    bool has_meta = false;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type == DT_DIR) {
+            continue;
+        }
+        if (entry->d_name[0] == '.') {
+            has_meta = has_meta || strncmp(entry->d_name, META_PREFIX, strlen(META_PREFIX)) == 0;
+            continue;
+        }
+        gif_index_item_t* item = find_item(entry->d_name);
+        if (item) {
+            if (seen && (size_t)(item - s_items) < indexed) {
+                seen[item - s_items] = true;
+            }
+            continue;
+        }
+
+        // Not indexed yet: first boot with the index, or written by an older build
+        build_path(path, sizeof(path), entry->d_name);
+        gif_storage_entry_t info = {0};
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            info.upload_time = st.st_mtime;
+        }
+        read_legacy_meta(entry->d_name, &info.upload_time);
+        if (gif_index_scan_file(path, &info) == ESP_OK && table_put(entry->d_name, &info)) {
+            ESP_LOGI(TAG, "Indexed %s (%zu bytes, %ux%u, %lu frames)", entry->d_name, info.size,
+                     info.width, info.height, (unsigned long)info.frame_count);
+            dirty = true;
+        }
+    }
+    closedir(dir);
+
+    // table_remove_at() moves the last item into the hole; walking backwards,
+    // that item is either already checked or one of the entries added above
+    for (size_t i = indexed; seen && i-- > 0;) {
+        if (!seen[i]) {
+            ESP_LOGW(TAG, "Dropping entry of missing file: %s", s_items[i].name);
+            table_remove_at(i);
+            dirty = true;
+        }
+    }
+    free(seen);
+
+    if (dirty) {
+        compact();
+    }
+
+    // Upload times now live in the index; remove the per-file sidecars
+    if (has_meta && (dir = opendir(s_base_path)) != NULL) {
+        char batch[8][64];
+        int count;
+        do {
+            count = 0;
+            rewinddir(dir);
+            while ((entry = readdir(dir)) != NULL && count < 8) {
+                if (strncmp(entry->d_name, META_PREFIX, strlen(META_PREFIX)) == 0) {
+                    snprintf(batch[count++], sizeof(batch[0]), "%s/%.40s", s_base_path, entry->d_name);
+                }
+            }
+            for (int i = 0; i < count; i++) {
+                unlink(batch[i]);
+            }
+        } while (count == 8);
+        closedir(dir);
+        ESP_LOGI(TAG, "Migrated legacy .meta_ files");
+    }
+
+    ESP_LOGI(TAG, "Index loaded: %zu files, %zu journal records", s_count, s_journal_records);
+    return ESP_OK;
+}
+
+void gif_index_unload(void) {
+    for (size_t i = 0; i < s_count; i++) {
+        free(s_items[i].name);
+    }
+    free(s_items);
+    s_items = NULL;
+    s_count = 0;
+    s_capacity = 0;
+    s_journal_records = 0;
+}
+
+/* ---------- queries / updates ---------- */
+
+const gif_storage_entry_t* gif_index_find(const char* name) {
+    gif_index_item_t* item = find_item(name);
+    return item ? &item->info : NULL;
+}
+
+esp_err_t gif_index_put(const char* name, const gif_storage_entry_t* info) {
+    if (!name || !name[0] || strlen(name) > RECORD_MAX_NAME || !info) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!table_put(name, info)) {
+        return ESP_ERR_NO_MEM;
+    }
+    return append_record(RECORD_PUT, name, info);
+}
+
+esp_err_t gif_index_remove(const char* name) {
+    if (!name || !table_remove(name)) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    return append_record(RECORD_DELETE, name, NULL);
+}
+
+esp_err_t gif_index_snapshot(gif_index_item_t** out_items, size_t* out_count) {
+    *out_items = NULL;
+    *out_count = 0;
+    if (s_count == 0) {
+        return ESP_OK;
+    }
+    gif_index_item_t* items = calloc(s_count, sizeof(gif_index_item_t));
+    if (!items) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (size_t i = 0; i < s_count; i++) {
+        items[i].info = s_items[i].info;
+        items[i].name = strdup(s_items[i].name);
+        if (!items[i].name) {
+            gif_index_free_snapshot(items, i);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    *out_items = items;
+    *out_count = s_count;
+    return ESP_OK;
+}
+
+void gif_index_free_snapshot(gif_index_item_t* items, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(items[i].name);
+    }
+    free(items);
+}
+
+/* ---------- eviction ---------- */
+
+typedef struct {
+    size_t index;
+    size_t size;
+    time_t last_used;
+} evict_candidate_t;
+
+static time_t last_used(const gif_storage_entry_t* info) {
+    return info->last_shown ? info->last_shown : info->upload_time;
+}
+
+static int compare_candidates(const void* a, const void* b) {
+    const evict_candidate_t* x = a;
+    const evict_candidate_t* y = b;
+    if (x->last_used != y->last_used) {
+        return x->last_used < y->last_used ? -1 : 1;
+    }
+    // Same age: the bigger file frees more on its own
+    return (x->size < y->size) - (x->size > y->size);
+}
+
+esp_err_t gif_index_plan_eviction(size_t bytes_to_free, gif_storage_evict_plan_t* plan) {
+    memset(plan, 0, sizeof(*plan));
+    if (bytes_to_free == 0) {
+        return ESP_OK;
+    }
+
+    evict_candidate_t* candidates = s_count ? malloc(s_count * sizeof(evict_candidate_t)) : NULL;
+    if (s_count && !candidates) {
+        return ESP_ERR_NO_MEM;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < s_count; i++) {
+        if (!(s_items[i].info.flags & GIF_STORAGE_FLAG_PINNED)) {
+            candidates[count].index = i;
+            candidates[count].size = s_items[i].info.size;
+            candidates[count].last_used = last_used(&s_items[i].info);
+            count++;
+        }
+    }
+    qsort(candidates, count, sizeof(evict_candidate_t), compare_candidates);
+
+    // Take the least recently used prefix that covers the request
+    size_t taken = 0, freed = 0;
+    while (taken < count && freed < bytes_to_free) {
+        freed += candidates[taken++].size;
+    }
+
+    // The last victim may be big enough to make some of the older, smaller
+    // ones unnecessary: spare those, most recently used first
+    size_t victims = taken;
+    for (size_t i = taken > 0 ? taken - 1 : 0; i-- > 0;) {
+        if (freed - candidates[i].size >= bytes_to_free) {
+            freed -= candidates[i].size;
+            candidates[i].size = SIZE_MAX;  // spared
+            victims--;
+        }
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (victims > 0) {
+        plan->victims = calloc(victims, sizeof(gif_storage_victim_t));
+        if (!plan->victims) {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    for (size_t i = 0; ret == ESP_OK && i < taken; i++) {
+        if (candidates[i].size == SIZE_MAX) {
+            continue;
+        }
+        const gif_index_item_t* item = &s_items[candidates[i].index];
+        gif_storage_victim_t* victim = &plan->victims[plan->count];
+        victim->name = strdup(item->name);
+        if (!victim->name) {
+            ret = ESP_ERR_NO_MEM;
+            break;
+        }
+        victim->size = candidates[i].size;
+        victim->last_used = candidates[i].last_used;
+        plan->count++;
+    }
+    free(candidates);
+
+    if (ret != ESP_OK) {
+        gif_index_free_eviction_plan(plan);
+        return ret;
+    }
+    plan->bytes_freed = freed;
+    plan->bytes_short = freed < bytes_to_free ? bytes_to_free - freed : 0;
+    return ESP_OK;
+}
+
+void gif_index_free_eviction_plan(gif_storage_evict_plan_t* plan) {
+    if (!plan) {
+        return;
+    }
+    for (size_t i = 0; i < plan->count; i++) {
+        free(plan->victims[i].name);
+    }
+    free(plan->victims);
+    memset(plan, 0, sizeof(*plan));
+}
@@ -0,0 +1,93 @@
+#ifndef GIF_INDEX_H
+#define GIF_INDEX_H
+
+#include "gif_storage.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief In-RAM index of the files on the storage partition
+ *
+ * Internal to gif_storage.c. Backed by a journal ("<base>/.index"): every
+ * change appends one CRC-protected record, replay stops at the first torn or
+ * corrupt record, and the journal is compacted when it gets long.
+ *
+ * All functions expect the caller to hold the storage lock.
+ */
+
+typedef struct {
+    char* name;
+    gif_storage_entry_t info;
+} gif_index_item_t;
+
+/**
+ * @brief Load the journal and reconcile it with the directory
+ *
+ * Files missing from the index are scanned and added (their legacy
+ * ".meta_<name>" upload time is migrated), entries whose file is gone are
+ * dropped.
+ */
+esp_err_t gif_index_load(const char* base_path);
+void gif_index_unload(void);
+
+/**
+ * @brief Read a file once: size, CRC32, GIF dimensions and frame count
+ */
+esp_err_t gif_index_scan_file(const char* path, gif_storage_entry_t* info);
+
+/**
+ * @brief The same scan over data as it is written, in chunks of any size
+ *
+ * Lets the streaming writer build the entry while appending instead of
+ * reading the file back on commit. Needs no lock.
+ */
+typedef struct {
+    uint32_t crc;
+    size_t total;
+    size_t skip;
+    uint8_t state;
+    uint8_t next;
+    uint8_t image;
+    uint8_t have;
+    uint8_t buf[13];
+    uint16_t width;
+    uint16_t height;
+    uint32_t frame_count;
+} gif_index_scanner_t;
+
+void gif_index_scanner_init(gif_index_scanner_t* scanner);
+void gif_index_scanner_feed(gif_index_scanner_t* scanner, const void* data, size_t size);
+/**
+ * @brief Fill size, CRC32 and the GIF fields; upload_time, last_shown and
+ *        flags are kept from *info
+ */
+void gif_index_scanner_finish(const gif_index_scanner_t* scanner, gif_storage_entry_t* info);
+
+const gif_storage_entry_t* gif_index_find(const char* name);
+esp_err_t gif_index_put(const char* name, const gif_storage_entry_t* info);
+esp_err_t gif_index_remove(const char* name);
+
+/**
+ * @brief Copy all entries, so callers can iterate without holding the lock
+ */
+esp_err_t gif_index_snapshot(gif_index_item_t** out_items, size_t* out_count);
+void gif_index_free_snapshot(gif_index_item_t* items, size_t count);
+
+/**
+ * @brief Choose the files to delete to free bytes_to_free
+ *
+ * Pinned files are never chosen. Candidates are ordered by last use (last
+ * shown, or upload time if never shown) and the oldest prefix covering the
+ * request is taken in one pass; older files made unnecessary by a large
+ * newer victim are then spared. The index is not modified.
+ */
+esp_err_t gif_index_plan_eviction(size_t bytes_to_free, gif_storage_evict_plan_t* plan);
+void gif_index_free_eviction_plan(gif_storage_evict_plan_t* plan);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GIF_INDEX_H
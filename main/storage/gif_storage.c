@@ -1,20 +1,29 @@
 #include "gif_storage.h"
+#include "gif_index.h"
+#include "gif_storage_backend.h"
 #include <esp_log.h>
-#include <esp_spiffs.h>
 #include <esp_heap_caps.h>
+#include <esp_rom_crc.h>
 #include <sys/stat.h>
 #include <dirent.h>
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "sdkconfig.h"
+#if !CONFIG_GIF_STORAGE_BACKEND_LITTLEFS
+#include <esp_partition.h>
+#endif
 
 static const char* TAG = "GifStorage";
 static bool s_initialized = false;
 static gif_storage_progress_callback_t s_progress_callback = NULL;
 static void* s_progress_user_data = NULL;
+static gif_storage_release_callback_t s_release_callback = NULL;
+static void* s_release_user_data = NULL;
 static SemaphoreHandle_t s_storage_mutex = NULL;
 
 static void storage_lock(void) {
@@ -31,6 +40,65 @@ static void storage_unlock(void) {
 
 #define STORAGE_BASE_PATH "/storage"
 #define STORAGE_PARTITION_LABEL "storage"
+#define TEMP_PREFIX ".tmp_"
+
+#ifndef CONFIG_GIF_STORAGE_MAX_FILES
+#define CONFIG_GIF_STORAGE_MAX_FILES 10
+#endif
+
+#if CONFIG_GIF_STORAGE_BACKEND_LITTLEFS
+static const gif_storage_backend_t* s_backend = &gif_storage_backend_littlefs;
+#else
+static const gif_storage_backend_t* s_backend = &gif_storage_backend_spiffs;
+#endif
+
+static void remove_stale_temp_files(void);
+
+#if !CONFIG_GIF_STORAGE_BACKEND_LITTLEFS
+// LittleFS keeps its superblock in the metadata pair at blocks 0 and 1, with
+// the name "littlefs" 8 bytes into the block
+static bool partition_has_littlefs(void) {
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                           STORAGE_PARTITION_LABEL);
+    if (!part) {
+        return false;
+    }
+    for (size_t block = 0; block < 2; block++) {
+        char magic[8];
+        if (esp_partition_read(part, block * 4096 + 8, magic, sizeof(magic)) == ESP_OK &&
+            memcmp(magic, "littlefs", sizeof(magic)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+// The configured backend did not find its filesystem. If the partition holds
+// the other one (GIF_STORAGE_BACKEND changed in an OTA update), formatting
+// would erase the stored images: mount it as it is when that backend is built
+// in, otherwise leave storage unmounted.
+// Returns ESP_OK if mounted, ESP_ERR_INVALID_STATE to not format,
+// ESP_ERR_NOT_FOUND if there is no other filesystem.
+static esp_err_t mount_other_filesystem(void) {
+#if CONFIG_GIF_STORAGE_BACKEND_LITTLEFS
+    // SPIFFS is always built in; with SPIFFS_USE_MAGIC it only mounts its own format
+    if (gif_storage_backend_spiffs.mount(STORAGE_BASE_PATH, STORAGE_PARTITION_LABEL, CONFIG_GIF_STORAGE_MAX_FILES) ==
+        ESP_OK) {
+        ESP_LOGW(TAG, "Partition '%s' holds SPIFFS, not LittleFS: mounting it as SPIFFS to keep the stored files. "
+                 "Erase the partition to switch.", STORAGE_PARTITION_LABEL);
+        s_backend = &gif_storage_backend_spiffs;
+        return ESP_OK;
+    }
+#else
+    if (partition_has_littlefs()) {
+        ESP_LOGE(TAG, "Partition '%s' holds LittleFS, which this firmware is built without: not formatting it. "
+                 "Select GIF_STORAGE_BACKEND_LITTLEFS or erase the partition.", STORAGE_PARTITION_LABEL);
+        return ESP_ERR_INVALID_STATE;
+    }
+#endif
+    return ESP_ERR_NOT_FOUND;
+}
 
 esp_err_t gif_storage_init(void) {
     if (s_initialized) {
@@ -40,43 +108,45 @@ esp_err_t gif_storage_init(void) {
 
     ESP_LOGI(TAG, "Initializing GIF storage...");
 
-    esp_vfs_spiffs_conf_t conf = {
-        .base_path = STORAGE_BASE_PATH,
-        .partition_label = STORAGE_PARTITION_LABEL,
-        .max_files = 10,
-        .format_if_mount_failed = false  // Don't auto-format, require explicit formatting
-    };
-
-    esp_err_t ret = esp_vfs_spiffs_register(&conf);
+    esp_err_t ret = s_backend->mount(STORAGE_BASE_PATH, STORAGE_PARTITION_LABEL, CONFIG_GIF_STORAGE_MAX_FILES);
+    if (ret == ESP_FAIL) {
+        esp_err_t other = mount_other_filesystem();
+        if (other == ESP_ERR_INVALID_STATE) {
+            return other;
+        }
+        if (other == ESP_OK) {
+            ret = ESP_OK;
+        }
+    }
     if (ret != ESP_OK) {
         if (ret == ESP_FAIL) {
-            ESP_LOGW(TAG, "Failed to mount filesystem, formatting...");
+            ESP_LOGW(TAG, "Failed to mount %s filesystem, formatting...", s_backend->name);
             // Format the partition and try again
-            ret = esp_spiffs_format(STORAGE_PARTITION_LABEL);
+            ret = s_backend->format(STORAGE_PARTITION_LABEL);
             if (ret != ESP_OK) {
-                ESP_LOGE(TAG, "Failed to format SPIFFS partition: %s", esp_err_to_name(ret));
+                ESP_LOGE(TAG, "Failed to format %s partition: %s", s_backend->name, esp_err_to_name(ret));
                 return ret;
             }
-            ESP_LOGI(TAG, "SPIFFS partition formatted successfully, retrying mount");
-            ret = esp_vfs_spiffs_register(&conf);
+            ESP_LOGI(TAG, "%s partition formatted successfully, retrying mount", s_backend->name);
+            ret = s_backend->mount(STORAGE_BASE_PATH, STORAGE_PARTITION_LABEL, CONFIG_GIF_STORAGE_MAX_FILES);
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "Failed to mount after format: %s", esp_err_to_name(ret));
                 return ret;
             }
         } else if (ret == ESP_ERR_NOT_FOUND) {
-            ESP_LOGE(TAG, "Failed to find SPIFFS partition '%s'", STORAGE_PARTITION_LABEL);
+            ESP_LOGE(TAG, "Failed to find storage partition '%s'", STORAGE_PARTITION_LABEL);
             return ret;
         } else {
-            ESP_LOGE(TAG, "Failed to initialize SPIFFS (%s)", esp_err_to_name(ret));
+            ESP_LOGE(TAG, "Failed to initialize %s (%s)", s_backend->name, esp_err_to_name(ret));
             return ret;
         }
     }
 
     size_t total = 0, used = 0;
-    ret = esp_spiffs_info(STORAGE_PARTITION_LABEL, &total, &used);
+    ret = s_backend->info(STORAGE_PARTITION_LABEL, &total, &used);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to get SPIFFS partition information (%s)", esp_err_to_name(ret));
-        esp_vfs_spiffs_unregister(STORAGE_PARTITION_LABEL);
+        ESP_LOGE(TAG, "Failed to get %s partition information (%s)", s_backend->name, esp_err_to_name(ret));
+        s_backend->unmount(STORAGE_PARTITION_LABEL);
         return ret;
     }
 
@@ -84,7 +154,12 @@ esp_err_t gif_storage_init(void) {
         s_storage_mutex = xSemaphoreCreateMutex();
     }
 
-    ESP_LOGI(TAG, "GIF storage initialized successfully");
+    remove_stale_temp_files();
+    storage_lock();
+    gif_index_load(STORAGE_BASE_PATH);
+    storage_unlock();
+
+    ESP_LOGI(TAG, "GIF storage initialized successfully (%s)", s_backend->name);
     ESP_LOGI(TAG, "Partition size: total: %d bytes, used: %d bytes", total, used);
     
     s_initialized = true;
@@ -96,12 +171,13 @@ esp_err_t gif_storage_deinit(void) {
         return ESP_OK;
     }
 
-    esp_err_t ret = esp_vfs_spiffs_unregister(STORAGE_PARTITION_LABEL);
+    esp_err_t ret = s_backend->unmount(STORAGE_PARTITION_LABEL);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to unregister SPIFFS (%s)", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to unmount %s (%s)", s_backend->name, esp_err_to_name(ret));
         return ret;
     }
 
+    gif_index_unload();
     if (s_storage_mutex) {
         vSemaphoreDelete(s_storage_mutex);
         s_storage_mutex = NULL;
@@ -179,6 +255,15 @@ esp_err_t gif_storage_read(const char* filename, uint8_t** out_data, size_t* out
         return ESP_ERR_INVALID_ARG;
     }
 
+    // The whole file is in memory anyway, check it against the index
+    gif_storage_entry_t entry;
+    if (gif_storage_get_entry(filename, &entry) == ESP_OK && entry.size == file_size &&
+        esp_rom_crc32_le(0, buffer, file_size) != entry.crc32) {
+        ESP_LOGE(TAG, "Checksum mismatch: %s", filename);
+        heap_caps_free(buffer);
+        return ESP_ERR_INVALID_CRC;
+    }
+
     *out_data = buffer;
     *out_size = file_size;
 
@@ -191,90 +276,245 @@ void gif_storage_set_progress_callback(gif_storage_progress_callback_t callback,
     s_progress_user_data = user_data;
 }
 
-esp_err_t gif_storage_write(const char* filename, const uint8_t* data, size_t size) {
+void gif_storage_set_release_callback(gif_storage_release_callback_t callback, void* user_data) {
+    s_release_callback = callback;
+    s_release_user_data = user_data;
+}
+
+// Let readers of `path` close it; called without the storage lock
+static void release_file(const char* path) {
+    if (s_release_callback) {
+        s_release_callback(path, s_release_user_data);
+    }
+}
+
+struct gif_storage_writer {
+    FILE* file;
+    char tmp_path[64];
+    char dest_path[256];
+    size_t written;
+    size_t expected_size;
+    gif_storage_progress_callback_t progress_callback;
+    void* progress_user_data;
+    // Index entry built from the appended data, so commit does not read the file back
+    gif_index_scanner_t scanner;
+};
+
+static void report_progress(gif_storage_writer_t* writer) {
+    if (writer->progress_callback) {
+        size_t total = writer->expected_size > writer->written ? writer->expected_size : writer->written;
+        writer->progress_callback(writer->written, total, writer->progress_user_data);
+    }
+}
+
+// Remove temp files left behind by a reboot during a write
+static void remove_stale_temp_files(void) {
+    DIR* dir = opendir(STORAGE_BASE_PATH);
+    if (!dir) {
+        return;
+    }
+    char paths[8][64];
+    int count;
+    do {
+        count = 0;
+        rewinddir(dir);
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL && count < 8) {
+            if (strncmp(entry->d_name, TEMP_PREFIX, strlen(TEMP_PREFIX)) == 0) {
+                snprintf(paths[count++], sizeof(paths[0]), "%s/%.40s", STORAGE_BASE_PATH, entry->d_name);
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            ESP_LOGW(TAG, "Removing stale temp file: %s", paths[i]);
+            unlink(paths[i]);
+        }
+    } while (count == 8);
+    closedir(dir);
+}
+
+esp_err_t gif_storage_open_write(const char* filename, size_t expected_size, gif_storage_writer_t** out_writer) {
     if (!s_initialized) {
         ESP_LOGE(TAG, "GIF storage not initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
-    if (!filename || !data || size == 0) {
+    if (!filename || !filename[0] || strchr(filename, '/') || !out_writer) {
         ESP_LOGE(TAG, "Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
+    *out_writer = NULL;
 
-    // Build full path
-    char filepath[256];
-    snprintf(filepath, sizeof(filepath), "%s/%s", STORAGE_BASE_PATH, filename);
-
-    ESP_LOGI(TAG, "Writing file: %s (%zu bytes)", filepath, size);
-
-    // Check available space before writing
-    size_t total, used;
-    esp_err_t space_ret = esp_spiffs_info(STORAGE_PARTITION_LABEL, &total, &used);
-    if (space_ret == ESP_OK) {
+    // Check available space once, instead of failing half way through
+    size_t total = 0, used = 0;
+    if (expected_size > 0 && s_backend->info(STORAGE_PARTITION_LABEL, &total, &used) == ESP_OK) {
         ESP_LOGI(TAG, "Before write - Total: %zu, Used: %zu, Free: %zu", total, used, total - used);
+        if (used + expected_size > total) {
+            ESP_LOGE(TAG, "Not enough space for %s (%zu bytes, %zu free)", filename, expected_size, total - used);
+            return ESP_ERR_NO_MEM;
+        }
     }
 
-    // Open file for writing
+    gif_storage_writer_t* writer = calloc(1, sizeof(gif_storage_writer_t));
+    if (!writer) {
+        return ESP_ERR_NO_MEM;
+    }
+    int len = snprintf(writer->dest_path, sizeof(writer->dest_path), "%s/%s", STORAGE_BASE_PATH, filename);
+    if (len < 0 || (size_t)len >= sizeof(writer->dest_path)) {
+        free(writer);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // Short temp name: SPIFFS object names are limited to CONFIG_SPIFFS_OBJ_NAME_LEN
+    static uint32_t s_temp_seq = 0;
     storage_lock();
-
-    FILE* f = fopen(filepath, "wb");
-    if (!f) {
-        ESP_LOGE(TAG, "Failed to create file: %s (errno: %d)", filepath, errno);
-        storage_unlock();
+    snprintf(writer->tmp_path, sizeof(writer->tmp_path), "%s/" TEMP_PREFIX "%lu", STORAGE_BASE_PATH,
+             (unsigned long)++s_temp_seq);
+    writer->file = fopen(writer->tmp_path, "wb");
+    storage_unlock();
+    if (!writer->file) {
+        ESP_LOGE(TAG, "Failed to create file: %s (errno: %d)", writer->tmp_path, errno);
+        free(writer);
         return ESP_FAIL;
     }
 
-    ESP_LOGI(TAG, "File opened successfully, attempting to write %zu bytes", size);
-    if (s_progress_callback) {
-        s_progress_callback(0, size, s_progress_user_data);
-    }
+    writer->expected_size = expected_size;
+    gif_index_scanner_init(&writer->scanner);
+    writer->progress_callback = s_progress_callback;
+    writer->progress_user_data = s_progress_user_data;
+    ESP_LOGI(TAG, "Writing file: %s (%zu bytes expected)", writer->dest_path, expected_size);
+    report_progress(writer);
 
-    // Write data in chunks to debug
-    size_t written = 0;
-    const size_t chunk_size = 8192;  // Write in 8KB chunks
-    const uint8_t* ptr = data;
+    *out_writer = writer;
+    return ESP_OK;
+}
 
-    while (written < size) {
-        size_t to_write = (size - written > chunk_size) ? chunk_size : (size - written);
-        size_t chunk_written = fwrite(ptr, 1, to_write, f);
+void gif_storage_writer_set_progress_callback(gif_storage_writer_t* writer,
+                                              gif_storage_progress_callback_t callback, void* user_data) {
+    if (writer) {
+        writer->progress_callback = callback;
+        writer->progress_user_data = user_data;
+    }
+}
 
-        if (chunk_written == 0) {
-            ESP_LOGE(TAG, "fwrite returned 0 at offset %zu, ferror=%d, feof=%d, errno=%d", written, ferror(f), feof(f), errno);
-            break;
-        }
+esp_err_t gif_storage_append(gif_storage_writer_t* writer, const void* data, size_t size) {
+    if (!writer || !writer->file || (!data && size > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (size == 0) {
+        return ESP_OK;
+    }
 
-        written += chunk_written;
-        ptr += chunk_written;
+    storage_lock();
+    size_t chunk_written = fwrite(data, 1, size, writer->file);
+    storage_unlock();
+    writer->written += chunk_written;
+    gif_index_scanner_feed(&writer->scanner, data, chunk_written);
 
-        if (s_progress_callback) {
-            s_progress_callback(written, size, s_progress_user_data);
-        }
+    if (chunk_written != size) {
+        ESP_LOGE(TAG, "fwrite failed at offset %zu, ferror=%d, errno=%d", writer->written, ferror(writer->file), errno);
+        return ESP_FAIL;
+    }
+    report_progress(writer);
+    return ESP_OK;
+}
 
-        if (written % (64 * 1024) == 0) {  // Log every 64KB
-            ESP_LOGI(TAG, "Written %zu / %zu bytes", written, size);
-        }
+esp_err_t gif_storage_commit(gif_storage_writer_t* writer) {
+    if (!writer) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    fclose(f);
+    storage_lock();
+    bool ok = writer->file && fclose(writer->file) == 0;
+    writer->file = NULL;
+    storage_unlock();
 
-    if (written != size) {
-        ESP_LOGE(TAG, "Failed to write complete file: %s (wrote %zu of %zu bytes)", filepath, written, size);
-        // Try to remove incomplete file
-        unlink(filepath);
-        if (s_progress_callback) {
-            s_progress_callback(written, size, s_progress_user_data);
+    // Hidden files (download cache blobs etc.) are not listed, so not indexed
+    const char* name = writer->dest_path + strlen(STORAGE_BASE_PATH) + 1;
+    bool indexed = (name[0] != '.');
+    gif_storage_entry_t entry = { .upload_time = time(NULL) };
+    if (indexed) {
+        // A replaced file stays pinned
+        storage_lock();
+        const gif_storage_entry_t* old = gif_index_find(name);
+        if (old) {
+            entry.flags = old->flags;
         }
         storage_unlock();
-        return ESP_FAIL;
+    }
+    if (ok && indexed) {
+        gif_index_scanner_finish(&writer->scanner, &entry);
     }
 
-    ESP_LOGI(TAG, "Successfully wrote file: %s (%zu bytes)", filename, size);
-    if (s_progress_callback) {
-        s_progress_callback(size, size, s_progress_user_data);
+    if (ok) {
+        release_file(writer->dest_path);
+    }
+    storage_lock();
+    if (ok) {
+        ok = gif_storage_replace_file(writer->tmp_path, writer->dest_path) == ESP_OK;
+    }
+    if (!ok) {
+        unlink(writer->tmp_path);
+        if (indexed) {
+            // The old file may be gone too (unlinked before the rename failed)
+            struct stat st;
+            if (stat(writer->dest_path, &st) != 0) {
+                gif_index_remove(name);
+            }
+        }
+    } else if (indexed) {
+        gif_index_put(name, &entry);
     }
     storage_unlock();
-    return ESP_OK;
+
+    esp_err_t ret = ESP_OK;
+    if (ok) {
+        ESP_LOGI(TAG, "Successfully wrote file: %s (%zu bytes)", writer->dest_path, writer->written);
+        writer->expected_size = writer->written;
+        report_progress(writer);
+    } else {
+        ESP_LOGE(TAG, "Failed to commit file: %s (errno: %d)", writer->dest_path, errno);
+        ret = ESP_FAIL;
+    }
+    free(writer);
+    return ret;
+}
+
+void gif_storage_abort(gif_storage_writer_t* writer) {
+    if (!writer) {
+        return;
+    }
+    storage_lock();
+    if (writer->file) {
+        fclose(writer->file);
+    }
+    unlink(writer->tmp_path);
+    storage_unlock();
+    ESP_LOGW(TAG, "Aborted write: %s (%zu bytes written)", writer->dest_path, writer->written);
+    free(writer);
+}
+
+esp_err_t gif_storage_write(const char* filename, const uint8_t* data, size_t size) {
+    if (!filename || !data || size == 0) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    gif_storage_writer_t* writer = NULL;
+    esp_err_t ret = gif_storage_open_write(filename, size, &writer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Write in 8KB chunks so progress is reported along the way
+    const size_t chunk_size = 8192;
+    for (size_t offset = 0; offset < size; offset += chunk_size) {
+        size_t to_write = (size - offset > chunk_size) ? chunk_size : (size - offset);
+        ret = gif_storage_append(writer, data + offset, to_write);
+        if (ret != ESP_OK) {
+            gif_storage_abort(writer);
+            return ret;
+        }
+    }
+    return gif_storage_commit(writer);
 }
 
 bool gif_storage_exists(const char* filename) {
@@ -282,6 +522,13 @@ bool gif_storage_exists(const char* filename) {
         return false;
     }
 
+    if (filename[0] != '.') {
+        storage_lock();
+        bool found = gif_index_find(filename) != NULL;
+        storage_unlock();
+        return found;
+    }
+
     char filepath[256];
     snprintf(filepath, sizeof(filepath), "%s/%s", STORAGE_BASE_PATH, filename);
 
@@ -292,6 +539,22 @@ bool gif_storage_exists(const char* filename) {
     return (ret == 0);
 }
 
+esp_err_t gif_storage_get_path(const char* filename, char* out_path, size_t out_size) {
+    if (!filename || !out_path || out_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int len = snprintf(out_path, out_size, "%s/%s", STORAGE_BASE_PATH, filename);
+    if (len < 0 || (size_t)len >= out_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    return gif_storage_exists(filename) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
 esp_err_t gif_storage_list(gif_storage_list_callback_t callback, void* user_data) {
     if (!s_initialized) {
         ESP_LOGE(TAG, "GIF storage not initialized");
@@ -303,37 +566,39 @@ esp_err_t gif_storage_list(gif_storage_list_callback_t callback, void* user_data
         return ESP_ERR_INVALID_ARG;
     }
 
-    DIR* dir = opendir(STORAGE_BASE_PATH);
-    if (!dir) {
-        ESP_LOGE(TAG, "Failed to open storage directory");
-        return ESP_FAIL;
+    // Walk a copy of the index, so callbacks may call back into gif_storage
+    gif_index_item_t* items = NULL;
+    size_t count = 0;
+    storage_lock();
+    esp_err_t ret = gif_index_snapshot(&items, &count);
+    storage_unlock();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to list files");
+        return ret;
     }
 
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL) {
-        // Skip directories and hidden files
-        if (entry->d_type == DT_DIR || entry->d_name[0] == '.') {
-            continue;
-        }
+    for (size_t i = 0; i < count; i++) {
+        callback(items[i].name, items[i].info.size, items[i].info.upload_time, user_data);
+    }
+    gif_index_free_snapshot(items, count);
+    return ESP_OK;
+}
 
-        // Get file size (use larger buffer to avoid truncation warning)
-        char filepath[512];
-        snprintf(filepath, sizeof(filepath), "%s/%s", STORAGE_BASE_PATH, entry->d_name);
-        struct stat st;
-        storage_lock();
-        int stat_res = stat(filepath, &st);
-        storage_unlock();
-        if (stat_res == 0) {
-            time_t upload_time = st.st_mtime;
-            if (gif_storage_get_upload_time(entry->d_name, &upload_time) != ESP_OK) {
-                upload_time = st.st_mtime;
-            }
-            callback(entry->d_name, st.st_size, upload_time, user_data);
-        }
+esp_err_t gif_storage_get_entry(const char* filename, gif_storage_entry_t* out_entry) {
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!filename || !out_entry) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    closedir(dir);
-    return ESP_OK;
+    storage_lock();
+    const gif_storage_entry_t* entry = gif_index_find(filename);
+    if (entry) {
+        *out_entry = *entry;
+    }
+    storage_unlock();
+    return entry ? ESP_OK : ESP_ERR_NOT_FOUND;
 }
 
 esp_err_t gif_storage_info(size_t* total_bytes, size_t* used_bytes) {
@@ -342,7 +607,18 @@ esp_err_t gif_storage_info(size_t* total_bytes, size_t* used_bytes) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    return esp_spiffs_info(STORAGE_PARTITION_LABEL, total_bytes, used_bytes);
+    return s_backend->info(STORAGE_PARTITION_LABEL, total_bytes, used_bytes);
+}
+
+esp_err_t gif_storage_replace_file(const char* src_path, const char* dest_path) {
+    if (!src_path || !dest_path) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_backend->rename_replaces) {
+        // SPIFFS rename does not replace an existing file
+        unlink(dest_path);
+    }
+    return rename(src_path, dest_path) == 0 ? ESP_OK : ESP_FAIL;
 }
 
 esp_err_t gif_storage_delete(const char* filename) {
@@ -356,21 +632,21 @@ esp_err_t gif_storage_delete(const char* filename) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    storage_lock();
-
     char filepath[256];
     snprintf(filepath, sizeof(filepath), "%s/%s", STORAGE_BASE_PATH, filename);
+    release_file(filepath);
+
+    storage_lock();
 
     if (unlink(filepath) != 0) {
         ESP_LOGE(TAG, "Failed to delete file: %s", filename);
         storage_unlock();
         return ESP_FAIL;
     }
+    gif_index_remove(filename);
 
     storage_unlock();
 
-    gif_storage_set_upload_time(filename, 0);
-
     ESP_LOGI(TAG, "Deleted file: %s", filename);
     return ESP_OK;
 }
@@ -379,70 +655,174 @@ esp_err_t gif_storage_get_info(size_t* total_bytes, size_t* used_bytes) {
     return gif_storage_info(total_bytes, used_bytes);
 }
 
-static void build_meta_path(const char* filename, char* buffer, size_t buffer_size) {
-    snprintf(buffer, buffer_size, "%s/.meta_%s", STORAGE_BASE_PATH, filename);
-}
-
 esp_err_t gif_storage_set_upload_time(const char* filename, time_t upload_time) {
     if (!s_initialized || !filename) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    char meta_path[256];
-    build_meta_path(filename, meta_path, sizeof(meta_path));
+    storage_lock();
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    const gif_storage_entry_t* entry = gif_index_find(filename);
+    if (entry) {
+        gif_storage_entry_t updated = *entry;
+        updated.upload_time = upload_time;
+        ret = gif_index_put(filename, &updated);
+    }
+    storage_unlock();
+    return ret;
+}
 
-    if (upload_time <= 0) {
-        storage_lock();
-        unlink(meta_path);
-        storage_unlock();
+esp_err_t gif_storage_get_upload_time(const char* filename, time_t* upload_time) {
+    if (!s_initialized || !filename || !upload_time) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    gif_storage_entry_t entry;
+    esp_err_t ret = gif_storage_get_entry(filename, &entry);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    *upload_time = entry.upload_time;
+    return ESP_OK;
+}
+
+// Before this the clock has not been set (see the check in lvgl_display.cc)
+#define CLOCK_VALID_AFTER 1735689600  // 2025-01-01
+
+esp_err_t gif_storage_mark_shown(const char* filename) {
+    if (!s_initialized || !filename) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    time_t now = time(NULL);
+    if (now < CLOCK_VALID_AFTER) {
         return ESP_OK;
     }
 
     storage_lock();
-    FILE* f = fopen(meta_path, "wb");
-    if (!f) {
-        ESP_LOGW(TAG, "Failed to open meta file: %s", meta_path);
-        storage_unlock();
-        return ESP_FAIL;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    const gif_storage_entry_t* entry = gif_index_find(filename);
+    if (entry) {
+        ret = ESP_OK;
+        if (now - entry->last_shown >= GIF_STORAGE_SHOWN_RESOLUTION_S) {
+            gif_storage_entry_t updated = *entry;
+            updated.last_shown = now;
+            ret = gif_index_put(filename, &updated);
+        }
     }
+    storage_unlock();
+    return ret;
+}
 
-    if (fwrite(&upload_time, sizeof(upload_time), 1, f) != 1) {
-        ESP_LOGW(TAG, "Failed to write meta file: %s", meta_path);
-        fclose(f);
-        unlink(meta_path);
-        storage_unlock();
-        return ESP_FAIL;
+esp_err_t gif_storage_set_pinned(const char* filename, bool pinned) {
+    if (!s_initialized || !filename) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    fclose(f);
+    storage_lock();
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    const gif_storage_entry_t* entry = gif_index_find(filename);
+    if (entry) {
+        gif_storage_entry_t updated = *entry;
+        if (pinned) {
+            updated.flags |= GIF_STORAGE_FLAG_PINNED;
+        } else {
+            updated.flags &= ~GIF_STORAGE_FLAG_PINNED;
+        }
+        ret = (updated.flags == entry->flags) ? ESP_OK : gif_index_put(filename, &updated);
+    }
     storage_unlock();
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "%s %s", pinned ? "Pinned" : "Unpinned", filename);
+    }
+    return ret;
+}
+
+// Bytes still to free for bytes_needed to be available; caller holds the lock
+static esp_err_t bytes_to_free(size_t bytes_needed, size_t* out_bytes) {
+    size_t total = 0, used = 0;
+    esp_err_t ret = s_backend->info(STORAGE_PARTITION_LABEL, &total, &used);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    size_t free_bytes = used < total ? total - used : 0;
+    *out_bytes = bytes_needed > free_bytes ? bytes_needed - free_bytes : 0;
     return ESP_OK;
 }
 
-esp_err_t gif_storage_get_upload_time(const char* filename, time_t* upload_time) {
-    if (!s_initialized || !filename || !upload_time) {
+esp_err_t gif_storage_plan_eviction(size_t bytes_needed, gif_storage_evict_plan_t* out_plan) {
+    if (!out_plan) {
         return ESP_ERR_INVALID_ARG;
     }
+    memset(out_plan, 0, sizeof(*out_plan));
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    char meta_path[256];
-    build_meta_path(filename, meta_path, sizeof(meta_path));
+    storage_lock();
+    size_t bytes = 0;
+    esp_err_t ret = bytes_to_free(bytes_needed, &bytes);
+    if (ret == ESP_OK) {
+        ret = gif_index_plan_eviction(bytes, out_plan);
+    }
+    storage_unlock();
+    return ret;
+}
 
+esp_err_t gif_storage_evict(size_t bytes_needed, gif_storage_evict_plan_t* out_plan) {
+    if (out_plan) {
+        memset(out_plan, 0, sizeof(*out_plan));
+    }
+    if (!s_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    gif_storage_evict_plan_t plan;
     storage_lock();
-    FILE* f = fopen(meta_path, "rb");
-    if (!f) {
+    size_t bytes = 0;
+    esp_err_t ret = bytes_to_free(bytes_needed, &bytes);
+    if (ret == ESP_OK) {
+        ret = gif_index_plan_eviction(bytes, &plan);
+    }
+    if (ret != ESP_OK) {
         storage_unlock();
-        return ESP_FAIL;
+        ESP_LOGE(TAG, "Failed to plan eviction: %s", esp_err_to_name(ret));
+        return ret;
     }
 
-    time_t stored_time = 0;
-    size_t read_items = fread(&stored_time, sizeof(stored_time), 1, f);
-    fclose(f);
+    char filepath[256];
+    if (s_release_callback && plan.count > 0) {
+        storage_unlock();
+        for (size_t i = 0; i < plan.count; i++) {
+            snprintf(filepath, sizeof(filepath), "%s/%s", STORAGE_BASE_PATH, plan.victims[i].name);
+            release_file(filepath);
+        }
+        storage_lock();
+    }
+    for (size_t i = 0; i < plan.count; i++) {
+        snprintf(filepath, sizeof(filepath), "%s/%s", STORAGE_BASE_PATH, plan.victims[i].name);
+        if (unlink(filepath) != 0) {
+            ESP_LOGW(TAG, "Failed to evict %s (errno: %d)", plan.victims[i].name, errno);
+            continue;
+        }
+        gif_index_remove(plan.victims[i].name);
+        ESP_LOGI(TAG, "Evicted %s (%zu bytes, last used %lld)", plan.victims[i].name, plan.victims[i].size,
+                 (long long)plan.victims[i].last_used);
+    }
+    ret = bytes_to_free(bytes_needed, &bytes);
     storage_unlock();
 
-    if (read_items != 1) {
-        return ESP_FAIL;
+    if (ret == ESP_OK && bytes > 0) {
+        ESP_LOGW(TAG, "Still %zu bytes short of %zu free after evicting %zu files", bytes, bytes_needed, plan.count);
+        ret = ESP_ERR_NO_MEM;
     }
+    if (out_plan) {
+        *out_plan = plan;
+    } else {
+        gif_index_free_eviction_plan(&plan);
+    }
+    return ret;
+}
 
-    *upload_time = stored_time;
-    return ESP_OK;
+void gif_storage_free_evict_plan(gif_storage_evict_plan_t* plan) {
+    gif_index_free_eviction_plan(plan);
 }
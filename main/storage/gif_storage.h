@@ -14,7 +14,8 @@ extern "C" {
 /**
  * @brief Initialize the GIF storage system
  * 
- * This function mounts the SPIFFS partition for GIF storage.
+ * This function mounts the storage partition with the configured backend
+ * (CONFIG_GIF_STORAGE_BACKEND_SPIFFS / _LITTLEFS).
  * 
  * @return ESP_OK on success, error code otherwise
  */
@@ -37,6 +38,7 @@ esp_err_t gif_storage_deinit(void);
  * @return ESP_OK on success, error code otherwise
  * 
  * @note The caller is responsible for freeing the allocated buffer using heap_caps_free()
+ * @note Returns ESP_ERR_INVALID_CRC if the data does not match the index checksum
  */
 esp_err_t gif_storage_read(const char* filename, uint8_t** out_data, size_t* out_size);
 
@@ -52,6 +54,66 @@ esp_err_t gif_storage_read(const char* filename, uint8_t** out_data, size_t* out
 esp_err_t gif_storage_write(const char* filename, const uint8_t* data, size_t size);
 typedef void (*gif_storage_progress_callback_t)(size_t written, size_t total, void* user_data);
 void gif_storage_set_progress_callback(gif_storage_progress_callback_t callback, void* user_data);
+
+/**
+ * @brief Streaming writer
+ *
+ * Data goes to a hidden temp file which replaces the destination on
+ * gif_storage_commit(), so readers never see a partially written file and a
+ * failed write leaves any previous version in place. Temp files left by a
+ * reboot are removed by gif_storage_init().
+ */
+typedef struct gif_storage_writer gif_storage_writer_t;
+
+/**
+ * @brief Start writing a file
+ *
+ * @param filename Name of the file (e.g., "image.gif")
+ * @param expected_size Expected size, checked against free space up front
+ *                      and used as progress total; 0 if unknown
+ * @param out_writer Receives the writer
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the partition is too full
+ *
+ * @note The writer reports progress through the callback set with
+ *       gif_storage_set_progress_callback() at the time it is opened
+ */
+esp_err_t gif_storage_open_write(const char* filename, size_t expected_size, gif_storage_writer_t** out_writer);
+
+/**
+ * @brief Override the progress callback of one writer
+ */
+void gif_storage_writer_set_progress_callback(gif_storage_writer_t* writer,
+                                              gif_storage_progress_callback_t callback, void* user_data);
+
+/**
+ * @brief Append data to the file
+ *
+ * @note On failure the writer stays open; call gif_storage_abort()
+ */
+esp_err_t gif_storage_append(gif_storage_writer_t* writer, const void* data, size_t size);
+
+/**
+ * @brief Finish the file and move it into place; frees the writer
+ */
+esp_err_t gif_storage_commit(gif_storage_writer_t* writer);
+
+/**
+ * @brief Discard the file; frees the writer
+ */
+void gif_storage_abort(gif_storage_writer_t* writer);
+
+/**
+ * @brief Called before a stored file is deleted or replaced
+ *
+ * Gets the full VFS path (e.g. "/storage/think.gif") on the caller's task,
+ * without the storage lock held, so a reader that keeps the file open (the
+ * display streaming a GIF) can close it before it goes away. Covers
+ * gif_storage_delete(), gif_storage_evict() and gif_storage_commit().
+ */
+typedef void (*gif_storage_release_callback_t)(const char* path, void* user_data);
+void gif_storage_set_release_callback(gif_storage_release_callback_t callback, void* user_data);
+
 esp_err_t gif_storage_delete(const char* filename);
 esp_err_t gif_storage_get_info(size_t* total_bytes, size_t* used_bytes);
 
@@ -63,9 +125,27 @@ esp_err_t gif_storage_get_info(size_t* total_bytes, size_t* used_bytes);
  */
 bool gif_storage_exists(const char* filename);
 
+/**
+ * @brief Build the VFS path of a stored GIF (e.g. "/storage/think.gif")
+ *
+ * Lets the display stream a file (fopen / lv_fs) instead of loading it
+ * into PSRAM with gif_storage_read().
+ *
+ * @param filename Name of the GIF file
+ * @param out_path Buffer to receive the path
+ * @param out_size Size of out_path
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the file does not exist,
+ *         ESP_ERR_INVALID_SIZE if the path does not fit
+ */
+esp_err_t gif_storage_get_path(const char* filename, char* out_path, size_t out_size);
+
 /**
  * @brief List all GIF files in storage
  * 
+ * Served from the in-RAM index, no filesystem access. The callback runs on
+ * a snapshot without the storage lock held, so it may call other
+ * gif_storage functions (e.g. delete the file it is given).
+ * 
  * @param callback Function to call for each file found
  * @param user_data User data to pass to callback
  * 
@@ -76,6 +156,82 @@ esp_err_t gif_storage_list(gif_storage_list_callback_t callback, void* user_data
 esp_err_t gif_storage_set_upload_time(const char* filename, time_t upload_time);
 esp_err_t gif_storage_get_upload_time(const char* filename, time_t* upload_time);
 
+/**
+ * @brief Index entry of a stored file
+ *
+ * Filled when the file is written (or first seen at boot) and kept in the
+ * index, so none of these needs the file to be opened.
+ */
+typedef struct {
+    size_t size;
+    time_t upload_time;
+    uint16_t width;         // logical screen size, 0 if not a GIF
+    uint16_t height;
+    uint32_t frame_count;
+    uint32_t crc32;         // esp_rom_crc32_le over the whole file
+    time_t last_shown;      // 0 if never shown, see gif_storage_mark_shown()
+    uint32_t flags;         // GIF_STORAGE_FLAG_*
+} gif_storage_entry_t;
+
+#define GIF_STORAGE_FLAG_PINNED 0x01    // never evicted
+
+/**
+ * @brief Look up the index entry of a file
+ * @return ESP_OK, or ESP_ERR_NOT_FOUND if the file is not stored
+ */
+esp_err_t gif_storage_get_entry(const char* filename, gif_storage_entry_t* out_entry);
+
+/**
+ * @brief Record that a file was put on screen
+ *
+ * Feeds the eviction order. Kept with a resolution of
+ * GIF_STORAGE_SHOWN_RESOLUTION_S so a running slideshow does not write the
+ * index on every frame change; ignored while the system clock is not set.
+ */
+#define GIF_STORAGE_SHOWN_RESOLUTION_S 600
+esp_err_t gif_storage_mark_shown(const char* filename);
+
+/**
+ * @brief Pin a file (or unpin it); pinned files are never evicted
+ */
+esp_err_t gif_storage_set_pinned(const char* filename, bool pinned);
+
+typedef struct {
+    char* name;
+    size_t size;
+    time_t last_used;       // last_shown, or upload_time if never shown
+} gif_storage_victim_t;
+
+typedef struct {
+    gif_storage_victim_t* victims;  // least recently used first
+    size_t count;
+    size_t bytes_freed;     // sum of the victims' sizes
+    size_t bytes_short;     // still missing after evicting all victims (the rest is pinned)
+} gif_storage_evict_plan_t;
+
+/**
+ * @brief Work out which files gif_storage_evict() would delete (dry run)
+ *
+ * @param bytes_needed Free space wanted on the partition; files are only
+ *                     chosen for the part that is not free already
+ * @param out_plan Receives the plan, free it with gif_storage_free_evict_plan()
+ */
+esp_err_t gif_storage_plan_eviction(size_t bytes_needed, gif_storage_evict_plan_t* out_plan);
+
+/**
+ * @brief Delete least recently used, unpinned files until bytes_needed are free
+ *
+ * The victim set is chosen up front from the index sizes, which never
+ * exceed what SPIFFS or LittleFS release for a file, so the partition is
+ * not re-queried between deletions.
+ *
+ * @param out_plan Optional, receives the files that were deleted
+ * @return ESP_OK if the space is now free, ESP_ERR_NO_MEM if pinned files
+ *         keep it from being freed
+ */
+esp_err_t gif_storage_evict(size_t bytes_needed, gif_storage_evict_plan_t* out_plan);
+void gif_storage_free_evict_plan(gif_storage_evict_plan_t* plan);
+
 /**
  * @brief Get storage information
  * 
@@ -86,6 +242,15 @@ esp_err_t gif_storage_get_upload_time(const char* filename, time_t* upload_time)
  */
 esp_err_t gif_storage_info(size_t* total_bytes, size_t* used_bytes);
 
+/**
+ * @brief Move src_path over dest_path (full VFS paths)
+ *
+ * Atomic on backends whose rename replaces the destination (LittleFS); on
+ * SPIFFS the destination is unlinked first. Used to commit files written
+ * under a temp name.
+ */
+esp_err_t gif_storage_replace_file(const char* src_path, const char* dest_path);
+
 #ifdef __cplusplus
 }
 
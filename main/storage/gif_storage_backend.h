@@ -0,0 +1,45 @@
+#ifndef GIF_STORAGE_BACKEND_H
+#define GIF_STORAGE_BACKEND_H
+
+#include <esp_err.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Filesystem behind the gif_storage API
+ *
+ * The implementation is chosen with CONFIG_GIF_STORAGE_BACKEND_* (boards can
+ * set it through sdkconfig_append). Once mounted, files are accessed through
+ * the VFS, so only mounting and partition queries differ per backend.
+ */
+typedef struct {
+    const char* name;
+
+    /**
+     * @return ESP_OK, ESP_FAIL if the partition holds no valid filesystem
+     *         (caller formats and retries), other errors are fatal
+     */
+    esp_err_t (*mount)(const char* base_path, const char* partition_label, size_t max_files);
+    esp_err_t (*unmount)(const char* partition_label);
+    esp_err_t (*format)(const char* partition_label);
+    esp_err_t (*info)(const char* partition_label, size_t* total_bytes, size_t* used_bytes);
+
+    // rename() atomically replaces an existing destination (SPIFFS fails instead)
+    bool rename_replaces;
+} gif_storage_backend_t;
+
+extern const gif_storage_backend_t gif_storage_backend_spiffs;
+#if CONFIG_GIF_STORAGE_BACKEND_LITTLEFS
+extern const gif_storage_backend_t gif_storage_backend_littlefs;
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GIF_STORAGE_BACKEND_H
@@ -0,0 +1,246 @@
+#include "gif_storage_bench.h"
+#include "gif_storage.h"
+#include "sdkconfig.h"
+
+#if CONFIG_GIF_STORAGE_BENCHMARK
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+#include <esp_spi_flash_counters.h>
+#endif
+
+static const char* TAG = "GifStorageBench";
+
+#define BENCH_DIR "/storage"
+#define BENCH_PREFIX ".bn_"
+#define BENCH_TMP BENCH_DIR "/" BENCH_PREFIX "tmp"
+
+// Workload shaped like the upload server: GIFs of 16-256 KB written in the
+// 4 KB chunks httpd_req_recv delivers, oldest files evicted when space runs out
+#define BENCH_UPLOADS 60
+#define BENCH_CHUNK_SIZE 4096
+#define BENCH_MIN_FILE (16 * 1024)
+#define BENCH_MAX_FILE (256 * 1024)
+#define BENCH_RESERVE (64 * 1024)
+#define BENCH_LIST_EVERY 5
+#define BENCH_MAX_FILES 64
+
+typedef struct {
+    uint32_t* samples;
+    size_t count;
+    size_t capacity;
+} latency_t;
+
+static void latency_add(latency_t* l, uint32_t us) {
+    if (l->count < l->capacity) {
+        l->samples[l->count++] = us;
+    }
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void latency_report(const char* name, latency_t* l) {
+    if (l->count == 0) {
+        return;
+    }
+    qsort(l->samples, l->count, sizeof(uint32_t), compare_u32);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < l->count; i++) {
+        sum += l->samples[i];
+    }
+    ESP_LOGI(TAG, "%-8s n=%-5u avg=%-7lu p50=%-7lu p99=%-7lu max=%lu us", name, (unsigned)l->count,
+             (unsigned long)(sum / l->count), (unsigned long)l->samples[l->count / 2],
+             (unsigned long)l->samples[(l->count * 99) / 100], (unsigned long)l->samples[l->count - 1]);
+}
+
+static bool latency_init(latency_t* l, size_t capacity) {
+    l->samples = heap_caps_malloc(capacity * sizeof(uint32_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!l->samples) {
+        l->samples = malloc(capacity * sizeof(uint32_t));
+    }
+    l->count = 0;
+    l->capacity = l->samples ? capacity : 0;
+    return l->samples != NULL;
+}
+
+static uint32_t s_rng = 0x12345678;
+
+static uint32_t next_random(void) {
+    // xorshift32: same workload on every run and backend
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void bench_path(char* buffer, size_t size, int id) {
+    snprintf(buffer, size, BENCH_DIR "/" BENCH_PREFIX "%03d", id);
+}
+
+// Directory walk + stat of every entry, what listing cost before the index
+static void list_all(void) {
+    DIR* dir = opendir(BENCH_DIR);
+    if (!dir) {
+        return;
+    }
+    struct dirent* entry;
+    char path[300];
+    while ((entry = readdir(dir)) != NULL) {
+        struct stat st;
+        snprintf(path, sizeof(path), BENCH_DIR "/%s", entry->d_name);
+        stat(path, &st);
+    }
+    closedir(dir);
+}
+
+static size_t free_bytes(void) {
+    size_t total = 0, used = 0;
+    if (gif_storage_info(&total, &used) != ESP_OK || used > total) {
+        return 0;
+    }
+    return total - used;
+}
+
+void gif_storage_run_benchmark(void) {
+    size_t total = 0, used = 0;
+    if (gif_storage_info(&total, &used) != ESP_OK) {
+        ESP_LOGE(TAG, "Storage not mounted");
+        return;
+    }
+
+    latency_t chunk_lat = {0}, commit_lat = {0}, delete_lat = {0}, list_lat = {0};
+    uint8_t* chunk = malloc(BENCH_CHUNK_SIZE);
+    bool ok = chunk && latency_init(&chunk_lat, BENCH_UPLOADS * (BENCH_MAX_FILE / BENCH_CHUNK_SIZE)) &&
+              latency_init(&commit_lat, BENCH_UPLOADS) &&
+              latency_init(&delete_lat, BENCH_UPLOADS + BENCH_MAX_FILES) &&
+              latency_init(&list_lat, BENCH_UPLOADS / BENCH_LIST_EVERY + 1);
+    if (!ok) {
+        ESP_LOGE(TAG, "Out of memory");
+        goto cleanup;
+    }
+    for (size_t i = 0; i < BENCH_CHUNK_SIZE; i++) {
+        chunk[i] = (uint8_t)next_random();
+    }
+
+    // Files of an interrupted run
+    char path[64];
+    for (int n = 0; n < BENCH_UPLOADS; n++) {
+        bench_path(path, sizeof(path), n);
+        unlink(path);
+    }
+    unlink(BENCH_TMP);
+    ESP_LOGI(TAG, "Running on partition: %u bytes, %u used", (unsigned)total, (unsigned)used);
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+    esp_flash_reset_counters();
+#endif
+
+    int live[BENCH_MAX_FILES];  // FIFO of file ids on flash
+    int live_head = 0, live_count = 0;
+    uint64_t bytes_written = 0;
+    int64_t start = esp_timer_get_time();
+
+    for (int n = 0; n < BENCH_UPLOADS; n++) {
+        size_t size = BENCH_MIN_FILE + next_random() % (BENCH_MAX_FILE - BENCH_MIN_FILE);
+
+        // Evict oldest first until the upload fits
+        while (live_count > 0 && (free_bytes() < size + BENCH_RESERVE || live_count == BENCH_MAX_FILES)) {
+            bench_path(path, sizeof(path), live[live_head]);
+            int64_t t = esp_timer_get_time();
+            unlink(path);
+            latency_add(&delete_lat, esp_timer_get_time() - t);
+            live_head = (live_head + 1) % BENCH_MAX_FILES;
+            live_count--;
+        }
+        if (free_bytes() < size + BENCH_RESERVE) {
+            ESP_LOGW(TAG, "Partition too full, stopping after %d uploads", n);
+            break;
+        }
+
+        FILE* f = fopen(BENCH_TMP, "wb");
+        if (!f) {
+            ESP_LOGE(TAG, "Failed to create %s", BENCH_TMP);
+            break;
+        }
+        size_t written = 0;
+        while (written < size) {
+            size_t len = size - written < BENCH_CHUNK_SIZE ? size - written : BENCH_CHUNK_SIZE;
+            int64_t t = esp_timer_get_time();
+            size_t w = fwrite(chunk, 1, len, f);
+            latency_add(&chunk_lat, esp_timer_get_time() - t);
+            if (w != len) {
+                break;
+            }
+            written += len;
+        }
+
+        int64_t t = esp_timer_get_time();
+        bool committed = (fclose(f) == 0) && written == size;
+        bench_path(path, sizeof(path), n);
+        committed = committed && gif_storage_replace_file(BENCH_TMP, path) == ESP_OK;
+        latency_add(&commit_lat, esp_timer_get_time() - t);
+        if (!committed) {
+            ESP_LOGE(TAG, "Write failed after %u bytes", (unsigned)written);
+            unlink(BENCH_TMP);
+            break;
+        }
+        bytes_written += size;
+        live[(live_head + live_count) % BENCH_MAX_FILES] = n;
+        live_count++;
+
+        if (n % BENCH_LIST_EVERY == 0) {
+            t = esp_timer_get_time();
+            list_all();
+            latency_add(&list_lat, esp_timer_get_time() - t);
+        }
+    }
+
+    int64_t elapsed_us = esp_timer_get_time() - start;
+    ESP_LOGI(TAG, "Wrote %llu bytes in %lld ms: %llu KB/s", (unsigned long long)bytes_written,
+             (long long)(elapsed_us / 1000),
+             elapsed_us > 0 ? (unsigned long long)(bytes_written * 1000000 / elapsed_us / 1024) : 0ULL);
+    latency_report("write", &chunk_lat);
+    latency_report("commit", &commit_lat);
+    latency_report("delete", &delete_lat);
+    latency_report("list", &list_lat);
+
+#if CONFIG_SPI_FLASH_ENABLE_COUNTERS
+    const esp_flash_counters_t* counters = esp_flash_get_counters();
+    ESP_LOGI(TAG, "Flash: %lu erases (%lu KB), %lu KB programmed, write amplification %.2f",
+             (unsigned long)counters->erase.count, (unsigned long)(counters->erase.bytes / 1024),
+             (unsigned long)(counters->write.bytes / 1024),
+             bytes_written ? (double)counters->write.bytes / bytes_written : 0.0);
+#endif
+
+    // Leave nothing behind
+    while (live_count > 0) {
+        bench_path(path, sizeof(path), live[live_head]);
+        unlink(path);
+        live_head = (live_head + 1) % BENCH_MAX_FILES;
+        live_count--;
+    }
+
+cleanup:
+    free(chunk);
+    free(chunk_lat.samples);
+    free(commit_lat.samples);
+    free(delete_lat.samples);
+    free(list_lat.samples);
+}
+
+#else
+
+void gif_storage_run_benchmark(void) {
+}
+
+#endif // CONFIG_GIF_STORAGE_BENCHMARK
@@ -0,0 +1,26 @@
+#ifndef GIF_STORAGE_BENCH_H
+#define GIF_STORAGE_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Replay an upload / list / delete workload on the storage partition
+ *
+ * Logs throughput, latency percentiles and flash wear (erase count and
+ * write amplification) for the configured backend. Build once per
+ * CONFIG_GIF_STORAGE_BACKEND_* to compare. Runs on the live /storage
+ * partition: it only uses hidden ".bn_*" files and removes them afterwards,
+ * but writes several MB per boot. tests/host/storage runs the same workload
+ * on the host against filesystem images.
+ *
+ * @note Requires gif_storage_init(); enabled with CONFIG_GIF_STORAGE_BENCHMARK
+ */
+void gif_storage_run_benchmark(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GIF_STORAGE_BENCH_H
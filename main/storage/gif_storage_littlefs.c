@@ -0,0 +1,42 @@
+#include "gif_storage_backend.h"
+#include "sdkconfig.h"
+
+#if CONFIG_GIF_STORAGE_BACKEND_LITTLEFS
+
+#include <esp_littlefs.h>
+
+static esp_err_t littlefs_mount(const char* base_path, const char* partition_label, size_t max_files) {
+    // LittleFS has no open file limit to configure
+    (void)max_files;
+    esp_vfs_littlefs_conf_t conf = {
+        .base_path = base_path,
+        .partition_label = partition_label,
+        .format_if_mount_failed = false,
+        .dont_mount = false,
+    };
+    return esp_vfs_littlefs_register(&conf);
+}
+
+static esp_err_t littlefs_unmount(const char* partition_label) {
+    return esp_vfs_littlefs_unregister(partition_label);
+}
+
+static esp_err_t littlefs_format(const char* partition_label) {
+    return esp_littlefs_format(partition_label);
+}
+
+static esp_err_t littlefs_info(const char* partition_label, size_t* total_bytes, size_t* used_bytes) {
+    return esp_littlefs_info(partition_label, total_bytes, used_bytes);
+}
+
+const gif_storage_backend_t gif_storage_backend_littlefs = {
+    .name = "LittleFS",
+    .mount = littlefs_mount,
+    .unmount = littlefs_unmount,
+    .format = littlefs_format,
+    .info = littlefs_info,
+    // Copy-on-write metadata: rename over an existing file is atomic
+    .rename_replaces = true,
+};
+
+#endif // CONFIG_GIF_STORAGE_BACKEND_LITTLEFS
@@ -0,0 +1,33 @@
+#include "gif_storage_backend.h"
+#include <esp_spiffs.h>
+
+static esp_err_t spiffs_mount(const char* base_path, const char* partition_label, size_t max_files) {
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = base_path,
+        .partition_label = partition_label,
+        .max_files = max_files,
+        .format_if_mount_failed = false  // Don't auto-format, require explicit formatting
+    };
+    return esp_vfs_spiffs_register(&conf);
+}
+
+static esp_err_t spiffs_unmount(const char* partition_label) {
+    return esp_vfs_spiffs_unregister(partition_label);
+}
+
+static esp_err_t spiffs_format(const char* partition_label) {
+    return esp_spiffs_format(partition_label);
+}
+
+static esp_err_t spiffs_info(const char* partition_label, size_t* total_bytes, size_t* used_bytes) {
+    return esp_spiffs_info(partition_label, total_bytes, used_bytes);
+}
+
+const gif_storage_backend_t gif_storage_backend_spiffs = {
+    .name = "SPIFFS",
+    .mount = spiffs_mount,
+    .unmount = spiffs_unmount,
+    .format = spiffs_format,
+    .info = spiffs_info,
+    .rename_replaces = false,
+};
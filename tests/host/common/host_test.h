@@ -0,0 +1,46 @@
+#pragma once
+
+// Minimal checks for the C++ host tests: a failed CHECK prints where and
+// keeps going, and main() returns host_test::Finish().
+
+#include <cstdio>
+
+namespace host_test {
+
+inline int& Failures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline int Finish() {
+    if (Failures() == 0) {
+        std::printf("all checks passed\n");
+        return 0;
+    }
+    std::printf("%d checks failed\n", Failures());
+    return 1;
+}
+
+} // namespace host_test
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            host_test::Failures()++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) do { \
+        auto _a = (a); \
+        auto _b = (b); \
+        if (!(_a == _b)) { \
+            std::printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, \
+                        (long long)_a, (long long)_b); \
+            host_test::Failures()++; \
+        } \
+    } while (0)
+
+#define RUN_TEST(fn) do { \
+        std::printf("-- %s\n", #fn); \
+        fn(); \
+    } while (0)
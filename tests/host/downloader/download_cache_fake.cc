@@ -0,0 +1,112 @@
+// DownloadCache with the same interface, kept in RAM: the downloader tests
+// exercise the HTTP side, not the storage partition.
+
+#include "download_cache.h"
+#include "download_cache_fake.h"
+
+#include <esp_heap_caps.h>
+
+#include <cstring>
+#include <map>
+
+namespace {
+
+std::map<std::string, std::string> g_bodies;
+DownloadCacheCounters g_counters;
+
+} // namespace
+
+DownloadCacheCounters& download_cache_counters() {
+    return g_counters;
+}
+
+void download_cache_clear() {
+    while (!g_bodies.empty()) {
+        DownloadCache::GetInstance().Remove(g_bodies.begin()->first);
+    }
+    g_counters = DownloadCacheCounters();
+}
+
+DownloadCache& DownloadCache::GetInstance() {
+    static DownloadCache instance;
+    return instance;
+}
+
+bool DownloadCache::IsEnabled() {
+    return true;
+}
+
+DownloadCache::Entry* DownloadCache::Find(const std::string& url) {
+    for (auto& entry : entries_) {
+        if (entry.url == url) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool DownloadCache::GetValidators(const std::string& url, std::string& etag, std::string& last_modified) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = Find(url);
+    if (!entry) {
+        return false;
+    }
+    etag = entry->etag;
+    last_modified = entry->last_modified;
+    return true;
+}
+
+bool DownloadCache::Load(const std::string& url, uint8_t** out_data, size_t* out_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Find(url)) {
+        return false;
+    }
+    const std::string& body = g_bodies[url];
+    *out_data = (uint8_t*)heap_caps_malloc(body.size(), MALLOC_CAP_SPIRAM);
+    memcpy(*out_data, body.data(), body.size());
+    *out_size = body.size();
+    g_counters.loads++;
+    return true;
+}
+
+bool DownloadCache::Store(const std::string& url, const uint8_t* data, size_t size,
+                          const std::string& etag, const std::string& last_modified) {
+    if (etag.empty() && last_modified.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = Find(url);
+    if (!entry) {
+        entries_.emplace_back();
+        entry = &entries_.back();
+        entry->url = url;
+    }
+    entry->etag = etag;
+    entry->last_modified = last_modified;
+    entry->size = size;
+    g_bodies[url].assign((const char*)data, size);
+    g_counters.stores++;
+    return true;
+}
+
+void DownloadCache::Remove(const std::string& url) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].url == url) {
+            entries_.erase(entries_.begin() + i);
+            g_bodies.erase(url);
+            return;
+        }
+    }
+}
+
+size_t DownloadCache::Shrink(size_t /* bytes */) {
+    return 0;
+}
+
+size_t DownloadCache::CachedBytes() {
+    return 0;
+}
+
+void DownloadCache::Flush() {
+}
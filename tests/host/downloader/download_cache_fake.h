@@ -0,0 +1,14 @@
+#pragma once
+
+// What the downloader tests need to see of the in-memory DownloadCache
+// (download_cache_fake.cc), which replaces the flash-backed one.
+
+#include <cstddef>
+
+struct DownloadCacheCounters {
+    int stores = 0;
+    int loads = 0;   // hits served by Load()
+};
+
+DownloadCacheCounters& download_cache_counters();
+void download_cache_clear();
@@ -0,0 +1,300 @@
+// GifDownloader against a local stand-in server: keep-alive reuse, resume
+// with Range/If-Range, and conditional GETs answered with 304.
+//
+// The downloader is a singleton with a small keep-alive pool, so the tests
+// share one server (one origin) and swap its handler; connection counts are
+// taken relative to the start of each test.
+
+#include "gif_downloader.h"
+#include "download_cache.h"
+#include "download_cache_fake.h"
+#include "test_http_server.h"
+#include "host_test.h"
+
+#include <esp_heap_caps.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace {
+
+struct Resource {
+    std::string body;
+    std::string etag;
+    std::string last_modified;
+};
+
+std::string MakeGif(size_t size, unsigned seed) {
+    std::string body = "GIF89a";
+    uint32_t x = seed * 2654435761u + 1;
+    while (body.size() < size) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        body += (char)(x & 0xFF);
+    }
+    return body;
+}
+
+// What a well-behaved origin does with the validators and Range
+HttpResponse Serve(const Resource& resource, const HttpRequest& request) {
+    HttpResponse response;
+    if (!resource.etag.empty()) {
+        response.headers.emplace_back("ETag", resource.etag);
+    }
+    if (!resource.last_modified.empty()) {
+        response.headers.emplace_back("Last-Modified", resource.last_modified);
+    }
+
+    std::string if_none_match = request.Header("if-none-match");
+    std::string if_modified_since = request.Header("if-modified-since");
+    if ((!if_none_match.empty() && if_none_match == resource.etag) ||
+        (if_none_match.empty() && !if_modified_since.empty() && if_modified_since == resource.last_modified)) {
+        response.status = 304;
+        return response;
+    }
+
+    std::string range = request.Header("range");
+    std::string if_range = request.Header("if-range");
+    bool same_entity = if_range.empty() || if_range == resource.etag || if_range == resource.last_modified;
+    if (range.compare(0, 6, "bytes=") == 0 && same_entity) {
+        size_t start = std::stoul(range.substr(6));
+        if (start >= resource.body.size()) {
+            response.status = 416;
+            return response;
+        }
+        response.status = 206;
+        response.headers.emplace_back("Content-Range", "bytes " + std::to_string(start) + "-" +
+                                      std::to_string(resource.body.size() - 1) + "/" +
+                                      std::to_string(resource.body.size()));
+        response.body = resource.body.substr(start);
+        return response;
+    }
+    response.body = resource.body;
+    return response;
+}
+
+TestHttpServer* g_server;
+
+// Fresh cache, fresh request log, new handler; returns the connection count so far
+int Begin(TestHttpServer::Handler handler) {
+    download_cache_clear();
+    g_server->SetHandler(std::move(handler));
+    g_server->ClearRequests();
+    return g_server->connections();
+}
+
+bool Download(const std::string& url, std::string& body) {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    bool ok = GifDownloader::GetInstance().Download(url, &data, &size);
+    body.assign(ok ? (const char*)data : "", ok ? size : 0);
+    heap_caps_free(data);
+    return ok;
+}
+
+void TestKeepAliveReusesConnection() {
+    Resource a{MakeGif(50000, 1), "\"a1\"", ""};
+    Resource b{MakeGif(30000, 2), "\"b1\"", ""};
+    int connections = Begin([&](const HttpRequest& request) {
+        return Serve(request.target == "/a.gif" ? a : b, request);
+    });
+
+    std::string body;
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    CHECK(body == a.body);
+    CHECK(Download(g_server->Url("/b.gif"), body));
+    CHECK(body == b.body);
+
+    auto requests = g_server->requests();
+    CHECK_EQ(requests.size(), 2u);
+    CHECK_EQ(g_server->connections() - connections, 1);
+    if (requests.size() == 2) {
+        CHECK_EQ(requests[0].connection, requests[1].connection);
+    }
+}
+
+void TestStaleKeepAliveIsRetried() {
+    Resource a{MakeGif(20000, 3), "\"a1\"", ""};
+    Begin([&](const HttpRequest& request) { return Serve(a, request); });
+
+    std::string body;
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    // The server times the pooled connection out before the next request
+    g_server->CloseIdleConnections();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int connections = g_server->connections();
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    CHECK(body == a.body);
+    // The dead socket failed before a request got through and was replaced
+    // without using up a retry
+    CHECK_EQ(g_server->connections() - connections, 1);
+    auto requests = g_server->requests();
+    CHECK_EQ(requests.size(), 2u);
+    if (requests.size() == 2) {
+        CHECK(requests[0].connection != requests[1].connection);
+    }
+}
+
+void TestEtagConditionalGetServes304FromCache() {
+    Resource a{MakeGif(80000, 4), "\"v1\"", "Wed, 21 Oct 2015 07:28:00 GMT"};
+    Begin([&](const HttpRequest& request) { return Serve(a, request); });
+
+    std::string body;
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    CHECK_EQ(download_cache_counters().stores, 1);
+
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    CHECK(body == a.body);
+    auto requests = g_server->requests();
+    CHECK_EQ(requests.size(), 2u);
+    if (requests.size() == 2) {
+        CHECK(requests[0].Header("if-none-match").empty());
+        CHECK(requests[1].Header("if-none-match") == a.etag);
+        CHECK(requests[1].Header("if-modified-since") == a.last_modified);
+    }
+    CHECK_EQ(download_cache_counters().loads, 1);
+    CHECK_EQ(download_cache_counters().stores, 1);
+
+    // A new version on the same connection (the 304 left it clean): the
+    // validator no longer matches and the cached body is replaced
+    a.body = MakeGif(60000, 5);
+    a.etag = "\"v2\"";
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    CHECK(body == a.body);
+    CHECK_EQ(download_cache_counters().stores, 2);
+    requests = g_server->requests();
+    CHECK_EQ(requests.size(), 3u);
+    if (requests.size() == 3) {
+        CHECK_EQ(requests[1].connection, requests[2].connection);
+        CHECK(requests[2].Header("if-none-match") == "\"v1\"");
+    }
+}
+
+void TestLastModifiedConditionalGet() {
+    Resource a{MakeGif(10000, 6), "", "Thu, 01 Jan 2026 00:00:00 GMT"};
+    Begin([&](const HttpRequest& request) { return Serve(a, request); });
+
+    std::string body;
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    CHECK(body == a.body);
+    auto requests = g_server->requests();
+    CHECK_EQ(requests.size(), 2u);
+    if (requests.size() == 2) {
+        CHECK(requests[1].Header("if-none-match").empty());
+        CHECK(requests[1].Header("if-modified-since") == a.last_modified);
+    }
+    CHECK_EQ(download_cache_counters().loads, 1);
+}
+
+void TestInterruptedTransferResumes() {
+    Resource a{MakeGif(200000, 7), "\"big\"", ""};
+    int responses = 0;
+    Begin([&](const HttpRequest& request) {
+        HttpResponse response = Serve(a, request);
+        if (responses++ == 0) {
+            response.cut_after = 70000;
+        }
+        return response;
+    });
+
+    std::string body;
+    CHECK(Download(g_server->Url("/big.gif"), body));
+    CHECK(body == a.body);
+    auto requests = g_server->requests();
+    CHECK_EQ(requests.size(), 2u);
+    if (requests.size() == 2) {
+        CHECK(requests[0].Header("range").empty());
+        CHECK(requests[1].Header("range") == "bytes=70000-");
+        CHECK(requests[1].Header("if-range") == a.etag);
+    }
+}
+
+void TestResumeRestartsWhenEntityChanged() {
+    Resource a{MakeGif(150000, 8), "\"old\"", ""};
+    std::string old_body = a.body;
+    int responses = 0;
+    Begin([&](const HttpRequest& request) {
+        HttpResponse response = Serve(a, request);
+        if (responses++ == 0) {
+            response.cut_after = 40000;
+            // Replaced on the server while the client was cut off
+            a.body = MakeGif(120000, 9);
+            a.etag = "\"new\"";
+        }
+        return response;
+    });
+
+    std::string body;
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    // If-Range did not match, so the server sent the whole new entity with a
+    // 200 and none of the old prefix survived
+    CHECK(body == a.body);
+    CHECK(body != old_body);
+    auto requests = g_server->requests();
+    CHECK_EQ(requests.size(), 2u);
+    if (requests.size() == 2) {
+        CHECK(requests[1].Header("range") == "bytes=40000-");
+        CHECK(requests[1].Header("if-range") == "\"old\"");
+    }
+
+    // The cache holds the new entity under its own validator
+    std::string etag, last_modified;
+    CHECK(DownloadCache::GetInstance().GetValidators(g_server->Url("/a.gif"), etag, last_modified));
+    CHECK(etag == "\"new\"");
+}
+
+void TestUnvalidatedPrefixIsNotResumed() {
+    // Without any validator a resumed body could splice two versions together
+    Resource a{MakeGif(90000, 10), "", ""};
+    int responses = 0;
+    Begin([&](const HttpRequest& request) {
+        HttpResponse response = Serve(a, request);
+        if (responses++ == 0) {
+            response.cut_after = 30000;
+        }
+        return response;
+    });
+
+    std::string body;
+    CHECK(Download(g_server->Url("/a.gif"), body));
+    CHECK(body == a.body);
+    auto requests = g_server->requests();
+    CHECK_EQ(requests.size(), 2u);
+    if (requests.size() == 2) {
+        CHECK(requests[1].Header("range").empty());
+    }
+    CHECK_EQ(download_cache_counters().stores, 0);
+}
+
+// Last: it takes the shared server down
+void TestUnreachableServerFallsBackToCache() {
+    Resource a{MakeGif(25000, 11), "\"a1\"", ""};
+    Begin([&](const HttpRequest& request) { return Serve(a, request); });
+    std::string url = g_server->Url("/a.gif");
+    std::string body;
+    CHECK(Download(url, body));
+
+    delete g_server;
+    g_server = nullptr;
+    CHECK(Download(url, body));
+    CHECK(body == a.body);
+    CHECK_EQ(download_cache_counters().loads, 1);
+}
+
+} // namespace
+
+int main() {
+    g_server = new TestHttpServer();
+    RUN_TEST(TestKeepAliveReusesConnection);
+    RUN_TEST(TestStaleKeepAliveIsRetried);
+    RUN_TEST(TestEtagConditionalGetServes304FromCache);
+    RUN_TEST(TestLastModifiedConditionalGet);
+    RUN_TEST(TestInterruptedTransferResumes);
+    RUN_TEST(TestResumeRestartsWhenEntityChanged);
+    RUN_TEST(TestUnvalidatedPrefixIsNotResumed);
+    RUN_TEST(TestUnreachableServerFallsBackToCache);
+    return host_test::Finish();
+}
@@ -0,0 +1,197 @@
+#include "test_http_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+static const char* Reason(int status) {
+    switch (status) {
+    case 200:
+        return "OK";
+    case 206:
+        return "Partial Content";
+    case 304:
+        return "Not Modified";
+    case 404:
+        return "Not Found";
+    case 416:
+        return "Range Not Satisfiable";
+    default:
+        return "Status";
+    }
+}
+
+static bool SendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+TestHttpServer::TestHttpServer(Handler handler) : handler_(std::move(handler)) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listen_fd_, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(listen_fd_, (sockaddr*)&addr, &len);
+    port_ = ntohs(addr.sin_port);
+    listen(listen_fd_, 8);
+    accept_thread_ = std::thread(&TestHttpServer::AcceptLoop, this);
+}
+
+TestHttpServer::~TestHttpServer() {
+    stopping_ = true;
+    shutdown(listen_fd_, SHUT_RDWR);
+    close(listen_fd_);
+    accept_thread_.join();
+    CloseIdleConnections();
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        threads.swap(connection_threads_);
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void TestHttpServer::SetHandler(Handler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    handler_ = std::move(handler);
+}
+
+std::string TestHttpServer::Url(const std::string& path) const {
+    return "http://127.0.0.1:" + std::to_string(port_) + path;
+}
+
+std::vector<HttpRequest> TestHttpServer::requests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return requests_;
+}
+
+void TestHttpServer::ClearRequests() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    requests_.clear();
+}
+
+void TestHttpServer::CloseIdleConnections() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int fd : idle_fds_) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    idle_fds_.clear();
+}
+
+void TestHttpServer::SetIdle(int fd, bool idle) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find(idle_fds_.begin(), idle_fds_.end(), fd);
+    if (idle && it == idle_fds_.end()) {
+        idle_fds_.push_back(fd);
+    } else if (!idle && it != idle_fds_.end()) {
+        idle_fds_.erase(it);
+    }
+}
+
+void TestHttpServer::AcceptLoop() {
+    while (!stopping_) {
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        int connection = ++connections_;
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_threads_.emplace_back(&TestHttpServer::Serve, this, fd, connection);
+    }
+}
+
+void TestHttpServer::Serve(int fd, int connection) {
+    std::string rx;
+    SetIdle(fd, true);
+    while (!stopping_) {
+        // One request head; GETs carry no body
+        size_t end;
+        bool closed = false;
+        while ((end = rx.find("\r\n\r\n")) == std::string::npos) {
+            char chunk[2048];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                closed = true;
+                break;
+            }
+            rx.append(chunk, n);
+        }
+        SetIdle(fd, false);
+        if (closed) {
+            break;
+        }
+        std::string head = rx.substr(0, end + 2);
+        rx.erase(0, end + 4);
+
+        HttpRequest request;
+        request.connection = connection;
+        size_t line_end = head.find("\r\n");
+        std::string request_line = head.substr(0, line_end);
+        size_t sp1 = request_line.find(' '), sp2 = request_line.rfind(' ');
+        request.target = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+        for (size_t pos = line_end + 2; pos < head.size();) {
+            size_t next = head.find("\r\n", pos);
+            std::string line = head.substr(pos, next - pos);
+            pos = next + 2;
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string key = line.substr(0, colon);
+            std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::tolower(c); });
+            size_t value_start = line.find_first_not_of(' ', colon + 1);
+            request.headers[key] = value_start == std::string::npos ? "" : line.substr(value_start);
+        }
+        Handler handler;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requests_.push_back(request);
+            handler = handler_;
+        }
+
+        HttpResponse response;
+        if (handler) {
+            response = handler(request);
+        } else {
+            response.status = 404;
+        }
+        bool close_after = response.close || request.Header("connection") == "close";
+        std::string out = "HTTP/1.1 " + std::to_string(response.status) + " " + Reason(response.status) + "\r\n";
+        for (const auto& header : response.headers) {
+            out += header.first + ": " + header.second + "\r\n";
+        }
+        if (response.status != 304) {
+            out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+        }
+        out += close_after ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n";
+        size_t body = std::min(response.cut_after, response.body.size());
+        out.append(response.body, 0, body);
+        bool keep_open = !close_after && body == response.body.size();
+        // Idle from here on: the client may have the whole response before send() returns
+        SetIdle(fd, keep_open);
+        if (!SendAll(fd, out.data(), out.size()) || !keep_open) {
+            break;
+        }
+    }
+    SetIdle(fd, false);
+    shutdown(fd, SHUT_RDWR);
+    close(fd);
+}
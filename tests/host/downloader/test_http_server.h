@@ -0,0 +1,70 @@
+#pragma once
+
+// In-process HTTP/1.1 stand-in server for the downloader tests.
+//
+// Listens on 127.0.0.1 with an ephemeral port, serves each connection on
+// its own thread and keeps it open between requests (keep-alive) until the
+// client or the response asks to close. Every request is recorded with the
+// connection it arrived on. Without a handler every request gets a 404.
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct HttpRequest {
+    int connection = 0;  // 1-based accept order
+    std::string target;
+    std::map<std::string, std::string> headers;  // keys lower-cased
+
+    std::string Header(const std::string& key) const {
+        auto it = headers.find(key);
+        return it == headers.end() ? std::string() : it->second;
+    }
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::vector<std::pair<std::string, std::string>> headers;
+    std::string body;
+    // Close the connection after sending this many body bytes (Content-Length still says all)
+    size_t cut_after = std::string::npos;
+    // Close the connection once the response is out
+    bool close = false;
+};
+
+class TestHttpServer {
+public:
+    using Handler = std::function<HttpResponse(const HttpRequest&)>;
+
+    explicit TestHttpServer(Handler handler = nullptr);
+    ~TestHttpServer();
+
+    void SetHandler(Handler handler);
+
+    std::string Url(const std::string& path) const;
+    int connections() const { return connections_; }
+    std::vector<HttpRequest> requests();
+    void ClearRequests();
+    // Server-side keep-alive timeout: drop the connections waiting for a request
+    void CloseIdleConnections();
+
+private:
+    Handler handler_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> connections_{0};
+    std::thread accept_thread_;
+    std::mutex mutex_;
+    std::vector<std::thread> connection_threads_;
+    std::vector<int> idle_fds_;
+    std::vector<HttpRequest> requests_;
+
+    void AcceptLoop();
+    void Serve(int fd, int connection);
+    void SetIdle(int fd, bool idle);
+};
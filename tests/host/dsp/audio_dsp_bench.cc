@@ -0,0 +1,135 @@
+// Time per call of each audio_dsp kernel, for the loops it replaced and for
+// the generic and packed implementations, on the buffer sizes the firmware
+// uses. Built with -Os and no auto-vectorisation, the way ESP-IDF builds the
+// firmware (CONFIG_COMPILER_OPTIMIZATION_SIZE; the Xtensa/RISC-V compilers do
+// not vectorise these loops). Absolute numbers are the host's; the ratios
+// between the reference, generic and packed variants are what carries over.
+// The sse2 row (x86 hosts) shows what 128-bit vectors buy over packed C on
+// the same machine; the firmware has no such path.
+//
+// audio_dsp_bench [-t min_ms]
+
+#include "audio_dsp_variants.h"
+#include "audio_dsp_reference.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// 60 ms frames: 16 kHz capture (InputAudio, NoAudioCodec::Read) and
+// 24 kHz playback (NoAudioCodec::Write)
+constexpr size_t kCaptureFrames = 960;
+constexpr size_t kPlaybackSamples = 1440;
+
+int min_ms = 200;
+volatile int sink;
+
+// Best of five runs, so a scheduler hiccup does not decide the ratio
+template <typename Fn>
+double NsPerCall(Fn fn) {
+    using Clock = std::chrono::steady_clock;
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        long calls = 0;
+        auto start = Clock::now();
+        auto deadline = start + std::chrono::microseconds(min_ms * 1000 / 5);
+        Clock::time_point now;
+        do {
+            for (int i = 0; i < 64; i++) {
+                fn();
+            }
+            calls += 64;
+            now = Clock::now();
+        } while (now < deadline);
+        double ns = std::chrono::duration<double, std::nano>(now - start).count() / calls;
+        best = run == 0 || ns < best ? ns : best;
+    }
+    return best;
+}
+
+void Report(const char* kernel, const char* variant, double ns, double reference_ns) {
+    std::printf("%-14s %-18s %9.1f ns/call  %5.2fx\n", kernel, variant, ns, reference_ns / ns);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "t:")) != -1) {
+        if (opt == 't') {
+            min_ms = std::atoi(optarg);
+        } else {
+            std::fprintf(stderr, "usage: %s [-t min_ms]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(1);
+    std::vector<int16_t> stereo(2 * kCaptureFrames), mic(kCaptureFrames), ref(kCaptureFrames);
+    std::vector<int16_t> playback(kPlaybackSamples), capture(kCaptureFrames);
+    std::vector<int32_t> slots_out(kPlaybackSamples), slots_in(kCaptureFrames);
+    for (auto& s : stereo) {
+        s = (int16_t)rng();
+    }
+    for (auto& s : playback) {
+        s = (int16_t)rng();
+    }
+    for (auto& s : slots_in) {
+        s = (int32_t)rng();
+    }
+    const int32_t loud_gain = 2 * reference::VolumeFactor(100);
+
+    // The replaced loops first; the ratios are against them
+    std::vector<AudioDspVariant> variants = {{"reference", reference::Deinterleave, reference::Interleave,
+                                              reference::VolumeFactor, reference::ScaleToS32,
+                                              reference::ConvertS32ToS16}};
+    variants.insert(variants.end(), std::begin(kAudioDspVariants), std::end(kAudioDspVariants));
+
+    struct Kernel {
+        const char* name;
+        std::function<void(const AudioDspVariant&)> run;
+    };
+    const Kernel kernels[] = {
+        {"deinterleave", [&](const AudioDspVariant& v) {
+             v.deinterleave(stereo.data(), mic.data(), ref.data(), kCaptureFrames);
+             sink = mic[0];
+         }},
+        {"interleave", [&](const AudioDspVariant& v) {
+             v.interleave(mic.data(), ref.data(), stereo.data(), kCaptureFrames);
+             sink = stereo[0];
+         }},
+        // NoAudioCodec::Write: gain from the volume on every call, then scale
+        {"volume+scale", [&](const AudioDspVariant& v) {
+             v.scale_to_s32(playback.data(), slots_out.data(), v.volume_to_gain_q16(sink & 63), kPlaybackSamples);
+             sink = slots_out[0];
+         }},
+        // Gain above 1.0: the saturating path
+        {"scale gain>1", [&](const AudioDspVariant& v) {
+             v.scale_to_s32(playback.data(), slots_out.data(), loud_gain, kPlaybackSamples);
+             sink = slots_out[0];
+         }},
+        {"s32->s16", [&](const AudioDspVariant& v) {
+             v.convert_s32_to_s16(slots_in.data(), capture.data(), 12, kCaptureFrames);
+             sink = capture[0];
+         }},
+    };
+
+    for (const auto& kernel : kernels) {
+        double reference_ns = 0;
+        for (const auto& v : variants) {
+            double ns = NsPerCall([&] { kernel.run(v); });
+            if (reference_ns == 0) {
+                reference_ns = ns;
+            }
+            Report(kernel.name, v.name, ns, reference_ns);
+        }
+    }
+    return 0;
+}
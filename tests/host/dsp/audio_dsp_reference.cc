@@ -0,0 +1,49 @@
+#include "audio_dsp_reference.h"
+
+#include <cmath>
+
+namespace reference {
+
+// Application::InputAudio, mic/reference split
+void Deinterleave(const int16_t* input_pcm, int16_t* mic_pcm, int16_t* reference_pcm, size_t size) {
+    for (size_t i = 0, j = 0; i < size; ++i, j += 2) {
+        mic_pcm[i] = input_pcm[j];
+        reference_pcm[i] = input_pcm[j + 1];
+    }
+}
+
+// Application::InputAudio, merge after resampling
+void Interleave(const int16_t* mic, const int16_t* ref, int16_t* out, size_t size) {
+    for (size_t i = 0, j = 0; i < size; ++i, j += 2) {
+        out[j] = mic[i];
+        out[j + 1] = ref[i];
+    }
+}
+
+// NoAudioCodec::Write
+int32_t VolumeFactor(int output_volume) {
+    return pow(double(output_volume) / 100.0, 2) * 65536;
+}
+
+void ScaleToS32(const int16_t* data, int32_t* buffer, int32_t volume_factor, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        int64_t temp = int64_t(data[i]) * volume_factor;
+        if (temp > INT32_MAX) {
+            buffer[i] = INT32_MAX;
+        } else if (temp < INT32_MIN) {
+            buffer[i] = INT32_MIN;
+        } else {
+            buffer[i] = static_cast<int32_t>(temp);
+        }
+    }
+}
+
+// NoAudioCodec::Read, with the shift as a parameter
+void ConvertS32ToS16(const int32_t* bit32_buffer, int16_t* dest, int shift, size_t samples) {
+    for (size_t i = 0; i < samples; i++) {
+        int32_t value = bit32_buffer[i] >> shift;
+        dest[i] = (value > INT16_MAX) ? INT16_MAX : (value < -INT16_MAX) ? -INT16_MAX : (int16_t)value;
+    }
+}
+
+} // namespace reference
@@ -0,0 +1,23 @@
+#pragma once
+
+// The loops audio_dsp replaced, as they were in application.cc and
+// no_audio_codec.cc: the reference both implementations must match bit for
+// bit. Kept in their own translation unit so the benchmark calls them the
+// same way it calls the kernels.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace reference {
+
+// Application::InputAudio, mic/reference split
+void Deinterleave(const int16_t* input_pcm, int16_t* mic_pcm, int16_t* reference_pcm, size_t size);
+// Application::InputAudio, merge after resampling
+void Interleave(const int16_t* mic, const int16_t* ref, int16_t* out, size_t size);
+// NoAudioCodec::Write
+int32_t VolumeFactor(int output_volume);
+void ScaleToS32(const int16_t* data, int32_t* buffer, int32_t volume_factor, size_t samples);
+// NoAudioCodec::Read, with the shift as a parameter
+void ConvertS32ToS16(const int32_t* bit32_buffer, int16_t* dest, int shift, size_t samples);
+
+} // namespace reference
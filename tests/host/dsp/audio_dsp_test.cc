@@ -0,0 +1,206 @@
+// audio_dsp against the loops it replaced (audio_dsp_reference.h), for the
+// generic, the packed and (on x86 hosts) the SSE2 implementation: every
+// length up to a few vectors at every alignment, random buffers, extreme samples and gains, and
+// guard words to catch writes past the end.
+
+#include "audio_dsp_variants.h"
+#include "audio_dsp_reference.h"
+#include "host_test.h"
+
+#include <climits>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr int16_t kGuard16 = 0x5A5A;
+constexpr int32_t kGuard32 = 0x5A5A5A5A;
+constexpr size_t kPad = 4;
+
+std::mt19937 rng(7);
+
+// Random samples with the extremes mixed in
+int16_t Sample16() {
+    switch (rng() % 8) {
+    case 0:
+        return INT16_MIN;
+    case 1:
+        return INT16_MAX;
+    case 2:
+        return -INT16_MAX;
+    default:
+        return (int16_t)rng();
+    }
+}
+
+int32_t Sample32(int shift) {
+    switch (rng() % 8) {
+    case 0:
+        return INT32_MIN;
+    case 1:
+        return INT32_MAX;
+    case 2:
+        // Right at the clamp edges after the shift
+        return (int32_t)((uint32_t)(INT16_MAX + (int)(rng() % 3) - 1) << shift);
+    case 3:
+        return (int32_t)(0u - ((uint32_t)(INT16_MAX + (int)(rng() % 3) - 1) << shift));
+    default:
+        return (int32_t)rng();
+    }
+}
+
+// memcmp, but fine with the null data() of an empty vector
+template <typename T>
+bool Same(const T* a, const T* b, size_t n) {
+    return n == 0 || std::memcmp(a, b, n * sizeof(T)) == 0;
+}
+
+// A buffer of n elements starting `offset` elements into an allocation with
+// guard elements on both sides
+template <typename T>
+struct Guarded {
+    std::vector<T> storage;
+    size_t offset;
+    size_t size;
+    T guard;
+
+    Guarded(size_t n, size_t off, T guard_value) : storage(n + off + 2 * kPad, guard_value), offset(off), size(n), guard(guard_value) {}
+    T* data() { return storage.data() + kPad + offset; }
+    const T* data() const { return storage.data() + kPad + offset; }
+    bool Intact() const {
+        for (size_t i = 0; i < storage.size(); i++) {
+            bool inside = i >= kPad + offset && i < kPad + offset + size;
+            if (!inside && storage[i] != guard) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+bool CheckInterleaving(const AudioDspVariant& v, size_t frames, size_t in_off, size_t l_off, size_t r_off) {
+    Guarded<int16_t> in(2 * frames, in_off, kGuard16);
+    for (size_t i = 0; i < 2 * frames; i++) {
+        in.data()[i] = Sample16();
+    }
+    Guarded<int16_t> left(frames, l_off, kGuard16), right(frames, r_off, kGuard16);
+    std::vector<int16_t> ref_left(frames), ref_right(frames);
+    v.deinterleave(in.data(), left.data(), right.data(), frames);
+    reference::Deinterleave(in.data(), ref_left.data(), ref_right.data(), frames);
+    bool ok = left.Intact() && right.Intact() &&
+              Same(left.data(), ref_left.data(), frames) &&
+              Same(right.data(), ref_right.data(), frames);
+
+    Guarded<int16_t> out(2 * frames, in_off, kGuard16);
+    std::vector<int16_t> ref_out(2 * frames);
+    v.interleave(left.data(), right.data(), out.data(), frames);
+    reference::Interleave(left.data(), right.data(), ref_out.data(), frames);
+    return ok && out.Intact() && Same(out.data(), ref_out.data(), 2 * frames);
+}
+
+bool CheckScale(const AudioDspVariant& v, size_t samples, size_t src_off, size_t dst_off, int32_t gain) {
+    Guarded<int16_t> src(samples, src_off, kGuard16);
+    for (size_t i = 0; i < samples; i++) {
+        src.data()[i] = Sample16();
+    }
+    Guarded<int32_t> dst(samples, dst_off, kGuard32);
+    std::vector<int32_t> ref(samples);
+    v.scale_to_s32(src.data(), dst.data(), gain, samples);
+    reference::ScaleToS32(src.data(), ref.data(), gain, samples);
+    return dst.Intact() && Same(dst.data(), ref.data(), samples);
+}
+
+bool CheckConvert(const AudioDspVariant& v, size_t samples, size_t src_off, size_t dst_off, int shift) {
+    Guarded<int32_t> src(samples, src_off, kGuard32);
+    for (size_t i = 0; i < samples; i++) {
+        src.data()[i] = Sample32(shift);
+    }
+    Guarded<int16_t> dst(samples, dst_off, kGuard16);
+    std::vector<int16_t> ref(samples);
+    v.convert_s32_to_s16(src.data(), dst.data(), shift, samples);
+    reference::ConvertS32ToS16(src.data(), ref.data(), shift, samples);
+    return dst.Intact() && Same(dst.data(), ref.data(), samples);
+}
+
+void TestVolumeToGain() {
+    for (const auto& v : kAudioDspVariants) {
+        int mismatches = 0;
+        for (int volume = 0; volume <= 100; volume++) {
+            mismatches += v.volume_to_gain_q16(volume) != reference::VolumeFactor(volume);
+        }
+        CHECK_EQ(mismatches, 0);
+    }
+}
+
+// Lengths 0..33 at every combination of 16-bit alignment of the three buffers
+void TestInterleavingAllAlignments() {
+    for (const auto& v : kAudioDspVariants) {
+        int failures = 0;
+        for (size_t frames = 0; frames <= 33; frames++) {
+            for (int alignment = 0; alignment < 8; alignment++) {
+                failures += !CheckInterleaving(v, frames, alignment & 1, (alignment >> 1) & 1, (alignment >> 2) & 1);
+            }
+        }
+        CHECK_EQ(failures, 0);
+    }
+}
+
+void TestInterleavingRandom() {
+    for (const auto& v : kAudioDspVariants) {
+        int failures = 0;
+        for (int trial = 0; trial < 2000; trial++) {
+            failures += !CheckInterleaving(v, rng() % 1500, rng() % 2, rng() % 2, rng() % 2);
+        }
+        CHECK_EQ(failures, 0);
+    }
+}
+
+void TestScale() {
+    // Every volume, then gains past 1.0 (saturating path) and negative ones
+    std::vector<int32_t> gains;
+    for (int volume = 0; volume <= 100; volume++) {
+        gains.push_back(reference::VolumeFactor(volume));
+    }
+    // 32767-32769 and 65534-65536 sit at the edges of the SSE2 gain split
+    for (int32_t gain : {1, 32767, 32768, 32769, 65533, 65534, 65535, 65536, 65537, 131072, 1 << 20, INT32_MAX,
+                         -1, -65536, -65537, INT32_MIN}) {
+        gains.push_back(gain);
+    }
+    for (const auto& v : kAudioDspVariants) {
+        int failures = 0;
+        for (int32_t gain : gains) {
+            for (size_t samples = 0; samples <= 33; samples++) {
+                failures += !CheckScale(v, samples, samples & 1, (samples >> 1) & 1, gain);
+            }
+            failures += !CheckScale(v, rng() % 2000, rng() % 2, rng() % 2, gain);
+        }
+        CHECK_EQ(failures, 0);
+    }
+}
+
+void TestConvert() {
+    for (const auto& v : kAudioDspVariants) {
+        int failures = 0;
+        for (int shift = 0; shift < 32; shift++) {
+            for (size_t samples = 0; samples <= 33; samples++) {
+                failures += !CheckConvert(v, samples, samples & 1, (samples >> 1) & 1, shift);
+            }
+            for (int trial = 0; trial < 20; trial++) {
+                failures += !CheckConvert(v, rng() % 2000, rng() % 2, rng() % 2, shift);
+            }
+        }
+        CHECK_EQ(failures, 0);
+    }
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestVolumeToGain);
+    RUN_TEST(TestInterleavingAllAlignments);
+    RUN_TEST(TestInterleavingRandom);
+    RUN_TEST(TestScale);
+    RUN_TEST(TestConvert);
+    return host_test::Finish();
+}
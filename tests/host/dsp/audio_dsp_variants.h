@@ -0,0 +1,40 @@
+#pragma once
+
+// All audio_dsp.cc implementations in one binary: CMake builds the file
+// with AUDIO_DSP_PACKED / AUDIO_DSP_SSE2 set per variant and the namespace
+// renamed to audio_dsp_generic / audio_dsp_packed / audio_dsp_sse2 (x86
+// hosts only, AUDIO_DSP_HOST_SSE2), and this declares them.
+
+#define audio_dsp audio_dsp_generic
+#include "audio_dsp.h"
+#undef audio_dsp
+#undef _AUDIO_DSP_H_
+#define audio_dsp audio_dsp_packed
+#include "audio_dsp.h"
+#undef audio_dsp
+#if AUDIO_DSP_HOST_SSE2
+#undef _AUDIO_DSP_H_
+#define audio_dsp audio_dsp_sse2
+#include "audio_dsp.h"
+#undef audio_dsp
+#endif
+
+struct AudioDspVariant {
+    const char* name;
+    void (*deinterleave)(const int16_t*, int16_t*, int16_t*, size_t);
+    void (*interleave)(const int16_t*, const int16_t*, int16_t*, size_t);
+    int32_t (*volume_to_gain_q16)(int);
+    void (*scale_to_s32)(const int16_t*, int32_t*, int32_t, size_t);
+    void (*convert_s32_to_s16)(const int32_t*, int16_t*, int, size_t);
+};
+
+#define AUDIO_DSP_VARIANT(ns) \
+    { #ns, ns::Deinterleave, ns::Interleave, ns::VolumeToGainQ16, ns::ScaleToS32, ns::ConvertS32ToS16 }
+
+inline const AudioDspVariant kAudioDspVariants[] = {
+    AUDIO_DSP_VARIANT(audio_dsp_generic),
+    AUDIO_DSP_VARIANT(audio_dsp_packed),
+#if AUDIO_DSP_HOST_SSE2
+    AUDIO_DSP_VARIANT(audio_dsp_sse2),
+#endif
+};
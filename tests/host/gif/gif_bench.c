@@ -0,0 +1,141 @@
+/* Decode throughput and memory of gifdec on the host.
+ *
+ *   gif_bench [-t min_ms] file.gif...
+ *
+ * Each file is played the way LvglGif plays it (gd_get_frame, then
+ * gd_render_frame onto the canvas) from memory and through lv_fs, for whole
+ * passes until min_ms has elapsed. Reported per source:
+ *   fps        frames per second of decode + dispose + render, wall clock
+ *   us/frame   gifdec's own split (GIFDEC_PROFILE)
+ *   B/frame    bytes lv_malloc'ed per frame after open (transient buffers)
+ *   open       bytes held by the decoder once open
+ *   peak       heap high-water mark from open to close
+ *   reads      lv_fs_read calls per frame (file source only)
+ */
+
+#include "gifdec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static uint8_t * load_file(const char * path, size_t * size)
+{
+    FILE * f = fopen(path, "rb");
+    if(f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t * data = n > 0 ? malloc((size_t)n) : NULL;
+    if(data && fread(data, 1, (size_t)n, f) != (size_t)n) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)n : 0;
+    return data;
+}
+
+static const char * base_name(const char * path)
+{
+    const char * slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+/* Returns 0 on success, -1 if the file does not open or decode */
+static int bench_source(const char * path, const uint8_t * data, uint32_t min_ms)
+{
+    lv_shim_heap_t heap;
+    lv_shim_heap(&heap);
+    size_t live_before = heap.live_bytes;
+    lv_shim_heap_reset();
+    uint64_t reads_before = lv_shim_fs_reads();
+
+    gd_GIF * gif = data ? gd_open_gif_data(data) : gd_open_gif_file(path);
+    if(gif == NULL) {
+        printf("%-24s %-4s open failed\n", base_name(path), data ? "mem" : "fs");
+        return -1;
+    }
+    lv_shim_heap(&heap);
+    size_t open_bytes = heap.live_bytes - live_before;
+    uint64_t open_allocated = heap.total_bytes;
+
+    uint32_t frames = 0, passes = 0;
+    uint64_t start = now_us(), elapsed = 0;
+    int ret = 0;
+    while(ret >= 0 && (passes == 0 || elapsed < (uint64_t)min_ms * 1000u)) {
+        while((ret = gd_get_frame(gif)) == 1) {
+            gd_render_frame(gif, gif->canvas);
+            gif->loop_count = 1; /* stop at the trailer even if NETSCAPE2.0 says loop forever */
+            frames++;
+        }
+        if(ret == 0) {
+            gd_rewind(gif);
+            passes++;
+        }
+        elapsed = now_us() - start;
+    }
+    lv_shim_heap(&heap);
+    uint64_t frame_allocated = heap.total_bytes - open_allocated;
+    uint64_t reads = lv_shim_fs_reads() - reads_before;
+
+    if(ret < 0 || frames == 0) {
+        printf("%-24s %-4s decode error after %u frames\n", base_name(path), data ? "mem" : "fs", (unsigned)frames);
+        gd_close_gif(gif);
+        return -1;
+    }
+
+    const gd_Stats * st = &gif->stats;
+    printf("%-24s %-4s %4ux%-4u %5u %8.1f %7.0f %7.0f %7.0f %9.0f %8zu %8zu",
+           base_name(path), data ? "mem" : "fs", gif->width, gif->height, (unsigned)(frames / passes),
+           frames * 1e6 / (double)elapsed,
+           (double)st->decode_us / frames, (double)st->dispose_us / frames, (double)st->render_us / frames,
+           (double)frame_allocated / frames, open_bytes, heap.peak_bytes - live_before);
+    if(data) printf("\n");
+    else printf(" %6.1f\n", (double)reads / frames);
+
+    gd_close_gif(gif);
+    return 0;
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t min_ms = 300;
+    int first = 1;
+    if(argc > 2 && strcmp(argv[1], "-t") == 0) {
+        min_ms = (uint32_t)atoi(argv[2]);
+        first = 3;
+    }
+    if(first >= argc) {
+        fprintf(stderr, "usage: %s [-t min_ms] file.gif...\n", argv[0]);
+        return 2;
+    }
+
+    printf("gifdec host benchmark: RGB565=%d cache=%d prefetch=%d read-ahead=%d B\n",
+           GIFDEC_USE_RGB565, LV_GIF_CACHE_DECODE_DATA, LV_GIF_PREFETCH_SUBBLOCKS, GIFDEC_READ_AHEAD_SIZE);
+    printf("%-24s %-4s %9s %5s %8s %7s %7s %7s %9s %8s %8s %6s\n", "file", "src", "size", "frms", "fps",
+           "dec us", "dsp us", "rnd us", "B/frame", "open B", "peak B", "reads");
+
+    int failures = 0;
+    for(int i = first; i < argc; i++) {
+        size_t size;
+        uint8_t * data = load_file(argv[i], &size);
+        if(data == NULL) {
+            printf("%-24s cannot read\n", base_name(argv[i]));
+            failures++;
+            continue;
+        }
+        failures += bench_source(argv[i], data, min_ms) != 0;
+        failures += bench_source(argv[i], NULL, min_ms) != 0;
+        free(data);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+/* The current gifdec against the reference decoder in reference/ (the
+ * version before the LZW rewrite).
+ *
+ *   gif_conformance [-n corpus_count] [-w dir] [file.gif...]
+ *
+ * Every generated corpus GIF and every file given on the command line is
+ * played for two passes (the second one runs from the frame index) by both
+ * decoders, from memory and through lv_fs. After each frame the palette
+ * indices, the canvas and the update rectangle must hash the same. For the
+ * corpus the current decoder's indices are also checked against the pixels
+ * the generator encoded. -w writes the corpus out for inspection. */
+
+#include "gif_corpus.h"
+#include "gif_player.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PASSES 2
+
+typedef struct {
+    uint64_t * hashes;
+    size_t count, cap;
+    const gif_corpus_item * expect;  /* corpus source, NULL for files */
+    int index_errors;
+} recording;
+
+static uint64_t fnv1a(uint64_t h, const void * data, size_t n)
+{
+    const uint8_t * p = data;
+    for(size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static void record_frame(void * ctx, const gif_frame_view * v)
+{
+    recording * rec = ctx;
+    size_t pixels = (size_t)v->width * v->height;
+    uint16_t rect[4] = {v->ux, v->uy, v->uw, v->uh};
+    uint64_t h = 14695981039346656037ull;
+    h = fnv1a(h, v->indices, pixels);
+    h = fnv1a(h, v->canvas, pixels * v->canvas_bpp);
+    h = fnv1a(h, rect, sizeof(rect));
+    if(rec->count == rec->cap) {
+        rec->cap = rec->cap ? rec->cap * 2 : 16;
+        rec->hashes = realloc(rec->hashes, rec->cap * sizeof(*rec->hashes));
+    }
+    rec->hashes[rec->count++] = h;
+
+    if(rec->expect && v->frame < rec->expect->frame_count) {
+        const gif_corpus_frame * f = &rec->expect->frames[v->frame];
+        for(int y = 0; y < f->h; y++) {
+            if(memcmp(v->indices + (size_t)(f->y + y) * v->width + f->x, f->pixels + (size_t)y * f->w, f->w) != 0) {
+                rec->index_errors++;
+                break;
+            }
+        }
+    }
+}
+
+typedef struct {
+    const char * name;
+    gif_play_fn play;
+} decoder;
+
+static const decoder kReference = {"reference", gif_play_reference};
+static const decoder kCurrent = {"current", gif_play_current};
+
+/* Plays one source with a decoder; the recording is reset first */
+static int play(const decoder * d, const uint8_t * data, const char * path, recording * rec, gif_play_stats * stats)
+{
+    rec->count = 0;
+    rec->index_errors = 0;
+    return d->play(data, path, PASSES, record_frame, rec, stats);
+}
+
+static int compare(const char * label, const char * mode, const recording * ref, const gif_play_stats * ref_stats,
+                   const recording * cur, const gif_play_stats * cur_stats)
+{
+    if(ref_stats->result != cur_stats->result) {
+        printf("FAIL %s (%s): reference ended with %d, current with %d\n", label, mode, ref_stats->result,
+               cur_stats->result);
+        return 1;
+    }
+    if(ref->count != cur->count) {
+        printf("FAIL %s (%s): reference decoded %zu frames, current %zu\n", label, mode, ref->count, cur->count);
+        return 1;
+    }
+    for(size_t i = 0; i < ref->count; i++) {
+        if(ref->hashes[i] != cur->hashes[i]) {
+            printf("FAIL %s (%s): frame %zu differs\n", label, mode, i);
+            return 1;
+        }
+    }
+    if(cur->index_errors) {
+        printf("FAIL %s (%s): %d frames do not match the encoded pixels\n", label, mode, cur->index_errors);
+        return 1;
+    }
+    return 0;
+}
+
+/* Both decoders, from memory and from `path`; returns the number of failures */
+static int check_source(const char * label, const uint8_t * data, const char * path,
+                        const gif_corpus_item * expect, size_t * frames)
+{
+    recording ref = {0}, cur = {0};
+    gif_play_stats ref_stats, cur_stats;
+    int failures = 0;
+
+    if(play(&kReference, data, NULL, &ref, &ref_stats) != 0) {
+        printf("FAIL %s: reference decoder does not open it\n", label);
+        return 1;
+    }
+    cur.expect = expect;
+    if(play(&kCurrent, data, NULL, &cur, &cur_stats) != 0) {
+        printf("FAIL %s (mem): current decoder does not open it\n", label);
+        failures++;
+    }
+    else {
+        failures += compare(label, "mem", &ref, &ref_stats, &cur, &cur_stats);
+    }
+    if(play(&kCurrent, NULL, path, &cur, &cur_stats) != 0) {
+        printf("FAIL %s (fs): current decoder does not open it\n", label);
+        failures++;
+    }
+    else {
+        failures += compare(label, "fs", &ref, &ref_stats, &cur, &cur_stats);
+    }
+    *frames += ref.count;
+    free(ref.hashes);
+    free(cur.hashes);
+    return failures;
+}
+
+static uint8_t * load_file(const char * path, size_t * size)
+{
+    FILE * f = fopen(path, "rb");
+    if(f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t * data = n > 0 ? malloc((size_t)n) : NULL;
+    if(data && fread(data, 1, (size_t)n, f) != (size_t)n) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)n : 0;
+    return data;
+}
+
+static int write_file(const char * path, const uint8_t * data, size_t size)
+{
+    FILE * f = fopen(path, "wb");
+    if(f == NULL) return -1;
+    size_t n = fwrite(data, 1, size, f);
+    return (fclose(f) == 0 && n == size) ? 0 : -1;
+}
+
+int main(int argc, char ** argv)
+{
+    int corpus_count = 800;
+    const char * write_dir = NULL;
+    int opt;
+    while((opt = getopt(argc, argv, "n:w:")) != -1) {
+        if(opt == 'n') corpus_count = atoi(optarg);
+        else if(opt == 'w') write_dir = optarg;
+        else {
+            fprintf(stderr, "usage: %s [-n corpus_count] [-w dir] [file.gif...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    char tmp_path[] = "/tmp/gif_conformance_XXXXXX";
+    int tmp_fd = mkstemp(tmp_path);
+    if(tmp_fd < 0) {
+        perror("mkstemp");
+        return 2;
+    }
+    close(tmp_fd);
+
+    int failures = 0;
+    size_t frames = 0;
+    for(int seed = 0; seed < corpus_count; seed++) {
+        gif_corpus_item item;
+        char label[64], path[512];
+        gif_corpus_make((uint32_t)seed, &item);
+        snprintf(label, sizeof(label), "corpus %d (%ux%u)", seed, item.width, item.height);
+        if(write_dir) snprintf(path, sizeof(path), "%s/c%03d.gif", write_dir, seed);
+        else snprintf(path, sizeof(path), "%s", tmp_path);
+        if(write_file(path, item.data, item.size) != 0) {
+            printf("FAIL %s: cannot write %s\n", label, path);
+            failures++;
+        }
+        else {
+            failures += check_source(label, item.data, path, &item, &frames);
+        }
+        gif_corpus_free(&item);
+    }
+    unlink(tmp_path);
+
+    for(int i = optind; i < argc; i++) {
+        size_t size;
+        uint8_t * data = load_file(argv[i], &size);
+        if(data == NULL) {
+            printf("FAIL %s: cannot read\n", argv[i]);
+            failures++;
+            continue;
+        }
+        failures += check_source(argv[i], data, argv[i], NULL, &frames);
+        free(data);
+    }
+
+    printf("%d generated + %d files, %zu frames x %d passes compared: %d failures\n", corpus_count,
+           argc - optind, frames / PASSES, PASSES, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+#include "gif_corpus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint8_t * data;
+    size_t size, cap;
+} buffer;
+
+static void put(buffer * b, const void * src, size_t n)
+{
+    if(b->size + n > b->cap) {
+        b->cap = (b->size + n) * 2;
+        b->data = realloc(b->data, b->cap);
+    }
+    memcpy(b->data + b->size, src, n);
+    b->size += n;
+}
+
+static void put8(buffer * b, uint8_t v)
+{
+    put(b, &v, 1);
+}
+
+static void put16(buffer * b, uint16_t v)
+{
+    put8(b, v & 0xFF);
+    put8(b, v >> 8);
+}
+
+/* xorshift32; one generator per item keeps every seed independent */
+static uint32_t next(uint32_t * s)
+{
+    uint32_t x = *s;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *s = x;
+}
+
+/* Uniform in [lo, hi] */
+static int range(uint32_t * s, int lo, int hi)
+{
+    return lo + (int)(next(s) % (uint32_t)(hi - lo + 1));
+}
+
+static int chance(uint32_t * s, int percent)
+{
+    return (int)(next(s) % 100) < percent;
+}
+
+/* LZW code stream, packed LSB first */
+typedef struct {
+    buffer out;
+    uint32_t bits;
+    int nbits;
+    int code_size;
+} bit_writer;
+
+static void emit(bit_writer * w, int code)
+{
+    w->bits |= (uint32_t)code << w->nbits;
+    w->nbits += w->code_size;
+    while(w->nbits >= 8) {
+        put8(&w->out, w->bits & 0xFF);
+        w->bits >>= 8;
+        w->nbits -= 8;
+    }
+}
+
+#define DICT_SLOTS 8192 /* power of two, twice the 4096 codes */
+
+typedef struct {
+    int32_t key[DICT_SLOTS]; /* (prefix << 8 | byte) + 1, 0 = empty */
+    int16_t code[DICT_SLOTS];
+} dictionary;
+
+static int dict_find(const dictionary * d, int32_t key, int * slot)
+{
+    uint32_t h = ((uint32_t)key * 2654435761u) & (DICT_SLOTS - 1);
+    while(d->key[h] != 0) {
+        if(d->key[h] == key + 1) {
+            *slot = (int)h;
+            return d->code[h];
+        }
+        h = (h + 1) & (DICT_SLOTS - 1);
+    }
+    *slot = (int)h;
+    return -1;
+}
+
+static void lzw_encode(uint32_t * s, const uint8_t * px, size_t n, int min_code_size, buffer * out)
+{
+    static dictionary dict;
+    const int clear = 1 << min_code_size, eoi = clear + 1;
+    bit_writer w = {{0}, 0, 0, min_code_size + 1};
+    int next_code = eoi + 1;
+
+    memset(dict.key, 0, sizeof(dict.key));
+    emit(&w, clear);
+    int prefix = px[0];
+    for(size_t i = 1; i < n; i++) {
+        int32_t key = (int32_t)prefix << 8 | px[i];
+        int slot;
+        int code = dict_find(&dict, key, &slot);
+        if(code >= 0) {
+            prefix = code;
+            continue;
+        }
+        emit(&w, prefix);
+        if(next_code < 4096) {
+            dict.key[slot] = key + 1;
+            dict.code[slot] = (int16_t)next_code++;
+            /* The decoder widens one code later than the encoder adds */
+            if(next_code - 1 == (1 << w.code_size) && w.code_size < 12) w.code_size++;
+        }
+        else if(chance(s, 50)) {
+            emit(&w, clear);
+            w.code_size = min_code_size + 1;
+            next_code = eoi + 1;
+            memset(dict.key, 0, sizeof(dict.key));
+        }
+        prefix = px[i];
+    }
+    emit(&w, prefix);
+    emit(&w, eoi);
+    if(w.nbits) put8(&w.out, w.bits & 0xFF);
+
+    /* Sub-blocks of up to 255 bytes and the terminator */
+    for(size_t i = 0; i < w.out.size; i += 255) {
+        size_t len = w.out.size - i < 255 ? w.out.size - i : 255;
+        put8(out, (uint8_t)len);
+        put(out, w.out.data + i, len);
+    }
+    put8(out, 0);
+    free(w.out.data);
+}
+
+static void put_palette(uint32_t * s, buffer * b, int colors)
+{
+    for(int i = 0; i < colors * 3; i++) put8(b, (uint8_t)next(s));
+}
+
+void gif_corpus_make(uint32_t seed, gif_corpus_item * item)
+{
+    uint32_t s = seed * 2654435761u + 0x9E3779B9u;
+    buffer b = {0};
+    memset(item, 0, sizeof(*item));
+
+    int W = range(&s, 1, 300), H = range(&s, 1, 200);
+    int depth = range(&s, 1, 8), colors = 1 << depth;
+    item->width = (uint16_t)W;
+    item->height = (uint16_t)H;
+
+    put(&b, "GIF89a", 6);
+    put16(&b, (uint16_t)W);
+    put16(&b, (uint16_t)H);
+    put8(&b, 0x80 | (depth - 1));
+    put8(&b, (uint8_t)range(&s, 0, colors - 1)); /* background */
+    put8(&b, 0);
+    put_palette(&s, &b, colors);
+    put(&b, "\x21\xff\x0bNETSCAPE2.0\x03\x01\x00\x00\x00", 19);
+
+    item->frame_count = range(&s, 1, GIF_CORPUS_MAX_FRAMES);
+    for(int f = 0; f < item->frame_count; f++) {
+        gif_corpus_frame * fr = &item->frames[f];
+        int fw = range(&s, 1, W), fh = range(&s, 1, H);
+        int fx = range(&s, 0, W - fw), fy = range(&s, 0, H - fh);
+        if(chance(&s, 30)) {
+            fx = fy = 0;
+            fw = W;
+            fh = H;
+        }
+        int interlaced = chance(&s, 40);
+        int local = chance(&s, 30);
+        int d = local ? range(&s, 1, 8) : depth, n_colors = 1 << d;
+        int disposal = range(&s, 0, 3), transparent = chance(&s, 50);
+
+        /* Graphic control extension: disposal, transparency, 50 ms */
+        put(&b, "\x21\xf9\x04", 3);
+        put8(&b, (uint8_t)(disposal << 2 | transparent));
+        put16(&b, 5);
+        put8(&b, (uint8_t)range(&s, 0, n_colors - 1));
+        put8(&b, 0);
+
+        put8(&b, ',');
+        put16(&b, (uint16_t)fx);
+        put16(&b, (uint16_t)fy);
+        put16(&b, (uint16_t)fw);
+        put16(&b, (uint16_t)fh);
+        put8(&b, (uint8_t)((local ? 0x80 | (d - 1) : 0) | (interlaced ? 0x40 : 0)));
+        if(local) put_palette(&s, &b, n_colors);
+
+        size_t n = (size_t)fw * fh;
+        uint8_t * px = malloc(n);
+        int mode = range(&s, 0, 9);
+        if(mode < 3) {
+            for(size_t i = 0; i < n; i++) px[i] = (uint8_t)range(&s, 0, n_colors - 1);
+        }
+        else if(mode < 6) {
+            for(size_t i = 0; i < n; i++) px[i] = (uint8_t)(chance(&s, 50) ? 1 % n_colors : 0);
+        }
+        else {
+            for(size_t i = 0; i < n;) {
+                uint8_t v = (uint8_t)range(&s, 0, n_colors - 1);
+                for(int run = range(&s, 1, 300); run > 0 && i < n; run--) px[i++] = v;
+            }
+        }
+
+        /* Interlaced frames are stored in pass order: rows 0,8,.. 4,12,.. 2,6,.. 1,3,.. */
+        uint8_t * coded = px;
+        if(interlaced) {
+            static const int start[4] = {0, 4, 2, 1}, step[4] = {8, 8, 4, 2};
+            coded = malloc(n);
+            size_t row_out = 0;
+            for(int pass = 0; pass < 4; pass++) {
+                for(int y = start[pass]; y < fh; y += step[pass]) {
+                    memcpy(coded + row_out++ * fw, px + (size_t)y * fw, fw);
+                }
+            }
+        }
+        int min_code_size = d < 2 ? 2 : d;
+        put8(&b, (uint8_t)min_code_size);
+        lzw_encode(&s, coded, n, min_code_size, &b);
+        if(coded != px) free(coded);
+
+        fr->x = (uint16_t)fx;
+        fr->y = (uint16_t)fy;
+        fr->w = (uint16_t)fw;
+        fr->h = (uint16_t)fh;
+        fr->interlaced = (uint8_t)interlaced;
+        fr->pixels = px;
+    }
+    put8(&b, ';');
+    item->data = b.data;
+    item->size = b.size;
+}
+
+void gif_corpus_free(gif_corpus_item * item)
+{
+    for(int f = 0; f < item->frame_count; f++) free(item->frames[f].pixels);
+    free(item->data);
+    memset(item, 0, sizeof(*item));
+}
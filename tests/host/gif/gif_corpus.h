@@ -0,0 +1,32 @@
+#pragma once
+
+/* Deterministic synthetic GIFs for the decoder conformance test.
+ *
+ * Each seed yields one GIF89a of random size (1..300 x 1..200) and depth,
+ * 1..6 frames with random sub-rectangles, interlacing, local palettes,
+ * disposal modes and transparency, and pixel data that is either noise,
+ * two colours or long runs. The LZW encoder fills the code table and then
+ * either clears it or keeps coding with a full table. The pixels of every
+ * frame are kept so the decoded indices can be checked exactly. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GIF_CORPUS_MAX_FRAMES 6
+
+typedef struct {
+    uint16_t x, y, w, h;
+    uint8_t interlaced;
+    uint8_t * pixels; /* w * h palette indices, row-major in display order */
+} gif_corpus_frame;
+
+typedef struct {
+    uint8_t * data;
+    size_t size;
+    uint16_t width, height;
+    int frame_count;
+    gif_corpus_frame frames[GIF_CORPUS_MAX_FRAMES];
+} gif_corpus_item;
+
+void gif_corpus_make(uint32_t seed, gif_corpus_item * item);
+void gif_corpus_free(gif_corpus_item * item);
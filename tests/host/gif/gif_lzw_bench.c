@@ -0,0 +1,93 @@
+/* LZW decode speed of the current gifdec against the reference decoder.
+ *
+ *   gif_lzw_bench [-t min_ms] file.gif...
+ *
+ * Plays each file from memory with both decoders for at least min_ms and
+ * reports frame-rectangle megapixels per second, twice: in read_image()
+ * alone (the LZW decode, timed by GIFDEC_PROFILE) and in the whole of
+ * gd_get_frame, which adds disposal. Disposal of the default kind renders
+ * the previous frame onto the canvas with the same code in both decoders,
+ * so it narrows the second ratio. */
+
+#include "gif_player.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t * load_file(const char * path, size_t * size)
+{
+    FILE * f = fopen(path, "rb");
+    if(f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t * data = n > 0 ? malloc((size_t)n) : NULL;
+    if(data && fread(data, 1, (size_t)n, f) != (size_t)n) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = data ? (size_t)n : 0;
+    return data;
+}
+
+typedef struct {
+    double decode;      /* Mpx/s in read_image() */
+    double get_frame;   /* Mpx/s in gd_get_frame() */
+} rates;
+
+/* Rates over whole passes; zero if the file does not decode */
+static rates measure(gif_play_fn play, const uint8_t * data, uint32_t min_ms)
+{
+    rates r = {0, 0};
+    uint64_t us = 0, decode_us = 0, pixels = 0;
+    while(us < (uint64_t)min_ms * 1000u) {
+        gif_play_stats stats;
+        if(play(data, NULL, 4, NULL, NULL, &stats) != 0 || stats.result < 0 || stats.pixels == 0) return r;
+        us += stats.get_frame_us;
+        decode_us += stats.decode_us;
+        pixels += stats.pixels;
+    }
+    r.decode = decode_us ? (double)pixels / (double)decode_us : 0;
+    r.get_frame = (double)pixels / (double)us;
+    return r;
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t min_ms = 300;
+    int first = 1;
+    if(argc > 2 && strcmp(argv[1], "-t") == 0) {
+        min_ms = (uint32_t)atoi(argv[2]);
+        first = 3;
+    }
+    if(first >= argc) {
+        fprintf(stderr, "usage: %s [-t min_ms] file.gif...\n", argv[0]);
+        return 2;
+    }
+
+    printf("%-16s %30s %30s\n", "", "LZW decode Mpx/s", "gd_get_frame Mpx/s");
+    printf("%-16s %10s %10s %8s %10s %10s %8s\n", "file",
+           "reference", "current", "speedup", "reference", "current", "speedup");
+    int failures = 0;
+    for(int i = first; i < argc; i++) {
+        size_t size;
+        uint8_t * data = load_file(argv[i], &size);
+        const char * name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+        rates none = {0, 0};
+        rates ref = data ? measure(gif_play_reference, data, min_ms) : none;
+        rates cur = data ? measure(gif_play_current, data, min_ms) : none;
+        if(ref.decode == 0 || cur.decode == 0) {
+            printf("%-16s does not decode\n", name);
+            failures++;
+        }
+        else {
+            printf("%-16s %10.1f %10.1f %7.2fx %10.1f %10.1f %7.2fx\n", name,
+                   ref.decode, cur.decode, cur.decode / ref.decode,
+                   ref.get_frame, cur.get_frame, cur.get_frame / ref.get_frame);
+        }
+        free(data);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+#include "gif_player.h"
+#include "gifdec.h"
+
+#include <string.h>
+#include <time.h>
+
+#ifndef GIF_PLAYER
+#error "GIF_PLAYER must name the entry point for this decoder build"
+#endif
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+int GIF_PLAYER(const uint8_t * data, const char * path, int passes,
+               gif_frame_cb cb, void * ctx, gif_play_stats * stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    gd_GIF * gif = data ? gd_open_gif_data(data) : gd_open_gif_file(path);
+    if(gif == NULL) return -1;
+
+    for(int pass = 0; pass < passes; pass++) {
+        if(pass > 0) gd_rewind(gif);
+        for(int frame = 0;; frame++) {
+            uint64_t start = now_us();
+            int ret = gd_get_frame(gif);
+            stats->get_frame_us += now_us() - start;
+            if(ret != 1) {
+                stats->result = ret;
+                if(ret < 0) pass = passes;
+                break;
+            }
+            /* Stop at the trailer even if NETSCAPE2.0 asked to loop forever */
+            gif->loop_count = 1;
+            gd_render_frame(gif, gif->canvas);
+            stats->frames++;
+            stats->pixels += (uint64_t)gif->fw * gif->fh;
+            if(cb) {
+                gif_frame_view view = {
+                    .pass = pass, .frame = frame,
+                    .width = gif->width, .height = gif->height,
+                    .x = gif->fx, .y = gif->fy, .w = gif->fw, .h = gif->fh,
+                    .indices = gif->frame, .canvas = gif->canvas,
+                    .canvas_bpp = GIFDEC_USE_RGB565 ? 2 : 4,
+                };
+                gd_get_update_rect(gif, &view.ux, &view.uy, &view.uw, &view.uh);
+                cb(ctx, &view);
+            }
+        }
+    }
+#if GIFDEC_PROFILE
+    stats->decode_us = gif->stats.decode_us;
+#endif
+    gd_close_gif(gif);
+    return 0;
+}
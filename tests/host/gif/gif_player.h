@@ -0,0 +1,51 @@
+#pragma once
+
+/* Plays a GIF through one decoder build the way LvglGif does: gd_get_frame,
+ * then gd_render_frame onto the decoder's own canvas.
+ *
+ * gif_player.c is compiled once per decoder (the current gifdec.c and the
+ * reference copy in reference/), with GIF_PLAYER naming the entry point, so
+ * the two gd_GIF layouts never meet in one translation unit. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int pass, frame;
+    uint16_t width, height;
+    uint16_t x, y, w, h;            /* frame rectangle */
+    uint16_t ux, uy, uw, uh;        /* gd_get_update_rect() */
+    const uint8_t * indices;        /* width * height palette indices */
+    const uint8_t * canvas;         /* width * height * canvas_bpp */
+    int canvas_bpp;
+} gif_frame_view;
+
+typedef void (*gif_frame_cb)(void * ctx, const gif_frame_view * view);
+
+typedef struct {
+    uint32_t frames;
+    int result;                     /* gd_get_frame() value that ended the last pass */
+    uint64_t get_frame_us;          /* wall time in gd_get_frame (decode + dispose) */
+    uint64_t decode_us;             /* read_image() alone, from gd_Stats; 0 without GIFDEC_PROFILE */
+    uint64_t pixels;                /* frame-rectangle pixels decoded */
+} gif_play_stats;
+
+/* Open `data` (or `path` through lv_fs when data is NULL), play `passes`
+ * passes with gd_rewind in between and call `cb` after every frame.
+ * Returns -1 if the file does not open, otherwise 0; decode errors end the
+ * pass and show up in stats->result. */
+typedef int (*gif_play_fn)(const uint8_t * data, const char * path, int passes,
+                           gif_frame_cb cb, void * ctx, gif_play_stats * stats);
+
+int gif_play_current(const uint8_t * data, const char * path, int passes,
+                     gif_frame_cb cb, void * ctx, gif_play_stats * stats);
+int gif_play_reference(const uint8_t * data, const char * path, int passes,
+                       gif_frame_cb cb, void * ctx, gif_play_stats * stats);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+/* The slice of LVGL that gifdec.c uses, for host builds.
+ *
+ * lv_malloc/lv_realloc/lv_free keep byte counters (see lv_shim_heap) so the
+ * benchmarks can report allocation per frame and peak heap. New blocks are
+ * filled with a pattern instead of zeroes, like a real heap would leave
+ * them. lv_fs_* read plain host paths; an LVGL drive prefix ("A:") is
+ * ignored. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <limits.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LV_USE_DRAW_SW_ASM 0
+#define LV_DRAW_SW_ASM_HELIUM 2
+
+#define LV_LOG_WARN(...) do { fprintf(stderr, "[lv warn] "); fprintf(stderr, __VA_ARGS__); fputc('\n', stderr); } while (0)
+
+void * lv_malloc(size_t size);
+void * lv_realloc(void * ptr, size_t size);
+void lv_free(void * ptr);
+
+typedef struct {
+    size_t live_bytes;      /* currently allocated */
+    size_t peak_bytes;      /* high-water mark of live_bytes since the last reset */
+    uint64_t total_bytes;   /* bytes requested by lv_malloc/lv_realloc since the last reset */
+    uint64_t allocs;        /* number of lv_malloc/lv_realloc calls since the last reset */
+} lv_shim_heap_t;
+
+void lv_shim_heap(lv_shim_heap_t * stats);
+/* Zero the totals and restart the peak from the current live bytes */
+void lv_shim_heap_reset(void);
+
+typedef enum {
+    LV_FS_RES_OK = 0,
+    LV_FS_RES_FS_ERR,
+    LV_FS_RES_NOT_EX,
+} lv_fs_res_t;
+
+typedef enum {
+    LV_FS_MODE_WR = 0x01,
+    LV_FS_MODE_RD = 0x02,
+} lv_fs_mode_t;
+
+typedef enum {
+    LV_FS_SEEK_SET = 0,
+    LV_FS_SEEK_CUR = 1,
+    LV_FS_SEEK_END = 2,
+} lv_fs_whence_t;
+
+typedef struct {
+    FILE * file;
+} lv_fs_file_t;
+
+lv_fs_res_t lv_fs_open(lv_fs_file_t * file_p, const char * path, lv_fs_mode_t mode);
+lv_fs_res_t lv_fs_close(lv_fs_file_t * file_p);
+lv_fs_res_t lv_fs_read(lv_fs_file_t * file_p, void * buf, uint32_t btr, uint32_t * br);
+lv_fs_res_t lv_fs_seek(lv_fs_file_t * file_p, uint32_t pos, lv_fs_whence_t whence);
+lv_fs_res_t lv_fs_tell(lv_fs_file_t * file_p, uint32_t * pos);
+
+/* Number of lv_fs_read calls since start; shows what the read-ahead buffer saves */
+uint64_t lv_shim_fs_reads(void);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,107 @@
+#include "lvgl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Every block carries its size in front so lv_free can keep the counters.
+ * The header is 16 bytes to keep malloc's alignment for the caller. */
+#define HEADER_SIZE 16
+#define FILL_PATTERN 0xA5
+
+static lv_shim_heap_t s_heap;
+static uint64_t s_fs_reads;
+
+static void account(size_t old_size, size_t new_size)
+{
+    s_heap.live_bytes = s_heap.live_bytes - old_size + new_size;
+    if(s_heap.live_bytes > s_heap.peak_bytes) s_heap.peak_bytes = s_heap.live_bytes;
+    s_heap.total_bytes += new_size;
+    s_heap.allocs++;
+}
+
+void * lv_malloc(size_t size)
+{
+    uint8_t * block = malloc(HEADER_SIZE + size);
+    if(block == NULL) return NULL;
+    memcpy(block, &size, sizeof(size));
+    memset(block + HEADER_SIZE, FILL_PATTERN, size);
+    account(0, size);
+    return block + HEADER_SIZE;
+}
+
+void * lv_realloc(void * ptr, size_t size)
+{
+    if(ptr == NULL) return lv_malloc(size);
+    uint8_t * block = (uint8_t *)ptr - HEADER_SIZE;
+    size_t old_size;
+    memcpy(&old_size, block, sizeof(old_size));
+    block = realloc(block, HEADER_SIZE + size);
+    if(block == NULL) return NULL;
+    memcpy(block, &size, sizeof(size));
+    if(size > old_size) memset(block + HEADER_SIZE + old_size, FILL_PATTERN, size - old_size);
+    account(old_size, size);
+    return block + HEADER_SIZE;
+}
+
+void lv_free(void * ptr)
+{
+    if(ptr == NULL) return;
+    uint8_t * block = (uint8_t *)ptr - HEADER_SIZE;
+    size_t size;
+    memcpy(&size, block, sizeof(size));
+    s_heap.live_bytes -= size;
+    free(block);
+}
+
+void lv_shim_heap(lv_shim_heap_t * stats)
+{
+    *stats = s_heap;
+}
+
+void lv_shim_heap_reset(void)
+{
+    s_heap.peak_bytes = s_heap.live_bytes;
+    s_heap.total_bytes = 0;
+    s_heap.allocs = 0;
+}
+
+lv_fs_res_t lv_fs_open(lv_fs_file_t * file_p, const char * path, lv_fs_mode_t mode)
+{
+    if(path[0] != '\0' && path[1] == ':') path += 2;
+    file_p->file = fopen(path, mode == LV_FS_MODE_WR ? "wb" : "rb");
+    return file_p->file ? LV_FS_RES_OK : LV_FS_RES_NOT_EX;
+}
+
+lv_fs_res_t lv_fs_close(lv_fs_file_t * file_p)
+{
+    fclose(file_p->file);
+    file_p->file = NULL;
+    return LV_FS_RES_OK;
+}
+
+lv_fs_res_t lv_fs_read(lv_fs_file_t * file_p, void * buf, uint32_t btr, uint32_t * br)
+{
+    size_t n = fread(buf, 1, btr, file_p->file);
+    s_fs_reads++;
+    if(br) *br = (uint32_t)n;
+    return ferror(file_p->file) ? LV_FS_RES_FS_ERR : LV_FS_RES_OK;
+}
+
+lv_fs_res_t lv_fs_seek(lv_fs_file_t * file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+    int origin = whence == LV_FS_SEEK_SET ? SEEK_SET : whence == LV_FS_SEEK_CUR ? SEEK_CUR : SEEK_END;
+    return fseek(file_p->file, (long)pos, origin) == 0 ? LV_FS_RES_OK : LV_FS_RES_FS_ERR;
+}
+
+lv_fs_res_t lv_fs_tell(lv_fs_file_t * file_p, uint32_t * pos)
+{
+    long p = ftell(file_p->file);
+    if(p < 0) return LV_FS_RES_FS_ERR;
+    *pos = (uint32_t)p;
+    return LV_FS_RES_OK;
+}
+
+uint64_t lv_shim_fs_reads(void)
+{
+    return s_fs_reads;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// Just enough Application for thing.cc: scheduled calls run right away
+
+#include <functional>
+
+class Application {
+public:
+    static Application& GetInstance() {
+        static Application instance;
+        return instance;
+    }
+
+    void Schedule(std::function<void()> callback) {
+        callback();
+    }
+};
@@ -0,0 +1,8 @@
+// Host driver for main/iot/thing_state_bench.cc
+
+#include "thing_state_bench.h"
+
+int main() {
+    thing_state_run_benchmark();
+    return 0;
+}
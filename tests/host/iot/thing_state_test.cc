@@ -0,0 +1,194 @@
+// ThingManager::AppendStatesJson against the report it replaced, which
+// compared each thing's full state string with the one last sent and sent
+// the whole state of every thing that differed. The server replaces a
+// thing's state with what it receives, so a delta report has to carry the
+// same things with the same full states.
+
+#include "thing_manager.h"
+#include "host_test.h"
+
+#include <cJSON.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Values {
+    bool power = false;
+    int level = 50;
+    std::string label = "lamp";
+};
+
+class TestThing : public iot::Thing {
+public:
+    TestThing(const std::string& name, Values* values) : Thing(name, "test") {
+        properties_.AddBooleanProperty("power", "on/off", [values]() -> bool {
+            return values->power;
+        });
+        properties_.AddNumberProperty("level", "0-100", [values]() -> int {
+            return values->level;
+        });
+        properties_.AddStringProperty("label", "display name", [values]() -> std::string {
+            return values->label;
+        });
+    }
+
+    iot::PropertyList& properties() { return properties_; }
+};
+
+// The old ThingManager::GetStatesJson(delta = true); it did not escape
+// strings, so the labels compared against it need none
+class LegacyStates {
+public:
+    bool GetStatesJson(const std::vector<TestThing*>& things, std::string& json) {
+        bool changed = false;
+        json = "[";
+        for (auto& thing : things) {
+            std::string state = GetStateJson(thing);
+            auto it = last_states_.find(thing->name());
+            if (it != last_states_.end() && it->second == state) {
+                continue;
+            }
+            changed = true;
+            last_states_[thing->name()] = state;
+            json += state + ",";
+        }
+        if (json.back() == ',') {
+            json.pop_back();
+        }
+        json += "]";
+        return changed;
+    }
+
+private:
+    std::map<std::string, std::string> last_states_;
+
+    static std::string GetStateJson(TestThing* thing) {
+        std::string properties = "{";
+        for (auto& property : thing->properties()) {
+            std::string value;
+            if (property.type() == iot::kValueTypeBoolean) {
+                value = property.boolean() ? "true" : "false";
+            } else if (property.type() == iot::kValueTypeNumber) {
+                value = std::to_string(property.number());
+            } else {
+                value = "\"" + property.string() + "\"";
+            }
+            properties += "\"" + property.name() + "\":" + value + ",";
+        }
+        properties.pop_back();
+        properties += "}";
+        return "{\"name\":\"" + thing->name() + "\",\"state\":" + properties + "}";
+    }
+};
+
+struct Fixture {
+    std::vector<Values> values;
+    std::vector<std::unique_ptr<TestThing>> owners;
+    std::vector<TestThing*> test_things;
+    std::vector<iot::Thing*> things;
+
+    explicit Fixture(int count) : values(count) {
+        for (int i = 0; i < count; i++) {
+            owners.emplace_back(new TestThing("Thing" + std::to_string(i), &values[i]));
+            test_things.push_back(owners.back().get());
+            things.push_back(owners.back().get());
+        }
+    }
+
+    bool Report(std::string& json, bool delta) {
+        json.clear();
+        return iot::ThingManager::AppendStatesJson(things, json, delta);
+    }
+};
+
+void TestMatchesLegacy() {
+    // Two copies of the same things and the same changes, one per reporter
+    Fixture current(24);
+    Fixture legacy_fixture(24);
+    LegacyStates legacy;
+    std::mt19937 random(7);
+    std::string json;
+    std::string expected;
+    int mismatches = 0;
+    int reports = 0;
+    for (int round = 0; round < 2000; round++) {
+        // Often nothing changes between reports, sometimes a value is set to
+        // what it already was, sometimes several things change
+        int changes = random() % 4;
+        for (int change = 0; change < changes; change++) {
+            int thing = random() % current.values.size();
+            int value = random() % 3;
+            int property = random() % 3;
+            for (auto* values : {&current.values[thing], &legacy_fixture.values[thing]}) {
+                switch (property) {
+                case 0:
+                    values->power = value != 0;
+                    break;
+                case 1:
+                    values->level = value * 50;
+                    break;
+                default:
+                    values->label = "lamp " + std::to_string(value);
+                    break;
+                }
+            }
+        }
+        bool legacy_changed = legacy.GetStatesJson(legacy_fixture.test_things, expected);
+        bool changed = current.Report(json, true);
+        CHECK_EQ(changed, legacy_changed);
+        if (json != expected) {
+            if (mismatches++ < 5) {
+                std::printf("  round %d\n    old: %s\n    new: %s\n", round, expected.c_str(), json.c_str());
+            }
+            host_test::Failures()++;
+        }
+        reports += changed;
+    }
+    std::printf("  2000 rounds, %d reports\n", reports);
+}
+
+void TestChangedThingSendsFullState() {
+    Fixture fixture(3);
+    std::string json;
+    CHECK(fixture.Report(json, false));
+    CHECK(!fixture.Report(json, true));
+    CHECK(json == "[]");
+
+    fixture.values[1].level = 80;
+    CHECK(fixture.Report(json, true));
+    CHECK(json == R"([{"name":"Thing1","state":{"power":false,"level":80,"label":"lamp"}}])");
+    CHECK(!fixture.Report(json, true));
+
+    // A value changed and changed back between reports is no change
+    fixture.values[2].power = true;
+    fixture.values[2].power = false;
+    CHECK(!fixture.Report(json, true));
+}
+
+void TestEscapedStrings() {
+    Fixture fixture(1);
+    const std::string label = "客厅 \"主灯\" \\ line\nbreak\ttab\x01";
+    fixture.values[0].label = label;
+    std::string json;
+    CHECK(fixture.Report(json, true));
+    cJSON* root = cJSON_Parse(json.c_str());
+    CHECK(root != nullptr);
+    auto state = cJSON_GetObjectItem(cJSON_GetArrayItem(root, 0), "state");
+    auto parsed = cJSON_GetObjectItem(state, "label");
+    CHECK(cJSON_IsString(parsed) && label == parsed->valuestring);
+    cJSON_Delete(root);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestMatchesLegacy);
+    RUN_TEST(TestChangedThingSendsFullState);
+    RUN_TEST(TestEscapedStrings);
+    return host_test::Finish();
+}
@@ -0,0 +1,217 @@
+// Replays recorded downlink traces (traces/*.trace, see make_traces.py)
+// through OpusJitterBuffer the way MqttProtocol drives it: Push() at each
+// arrival, Poll() from a 20 ms timer. Checks that frames come out in send
+// order, that every received packet is accounted for, that concealment runs
+// stay within kMaxConcealFrames and that the stats stay within the bounds in
+// the trace header; prints the stats and the delay the buffer added.
+//
+// jitter_replay [-d max_delay_ms] trace...
+
+#include "jitter_buffer.h"
+#include "host_test.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// MQTT_JITTER_POLL_INTERVAL_MS, CONFIG_AUDIO_JITTER_MAX_DELAY_MS default
+constexpr int64_t kPollIntervalUs = 20000;
+constexpr int kDefaultMaxDelayMs = 240;
+
+struct Arrival {
+    int64_t time_us;
+    uint32_t sequence;
+    uint32_t frame;
+};
+
+struct Trace {
+    std::string name;
+    int frame_ms = 60;
+    std::vector<Arrival> arrivals;
+    std::map<std::string, long> max;     // "# max stat=n ..."
+    std::map<std::string, long> expect;  // "# expect stat=n ..."
+};
+
+bool LoadTrace(const char* path, Trace& trace) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    trace.name = path;
+    size_t slash = trace.name.find_last_of('/');
+    if (slash != std::string::npos) {
+        trace.name = trace.name.substr(slash + 1);
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] == '#') {
+            std::string hash, key;
+            fields >> hash >> key;
+            if (key == "frame_ms") {
+                fields >> trace.frame_ms;
+            } else if (key == "max" || key == "expect") {
+                // "# expect a=1 b=2 max c=3": each keyword applies to the bounds after it
+                auto* bounds = key == "max" ? &trace.max : &trace.expect;
+                std::string bound;
+                while (fields >> bound) {
+                    size_t eq = bound.find('=');
+                    if (eq != std::string::npos) {
+                        (*bounds)[bound.substr(0, eq)] = std::atol(bound.c_str() + eq + 1);
+                    } else if (bound == "max" || bound == "expect") {
+                        bounds = bound == "max" ? &trace.max : &trace.expect;
+                    }
+                }
+            }
+            continue;
+        }
+        Arrival arrival;
+        long long time_us;
+        unsigned long sequence, frame;
+        if (!(fields >> time_us >> sequence >> frame)) {
+            std::printf("%s: bad line '%s'\n", path, line.c_str());
+            return false;
+        }
+        arrival.time_us = time_us;
+        arrival.sequence = (uint32_t)sequence;
+        arrival.frame = (uint32_t)frame;
+        trace.arrivals.push_back(arrival);
+    }
+    return !trace.arrivals.empty();
+}
+
+long Percentile(std::vector<long>& values, int percent) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, values.size() * percent / 100)];
+}
+
+void Replay(const Trace& trace, int max_delay_ms) {
+    OpusJitterBuffer buffer(trace.frame_ms, max_delay_ms);
+
+    // Payload = frame number, so the output can be checked against send order
+    std::vector<int64_t> arrival_of;
+    for (const auto& arrival : trace.arrivals) {
+        if (arrival.frame >= arrival_of.size()) {
+            arrival_of.resize(arrival.frame + 1, -1);
+        }
+        if (arrival_of[arrival.frame] < 0) {
+            arrival_of[arrival.frame] = arrival.time_us;
+        }
+    }
+
+    int64_t now = 0;
+    long played = 0;
+    long last_frame = -1;
+    long out_of_order = 0;
+    long conceal_run = 0;
+    long longest_conceal_run = 0;
+    std::vector<long> added_delay_ms;
+    auto output = [&](std::vector<uint8_t>&& opus) {
+        if (opus.empty()) {
+            longest_conceal_run = std::max(longest_conceal_run, ++conceal_run);
+            return;
+        }
+        conceal_run = 0;
+        uint32_t frame;
+        std::memcpy(&frame, opus.data(), sizeof(frame));
+        if ((long)frame <= last_frame) {
+            out_of_order++;
+        }
+        last_frame = frame;
+        played++;
+        added_delay_ms.push_back((long)((now - arrival_of[frame]) / 1000));
+    };
+
+    size_t next = 0;
+    int64_t end_us = trace.arrivals.back().time_us + 2 * 1000 * max_delay_ms;
+    for (int64_t tick = trace.arrivals.front().time_us; tick <= end_us; tick += kPollIntervalUs) {
+        while (next < trace.arrivals.size() && trace.arrivals[next].time_us <= tick) {
+            const Arrival& arrival = trace.arrivals[next++];
+            now = arrival.time_us;
+            std::vector<uint8_t> opus(sizeof(arrival.frame));
+            std::memcpy(opus.data(), &arrival.frame, sizeof(arrival.frame));
+            buffer.Push(arrival.sequence, std::move(opus), now, output);
+        }
+        now = tick;
+        buffer.Poll(now, output);
+    }
+
+    auto stats = buffer.GetStats();
+    long p50 = Percentile(added_delay_ms, 50);
+    long p99 = Percentile(added_delay_ms, 99);
+    long max = Percentile(added_delay_ms, 100);
+    std::printf("%-18s recv %4u late %3u dup %3u lost %3u concealed %3u resync %u | jitter %3d ms target %3d ms "
+                "| added delay p50 %3ld p99 %3ld max %3ld ms\n",
+                trace.name.c_str(), stats.received, stats.late, stats.duplicate, stats.lost, stats.concealed,
+                stats.resyncs, stats.jitter_ms, stats.target_delay_ms, p50, p99, max);
+
+    CHECK_EQ(out_of_order, 0);
+    CHECK_EQ(stats.depth, 0u);
+    CHECK_EQ(played, (long)stats.received - (long)stats.late - (long)stats.duplicate);
+    CHECK(stats.concealed <= stats.lost);
+    CHECK(longest_conceal_run <= (long)OpusJitterBuffer::kMaxConcealFrames);
+
+    const std::map<std::string, long> values = {
+        {"late", stats.late}, {"duplicate", stats.duplicate}, {"lost", stats.lost},
+        {"concealed", stats.concealed}, {"resyncs", stats.resyncs}, {"p99_ms", p99}, {"max_ms", max},
+    };
+    for (const auto& [stat, bound] : trace.max) {
+        auto value = values.find(stat);
+        CHECK(value != values.end());
+        if (value != values.end() && value->second > bound) {
+            std::printf("%s: %s %ld above %ld\n", trace.name.c_str(), stat.c_str(), value->second, bound);
+            host_test::Failures()++;
+        }
+    }
+    for (const auto& [stat, expected] : trace.expect) {
+        auto value = values.find(stat);
+        CHECK(value != values.end());
+        if (value != values.end() && value->second != expected) {
+            std::printf("%s: %s %ld, expected %ld\n", trace.name.c_str(), stat.c_str(), value->second, expected);
+            host_test::Failures()++;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int max_delay_ms = kDefaultMaxDelayMs;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:")) != -1) {
+        if (opt == 'd') {
+            max_delay_ms = std::atoi(optarg);
+        } else {
+            std::fprintf(stderr, "usage: %s [-d max_delay_ms] trace...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (optind == argc) {
+        std::fprintf(stderr, "usage: %s [-d max_delay_ms] trace...\n", argv[0]);
+        return 2;
+    }
+    for (int i = optind; i < argc; i++) {
+        Trace trace;
+        if (!LoadTrace(argv[i], trace)) {
+            std::printf("%s: cannot read trace\n", argv[i]);
+            host_test::Failures()++;
+            continue;
+        }
+        Replay(trace, max_delay_ms);
+    }
+    return host_test::Finish();
+}
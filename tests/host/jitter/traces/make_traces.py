@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+"""Generate the downlink traces jitter_replay plays through OpusJitterBuffer.
+
+Each trace is one line per datagram as it reaches the device:
+
+    <arrival_us> <sequence> <frame>
+
+sorted by arrival. <sequence> is the header sequence number the buffer keys
+on; <frame> counts frames in send order across server restarts, so the
+replay can check playout order. Lines starting with '#' are comments, except
+
+    # frame_ms <n>          frame duration of the stream
+    # max <stat>=<n> ...    upper bounds jitter_replay enforces
+
+The traces are synthetic but shaped after what Wi-Fi downlinks do: uniform
+send jitter, random and bursty loss, duplicates, stalls that deliver a
+backlog at once, counter wrap and a server restart. Re-run this script after
+changing a scenario; the output is deterministic.
+"""
+
+import os
+import random
+
+FRAME_US = 60000
+FRAMES = 1000
+
+
+def scenario(rng, jitter_us=5000, loss=0.0, burst=None, duplicate_every=0, stall=None,
+             first_sequence=1, restart_at=None):
+    """Returns [(arrival_us, sequence, frame)] sorted by arrival."""
+    packets = []
+    sequence = first_sequence
+    in_burst = False
+    for frame in range(FRAMES):
+        if restart_at is not None and frame == restart_at:
+            sequence = 1
+        send_us = frame * FRAME_US
+        seq = sequence & 0xFFFFFFFF
+        sequence += 1
+
+        if burst:
+            # Gilbert-Elliott: enter a loss burst with p, leave it with r
+            p, r = burst
+            in_burst = (rng.random() >= r) if in_burst else (rng.random() < p)
+            if in_burst:
+                continue
+        if rng.random() < loss:
+            continue
+
+        arrival = send_us + rng.randint(0, jitter_us)
+        if stall and stall[0] <= arrival < stall[0] + stall[1]:
+            # Nothing gets through during the stall; the queued backlog then
+            # lands in order, 0.5 ms apart
+            arrival = stall[0] + stall[1] + (arrival - stall[0]) // FRAME_US * 500
+        packets.append((arrival, seq, frame))
+        if duplicate_every and frame % duplicate_every == 0:
+            packets.append((arrival + 3000, seq, frame))
+    packets.sort()
+    return packets
+
+
+SCENARIOS = {
+    # name: (description, scenario kwargs, bounds for jitter_replay)
+    "clean": ("in order, 5 ms jitter", {},
+              "expect late=0 lost=0 concealed=0 max_ms=0"),
+    "loss3": ("3% random loss, 5 ms jitter", {"loss": 0.03},
+              "expect late=0 max lost=35 p99_ms=80"),
+    "jitter40": ("40 ms jitter, 3% loss", {"jitter_us": 40000, "loss": 0.03},
+                 "expect late=0 max lost=35 p99_ms=80"),
+    "jitter150": ("150 ms jitter: up to 3 frames out of order, 3% loss",
+                  {"jitter_us": 150000, "loss": 0.03},
+                  "expect late=0 max lost=40 p99_ms=160"),
+    "duplicates": ("every 97th frame twice, 3 ms apart, 3% loss",
+                   {"loss": 0.03, "duplicate_every": 97},
+                   # A copy of a frame already played counts as late
+                   "max late=11 lost=35 p99_ms=80"),
+    "burst": ("bursty loss (Gilbert-Elliott p=2% r=30%), 20 ms jitter",
+              {"jitter_us": 20000, "burst": (0.02, 0.3)},
+              "expect late=0 max lost=100 p99_ms=80"),
+    "stall": ("1.5 s stall at 20 s, then the backlog in order", {"stall": (20000000, 1500000)},
+              "expect late=0 lost=0 concealed=0"),
+    "wrap": ("sequence counter wraps past 2^32, 40 ms jitter",
+             {"first_sequence": 0xFFFFFE00, "jitter_us": 40000},
+             "expect late=0 lost=0 resyncs=0"),
+    "restart": ("server restarts its counter at frame 500", {"restart_at": 500, "jitter_us": 20000},
+                "expect late=0 lost=0 resyncs=1"),
+}
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    for index, (name, (description, kwargs, bounds)) in enumerate(SCENARIOS.items()):
+        rng = random.Random(index + 1)
+        packets = scenario(rng, **kwargs)
+        with open(os.path.join(here, name + ".trace"), "w") as f:
+            f.write("# %s\n" % description)
+            f.write("# frame_ms %d\n" % (FRAME_US // 1000))
+            f.write("# %s\n" % bounds)
+            for arrival, seq, frame in packets:
+                f.write("%d %d %d\n" % (arrival, seq, frame))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,294 @@
+// MultipartParser fed the way httpd_req_recv hands it data: in chunks of
+// any size, with the delimiter split at every possible offset and part
+// bodies built from the delimiter's own bytes.
+
+#include "multipart_parser.h"
+#include "host_test.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct File {
+    std::string name;
+    std::string filename;
+    std::string body;
+};
+
+struct Result {
+    bool ok = true;
+    bool complete = false;
+    bool nested = false;    // a callback arrived outside begin/end
+    std::vector<MultipartParser::Part> parts;
+    std::vector<std::string> bodies;
+};
+
+std::string Build(const std::string& boundary, const std::vector<File>& files, const std::string& preamble) {
+    std::string message = preamble;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (i > 0) {
+            message += "\r\n";
+        }
+        message += "--" + boundary + "\r\n";
+        message += "Content-Disposition: form-data; name=\"" + files[i].name + "\"; filename=\"" +
+                   files[i].filename + "\"\r\n";
+        message += "Content-Type: image/gif\r\n\r\n";
+        message += files[i].body;
+    }
+    // The epilogue may contain anything, including another delimiter
+    message += "\r\n--" + boundary + "--\r\nepilogue\r\n--" + boundary + "\r\n";
+    return message;
+}
+
+// Feed `message` in the chunk sizes `next_chunk` picks
+template <typename NextChunk>
+Result Parse(const std::string& boundary, const std::string& message, NextChunk next_chunk) {
+    Result result;
+    bool in_part = false;
+    MultipartParser::Callbacks callbacks;
+    callbacks.on_part_begin = [&](const MultipartParser::Part& part) {
+        result.nested |= in_part;
+        in_part = true;
+        result.parts.push_back(part);
+        result.bodies.emplace_back();
+        return true;
+    };
+    callbacks.on_part_data = [&](const uint8_t* data, size_t size) {
+        result.nested |= !in_part;
+        if (in_part) {
+            result.bodies.back().append((const char*)data, size);
+        }
+        return true;
+    };
+    callbacks.on_part_end = [&]() {
+        result.nested |= !in_part;
+        in_part = false;
+        return true;
+    };
+
+    MultipartParser parser(boundary, callbacks);
+    size_t pos = 0;
+    while (pos < message.size() && result.ok) {
+        size_t size = std::min(std::max<size_t>(next_chunk(pos), 1), message.size() - pos);
+        result.ok = parser.Feed((const uint8_t*)message.data() + pos, size);
+        pos += size;
+    }
+    result.complete = parser.IsComplete();
+    return result;
+}
+
+bool Matches(const Result& result, const std::vector<File>& files) {
+    if (!result.ok || !result.complete || result.nested || result.parts.size() != files.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (result.parts[i].name != files[i].name || result.bodies[i] != files[i].body ||
+            result.parts[i].content_type != "image/gif") {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A body made only of CR, LF, '-' and boundary characters, with every full
+// delimiter removed. Prefixes of the delimiter stay in, also at the very end
+// where they run into the real one.
+std::string AdversarialBody(std::mt19937& rng, const std::string& boundary, size_t length) {
+    const std::string delimiter = "\r\n--" + boundary;
+    const std::string alphabet = "\r\n-" + boundary + "Z";
+    std::string body;
+    for (size_t i = 0; i < length; ++i) {
+        body += alphabet[rng() % alphabet.size()];
+    }
+    for (;;) {
+        size_t found = (body + delimiter).find(delimiter);
+        if (found == body.size()) {
+            return body;
+        }
+        body.erase(found, 1);
+    }
+}
+
+const char* const kBoundaries[] = {"----WebKitFormBoundary7MA4YWxkTrZu0gW", "aaaab", "x"};
+
+void TestOneByteChunks() {
+    for (const char* boundary : kBoundaries) {
+        const std::string prefix(boundary, strlen(boundary) - 1);
+        std::vector<File> files = {
+            {"file", "a.gif", "GIF89a\r\n--" + prefix + "\r\n\r\n"},
+            {"file2", "b.gif", ""},
+            {"file3", "c.gif", std::string(3000, '-')},
+        };
+        std::string message = Build(boundary, files, "");
+        Result result = Parse(boundary, message, [](size_t) { return 1; });
+        CHECK(Matches(result, files));
+        CHECK(!result.parts.empty() && result.parts[0].filename == "a.gif");
+    }
+}
+
+// Two chunks, cut at every offset of the message, so each byte of every
+// delimiter (and of the CRLF before it) lands at a chunk edge once
+void TestSplitAtEveryOffset() {
+    for (const char* boundary : kBoundaries) {
+        std::vector<File> files = {
+            {"file", "a.gif", "GIF89a\r\n-\r\n--\r"},
+            {"file", "b.gif", std::string("\r\n-") + boundary + "\r\n--"},
+        };
+        std::string message = Build(boundary, files, "preamble\r\n");
+        int failures = 0;
+        for (size_t cut = 1; cut < message.size(); ++cut) {
+            Result result = Parse(boundary, message, [cut](size_t pos) { return pos == 0 ? cut : SIZE_MAX; });
+            failures += !Matches(result, files);
+        }
+        CHECK_EQ(failures, 0);
+    }
+}
+
+// Three chunks: the delimiter before the second part split in three
+// everywhere it can be
+void TestDelimiterSplitThreeWays() {
+    const std::string boundary = "aaaab";
+    std::vector<File> files = {{"f", "a.gif", "aaaa\r\n--aaaa"}, {"g", "b.gif", "--aaaab"}};
+    std::string message = Build(boundary, files, "");
+    size_t start = message.find("\r\n--" + boundary, message.find("aaaa\r\n--aaaa") + 12);
+    size_t length = boundary.size() + 4;
+    int failures = 0;
+    for (size_t a = 1; a < length; ++a) {
+        for (size_t b = a + 1; b < length; ++b) {
+            size_t first = start + a;
+            size_t second = start + b;
+            Result result = Parse(boundary, message, [=](size_t pos) {
+                return pos == 0 ? first : pos == first ? second - first : SIZE_MAX;
+            });
+            failures += !Matches(result, files);
+        }
+    }
+    CHECK_EQ(failures, 0);
+}
+
+void TestBoundaryLikePayload() {
+    const std::string boundary = "----WebKitFormBoundaryABC";
+    std::vector<File> files = {
+        // The boundary without its leading CRLF is ordinary data
+        {"f", "a.gif", "--" + boundary + "\r\n--" + boundary.substr(0, 10) + "\n--" + boundary},
+        // So is one byte short of the delimiter, at the end of the body
+        {"g", "b.gif", "data\r\n--" + boundary.substr(0, boundary.size() - 1)},
+        // And a CR or LF alone in front of it
+        {"h", "c.gif", "\r--" + boundary + "\n--" + boundary + "\r\r\n-"},
+    };
+    std::string message = Build(boundary, files, "");
+    CHECK(Matches(Parse(boundary, message, [](size_t) { return SIZE_MAX; }), files));
+    CHECK(Matches(Parse(boundary, message, [](size_t) { return 1; }), files));
+    CHECK(Matches(Parse(boundary, message, [](size_t) { return 7; }), files));
+}
+
+// Random bodies over the delimiter's alphabet in random chunk sizes
+void TestRandomMessages() {
+    std::mt19937 rng(1);
+    int failures = 0;
+    for (int iteration = 0; iteration < 20000; ++iteration) {
+        const std::string boundary = kBoundaries[iteration % 3];
+        std::vector<File> files;
+        int count = 1 + rng() % 3;
+        for (int i = 0; i < count; ++i) {
+            files.push_back({"f" + std::to_string(i), std::to_string(i) + ".gif",
+                             AdversarialBody(rng, boundary, rng() % 300)});
+        }
+        std::string preamble = rng() % 2 ? "" : (rng() % 2 ? "\r\n" : "preamble\r\n--\r\n");
+        std::string message = Build(boundary, files, preamble);
+        Result result = Parse(boundary, message, [&rng](size_t) {
+            return rng() % 4 == 0 ? 1 : 1 + rng() % (rng() % 2 ? 7 : 200);
+        });
+        if (!Matches(result, files)) {
+            if (failures++ == 0) {
+                std::printf("first mismatch at iteration %d\n", iteration);
+            }
+        }
+    }
+    CHECK_EQ(failures, 0);
+}
+
+void TestFilenames() {
+    const std::string boundary = "b";
+    std::vector<File> files = {{"file", "C:\\\\Users\\\\me\\\\cat.gif", "x"}, {"file", "dir/dog.gif", "y"}};
+    Result result = Parse(boundary, Build(boundary, files, ""), [](size_t) { return SIZE_MAX; });
+    CHECK(result.ok && result.parts.size() == 2);
+    if (result.parts.size() == 2) {
+        // Browsers on Windows may send the full path; only the base name is kept
+        CHECK(result.parts[0].filename == "cat.gif");
+        CHECK(result.parts[1].filename == "dog.gif");
+    }
+}
+
+void TestParseBoundary() {
+    std::string boundary;
+    CHECK(MultipartParser::ParseBoundary("multipart/form-data; boundary=----WebKitFormBoundaryX", boundary));
+    CHECK(boundary == "----WebKitFormBoundaryX");
+    CHECK(MultipartParser::ParseBoundary("multipart/form-data; charset=utf-8; BOUNDARY=\"a b;c\"", boundary));
+    CHECK(boundary == "a b;c");
+    CHECK(MultipartParser::ParseBoundary("multipart/form-data; boundary=abc ; x=y", boundary));
+    CHECK(boundary == "abc");
+    CHECK(!MultipartParser::ParseBoundary("multipart/form-data", boundary));
+    CHECK(!MultipartParser::ParseBoundary("multipart/form-data; boundary=", boundary));
+    CHECK(!MultipartParser::ParseBoundary(("multipart/form-data; boundary=" + std::string(71, 'a')).c_str(), boundary));
+    CHECK(!MultipartParser::ParseBoundary(nullptr, boundary));
+}
+
+void TestMalformed() {
+    auto feed = [](MultipartParser& parser, const std::string& data) {
+        return parser.Feed((const uint8_t*)data.data(), data.size());
+    };
+    {
+        // Truncated: no error, but not complete either
+        MultipartParser parser("b", {});
+        CHECK(feed(parser, "--b\r\nX: y\r\n\r\nabc"));
+        CHECK(!parser.IsComplete());
+        CHECK(!parser.HasError());
+    }
+    {
+        // A longer boundary is not ours
+        MultipartParser parser("b", {});
+        CHECK(!feed(parser, "--bX\r\n"));
+        CHECK(parser.HasError());
+        CHECK(parser.error() != nullptr);
+        // and the parser stays failed
+        CHECK(!feed(parser, "--b--\r\n"));
+    }
+    {
+        // Header line over the limit
+        MultipartParser parser("b", {});
+        CHECK(!feed(parser, "--b\r\nX-Long: " + std::string(MultipartParser::kMaxHeaderLineLength, 'a') + "\r\n"));
+    }
+}
+
+void TestCallbackAbort() {
+    MultipartParser::Callbacks callbacks;
+    int ends = 0;
+    callbacks.on_part_data = [](const uint8_t*, size_t) { return false; };
+    callbacks.on_part_end = [&ends]() { ends++; return true; };
+    MultipartParser parser("b", callbacks);
+    std::string message = "--b\r\n\r\nabc\r\n--b--";
+    CHECK(!parser.Feed((const uint8_t*)message.data(), message.size()));
+    CHECK(parser.HasError());
+    CHECK_EQ(ends, 0);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestOneByteChunks);
+    RUN_TEST(TestSplitAtEveryOffset);
+    RUN_TEST(TestDelimiterSplitThreeWays);
+    RUN_TEST(TestBoundaryLikePayload);
+    RUN_TEST(TestRandomMessages);
+    RUN_TEST(TestFilenames);
+    RUN_TEST(TestParseBoundary);
+    RUN_TEST(TestMalformed);
+    RUN_TEST(TestCallbackAbort);
+    return host_test::Finish();
+}
@@ -0,0 +1,211 @@
+// Time per datagram of the UDP audio encryption at Opus packet sizes: the
+// old SendAudio, AudioCrypto::Seal, the cipher call alone, and a Seal whose
+// keystream had been computed in advance. The last one is what keystream
+// precompute could at best achieve; the bench also shows why it cannot be
+// done: the keystream of a packet changes with the payload size, which is
+// only known once the frame is encoded. The "3 frames" rows compare three
+// packets with one multi-frame datagram (AudioFrameBatcher), the one form of
+// batching the protocol allows.
+//
+// Seal leaves out the two esp_timer_get_time() reads behind Stats::busy_us
+// unless built with CONFIG_AUDIO_CRYPTO_PROFILE=1.
+// Host mbedtls usually runs AES on AES-NI, the device on the AES peripheral
+// (CONFIG_MBEDTLS_HARDWARE_AES); neither is the software path, so only the
+// split between cipher and bookkeeping carries over, not the numbers.
+//
+// audio_crypto_bench [-t min_ms]
+
+#include "audio_crypto.h"
+#include "udp_audio_reference.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// 16 kHz mono Opus, 60 ms frames: ~60 B at 8 kbps to ~240 B at 32 kbps,
+// up to MQTT_AUDIO_MAX_PAYLOAD_SIZE
+const size_t kSizes[] = {60, 120, 240, 480, 1000};
+
+int min_ms = 200;
+volatile size_t sink;
+
+// Host timings here swing by 2x from one moment to the next, so the rows
+// being compared take turns in short runs and each keeps its best
+class Race {
+public:
+    template <typename Fn>
+    void Add(const char* row, Fn fn) {
+        rows_.push_back(row);
+        runs_.push_back([fn](std::chrono::nanoseconds budget) mutable {
+            using Clock = std::chrono::steady_clock;
+            long calls = 0;
+            auto start = Clock::now();
+            Clock::time_point now;
+            do {
+                for (int i = 0; i < 64; i++) {
+                    fn();
+                }
+                calls += 64;
+                now = Clock::now();
+            } while (now - start < budget);
+            return std::chrono::duration<double, std::nano>(now - start).count() / calls;
+        });
+    }
+
+    // ns per call of each row, in the order added
+    std::vector<double> Run() {
+        const int rounds = 20;
+        std::chrono::nanoseconds budget(min_ms * 1000000L / (rounds * (long)runs_.size()));
+        std::vector<double> best(runs_.size(), 0);
+        for (int round = 0; round < rounds; round++) {
+            for (size_t i = 0; i < runs_.size(); i++) {
+                double ns = runs_[i](budget);
+                best[i] = round == 0 || ns < best[i] ? ns : best[i];
+            }
+        }
+        return best;
+    }
+
+    const char* row(size_t i) const { return rows_[i]; }
+
+private:
+    std::vector<const char*> rows_;
+    std::vector<std::function<double(std::chrono::nanoseconds)>> runs_;
+};
+
+// The first row is the baseline for the ratios
+void Report(Race& race, size_t size) {
+    auto ns = race.Run();
+    for (size_t i = 0; i < ns.size(); i++) {
+        std::printf("%-22s %5zu B %9.1f ns/packet %7.1f MB/s  %5.2fx\n", race.row(i), size, ns[i],
+                    size * 1e3 / ns[i], ns[0] / ns[i]);
+    }
+    std::printf("\n");
+}
+
+// Keystream of one packet: the sealed payload of an all-zero frame
+std::vector<uint8_t> Keystream(AudioCrypto& crypto, uint32_t sequence, size_t size) {
+    std::vector<uint8_t> zeros(size);
+    std::string packet;
+    crypto.Seal(sequence, zeros.data(), size, packet);
+    return std::vector<uint8_t>(packet.begin() + crypto.header_size(), packet.end());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int opt;
+    while ((opt = getopt(argc, argv, "t:")) != -1) {
+        if (opt == 't') {
+            min_ms = std::atoi(optarg);
+        } else {
+            std::fprintf(stderr, "usage: %s [-t min_ms]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(5);
+    std::string key(16, 0), nonce(16, 0);
+    for (auto& c : key) {
+        c = (char)rng();
+    }
+    for (auto& c : nonce) {
+        c = (char)rng();
+    }
+    nonce[0] = 0x01;
+    mbedtls_aes_context aes;
+    mbedtls_aes_init(&aes);
+    mbedtls_aes_setkey_enc(&aes, (const unsigned char*)key.data(), 128);
+    AudioCrypto crypto;
+    if (!crypto.Configure(key, nonce)) {
+        return 1;
+    }
+
+    // The same sequence number with one byte more payload: a different
+    // counter block, so no keystream block in common
+    auto shorter = Keystream(crypto, 1000, 120);
+    auto longer = Keystream(crypto, 1000, 121);
+    bool shared = false;
+    for (size_t i = 0; i + 16 <= shorter.size() && !shared; i += 16) {
+        for (size_t j = 0; j + 16 <= longer.size() && !shared; j += 16) {
+            shared = memcmp(&shorter[i], &longer[j], 16) == 0;
+        }
+    }
+    std::printf("keystream depends on the payload size: %s\n\n", shared ? "NO" : "yes");
+    if (shared) {
+        return 1;
+    }
+
+    uint32_t old_sequence = 0;
+    uint32_t sequence = 0;
+    std::string packet;
+    packet.reserve(crypto.header_size() + 1100);
+    for (size_t size : kSizes) {
+        std::vector<uint8_t> payload(size);
+        for (auto& b : payload) {
+            b = (uint8_t)rng();
+        }
+
+        std::vector<uint8_t> output(size);
+        // Impossible in practice: the keystream for this exact size and sequence
+        auto keystream = Keystream(crypto, sequence + 1, size);
+
+        Race race;
+        race.Add("SendAudio (old)", [&] {
+            sink = reference::SendAudio(aes, nonce, old_sequence, payload).size();
+        });
+        race.Add("Seal", [&] {
+            crypto.Seal(++sequence, payload.data(), size, packet);
+            sink = packet.size();
+        });
+        race.Add("cipher only", [&] {
+            uint8_t counter[16];
+            memcpy(counter, nonce.data(), sizeof(counter));
+            uint8_t stream_block[16];
+            size_t nc_off = 0;
+            mbedtls_aes_crypt_ctr(&aes, size, &nc_off, counter, stream_block, payload.data(), output.data());
+            sink = output[0];
+        });
+        race.Add("precomputed keystream", [&] {
+            packet.resize(crypto.header_size() + size);
+            auto header = (uint8_t*)packet.data();
+            memcpy(header, nonce.data(), crypto.header_size());
+            for (size_t i = 0; i < size; i++) {
+                header[crypto.header_size() + i] = payload[i] ^ keystream[i];
+            }
+            sink = packet.size();
+        });
+        Report(race, size);
+    }
+
+    // Three 120 B frames: three datagrams, or one with 2-byte length prefixes
+    std::vector<uint8_t> frame(120, 0x5a);
+    std::vector<uint8_t> batch;
+    for (int i = 0; i < 3; i++) {
+        batch.push_back(0);
+        batch.push_back((uint8_t)frame.size());
+        batch.insert(batch.end(), frame.begin(), frame.end());
+    }
+    Race race;
+    race.Add("3 frames, 3 Seals", [&] {
+        for (int i = 0; i < 3; i++) {
+            crypto.Seal(++sequence, frame.data(), frame.size(), packet);
+        }
+        sink = packet.size();
+    });
+    race.Add("3 frames, 1 Seal", [&] {
+        crypto.Seal(++sequence, batch.data(), batch.size(), packet);
+        sink = packet.size();
+    });
+    Report(race, 3 * frame.size());
+
+    mbedtls_aes_free(&aes);
+    return 0;
+}
@@ -0,0 +1,159 @@
+// AudioCrypto against the MqttProtocol code it replaced: every datagram
+// sealed into the reused buffer must be byte-identical to what SendAudio
+// built, and Open must recover what the old receive path did.
+
+#include "audio_crypto.h"
+#include "udp_audio_reference.h"
+#include "host_test.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// MQTT_AUDIO_MAX_PAYLOAD_SIZE, which MqttProtocol reserves the datagram for
+const size_t kMaxPayload = 1000;
+
+struct Session {
+    std::string key;
+    std::string nonce;
+    mbedtls_aes_context aes;
+
+    explicit Session(std::mt19937& rng) : key(16, 0), nonce(16, 0) {
+        for (auto& c : key) {
+            c = (char)rng();
+        }
+        for (auto& c : nonce) {
+            c = (char)rng();
+        }
+        nonce[0] = 0x01;
+        mbedtls_aes_init(&aes);
+        mbedtls_aes_setkey_enc(&aes, (const unsigned char*)key.data(), 128);
+    }
+    ~Session() { mbedtls_aes_free(&aes); }
+};
+
+std::vector<uint8_t> RandomPayload(std::mt19937& rng, size_t size) {
+    std::vector<uint8_t> payload(size);
+    for (auto& b : payload) {
+        b = (uint8_t)rng();
+    }
+    return payload;
+}
+
+// Random sizes up to past the reserved maximum, with the sequence number
+// wrapping through zero on the way
+void TestByteIdentical() {
+    std::mt19937 rng(7);
+    Session session(rng);
+    AudioCrypto crypto;
+    CHECK(crypto.Configure(session.key, session.nonce));
+    CHECK_EQ(crypto.header_size(), 16u);
+
+    uint32_t old_sequence = 0xFFFFFF00u;
+    uint32_t sequence = old_sequence;
+    std::string packet;
+    std::vector<uint8_t> opened;
+    std::vector<uint8_t> expected;
+    int mismatches = 0;
+    for (int i = 0; i < 20000; i++) {
+        auto payload = RandomPayload(rng, i < 64 ? i : rng() % 1100);
+        std::string datagram = reference::SendAudio(session.aes, session.nonce, old_sequence, payload);
+        CHECK(crypto.Seal(++sequence, payload.data(), payload.size(), packet));
+        mismatches += packet != datagram;
+
+        std::string received = datagram;
+        CHECK(reference::ReceiveAudio(session.aes, session.nonce, received, expected));
+        CHECK(crypto.Open(packet, opened));
+        mismatches += opened != expected || opened != payload;
+        // Open decrypts with a copy of the counter block; the datagram is left alone
+        mismatches += packet != datagram;
+    }
+    CHECK_EQ(mismatches, 0);
+    CHECK_EQ(sequence, 0xFFFFFF00u + 20000);
+
+    auto stats = crypto.GetStats();
+    CHECK_EQ(stats.sealed, 20000u);
+    CHECK_EQ(stats.opened, 20000u);
+    CHECK_EQ(stats.failed, 0u);
+}
+
+// After MqttProtocol's reserve, sealing never reallocates the datagram, and
+// a recycled receive buffer stops growing once it has held the largest frame
+void TestBuffersReused() {
+    std::mt19937 rng(11);
+    Session session(rng);
+    AudioCrypto crypto;
+    CHECK(crypto.Configure(session.key, session.nonce));
+
+    std::string packet;
+    packet.reserve(crypto.header_size() + kMaxPayload);
+    const char* datagram = packet.data();
+    std::vector<uint8_t> opened;
+    opened.reserve(kMaxPayload);
+    const uint8_t* buffer = opened.data();
+    for (uint32_t sequence = 1; sequence <= 2000; sequence++) {
+        auto payload = RandomPayload(rng, rng() % (kMaxPayload + 1));
+        CHECK(crypto.Seal(sequence, payload.data(), payload.size(), packet));
+        CHECK(crypto.Open(packet, opened));
+        if (packet.data() != datagram || opened.data() != buffer) {
+            CHECK(!"buffer reallocated");
+            break;
+        }
+    }
+}
+
+// A new server hello replaces the key schedule; the old code re-initialised
+// its context in place
+void TestReconfigure() {
+    std::mt19937 rng(13);
+    Session first(rng);
+    Session second(rng);
+    AudioCrypto crypto;
+    CHECK(crypto.Configure(first.key, first.nonce));
+    CHECK(crypto.Configure(second.key, second.nonce));
+
+    uint32_t old_sequence = 41;
+    auto payload = RandomPayload(rng, 300);
+    std::string datagram = reference::SendAudio(second.aes, second.nonce, old_sequence, payload);
+    std::string packet;
+    CHECK(crypto.Seal(42, payload.data(), payload.size(), packet));
+    CHECK(packet == datagram);
+    CHECK_EQ(crypto.GetStats().sealed, 1u);
+}
+
+void TestRejects() {
+    std::mt19937 rng(17);
+    Session session(rng);
+    AudioCrypto crypto;
+    std::string packet;
+    std::vector<uint8_t> opened;
+    uint8_t payload[8] = {0};
+
+    // Nothing goes out before the hello
+    CHECK(!crypto.IsConfigured());
+    CHECK(!crypto.Seal(1, payload, sizeof(payload), packet));
+    CHECK(!crypto.Open(std::string(32, '\x01'), opened));
+
+    CHECK(!crypto.Configure(std::string(15, 'k'), session.nonce));
+    CHECK(!crypto.Configure(session.key, std::string(12, 'n')));
+    CHECK(!crypto.IsConfigured());
+
+    CHECK(crypto.Configure(session.key, session.nonce));
+    CHECK(!crypto.Open(std::string(15, '\x01'), opened));
+    // A bare header is an empty frame
+    CHECK(crypto.Open(session.nonce, opened));
+    CHECK(opened.empty());
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestByteIdentical);
+    RUN_TEST(TestBuffersReused);
+    RUN_TEST(TestReconfigure);
+    RUN_TEST(TestRejects);
+    return host_test::Finish();
+}
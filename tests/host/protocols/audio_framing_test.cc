@@ -0,0 +1,345 @@
+// Multi-frame audio messages end to end: Protocol batches frames and sends
+// each message as a UDP datagram over loopback to a stand-in server, which
+// unpacks them with its own reading of the wire format. The server packs
+// the downlink the same way and the device side splits it through
+// DeliverIncomingAudio.
+//
+// Built with CONFIG_AUDIO_FRAMES_PER_PACKET=3 and
+// CONFIG_AUDIO_BATCH_MAX_DELAY_MS=150; the batch timer is a real
+// esp_timer on the host dispatcher thread.
+
+#include "protocol.h"
+#include "host_test.h"
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kFramesPerPacket = 3;
+const int kMaxDelayMs = 150;
+
+typedef std::vector<uint8_t> Frame;
+
+// Protocol with a UDP socket as its transport
+class LoopbackProtocol : public Protocol {
+public:
+    explicit LoopbackProtocol(int socket) : socket_(socket) {}
+
+    void Start() override {}
+    bool OpenAudioChannel() override { return true; }
+    void CloseAudioChannel() override { FlushAudio(); }
+    bool IsAudioChannelOpened() const override { return true; }
+
+    using Protocol::ConfigureAudioFraming;
+    using Protocol::DeliverIncomingAudio;
+    using Protocol::audio_frames_per_packet;
+
+    std::vector<std::string> texts;
+
+protected:
+    void SendText(const std::string& text) override { texts.push_back(text); }
+    void SendAudioPacket(const uint8_t* data, size_t size) override { send(socket_, data, size, 0); }
+    void ParseServerHello(const cJSON* /* root */) override {}
+
+private:
+    int socket_;
+};
+
+// The server's side of the framing, written from the protocol description
+// rather than with AudioFrameBatcher
+bool Unpack(const std::string& message, std::vector<Frame>& frames) {
+    frames.clear();
+    size_t offset = 0;
+    while (offset < message.size()) {
+        if (message.size() - offset < 2) {
+            return false;
+        }
+        size_t length = (uint8_t)message[offset] << 8 | (uint8_t)message[offset + 1];
+        offset += 2;
+        if (length > message.size() - offset) {
+            return false;
+        }
+        frames.emplace_back(message.begin() + offset, message.begin() + offset + length);
+        offset += length;
+    }
+    return !frames.empty() && frames.size() <= kFramesPerPacket;
+}
+
+Frame Pack(const std::vector<Frame>& frames) {
+    Frame message;
+    for (auto& frame : frames) {
+        message.push_back((uint8_t)(frame.size() >> 8));
+        message.push_back((uint8_t)frame.size());
+        message.insert(message.end(), frame.begin(), frame.end());
+    }
+    return message;
+}
+
+Frame RandomFrame(std::mt19937& rng) {
+    // 60 ms Opus frames at 8-32 kbps, and the odd large one
+    Frame frame(1 + rng() % (rng() % 16 == 0 ? 1000 : 300));
+    for (auto& b : frame) {
+        b = (uint8_t)rng();
+    }
+    return frame;
+}
+
+// The device's and the server's ends of a loopback UDP link
+struct Link {
+    int device = -1;
+    int server = -1;
+
+    Link() {
+        device = socket(AF_INET, SOCK_DGRAM, 0);
+        server = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(server, (sockaddr*)&address, sizeof(address));
+        bind(device, (sockaddr*)&address, sizeof(address));
+        sockaddr_in server_address, device_address;
+        socklen_t length = sizeof(server_address);
+        getsockname(server, (sockaddr*)&server_address, &length);
+        length = sizeof(device_address);
+        getsockname(device, (sockaddr*)&device_address, &length);
+        connect(device, (sockaddr*)&server_address, sizeof(server_address));
+        connect(server, (sockaddr*)&device_address, sizeof(device_address));
+        // The uplink test queues all its datagrams before reading any
+        int size = 4 << 20;
+        setsockopt(server, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        setsockopt(device, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+    ~Link() {
+        close(device);
+        close(server);
+    }
+
+    // One datagram, or false after timeout_ms
+    static bool Receive(int socket, std::string& datagram, int timeout_ms) {
+        timeval timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        char buffer[65536];
+        ssize_t size = recv(socket, buffer, sizeof(buffer), 0);
+        if (size < 0) {
+            return false;
+        }
+        datagram.assign(buffer, size);
+        return true;
+    }
+};
+
+int64_t NowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 301 frames sent back to back: 100 full messages, then the last frame
+// flushed when listening stops
+void TestUplink() {
+    Link link;
+    LoopbackProtocol protocol(link.device);
+    protocol.ConfigureAudioFraming(kFramesPerPacket);
+    CHECK_EQ(protocol.audio_frames_per_packet(), kFramesPerPacket);
+
+    std::mt19937 rng(3);
+    std::vector<Frame> sent;
+    for (int i = 0; i < 301; i++) {
+        sent.push_back(RandomFrame(rng));
+        protocol.SendAudio(sent.back());
+    }
+    protocol.SendStopListening();
+    CHECK_EQ(protocol.texts.size(), 1u);
+
+    std::vector<Frame> received;
+    std::vector<Frame> frames;
+    std::string datagram;
+    int datagrams = 0;
+    int full = 0;
+    while (Link::Receive(link.server, datagram, 500)) {
+        datagrams++;
+        if (!Unpack(datagram, frames)) {
+            CHECK(!"malformed message");
+            continue;
+        }
+        full += frames.size() == kFramesPerPacket;
+        received.insert(received.end(), frames.begin(), frames.end());
+    }
+    CHECK_EQ(datagrams, 101);
+    CHECK_EQ(full, 100);
+    CHECK_EQ(received.size(), sent.size());
+    CHECK(received == sent);
+}
+
+// A partial batch goes out once its first frame has waited the budget
+void TestLatencyBudget() {
+    Link link;
+    LoopbackProtocol protocol(link.device);
+    protocol.ConfigureAudioFraming(kFramesPerPacket);
+    std::mt19937 rng(5);
+    std::string datagram;
+    std::vector<Frame> frames;
+
+    for (int count = 1; count < kFramesPerPacket; count++) {
+        std::vector<Frame> sent;
+        int64_t start = NowMs();
+        for (int i = 0; i < count; i++) {
+            sent.push_back(RandomFrame(rng));
+            protocol.SendAudio(sent.back());
+        }
+        CHECK(!Link::Receive(link.server, datagram, kMaxDelayMs / 2));
+        CHECK(Link::Receive(link.server, datagram, 1000));
+        int64_t waited = NowMs() - start;
+        CHECK(Unpack(datagram, frames));
+        CHECK(frames == sent);
+        CHECK(waited >= kMaxDelayMs);
+        CHECK(waited < kMaxDelayMs + 500);
+    }
+    // Nothing else is pending
+    CHECK(!Link::Receive(link.server, datagram, kMaxDelayMs * 2));
+}
+
+// Stopping listening sends the partial batch at once
+void TestFlushOnStop() {
+    Link link;
+    LoopbackProtocol protocol(link.device);
+    protocol.ConfigureAudioFraming(kFramesPerPacket);
+    std::mt19937 rng(7);
+    std::vector<Frame> sent = {RandomFrame(rng), RandomFrame(rng)};
+    int64_t start = NowMs();
+    for (auto& frame : sent) {
+        protocol.SendAudio(frame);
+    }
+    protocol.SendStopListening();
+    std::string datagram;
+    std::vector<Frame> frames;
+    CHECK(Link::Receive(link.server, datagram, 1000));
+    CHECK(NowMs() - start < kMaxDelayMs);
+    CHECK(Unpack(datagram, frames));
+    CHECK(frames == sent);
+    CHECK(!Link::Receive(link.server, datagram, kMaxDelayMs * 2));
+}
+
+// One frame per message is a bare Opus frame, as before batching existed;
+// the server can only turn batching on up to the configured maximum
+void TestSingleFrame() {
+    for (int requested : {1, 0, kFramesPerPacket + 1}) {
+        Link link;
+        LoopbackProtocol protocol(link.device);
+        protocol.ConfigureAudioFraming(requested);
+        CHECK_EQ(protocol.audio_frames_per_packet(), 1);
+
+        std::mt19937 rng(9);
+        std::string datagram;
+        for (int i = 0; i < 20; i++) {
+            Frame frame = RandomFrame(rng);
+            protocol.SendAudio(frame);
+            CHECK(Link::Receive(link.server, datagram, 1000));
+            CHECK(datagram == std::string(frame.begin(), frame.end()));
+        }
+
+        std::vector<Frame> delivered;
+        protocol.OnIncomingAudio([&](Frame&& frame) { delivered.push_back(frame); });
+        Frame frame = RandomFrame(rng);
+        protocol.DeliverIncomingAudio(Frame(frame));
+        CHECK_EQ(delivered.size(), 1u);
+        CHECK(delivered.back() == frame);
+    }
+}
+
+// Downlink messages of one to three frames from the server
+void TestDownlink() {
+    Link link;
+    LoopbackProtocol protocol(link.device);
+    protocol.ConfigureAudioFraming(kFramesPerPacket);
+    std::vector<Frame> delivered;
+    protocol.OnIncomingAudio([&](Frame&& frame) {
+        delivered.push_back(frame);
+        protocol.RecycleAudioBuffer(std::move(frame));
+    });
+
+    std::mt19937 rng(11);
+    std::vector<Frame> sent;
+    int messages = 0;
+    while (sent.size() < 300) {
+        std::vector<Frame> batch(1 + rng() % kFramesPerPacket);
+        for (auto& frame : batch) {
+            frame = RandomFrame(rng);
+        }
+        sent.insert(sent.end(), batch.begin(), batch.end());
+        Frame message = Pack(batch);
+        send(link.server, message.data(), message.size(), 0);
+        messages++;
+    }
+    std::string datagram;
+    for (int i = 0; i < messages && Link::Receive(link.device, datagram, 1000); i++) {
+        protocol.DeliverIncomingAudio(Frame(datagram.begin(), datagram.end()));
+    }
+    CHECK_EQ(delivered.size(), sent.size());
+    CHECK(delivered == sent);
+}
+
+// A lost message (the jitter buffer hands over an empty one) is concealed
+// frame by frame
+void TestLostMessage() {
+    Link link;
+    LoopbackProtocol protocol(link.device);
+    protocol.ConfigureAudioFraming(kFramesPerPacket);
+    std::vector<Frame> delivered;
+    protocol.OnIncomingAudio([&](Frame&& frame) { delivered.push_back(frame); });
+    protocol.DeliverIncomingAudio(Frame());
+    CHECK_EQ(delivered.size(), (size_t)kFramesPerPacket);
+    for (auto& frame : delivered) {
+        CHECK(frame.empty());
+    }
+}
+
+// Malformed messages deliver nothing at all, not even their good frames
+void TestMalformed() {
+    Link link;
+    LoopbackProtocol protocol(link.device);
+    protocol.ConfigureAudioFraming(kFramesPerPacket);
+    std::vector<Frame> delivered;
+    protocol.OnIncomingAudio([&](Frame&& frame) { delivered.push_back(frame); });
+
+    Frame good = Pack({{1, 2, 3}, {4}});
+    std::vector<Frame> malformed = {
+        {0},                                        // half a length prefix
+        {0, 5, 1, 2},                               // frame longer than the message
+        Pack({{1}, {2}, {3}, {4}}),                 // more frames than negotiated
+    };
+    Frame trailing = good;
+    trailing.push_back(0);                          // good frames, then half a prefix
+    malformed.push_back(trailing);
+    Frame cut = good;
+    cut.pop_back();                                 // last frame cut short
+    malformed.push_back(cut);
+
+    for (auto& message : malformed) {
+        protocol.DeliverIncomingAudio(Frame(message));
+    }
+    CHECK_EQ(delivered.size(), 0u);
+
+    protocol.DeliverIncomingAudio(Frame(good));
+    CHECK_EQ(delivered.size(), 2u);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(TestUplink);
+    RUN_TEST(TestLatencyBudget);
+    RUN_TEST(TestFlushOnStop);
+    RUN_TEST(TestSingleFrame);
+    RUN_TEST(TestDownlink);
+    RUN_TEST(TestLostMessage);
+    RUN_TEST(TestMalformed);
+    return host_test::Finish();
+}
@@ -0,0 +1,42 @@
+// Host driver for main/protocols/server_message_bench.cc. On the device
+// every malloc is a heap_caps block; here cJSON and operator new are sent
+// through the heap_caps stub so the blocks-per-message column counts the
+// same allocations.
+
+#include "server_message_bench.h"
+
+#include <cJSON.h>
+#include <esp_heap_caps.h>
+
+#include <new>
+
+void* operator new(size_t size) {
+    void* p = heap_caps_malloc(size != 0 ? size : 1, MALLOC_CAP_DEFAULT);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    heap_caps_free(p);
+}
+
+void operator delete(void* p, size_t /* size */) noexcept {
+    heap_caps_free(p);
+}
+
+namespace {
+
+void* HeapMalloc(size_t size) {
+    return heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+}
+
+} // namespace
+
+int main() {
+    cJSON_Hooks hooks = {HeapMalloc, heap_caps_free};
+    cJSON_InitHooks(&hooks);
+    server_message_run_benchmark();
+    return 0;
+}
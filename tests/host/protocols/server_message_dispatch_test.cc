@@ -0,0 +1,425 @@
+// The cJSON-free dispatcher against the cJSON one it replaced. Every frame
+// goes through a model of the old receive path (cJSON_Parse + strcmp in
+// MqttProtocol/WebsocketProtocol and the old Application handler) and
+// through Protocol::DispatchIncomingText with a handler that mirrors the
+// current Application one; both sides record what the device would do.
+//
+// Frames are the message types the server sends, hand-written malformed
+// ones, every prefix of each (truncation) and seeded random byte edits.
+// Where the old path dereferenced a missing or non-string member it would
+// have crashed, and there is nothing to compare against.
+
+#include "protocol.h"
+#include "host_test.h"
+
+#include <esp_log.h>
+
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const kSessionId = "7c1e4a52";
+
+typedef std::vector<std::string> Events;
+
+std::string Print(const cJSON* item) {
+    char* text = cJSON_PrintUnformatted(item);
+    std::string printed = text != nullptr ? text : "";
+    cJSON_free(text);
+    return printed;
+}
+
+// The old code read valuestring without checking the member's type
+struct Crash : std::runtime_error {
+    Crash() : std::runtime_error("null dereference") {}
+};
+
+const char* ValueString(const cJSON* item) {
+    if (item == nullptr || item->valuestring == nullptr) {
+        throw Crash();
+    }
+    return item->valuestring;
+}
+
+// The old Application::OnIncomingJson handler
+void OldApplication(const cJSON* root, Events& events) {
+    auto type = cJSON_GetObjectItem(root, "type");
+    if (strcmp(ValueString(type), "tts") == 0) {
+        auto state = cJSON_GetObjectItem(root, "state");
+        if (strcmp(ValueString(state), "start") == 0) {
+            events.push_back("tts start");
+        } else if (strcmp(ValueString(state), "stop") == 0) {
+            events.push_back("tts stop");
+        } else if (strcmp(ValueString(state), "sentence_start") == 0) {
+            auto text = cJSON_GetObjectItem(root, "text");
+            if (text != NULL) {
+                events.push_back(std::string("assistant ") + ValueString(text));
+            }
+        }
+    } else if (strcmp(ValueString(type), "stt") == 0) {
+        auto text = cJSON_GetObjectItem(root, "text");
+        if (text != NULL) {
+            events.push_back(std::string("user ") + ValueString(text));
+        }
+    } else if (strcmp(ValueString(type), "llm") == 0) {
+        auto emotion = cJSON_GetObjectItem(root, "emotion");
+        if (emotion != NULL) {
+            events.push_back(std::string("emotion ") + ValueString(emotion));
+        }
+    } else if (strcmp(ValueString(type), "iot") == 0) {
+        auto commands = cJSON_GetObjectItem(root, "commands");
+        if (commands != NULL) {
+            for (int i = 0; i < cJSON_GetArraySize(commands); ++i) {
+                events.push_back("invoke " + Print(cJSON_GetArrayItem(commands, i)));
+            }
+        }
+    }
+}
+
+// The old MqttProtocol and WebsocketProtocol receive callbacks; both
+// parsed the payload as a C string
+Events OldDispatch(const std::string& frame, bool mqtt) {
+    Events events;
+    cJSON* root = cJSON_Parse(frame.c_str());
+    try {
+        auto type = cJSON_GetObjectItem(root, "type");
+        if (mqtt) {
+            if (root != nullptr && type != nullptr) {
+                if (strcmp(ValueString(type), "hello") == 0) {
+                    events.push_back("hello " + Print(root));
+                } else if (strcmp(ValueString(type), "goodbye") == 0) {
+                    auto session_id = cJSON_GetObjectItem(root, "session_id");
+                    if (session_id == nullptr || std::string(kSessionId) == ValueString(session_id)) {
+                        events.push_back("close");
+                    }
+                } else {
+                    OldApplication(root, events);
+                }
+            }
+        } else if (type != NULL) {
+            if (strcmp(ValueString(type), "hello") == 0) {
+                events.push_back("hello " + Print(root));
+            } else {
+                OldApplication(root, events);
+            }
+        }
+    } catch (const Crash&) {
+        cJSON_Delete(root);
+        throw;
+    }
+    cJSON_Delete(root);
+    return events;
+}
+
+// Protocol with the transport's hello and goodbye handling recorded
+class TestProtocol : public Protocol {
+public:
+    explicit TestProtocol(bool mqtt) : mqtt_(mqtt) {
+        session_id_ = kSessionId;
+        // Mirrors the Application handler
+        OnIncomingMessage([this](const ServerMessage& message) {
+            switch (message.type) {
+            case kServerMessageTts:
+                if (message.state == kTtsStateStart) {
+                    events.push_back("tts start");
+                } else if (message.state == kTtsStateStop) {
+                    events.push_back("tts stop");
+                } else if (message.state == kTtsStateSentenceStart && message.has_text) {
+                    events.push_back(std::string("assistant ") + message.text.c_str());
+                }
+                break;
+            case kServerMessageStt:
+                if (message.has_text) {
+                    events.push_back(std::string("user ") + message.text.c_str());
+                }
+                break;
+            case kServerMessageLlm:
+                if (message.has_emotion) {
+                    events.push_back(std::string("emotion ") + message.emotion.c_str());
+                }
+                break;
+            case kServerMessageIot:
+                if (!message.commands.empty()) {
+                    auto commands = cJSON_ParseWithLength(message.commands.data(), message.commands.size());
+                    for (int i = 0; i < cJSON_GetArraySize(commands); ++i) {
+                        events.push_back("invoke " + Print(cJSON_GetArrayItem(commands, i)));
+                    }
+                    cJSON_Delete(commands);
+                }
+                break;
+            default:
+                break;
+            }
+        });
+    }
+
+    void Start() override {}
+    bool OpenAudioChannel() override { return true; }
+    void CloseAudioChannel() override {}
+    bool IsAudioChannelOpened() const override { return true; }
+
+    Events Dispatch(const std::string& frame) {
+        events.clear();
+        DispatchIncomingText(frame.data(), frame.size());
+        return events;
+    }
+
+    Events events;
+
+protected:
+    void SendText(const std::string& /* text */) override {}
+    void SendAudioPacket(const uint8_t* /* data */, size_t /* size */) override {}
+    void ParseServerHello(const cJSON* root) override { events.push_back("hello " + Print(root)); }
+
+    // WebsocketProtocol keeps the default, which ignores goodbye
+    void OnServerGoodbye(const ServerMessage& message) override {
+        if (mqtt_ && message.IsForSession(session_id_)) {
+            events.push_back("close");
+        }
+    }
+
+private:
+    bool mqtt_;
+};
+
+struct Stats {
+    int frames = 0;
+    int compared = 0;
+    int crashed = 0;
+    int mismatches = 0;
+};
+
+std::string Printable(const std::string& frame) {
+    std::string out;
+    for (unsigned char c : frame.substr(0, 160)) {
+        if (c < 0x20 || c >= 0x7F) {
+            char hex[8];
+            snprintf(hex, sizeof(hex), "\\x%02x", c);
+            out += hex;
+        } else {
+            out += (char)c;
+        }
+    }
+    return out;
+}
+
+void Compare(const std::string& frame, Stats& stats) {
+    static TestProtocol mqtt(true);
+    static TestProtocol websocket(false);
+    stats.frames++;
+
+    // The reader takes a frame exactly when cJSON would have produced an object
+    cJSON* root = cJSON_Parse(frame.c_str());
+    bool is_object = cJSON_IsObject(root);
+    cJSON_Delete(root);
+    ServerMessage message;
+    if (message.Parse(frame.c_str(), strlen(frame.c_str())) != is_object) {
+        if (stats.mismatches++ < 10) {
+            std::printf("  accepted differently (cJSON %d): %s\n", is_object, Printable(frame).c_str());
+        }
+        host_test::Failures()++;
+        return;
+    }
+
+    for (bool is_mqtt : {true, false}) {
+        Events expected;
+        try {
+            expected = OldDispatch(frame, is_mqtt);
+        } catch (const Crash&) {
+            stats.crashed++;
+            continue;
+        }
+        Events actual = (is_mqtt ? mqtt : websocket).Dispatch(frame);
+        stats.compared++;
+        if (actual != expected) {
+            if (stats.mismatches++ < 10) {
+                std::printf("  %s differs: %s\n", is_mqtt ? "mqtt" : "websocket", Printable(frame).c_str());
+                for (auto& event : expected) {
+                    std::printf("    old: %s\n", Printable(event).c_str());
+                }
+                for (auto& event : actual) {
+                    std::printf("    new: %s\n", Printable(event).c_str());
+                }
+            }
+            host_test::Failures()++;
+        }
+    }
+}
+
+void Report(const char* name, const Stats& stats) {
+    std::printf("  %s: %d frames, %d dispatches compared, %d would have crashed the old path\n",
+                name, stats.frames, stats.compared, stats.crashed);
+}
+
+std::string Nested(int depth) {
+    return R"({"type":"iot","commands":)" + std::string(depth, '[') + std::string(depth, ']') + "}";
+}
+
+// One of each message the server sends, then the corners of both parsers
+const std::vector<std::string>& Frames() {
+    static std::vector<std::string> frames = {
+        R"({"type":"hello","transport":"udp","session_id":"7c1e4a52","audio_params":{"sample_rate":24000,"frames_per_packet":3},"udp":{"server":"10.0.0.1","port":8884,"key":"00112233445566778899aabbccddeeff","nonce":"01000000000000000000000000000000"}})",
+        R"({"type":"hello","transport":"websocket","audio_params":{"sample_rate":16000}})",
+        R"({"type":"goodbye","session_id":"7c1e4a52"})",
+        R"({"type":"goodbye","session_id":"another"})",
+        R"({"type":"goodbye","session_id":""})",
+        R"({"type":"goodbye"})",
+        R"({"type":"tts","state":"start","sample_rate":24000,"session_id":"7c1e4a52"})",
+        R"({"type":"tts","state":"stop","session_id":"7c1e4a52"})",
+        R"({"type":"tts","state":"sentence_start","text":"今天天气怎么样","session_id":"7c1e4a52"})",
+        R"({"type":"tts","state":"sentence_end","text":"done"})",
+        R"({"type":"tts","state":"sentence_start"})",
+        R"({"type":"tts","state":"sentence_start","text":""})",
+        R"({"type":"tts","state":"paused"})",
+        R"({"type":"stt","text":"你好，小智","session_id":"7c1e4a52"})",
+        R"({"type":"stt","text":""})",
+        R"({"type":"stt"})",
+        R"({"type":"llm","text":"😊","emotion":"happy","session_id":"7c1e4a52"})",
+        R"({"type":"llm","emotion":""})",
+        R"({"type":"llm"})",
+        R"({"type":"iot","commands":[{"name":"Speaker","method":"SetVolume","parameters":{"volume":60}},{"name":"Lamp","method":"TurnOn","parameters":{}}]})",
+        R"({"type":"iot","commands":[]})",
+        R"({"type":"iot","commands":{"name":"Lamp","method":"TurnOff"}})",
+        R"({"type":"iot","commands":"none"})",
+        R"({"type":"iot","commands":[1,-2.5e3,true,false,null,"s",[[]],{}]})",
+        R"({"type":"iot"})",
+        R"({"type":"mcp","payload":{"jsonrpc":"2.0"}})",
+        R"({"type":""})",
+        R"({"state":"start"})",
+        R"({})",
+        // Keys are matched like cJSON_GetObjectItem: case-insensitively, the first one wins
+        R"({"TYPE":"tts","State":"start"})",
+        R"({"type":"stt","text":"first","text":"second"})",
+        R"({"type":"stt","type":"llm","text":"x","emotion":"sad"})",
+        R"({"type":"llm","emotion":"sad","EMOTION":"happy"})",
+        R"({"type":"goodbye","session_id":"other","session_id":"7c1e4a52"})",
+        R"({"type":"iot","commands":[{"n":1}],"Commands":[{"n":2}]})",
+        R"({"ty\u0070e":"stt","T\u0065xt":"escaped keys"})",
+        R"({"type\u0000x":"stt","text\u0000":"keys end at a NUL"})",
+        R"({"type":"\u0073tt","text":"escaped value"})",
+        R"({"type":"stt\u0000x","text":"value ends at a NUL"})",
+        R"({"type":"stt","text":"a\u0000b"})",
+        R"({"type":"stt","text":"\u00zz bad hex reads as NUL"})",
+        R"({"type":"stt","text":"\"\\\/\b\f\n\r\t"})",
+        R"({"type":"stt","text":"\ud83d"})",
+        R"({"type":"stt","text":"\ude0a"})",
+        R"({"type":"stt","text":"\ud83dA"})",
+        R"({"type":"stt","text":"\ud83dx\ude0a"})",
+        R"({"type":"stt","text":"\u12"})",
+        R"({"type":"stt","text":"\u\"ab"})",
+        R"({"type":"stt","text":"\x"})",
+        "{\"type\":\"stt\",\"text\":\"raw\tcontrol\x01" "bytes\"}",
+        "\xEF\xBB\xBF{\"type\":\"stt\",\"text\":\"bom\"}",
+        "\x01\x1F {\"type\":\"stt\"\x7F,\"text\":\"x\"}",
+        " \t\r\n{ \"type\" : \"tts\" , \"state\" : \"start\" } trailing",
+        R"({"type":"tts","state":"start"}{"type":"tts","state":"stop"})",
+        // Numbers as strtod reads them
+        R"({"n":01,"type":"tts","state":"stop"})",
+        R"({"n":-.5,"type":"tts","state":"stop"})",
+        R"({"n":1.e5,"type":"tts","state":"stop"})",
+        R"({"n":1e,"type":"tts","state":"stop"})",
+        R"({"n":1.2.3,"type":"tts","state":"stop"})",
+        R"({"n":-,"type":"tts","state":"stop"})",
+        R"({"n":+1,"type":"tts","state":"stop"})",
+        R"({"n":.5,"type":"tts","state":"stop"})",
+        R"({"n":0x10,"type":"tts","state":"stop"})",
+        R"({"n":1234567890123456789012345678901234567890123456789012345678901234567890,"type":"tts","state":"stop"})",
+        R"({"n":[1,],"type":"tts","state":"stop"})",
+        R"({"n":{"a":1,},"type":"tts","state":"stop"})",
+        R"({"n":{"a" 1},"type":"tts","state":"stop"})",
+        R"({"n":[1 2],"type":"tts","state":"stop"})",
+        R"({"n":[1}],"type":"tts","state":"stop"})",
+        R"({"n":nul,"type":"tts","state":"stop"})",
+        R"({"n":truex,"type":"tts","state":"stop"})",
+        R"({"n":{1:2},"type":"tts","state":"stop"})",
+        R"({"type":"tts","state":"stop",})",
+        R"({,"type":"tts","state":"stop"})",
+        R"({"type":"tts""state":"stop"})",
+        R"({"type":"tts",,"state":"stop"})",
+        R"({"type":tts,"state":"stop"})",
+        R"({"type":["tts"],"state":"stop"})",
+        R"({"type":"tts","state":5})",
+        R"({"type":"stt","text":7})",
+        R"({"type":"goodbye","session_id":null})",
+        R"([{"type":"tts","state":"start"}])",
+        R"("type")",
+        "",
+        "null",
+        Nested(998),
+        Nested(999),
+        Nested(1000),
+    };
+    return frames;
+}
+
+void TestValidAndMalformed() {
+    Stats stats;
+    for (auto& frame : Frames()) {
+        Compare(frame, stats);
+    }
+    Report("frames", stats);
+}
+
+void TestTruncated() {
+    Stats stats;
+    for (auto& frame : Frames()) {
+        for (size_t length = 0; length < frame.size() && length < 4096; length++) {
+            Compare(frame.substr(0, length), stats);
+        }
+    }
+    Report("prefixes", stats);
+}
+
+void TestMutated() {
+    // Bytes that matter to one parser or the other
+    std::string alphabet("{}[]\":,\\/ubfnrt0123456789aAeE.+-ltsx \t\r\n\x01\x7F\xEF\xBB\xBF");
+    alphabet += '\0';
+    std::mt19937 random(20240611);
+    Stats stats;
+    for (auto& seed : Frames()) {
+        if (seed.size() > 4096) {
+            continue;
+        }
+        for (int i = 0; i < 400; i++) {
+            std::string frame = seed;
+            int edits = 1 + random() % 3;
+            for (int edit = 0; edit < edits; edit++) {
+                size_t at = frame.empty() ? 0 : random() % (frame.size() + 1);
+                char c = alphabet[random() % alphabet.size()];
+                switch (random() % 3) {
+                case 0:
+                    if (at < frame.size()) {
+                        frame[at] = c;
+                        break;
+                    }
+                    // fall through
+                case 1:
+                    frame.insert(frame.begin() + at, c);
+                    break;
+                default:
+                    if (at < frame.size()) {
+                        frame.erase(at, 1);
+                    }
+                    break;
+                }
+            }
+            Compare(frame, stats);
+        }
+    }
+    Report("mutations", stats);
+}
+
+} // namespace
+
+int main() {
+    // Most frames are junk on purpose; the parse errors are expected
+    esp_log_level_set("*", ESP_LOG_NONE);
+    RUN_TEST(TestValidAndMalformed);
+    RUN_TEST(TestTruncated);
+    RUN_TEST(TestMutated);
+    return host_test::Finish();
+}
@@ -0,0 +1,42 @@
+#include "udp_audio_reference.h"
+
+#include <arpa/inet.h>
+#include <cstring>
+
+namespace reference {
+
+std::string SendAudio(mbedtls_aes_context& aes_ctx, const std::string& aes_nonce, uint32_t& local_sequence,
+                      const std::vector<uint8_t>& data) {
+    std::string nonce(aes_nonce);
+    *(uint16_t*)&nonce[2] = htons(data.size());
+    *(uint32_t*)&nonce[12] = htonl(++local_sequence);
+
+    std::string encrypted;
+    encrypted.resize(aes_nonce.size() + data.size());
+    memcpy(encrypted.data(), nonce.data(), nonce.size());
+
+    size_t nc_off = 0;
+    uint8_t stream_block[16] = {0};
+    if (mbedtls_aes_crypt_ctr(&aes_ctx, data.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
+        (uint8_t*)data.data(), (uint8_t*)&encrypted[nonce.size()]) != 0) {
+        return std::string();
+    }
+    return encrypted;
+}
+
+bool ReceiveAudio(mbedtls_aes_context& aes_ctx, const std::string& aes_nonce, const std::string& data,
+                  std::vector<uint8_t>& decrypted) {
+    if (data.size() < aes_nonce.size()) {
+        return false;
+    }
+    size_t decrypted_size = data.size() - aes_nonce.size();
+    size_t nc_off = 0;
+    uint8_t stream_block[16] = {0};
+    decrypted.resize(decrypted_size);
+    auto nonce = (uint8_t*)data.data();
+    auto encrypted = (uint8_t*)data.data() + aes_nonce.size();
+    int ret = mbedtls_aes_crypt_ctr(&aes_ctx, decrypted_size, &nc_off, nonce, stream_block, encrypted, (uint8_t*)decrypted.data());
+    return ret == 0;
+}
+
+} // namespace reference
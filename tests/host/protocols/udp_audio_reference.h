@@ -0,0 +1,25 @@
+#pragma once
+
+// MqttProtocol's UDP audio path before AudioCrypto: SendAudio and the
+// OnMessage decrypt, with the member state passed in. The reference
+// AudioCrypto must match byte for byte. Kept in its own translation unit so
+// the benchmark calls it the same way it calls AudioCrypto.
+
+#include <mbedtls/aes.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace reference {
+
+// MqttProtocol::SendAudio; returns the datagram, empty if encryption failed
+std::string SendAudio(mbedtls_aes_context& aes_ctx, const std::string& aes_nonce, uint32_t& local_sequence,
+                      const std::vector<uint8_t>& data);
+// The udp_->OnMessage handler, minus the sequence checks. mbedtls advances
+// the counter in place, so like the original this overwrites the header of
+// `data`: pass a copy
+bool ReceiveAudio(mbedtls_aes_context& aes_ctx, const std::string& aes_nonce, const std::string& data,
+                  std::vector<uint8_t>& decrypted);
+
+} // namespace reference
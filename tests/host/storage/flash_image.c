@@ -0,0 +1,110 @@
+#include "flash_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Typical, not worst case: sector erase 45 ms, page program 0.7 ms, reads
+// at about 20 MB/s (40 MHz QIO)
+#define FLASH_ERASE_US 45000
+#define FLASH_PAGE_PROGRAM_US 700
+#define FLASH_READ_BYTES_PER_US 20
+
+bool flash_image_init(flash_image_t* flash, size_t size) {
+    memset(flash, 0, sizeof(*flash));
+    if (size == 0 || size % FLASH_SECTOR_SIZE != 0) {
+        return false;
+    }
+    flash->data = malloc(size);
+    if (!flash->data) {
+        return false;
+    }
+    memset(flash->data, 0xFF, size);
+    flash->size = size;
+    return true;
+}
+
+bool flash_image_load(flash_image_t* flash, const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    bool ok = size > 0 && flash_image_init(flash, (size_t)size) &&
+              fread(flash->data, 1, (size_t)size, f) == (size_t)size;
+    fclose(f);
+    if (!ok) {
+        flash_image_free(flash);
+    }
+    return ok;
+}
+
+bool flash_image_save(const flash_image_t* flash, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(flash->data, 1, flash->size, f) == flash->size;
+    return fclose(f) == 0 && ok;
+}
+
+void flash_image_free(flash_image_t* flash) {
+    free(flash->data);
+    memset(flash, 0, sizeof(*flash));
+}
+
+void flash_image_reset_counters(flash_image_t* flash) {
+    flash->read_bytes = 0;
+    flash->program_bytes = 0;
+    flash->program_pages = 0;
+    flash->erases = 0;
+    flash->bad_programs = 0;
+    flash->busy_us = 0;
+}
+
+static bool in_range(const flash_image_t* flash, uint32_t addr, size_t size) {
+    return addr <= flash->size && size <= flash->size - addr;
+}
+
+int flash_image_read(flash_image_t* flash, uint32_t addr, void* dst, size_t size) {
+    if (!in_range(flash, addr, size)) {
+        return -1;
+    }
+    memcpy(dst, flash->data + addr, size);
+    flash->read_bytes += size;
+    flash->busy_us += size / FLASH_READ_BYTES_PER_US;
+    return 0;
+}
+
+int flash_image_program(flash_image_t* flash, uint32_t addr, const void* src, size_t size) {
+    if (!in_range(flash, addr, size)) {
+        return -1;
+    }
+    const uint8_t* in = src;
+    for (size_t i = 0; i < size; i++) {
+        uint8_t old = flash->data[addr + i];
+        if (in[i] & ~old) {
+            flash->bad_programs++;
+        }
+        flash->data[addr + i] = old & in[i];
+    }
+    // The driver splits writes at page boundaries
+    uint32_t first = addr / FLASH_PAGE_SIZE;
+    uint32_t last = size ? (uint32_t)((addr + size - 1) / FLASH_PAGE_SIZE) : first - 1;
+    flash->program_pages += last + 1 - first;
+    flash->program_bytes += size;
+    flash->busy_us += (uint64_t)(last + 1 - first) * FLASH_PAGE_PROGRAM_US;
+    return 0;
+}
+
+int flash_image_erase(flash_image_t* flash, uint32_t addr, size_t size) {
+    if (!in_range(flash, addr, size) || addr % FLASH_SECTOR_SIZE != 0 || size % FLASH_SECTOR_SIZE != 0) {
+        return -1;
+    }
+    memset(flash->data + addr, 0xFF, size);
+    flash->erases += size / FLASH_SECTOR_SIZE;
+    flash->busy_us += (uint64_t)(size / FLASH_SECTOR_SIZE) * FLASH_ERASE_US;
+    return 0;
+}
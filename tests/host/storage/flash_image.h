@@ -0,0 +1,53 @@
+#ifndef FLASH_IMAGE_H
+#define FLASH_IMAGE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FLASH_SECTOR_SIZE 4096
+#define FLASH_PAGE_SIZE 256
+
+/**
+ * @brief A storage partition as NOR flash, in RAM
+ *
+ * Erase sets a 4 KB sector to 0xFF and program can only clear bits, like the
+ * real part, so a filesystem that programs a page twice without erasing
+ * reads back garbage here too. Every operation is counted and charged a
+ * modelled device time (datasheet typicals of the W25Q/GD25Q class flash on
+ * these boards), which is what the benchmark reports instead of host time.
+ */
+typedef struct {
+    uint8_t* data;
+    size_t size;
+
+    uint64_t read_bytes;
+    uint64_t program_bytes;
+    uint32_t program_pages;     // page-sized program operations
+    uint32_t erases;
+    uint32_t bad_programs;      // 0 -> 1 transitions requested without an erase
+    uint64_t busy_us;           // modelled flash time
+} flash_image_t;
+
+// Fully erased image of `size` bytes (a multiple of the sector size)
+bool flash_image_init(flash_image_t* flash, size_t size);
+// Image file dumped from a device (esptool read_flash) or built by
+// spiffsgen.py / mklittlefs; its size becomes the partition size
+bool flash_image_load(flash_image_t* flash, const char* path);
+bool flash_image_save(const flash_image_t* flash, const char* path);
+void flash_image_free(flash_image_t* flash);
+void flash_image_reset_counters(flash_image_t* flash);
+
+int flash_image_read(flash_image_t* flash, uint32_t addr, void* dst, size_t size);
+int flash_image_program(flash_image_t* flash, uint32_t addr, const void* src, size_t size);
+int flash_image_erase(flash_image_t* flash, uint32_t addr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_IMAGE_H
@@ -0,0 +1,317 @@
+// The gif_storage_bench.c workload on the host: each filesystem backend runs
+// from its upstream sources on a RAM flash image, so the two can be compared
+// (and re-run on a partition image read back from a device) without flashing
+// anything.
+//
+// storage_bench [-b littlefs|spiffs] [-s partition_kb] [-n uploads] [-i image] [-o image]
+//
+// -i mounts an existing image instead of a freshly formatted partition, e.g.
+// `esptool.py read_flash 0xD00000 0x300000 storage.bin` from a board that has
+// been in use; -o writes the image back out after the run. Times are the
+// modelled flash busy time from flash_image.c, not host time.
+
+#include "flash_image.h"
+#include "storage_fs.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+// Same workload as main/storage/gif_storage_bench.c
+#define BENCH_UPLOADS 60
+#define BENCH_CHUNK_SIZE 4096
+#define BENCH_MIN_FILE (16 * 1024)
+#define BENCH_MAX_FILE (256 * 1024)
+#define BENCH_RESERVE (64 * 1024)
+#define BENCH_LIST_EVERY 5
+#define BENCH_MAX_FILES 64
+#define BENCH_TMP "/.bn_tmp"
+
+// storage partition in partitions_16M.csv
+#define DEFAULT_PARTITION_KB 3072
+
+typedef struct {
+    uint32_t* samples;
+    size_t count;
+    size_t capacity;
+} latency_t;
+
+static const storage_fs_t* const s_backends[] = {
+#ifdef STORAGE_BENCH_LITTLEFS
+    &storage_fs_littlefs,
+#endif
+#ifdef STORAGE_BENCH_SPIFFS
+    &storage_fs_spiffs,
+#endif
+};
+static const size_t s_backend_count = sizeof(s_backends) / sizeof(s_backends[0]);
+
+static void latency_add(latency_t* l, uint64_t us) {
+    if (l->count < l->capacity) {
+        l->samples[l->count++] = (uint32_t)us;
+    }
+}
+
+static int compare_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void latency_report(const char* name, latency_t* l) {
+    if (l->count == 0) {
+        return;
+    }
+    qsort(l->samples, l->count, sizeof(uint32_t), compare_u32);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < l->count; i++) {
+        sum += l->samples[i];
+    }
+    printf("  %-8s n=%-5u avg=%-7lu p50=%-7lu p99=%-7lu max=%lu us\n", name, (unsigned)l->count,
+           (unsigned long)(sum / l->count), (unsigned long)l->samples[l->count / 2],
+           (unsigned long)l->samples[(l->count * 99) / 100], (unsigned long)l->samples[l->count - 1]);
+}
+
+static bool latency_init(latency_t* l, size_t capacity) {
+    l->samples = malloc(capacity * sizeof(uint32_t));
+    l->count = 0;
+    l->capacity = l->samples ? capacity : 0;
+    return l->samples != NULL;
+}
+
+static uint32_t s_rng;
+
+static uint32_t next_random(void) {
+    // xorshift32: same workload on every run and backend
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void bench_path(char* buffer, size_t size, int id) {
+    snprintf(buffer, size, "/.bn_%03d", id);
+}
+
+static size_t free_bytes(const storage_fs_t* fs) {
+    size_t total = 0, used = 0;
+    if (!fs->info(&total, &used) || used > total) {
+        return 0;
+    }
+    return total - used;
+}
+
+static double cpu_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// gif_storage_replace_file()
+static bool replace_file(const storage_fs_t* fs, const char* from, const char* to) {
+    if (!fs->rename_replaces) {
+        fs->remove(to);
+    }
+    return fs->rename(from, to);
+}
+
+static bool run(const storage_fs_t* fs, flash_image_t* flash, bool format, int uploads) {
+    if (!fs->mount(flash, format)) {
+        printf("%s: mount failed\n", fs->name);
+        return false;
+    }
+    size_t total = 0, used = 0;
+    fs->info(&total, &used);
+    printf("%s: partition %u KB, %u KB used, %d files\n", fs->name, (unsigned)(total / 1024),
+           (unsigned)(used / 1024), fs->list());
+
+    latency_t chunk_lat = {0}, commit_lat = {0}, delete_lat = {0}, list_lat = {0};
+    uint8_t* chunk = malloc(BENCH_CHUNK_SIZE);
+    bool ok = chunk && latency_init(&chunk_lat, uploads * (BENCH_MAX_FILE / BENCH_CHUNK_SIZE)) &&
+              latency_init(&commit_lat, uploads) && latency_init(&delete_lat, uploads + BENCH_MAX_FILES) &&
+              latency_init(&list_lat, uploads / BENCH_LIST_EVERY + 1);
+    if (!ok) {
+        printf("%s: out of memory\n", fs->name);
+        goto cleanup;
+    }
+    s_rng = 0x12345678;
+    for (size_t i = 0; i < BENCH_CHUNK_SIZE; i++) {
+        chunk[i] = (uint8_t)next_random();
+    }
+
+    int live[BENCH_MAX_FILES];  // FIFO of file ids on flash
+    int live_head = 0, live_count = 0;
+    uint64_t bytes_written = 0;
+    char path[32];
+    flash_image_reset_counters(flash);
+    double cpu_start = cpu_seconds();
+
+    for (int n = 0; n < uploads && ok; n++) {
+        size_t size = BENCH_MIN_FILE + next_random() % (BENCH_MAX_FILE - BENCH_MIN_FILE);
+
+        // Evict oldest first until the upload fits
+        while (live_count > 0 && (free_bytes(fs) < size + BENCH_RESERVE || live_count == BENCH_MAX_FILES)) {
+            bench_path(path, sizeof(path), live[live_head]);
+            uint64_t t = flash->busy_us;
+            fs->remove(path);
+            latency_add(&delete_lat, flash->busy_us - t);
+            live_head = (live_head + 1) % BENCH_MAX_FILES;
+            live_count--;
+        }
+        if (free_bytes(fs) < size + BENCH_RESERVE) {
+            printf("%s: partition too full, stopping after %d uploads\n", fs->name, n);
+            break;
+        }
+
+        if (!fs->create(BENCH_TMP)) {
+            printf("%s: failed to create %s\n", fs->name, BENCH_TMP);
+            ok = false;
+            break;
+        }
+        size_t written = 0;
+        while (written < size) {
+            size_t len = size - written < BENCH_CHUNK_SIZE ? size - written : BENCH_CHUNK_SIZE;
+            uint64_t t = flash->busy_us;
+            bool w = fs->write(chunk, len);
+            latency_add(&chunk_lat, flash->busy_us - t);
+            if (!w) {
+                break;
+            }
+            written += len;
+        }
+
+        uint64_t t = flash->busy_us;
+        bool committed = fs->close() && written == size;
+        bench_path(path, sizeof(path), n);
+        committed = committed && replace_file(fs, BENCH_TMP, path);
+        latency_add(&commit_lat, flash->busy_us - t);
+        if (!committed) {
+            printf("%s: write failed after %u bytes\n", fs->name, (unsigned)written);
+            fs->remove(BENCH_TMP);
+            ok = false;
+            break;
+        }
+        bytes_written += size;
+        live[(live_head + live_count) % BENCH_MAX_FILES] = n;
+        live_count++;
+
+        if (n % BENCH_LIST_EVERY == 0) {
+            t = flash->busy_us;
+            fs->list();
+            latency_add(&list_lat, flash->busy_us - t);
+        }
+    }
+
+    double cpu = cpu_seconds() - cpu_start;
+    printf("  wrote %llu KB, flash busy %llu ms: %llu KB/s (host CPU %.0f ms)\n",
+           (unsigned long long)(bytes_written / 1024), (unsigned long long)(flash->busy_us / 1000),
+           flash->busy_us ? (unsigned long long)(bytes_written * 1000000 / flash->busy_us / 1024) : 0ULL,
+           cpu * 1000);
+    latency_report("write", &chunk_lat);
+    latency_report("commit", &commit_lat);
+    latency_report("delete", &delete_lat);
+    latency_report("list", &list_lat);
+    printf("  flash: %lu erases (%lu KB), %lu KB programmed, write amplification %.2f, %llu KB read\n",
+           (unsigned long)flash->erases, (unsigned long)flash->erases * (FLASH_SECTOR_SIZE / 1024),
+           (unsigned long)(flash->program_bytes / 1024),
+           bytes_written ? (double)flash->program_bytes / bytes_written : 0.0,
+           (unsigned long long)(flash->read_bytes / 1024));
+    if (flash->bad_programs) {
+        // Would read back differently on a real part
+        printf("  %lu bytes programmed over unerased bits\n", (unsigned long)flash->bad_programs);
+        ok = false;
+    }
+
+    // Leave the image as it was found, apart from wear
+    while (live_count > 0) {
+        bench_path(path, sizeof(path), live[live_head]);
+        fs->remove(path);
+        live_head = (live_head + 1) % BENCH_MAX_FILES;
+        live_count--;
+    }
+
+cleanup:
+    fs->unmount();
+    free(chunk);
+    free(chunk_lat.samples);
+    free(commit_lat.samples);
+    free(delete_lat.samples);
+    free(list_lat.samples);
+    return ok;
+}
+
+static void usage(const char* argv0) {
+    fprintf(stderr, "usage: %s [-b backend] [-s partition_kb] [-n uploads] [-i image] [-o image]\n", argv0);
+    fprintf(stderr, "backends:");
+    for (size_t i = 0; i < s_backend_count; i++) {
+        fprintf(stderr, " %s", s_backends[i]->name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv) {
+    const char* backend = NULL;
+    const char* image_in = NULL;
+    const char* image_out = NULL;
+    size_t partition_kb = DEFAULT_PARTITION_KB;
+    int uploads = BENCH_UPLOADS;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:s:n:i:o:")) != -1) {
+        switch (opt) {
+        case 'b':
+            backend = optarg;
+            break;
+        case 's':
+            partition_kb = strtoul(optarg, NULL, 0);
+            break;
+        case 'n':
+            uploads = atoi(optarg);
+            break;
+        case 'i':
+            image_in = optarg;
+            break;
+        case 'o':
+            image_out = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (uploads <= 0 || ((image_in || image_out) && !backend)) {
+        // An image belongs to one filesystem
+        usage(argv[0]);
+        return 2;
+    }
+
+    int failures = 0;
+    int ran = 0;
+    for (size_t i = 0; i < s_backend_count; i++) {
+        const storage_fs_t* fs = s_backends[i];
+        if (backend && strcasecmp(backend, fs->name) != 0) {
+            continue;
+        }
+        flash_image_t flash;
+        bool loaded = image_in ? flash_image_load(&flash, image_in)
+                               : flash_image_init(&flash, partition_kb * 1024);
+        if (!loaded) {
+            fprintf(stderr, "%s: cannot %s\n", fs->name, image_in ? "load image" : "allocate partition");
+            return 1;
+        }
+        failures += !run(fs, &flash, image_in == NULL, uploads);
+        if (image_out && !flash_image_save(&flash, image_out)) {
+            fprintf(stderr, "cannot write %s\n", image_out);
+            failures++;
+        }
+        flash_image_free(&flash);
+        ran++;
+    }
+    if (ran == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+#ifndef STORAGE_FS_H
+#define STORAGE_FS_H
+
+#include "flash_image.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief One filesystem mounted on a flash_image_t, driven through its own API
+ *
+ * The host counterpart of gif_storage_backend_t: the same upstream sources
+ * and the same geometry the ESP-IDF components use, without the VFS. Paths
+ * are relative to the partition root ("/name"). Only one file is open at a
+ * time, which is all the benchmark needs.
+ */
+typedef struct {
+    const char* name;
+    // rename() atomically replaces an existing destination
+    bool rename_replaces;
+
+    // Mounts the image, formatting it first if `format`; fails on an image without this filesystem
+    bool (*mount)(flash_image_t* flash, bool format);
+    void (*unmount)(void);
+    bool (*info)(size_t* total_bytes, size_t* used_bytes);
+
+    bool (*create)(const char* path);
+    bool (*write)(const void* data, size_t size);
+    bool (*close)(void);
+    bool (*rename)(const char* from, const char* to);
+    bool (*remove)(const char* path);
+    // readdir + stat of every entry, like listing through the VFS; returns the entry count or -1
+    int (*list)(void);
+} storage_fs_t;
+
+extern const storage_fs_t storage_fs_littlefs;
+extern const storage_fs_t storage_fs_spiffs;
+
+#endif // STORAGE_FS_H
@@ -0,0 +1,126 @@
+#include "storage_fs.h"
+
+#include <lfs.h>
+
+#include <stdio.h>
+
+// esp_littlefs Kconfig defaults (LITTLEFS_READ_SIZE, LITTLEFS_WRITE_SIZE, ...)
+#define LFS_READ_SIZE 128
+#define LFS_PROG_SIZE 128
+#define LFS_CACHE_SIZE 512
+#define LFS_LOOKAHEAD_SIZE 128
+#define LFS_BLOCK_CYCLES 512
+
+static lfs_t s_lfs;
+static lfs_file_t s_file;
+static struct lfs_config s_config;
+
+static int littlefs_hal_read(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, void* buffer,
+                          lfs_size_t size) {
+    return flash_image_read(c->context, block * c->block_size + off, buffer, size) == 0 ? 0 : LFS_ERR_IO;
+}
+
+static int littlefs_hal_prog(const struct lfs_config* c, lfs_block_t block, lfs_off_t off, const void* buffer,
+                          lfs_size_t size) {
+    return flash_image_program(c->context, block * c->block_size + off, buffer, size) == 0 ? 0 : LFS_ERR_IO;
+}
+
+static int littlefs_hal_erase(const struct lfs_config* c, lfs_block_t block) {
+    return flash_image_erase(c->context, block * c->block_size, c->block_size) == 0 ? 0 : LFS_ERR_IO;
+}
+
+static int littlefs_hal_sync(const struct lfs_config* c) {
+    (void)c;
+    return 0;
+}
+
+static bool littlefs_mount(flash_image_t* flash, bool format) {
+    s_config = (struct lfs_config){
+        .context = flash,
+        .read = littlefs_hal_read,
+        .prog = littlefs_hal_prog,
+        .erase = littlefs_hal_erase,
+        .sync = littlefs_hal_sync,
+        .read_size = LFS_READ_SIZE,
+        .prog_size = LFS_PROG_SIZE,
+        .block_size = FLASH_SECTOR_SIZE,
+        .block_count = flash->size / FLASH_SECTOR_SIZE,
+        .block_cycles = LFS_BLOCK_CYCLES,
+        .cache_size = LFS_CACHE_SIZE,
+        .lookahead_size = LFS_LOOKAHEAD_SIZE,
+    };
+    if (format && lfs_format(&s_lfs, &s_config) != 0) {
+        return false;
+    }
+    return lfs_mount(&s_lfs, &s_config) == 0;
+}
+
+static void littlefs_unmount(void) {
+    lfs_unmount(&s_lfs);
+}
+
+static bool littlefs_info(size_t* total_bytes, size_t* used_bytes) {
+    // What esp_littlefs_info() reports: whole blocks in use
+    lfs_ssize_t blocks = lfs_fs_size(&s_lfs);
+    if (blocks < 0) {
+        return false;
+    }
+    *total_bytes = s_config.block_count * s_config.block_size;
+    *used_bytes = (size_t)blocks * s_config.block_size;
+    return true;
+}
+
+static bool littlefs_create(const char* path) {
+    return lfs_file_open(&s_lfs, &s_file, path, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) == 0;
+}
+
+static bool littlefs_write(const void* data, size_t size) {
+    return lfs_file_write(&s_lfs, &s_file, data, size) == (lfs_ssize_t)size;
+}
+
+static bool littlefs_close(void) {
+    return lfs_file_close(&s_lfs, &s_file) == 0;
+}
+
+static bool littlefs_rename(const char* from, const char* to) {
+    return lfs_rename(&s_lfs, from, to) == 0;
+}
+
+static bool littlefs_remove(const char* path) {
+    return lfs_remove(&s_lfs, path) == 0;
+}
+
+static int littlefs_list(void) {
+    lfs_dir_t dir;
+    if (lfs_dir_open(&s_lfs, &dir, "/") != 0) {
+        return -1;
+    }
+    int count = 0;
+    struct lfs_info entry;
+    char path[LFS_NAME_MAX + 2];
+    while (lfs_dir_read(&s_lfs, &dir, &entry) > 0) {
+        if (entry.type != LFS_TYPE_REG) {
+            continue;
+        }
+        struct lfs_info st;
+        snprintf(path, sizeof(path), "/%s", entry.name);
+        lfs_stat(&s_lfs, path, &st);
+        count++;
+    }
+    lfs_dir_close(&s_lfs, &dir);
+    return count;
+}
+
+const storage_fs_t storage_fs_littlefs = {
+    .name = "LittleFS",
+    .rename_replaces = true,
+    .mount = littlefs_mount,
+    .unmount = littlefs_unmount,
+    .info = littlefs_info,
+    .create = littlefs_create,
+    .write = littlefs_write,
+    .close = littlefs_close,
+    .rename = littlefs_rename,
+    .remove = littlefs_remove,
+    .list = littlefs_list,
+};
@@ -0,0 +1,154 @@
+#include "storage_fs.h"
+
+#include <spiffs.h>
+#include <spiffs_nucleus.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// esp_spiffs geometry: 256 byte pages in 4 KB logical blocks. The fd and
+// cache pools are sized from max_files as esp_vfs_spiffs_register() does,
+// with the firmware's CONFIG_GIF_STORAGE_MAX_FILES default.
+#define SPIFFS_PAGE_SIZE 256
+#define SPIFFS_MAX_FILES 10
+
+static spiffs s_fs;
+static spiffs_file s_file = -1;
+static spiffs_config s_config;
+static uint8_t s_work[SPIFFS_PAGE_SIZE * 2];
+static uint8_t* s_fds;
+static uint8_t* s_cache;
+static flash_image_t* s_flash;
+
+// SPIFFS_HAL_CALLBACK_EXTRA: the HAL gets the filesystem, unused with one instance
+static s32_t spiffs_hal_read(spiffs* fs, u32_t addr, u32_t size, u8_t* dst) {
+    (void)fs;
+    return flash_image_read(s_flash, addr, dst, size) == 0 ? SPIFFS_OK : SPIFFS_ERR_INTERNAL;
+}
+
+static s32_t spiffs_hal_write(spiffs* fs, u32_t addr, u32_t size, u8_t* src) {
+    (void)fs;
+    return flash_image_program(s_flash, addr, src, size) == 0 ? SPIFFS_OK : SPIFFS_ERR_INTERNAL;
+}
+
+static s32_t spiffs_hal_erase(spiffs* fs, u32_t addr, u32_t size) {
+    (void)fs;
+    return flash_image_erase(s_flash, addr, size) == 0 ? SPIFFS_OK : SPIFFS_ERR_INTERNAL;
+}
+
+static size_t fds_size(void) {
+    return SPIFFS_MAX_FILES * sizeof(spiffs_fd);
+}
+
+static size_t cache_size(void) {
+    return sizeof(spiffs_cache) + SPIFFS_MAX_FILES * (sizeof(spiffs_cache_page) + SPIFFS_PAGE_SIZE);
+}
+
+static s32_t spiffs_fs_try_mount(void) {
+    return SPIFFS_mount(&s_fs, &s_config, s_work, s_fds, fds_size(), s_cache, cache_size(), NULL);
+}
+
+static bool spiffs_fs_mount(flash_image_t* flash, bool format) {
+    s_config = (spiffs_config){
+        .hal_read_f = spiffs_hal_read,
+        .hal_write_f = spiffs_hal_write,
+        .hal_erase_f = spiffs_hal_erase,
+        .phys_size = flash->size,
+        .phys_addr = 0,
+        .phys_erase_block = FLASH_SECTOR_SIZE,
+        .log_block_size = FLASH_SECTOR_SIZE,
+        .log_page_size = SPIFFS_PAGE_SIZE,
+    };
+    s_flash = flash;
+    free(s_fds);
+    free(s_cache);
+    s_fds = calloc(1, fds_size());
+    s_cache = calloc(1, cache_size());
+    if (!s_fds || !s_cache) {
+        return false;
+    }
+
+    s32_t res = spiffs_fs_try_mount();
+    if (!format) {
+        return res == SPIFFS_OK;
+    }
+    // SPIFFS_format() wants the configuration a (failed) mount leaves behind
+    // and an unmounted filesystem
+    if (res == SPIFFS_OK) {
+        SPIFFS_unmount(&s_fs);
+    }
+    return SPIFFS_format(&s_fs) == SPIFFS_OK && spiffs_fs_try_mount() == SPIFFS_OK;
+}
+
+static void spiffs_fs_unmount(void) {
+    SPIFFS_unmount(&s_fs);
+    free(s_fds);
+    free(s_cache);
+    s_fds = NULL;
+    s_cache = NULL;
+}
+
+static bool spiffs_fs_info(size_t* total_bytes, size_t* used_bytes) {
+    u32_t total = 0;
+    u32_t used = 0;
+    if (SPIFFS_info(&s_fs, &total, &used) != SPIFFS_OK) {
+        return false;
+    }
+    *total_bytes = total;
+    *used_bytes = used;
+    return true;
+}
+
+static bool spiffs_fs_create(const char* path) {
+    s_file = SPIFFS_open(&s_fs, path, SPIFFS_O_CREAT | SPIFFS_O_TRUNC | SPIFFS_O_WRONLY, 0);
+    return s_file >= 0;
+}
+
+static bool spiffs_fs_write(const void* data, size_t size) {
+    return SPIFFS_write(&s_fs, s_file, (void*)data, size) == (s32_t)size;
+}
+
+static bool spiffs_fs_close(void) {
+    bool ok = SPIFFS_close(&s_fs, s_file) == SPIFFS_OK;
+    s_file = -1;
+    return ok;
+}
+
+static bool spiffs_fs_rename(const char* from, const char* to) {
+    return SPIFFS_rename(&s_fs, from, to) == SPIFFS_OK;
+}
+
+static bool spiffs_fs_remove(const char* path) {
+    return SPIFFS_remove(&s_fs, path) == SPIFFS_OK;
+}
+
+static int spiffs_fs_list(void) {
+    spiffs_DIR dir;
+    if (!SPIFFS_opendir(&s_fs, "/", &dir)) {
+        return -1;
+    }
+    int count = 0;
+    struct spiffs_dirent entry;
+    while (SPIFFS_readdir(&dir, &entry)) {
+        spiffs_stat st;
+        SPIFFS_stat(&s_fs, (const char*)entry.name, &st);
+        count++;
+    }
+    SPIFFS_closedir(&dir);
+    return count;
+}
+
+const storage_fs_t storage_fs_spiffs = {
+    .name = "SPIFFS",
+    // SPIFFS_rename() fails if the destination exists
+    .rename_replaces = false,
+    .mount = spiffs_fs_mount,
+    .unmount = spiffs_fs_unmount,
+    .info = spiffs_fs_info,
+    .create = spiffs_fs_create,
+    .write = spiffs_fs_write,
+    .close = spiffs_fs_close,
+    .rename = spiffs_fs_rename,
+    .remove = spiffs_fs_remove,
+    .list = spiffs_fs_list,
+};
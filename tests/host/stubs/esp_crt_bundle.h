@@ -0,0 +1,14 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Host tests use plain HTTP; attaching fails like a missing bundle would */
+esp_err_t esp_crt_bundle_attach(void *conf);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,79 @@
+#include "esp_heap_caps.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_HEAP_SIZE (4 * 1024 * 1024)
+
+static long s_blocks;
+
+static void count_block(int delta)
+{
+    __atomic_add_fetch(&s_blocks, delta, __ATOMIC_RELAXED);
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    void *p = malloc(size);
+    if (p) {
+        count_block(1);
+    }
+    return p;
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    void *p = calloc(n, size);
+    if (p) {
+        count_block(1);
+    }
+    return p;
+}
+
+void *heap_caps_realloc(void *ptr, size_t size, uint32_t caps)
+{
+    (void)caps;
+    void *p = realloc(ptr, size);
+    if (p && !ptr) {
+        count_block(1);
+    }
+    return p;
+}
+
+void heap_caps_free(void *ptr)
+{
+    if (ptr) {
+        count_block(-1);
+    }
+    free(ptr);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_SIZE;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_SIZE;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_SIZE;
+}
+
+void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps)
+{
+    (void)caps;
+    memset(info, 0, sizeof(*info));
+    info->total_free_bytes = HOST_HEAP_SIZE;
+    info->largest_free_block = HOST_HEAP_SIZE;
+    info->minimum_free_bytes = HOST_HEAP_SIZE;
+    info->allocated_blocks = (size_t)__atomic_load_n(&s_blocks, __ATOMIC_RELAXED);
+}
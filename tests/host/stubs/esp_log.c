@@ -0,0 +1,9 @@
+#include "esp_log.h"
+
+esp_log_level_t esp_log_host_level = ESP_LOG_INFO;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    esp_log_host_level = level;
+}
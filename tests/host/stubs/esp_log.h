@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+/* One level for every tag; tests that feed junk on purpose turn it down */
+extern esp_log_level_t esp_log_host_level;
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+/* Same call shape as ESP-IDF; everything goes to stdout with the tag */
+#define ESP_LOG_HOST(level, letter, tag, format, ...) do { \
+        if (esp_log_host_level >= (level)) { \
+            printf(letter " (%s) " format "\n", tag, ##__VA_ARGS__); \
+        } \
+    } while (0)
+#define ESP_LOGE(tag, format, ...) ESP_LOG_HOST(ESP_LOG_ERROR, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_HOST(ESP_LOG_WARN, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_HOST(ESP_LOG_INFO, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do { } while (0)
+#define ESP_LOGV(tag, format, ...) do { } while (0)
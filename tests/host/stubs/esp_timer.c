@@ -0,0 +1,167 @@
+#include "esp_timer.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void *arg;
+    int64_t deadline_us;    /* 0 when not armed */
+    uint64_t period_us;     /* 0 for one-shot */
+    esp_timer_handle_t next;
+};
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_changed = PTHREAD_COND_INITIALIZER;
+static esp_timer_handle_t s_timers;
+static esp_timer_handle_t s_running;
+static pthread_t s_dispatcher;
+static bool s_started;
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static esp_timer_handle_t next_due(void)
+{
+    esp_timer_handle_t due = NULL;
+    for (esp_timer_handle_t t = s_timers; t; t = t->next) {
+        if (t->deadline_us != 0 && (due == NULL || t->deadline_us < due->deadline_us)) {
+            due = t;
+        }
+    }
+    return due;
+}
+
+static void *dispatcher_main(void *unused)
+{
+    (void)unused;
+    pthread_mutex_lock(&s_lock);
+    for (;;) {
+        esp_timer_handle_t due = next_due();
+        if (due == NULL) {
+            pthread_cond_wait(&s_changed, &s_lock);
+            continue;
+        }
+        int64_t now = esp_timer_get_time();
+        if (now < due->deadline_us) {
+            /* The condition variable uses CLOCK_REALTIME; recheck on wakeup */
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            int64_t wait_us = due->deadline_us - now;
+            ts.tv_sec += wait_us / 1000000;
+            ts.tv_nsec += (wait_us % 1000000) * 1000;
+            if (ts.tv_nsec >= 1000000000) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            pthread_cond_timedwait(&s_changed, &s_lock, &ts);
+            continue;
+        }
+        due->deadline_us = due->period_us ? now + (int64_t)due->period_us : 0;
+        s_running = due;
+        pthread_mutex_unlock(&s_lock);
+        due->callback(due->arg);
+        pthread_mutex_lock(&s_lock);
+        s_running = NULL;
+        pthread_cond_broadcast(&s_changed);
+    }
+    return NULL;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_timer_handle_t timer = calloc(1, sizeof(*timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    pthread_mutex_lock(&s_lock);
+    if (!s_started) {
+        if (pthread_create(&s_dispatcher, NULL, dispatcher_main, NULL) != 0) {
+            pthread_mutex_unlock(&s_lock);
+            free(timer);
+            return ESP_FAIL;
+        }
+        pthread_detach(s_dispatcher);
+        s_started = true;
+    }
+    timer->next = s_timers;
+    s_timers = timer;
+    pthread_mutex_unlock(&s_lock);
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    if (timer->deadline_us != 0) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    /* Never 0, which means disarmed */
+    timer->deadline_us = esp_timer_get_time() + (int64_t)timeout_us + 1;
+    timer->period_us = period_us;
+    pthread_cond_broadcast(&s_changed);
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    esp_err_t err = timer->deadline_us != 0 ? ESP_OK : ESP_ERR_INVALID_STATE;
+    timer->deadline_us = 0;
+    pthread_cond_broadcast(&s_changed);
+    pthread_mutex_unlock(&s_lock);
+    return err;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&s_lock);
+    if (timer->deadline_us != 0) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    while (s_running == timer && !pthread_equal(pthread_self(), s_dispatcher)) {
+        pthread_cond_wait(&s_changed, &s_lock);
+    }
+    for (esp_timer_handle_t *link = &s_timers; *link; link = &(*link)->next) {
+        if (*link == timer) {
+            *link = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    free(timer);
+    return ESP_OK;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdPASS 1
+#define pdFAIL 0
+
+/* Tasks are detached pthreads; priority and stack size are ignored */
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle);
+/* Only vTaskDelete(NULL) at the end of a task function is supported */
+void vTaskDelete(TaskHandle_t task);
+/* One tick is one millisecond */
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+
+#define taskYIELD() do { } while (0)
+
+#ifdef __cplusplus
+}
+#endif
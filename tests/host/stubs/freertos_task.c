@@ -0,0 +1,60 @@
+#include "freertos/task.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    TaskFunction_t task;
+    void *arg;
+} task_start_t;
+
+static void *task_main(void *p)
+{
+    task_start_t start = *(task_start_t *)p;
+    free(p);
+    start.task(start.arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t task, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+    task_start_t *start = malloc(sizeof(*start));
+    pthread_t thread;
+    if (start == NULL) {
+        return pdFAIL;
+    }
+    start->task = task;
+    start->arg = arg;
+    if (pthread_create(&thread, NULL, task_main, start) != 0) {
+        free(start);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    if (handle) {
+        *handle = (TaskHandle_t)thread;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    (void)task;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = {(time_t)(ticks / 1000), (long)(ticks % 1000) * 1000000L};
+    nanosleep(&ts, NULL);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+}
@@ -0,0 +1,4 @@
+#pragma once
+
+/* Host builds pass the CONFIG_* values a test needs as compile definitions;
+ * everything else falls back to the #ifndef defaults in the sources */